@@ -0,0 +1,119 @@
+#  Phusion Passenger - https://www.phusionpassenger.com/
+#  Copyright (c) 2015 Phusion Holding B.V.
+#
+#  "Passenger", "Phusion Passenger" and "Union Station" are registered
+#  trademarks of Phusion Holding B.V.
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to deal
+#  in the Software without restriction, including without limitation the rights
+#  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+#  copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+#  THE SOFTWARE.
+
+### C++ microbenchmarks ###
+
+TEST_CXX_BENCHMARKS_TARGET = "#{TEST_OUTPUT_DIR}cxx_benchmarks/main"
+TEST_CXX_BENCHMARKS_CFLAGS = "-O2 -DNDEBUG"
+TEST_CXX_BENCHMARKS_OBJECTS = {
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/main.o" =>
+    "test/cxx_benchmarks/main.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/PoolLockingBenchmark.o" =>
+    "test/cxx_benchmarks/PoolLockingBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/ProcessSelectionBenchmark.o" =>
+    "test/cxx_benchmarks/ProcessSelectionBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/HttpHeaderParserBenchmark.o" =>
+    "test/cxx_benchmarks/HttpHeaderParserBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/HeaderTableBenchmark.o" =>
+    "test/cxx_benchmarks/HeaderTableBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/StringKeyTableBenchmark.o" =>
+    "test/cxx_benchmarks/StringKeyTableBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/LStringBenchmark.o" =>
+    "test/cxx_benchmarks/LStringBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/MbufBenchmark.o" =>
+    "test/cxx_benchmarks/MbufBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/ControllerBenchmark.o" =>
+    "test/cxx_benchmarks/ControllerBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/ResponseCacheBenchmark.o" =>
+    "test/cxx_benchmarks/ResponseCacheBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/RemoteSenderBenchmark.o" =>
+    "test/cxx_benchmarks/RemoteSenderBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/UstRouterTransactionBenchmark.o" =>
+    "test/cxx_benchmarks/UstRouterTransactionBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/ResponseSpliceBenchmark.o" =>
+    "test/cxx_benchmarks/ResponseSpliceBenchmark.cpp",
+  "#{TEST_OUTPUT_DIR}cxx_benchmarks/RequestInitBenchmark.o" =>
+    "test/cxx_benchmarks/RequestInitBenchmark.cpp"
+}
+
+def test_cxx_benchmarks_ldflags
+  @test_cxx_benchmarks_ldflags ||= begin
+    result = "#{EXTRA_PRE_CXX_LDFLAGS} " <<
+      "#{TEST_COMMON_LIBRARY.link_objects_as_string} " <<
+      "#{TEST_BOOST_OXT_LIBRARY} #{libev_libs} #{libuv_libs} " <<
+      "#{PlatformInfo.curl_libs} " <<
+      "#{PlatformInfo.zlib_libs} " <<
+      "#{PlatformInfo.portability_cxx_ldflags} " <<
+      "#{EXTRA_CXX_LDFLAGS}"
+    result.strip!
+    result
+  end
+end
+
+# Define compilation tasks for object files.
+TEST_CXX_BENCHMARKS_OBJECTS.each_pair do |object, source|
+  define_cxx_object_compilation_task(
+    object,
+    source,
+    :include_paths => [
+      "test/cxx_benchmarks",
+      "src/agent",
+      *CXX_SUPPORTLIB_INCLUDE_PATHS
+    ],
+    :flags => [
+      TEST_CXX_BENCHMARKS_CFLAGS,
+      LIBEV_CFLAGS,
+      LIBUV_CFLAGS,
+      PlatformInfo.curl_flags
+    ]
+  )
+end
+
+# Define compilation task for the benchmark executable. The Core benchmarks
+# link against the agent objects, so those are built with the usual agent
+# flags; pass OPTIMIZE=1 to benchmark an optimized build.
+dependencies = [
+  TEST_CXX_BENCHMARKS_OBJECTS.keys,
+  LIBEV_TARGET,
+  LIBUV_TARGET,
+  TEST_BOOST_OXT_LIBRARY,
+  TEST_COMMON_LIBRARY.link_objects,
+  AGENT_OBJECTS.keys - [AGENT_MAIN_OBJECT]
+].flatten.compact
+file(TEST_CXX_BENCHMARKS_TARGET => dependencies) do
+  create_cxx_executable(
+    TEST_CXX_BENCHMARKS_TARGET,
+    TEST_CXX_BENCHMARKS_OBJECTS.keys + AGENT_OBJECTS.keys - [AGENT_MAIN_OBJECT],
+    :flags => test_cxx_benchmarks_ldflags
+  )
+end
+
+desc "Run C++ microbenchmarks (select with BENCHMARKS='name1 name2', " \
+  "write JSON results with OUTPUT=filename.json)"
+task 'benchmark:cxx' => TEST_CXX_BENCHMARKS_TARGET do
+  args = ENV['BENCHMARKS'].to_s.split(/[ ,]/).map { |name| "-b #{name}" }
+  args << "-t #{ENV['MIN_TIME']}" if !ENV['MIN_TIME'].to_s.empty?
+  args << "-o #{File.expand_path(ENV['OUTPUT'])}" if !ENV['OUTPUT'].to_s.empty?
+  sh "#{File.expand_path(TEST_CXX_BENCHMARKS_TARGET)} #{args.join(' ')}".strip
+end
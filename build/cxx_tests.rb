@@ -58,10 +58,16 @@
     "test/cxx/ServerKit/FileBufferedChannelTest.cpp",
   "#{TEST_OUTPUT_DIR}cxx/ServerKit/HeaderTableTest.o" =>
     "test/cxx/ServerKit/HeaderTableTest.cpp",
+  "#{TEST_OUTPUT_DIR}cxx/ServerKit/HttpHeaderParserTest.o" =>
+    "test/cxx/ServerKit/HttpHeaderParserTest.cpp",
   "#{TEST_OUTPUT_DIR}cxx/ServerKit/ServerTest.o" =>
     "test/cxx/ServerKit/ServerTest.cpp",
   "#{TEST_OUTPUT_DIR}cxx/ServerKit/HttpServerTest.o" =>
     "test/cxx/ServerKit/HttpServerTest.cpp",
+  "#{TEST_OUTPUT_DIR}cxx/ServerKit/IoUringEngineTest.o" =>
+    "test/cxx/ServerKit/IoUringEngineTest.cpp",
+  "#{TEST_OUTPUT_DIR}cxx/ServerKit/PallocPoolRecyclerTest.o" =>
+    "test/cxx/ServerKit/PallocPoolRecyclerTest.cpp",
   "#{TEST_OUTPUT_DIR}cxx/ServerKit/CookieUtilsTest.o" =>
     "test/cxx/ServerKit/CookieUtilsTest.cpp",
 
@@ -69,6 +75,8 @@
     "test/cxx/MemoryKit/MbufTest.cpp",
   "#{TEST_OUTPUT_DIR}cxx/MemoryKit/PallocTest.o" =>
     "test/cxx/MemoryKit/PallocTest.cpp",
+  "#{TEST_OUTPUT_DIR}cxx/DataStructures/IndexedMinHeapTest.o" =>
+    "test/cxx/DataStructures/IndexedMinHeapTest.cpp",
   "#{TEST_OUTPUT_DIR}cxx/DataStructures/LStringTest.o" =>
     "test/cxx/DataStructures/LStringTest.cpp",
   "#{TEST_OUTPUT_DIR}cxx/DataStructures/StringKeyTableTest.o" =>
@@ -0,0 +1,55 @@
+#!/usr/bin/env ruby
+#
+# Usage: ./dev/compare_cxx_benchmarks.rb <OLD.json> <NEW.json> [THRESHOLD_PERCENT]
+#
+# Compares two result files written by `rake benchmark:cxx OUTPUT=...` and
+# prints the change in time per operation of every benchmark case. Cases
+# that became more than THRESHOLD_PERCENT (default: 10) slower are marked.
+# Exits with status 1 if there are any such regressions.
+
+require 'json'
+
+def load_results(filename)
+  doc = JSON.parse(File.read(filename))
+  result = {}
+  doc['benchmarks'].each do |item|
+    result[item['name']] = item['ns_per_op']
+  end
+  result
+end
+
+def start
+  if ARGV.size < 2
+    abort "Usage: ./dev/compare_cxx_benchmarks.rb <OLD.json> <NEW.json> [THRESHOLD_PERCENT]"
+  end
+
+  old_results = load_results(ARGV[0])
+  new_results = load_results(ARGV[1])
+  threshold = (ARGV[2] || 10).to_f
+  regressions = 0
+
+  printf("%-64s %12s %12s %9s\n", "Benchmark", "Old ns/op", "New ns/op", "Change")
+  (old_results.keys | new_results.keys).each do |name|
+    old_value = old_results[name]
+    new_value = new_results[name]
+    if old_value.nil? || new_value.nil?
+      printf("%-64s %12s %12s\n", name,
+        old_value ? format("%.1f", old_value) : "-",
+        new_value ? format("%.1f", new_value) : "-")
+      next
+    end
+
+    change = (new_value - old_value) / old_value * 100
+    marker = ""
+    if change > threshold
+      marker = "  REGRESSION"
+      regressions += 1
+    end
+    printf("%-64s %12.1f %12.1f %+8.1f%%%s\n", name, old_value, new_value,
+      change, marker)
+  end
+
+  exit(regressions > 0 ? 1 : 0)
+end
+
+start
@@ -7,12 +7,14 @@
   "src/cxx_supportlib",
   "src/cxx_supportlib/vendor-copy",
   "src/cxx_supportlib/vendor-modified",
-  "test/cxx"
+  "test/cxx",
+  "test/cxx_benchmarks"
 ]
 SCAN_FILES = Dir[
   "src/**/*.{c,cpp,h,hpp}",
   "test/oxt/**/*.{c,cpp,h,hpp}",
-  "test/cxx/**/*.{c,cpp,h,hpp}"
+  "test/cxx/**/*.{c,cpp,h,hpp}",
+  "test/cxx_benchmarks/**/*.{c,cpp,h,hpp}"
 ]
 EXCLUDE_FILES = Dir[
   "src/cxx_supportlib/vendor-copy/**/*",
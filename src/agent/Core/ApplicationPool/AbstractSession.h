@@ -59,6 +59,21 @@ public:
 
 	virtual void requestOOBW() { /* Do nothing */ }
 
+	/**
+	 * Tells the session how long, in microseconds, it took for the app
+	 * to start responding. This is fed into the process's response time
+	 * statistics when the session is closed.
+	 */
+	virtual void reportResponseTime(unsigned long long usec) { /* Do nothing */ }
+
+	/**
+	 * Whether the process was totally busy right after this session was
+	 * checked out, i.e. whether this session took the process's last free slot.
+	 */
+	virtual bool tookLastFreeSlot() const {
+		return false;
+	}
+
 	/**
 	 * This Session object becomes fully unsable after closing.
 	 */
@@ -46,13 +46,17 @@
 #include <cassert>
 #include <SmallVector.h>
 #include <MemoryKit/palloc.h>
+#include <DataStructures/IndexedMinHeap.h>
+#include <Algorithms/MovingAverage.h>
 #include <Hooks.h>
 #include <Utils.h>
+#include <Utils/SpeedMeter.h>
 #include <Core/ApplicationPool/Common.h>
 #include <Core/ApplicationPool/Context.h>
 #include <Core/ApplicationPool/BasicGroupInfo.h>
 #include <Core/ApplicationPool/Process.h>
 #include <Core/ApplicationPool/Options.h>
+#include <Core/ApplicationPool/RoutingPolicy.h>
 #include <Core/SpawningKit/Factory.h>
 #include <Core/SpawningKit/UserSwitchingRules.h>
 #include <Shared/ApplicationPoolApiKey.h>
@@ -89,6 +93,20 @@ public:
 			{ }
 	};
 
+	enum DemandForecastDecision {
+		/**
+		 * Nothing was done: there isn't enough data to make a forecast yet,
+		 * or predictive scaling is turned off.
+		 */
+		DFD_NONE,
+		/** The group has the right number of processes for the forecast. */
+		DFD_HOLD,
+		/** Processes are being spawned or promoted ahead of the forecasted demand. */
+		DFD_SPAWN,
+		/** An idle process was retired because the forecasted demand is lower. */
+		DFD_RETIRE
+	};
+
 	struct RouteResult {
 		Process *process;
 		bool finished;
@@ -138,8 +156,18 @@ public:
 	 *
 	 * Invariant:
 	 *     if processesBeingSpawned > 0: m_spawning
+	 *     processesBeingSpawned <= spawnLoopsActive
 	 */
 	short processesBeingSpawned;
+	/**
+	 * The number of spawn loop threads that are working right now. Each
+	 * loop spawns one process at a time, so up to `options.spawnConcurrency`
+	 * processes can be spawned in parallel.
+	 *
+	 * Invariant:
+	 *     m_spawning == (spawnLoopsActive > 0)
+	 */
+	short spawnLoopsActive;
 	/**
 	 * A Group object progresses through a life.
 	 *
@@ -150,11 +178,12 @@ public:
 	 *       enabledCount == 0
 	 *       disablingCount == 0
 	 *       disabledCount == 0
+	 *       standbyCount == 0
 	 *       nEnabledProcessesTotallyBusy == 0
 	 */
 	boost::atomic<boost::uint8_t> lifeStatus;
 	/**
-	 * Whether the spawner thread is currently working. Note that even
+	 * Whether any spawner thread is currently working. Note that even
 	 * if it's working, it doesn't necessarily mean that processes are
 	 * being spawned (i.e. that processesBeingSpawned > 0). After the
 	 * thread is done spawning a process, it will attempt to attach
@@ -175,9 +204,71 @@ public:
 	bool m_restarting: 1;
 	bool alwaysRestartFileExists: 1;
 
-	/** Contains the spawn loop thread and the restarter thread. */
+	/**
+	 * Session checkout and session close have a fast path which only holds
+	 * the pool lock in shared mode (see `Pool::syncher`). Such code must hold
+	 * this mutex too, while it reads or writes anything that those fast paths
+	 * may change: the session counters and statistics of this group's processes
+	 * and sockets, `enabledProcessBusynessLevels`, `nEnabledProcessesTotallyBusy`,
+	 * the routing policy's state, `options` (through `mergeOptions()`) and the
+	 * restart file check times. Code that holds the pool lock in exclusive mode
+	 * need not lock this mutex.
+	 *
+	 * Lock order: pool lock (shared), then this mutex.
+	 */
+	boost::mutex sessionSyncher;
+
+	/** Contains the spawn loop threads and the restarter thread. */
 	dynamic_thread_group interruptableThreads;
 
+	/**
+	 * Spawn latency statistics of this group, i.e. how long successful
+	 * `spawner->spawn()` calls took. Histogram bucket `i` counts spawns
+	 * that took at most (100 ms << i). The last bucket counts all slower ones.
+	 */
+	static const unsigned int SPAWN_LATENCY_HISTOGRAM_BUCKETS = 8;
+	unsigned int spawnLatencyHistogram[SPAWN_LATENCY_HISTOGRAM_BUCKETS];
+	unsigned int spawnsCompleted;
+	unsigned long long totalSpawnTime;
+	unsigned long long maxSpawnTime;
+
+	/** How often the pool updates the demand forecast of each group. */
+	static const unsigned long long DEMAND_FORECAST_INTERVAL = 5 * 1000000;
+	/**
+	 * Demand forecasting state, updated periodically by `updateDemandForecast()`.
+	 *
+	 * `getActionsReceived` counts the get actions that this group received.
+	 * The fast path of `Pool::asyncGet()` increments it while holding
+	 * `sessionSyncher`. `arrivalRateMeter` turns it into an arrival rate, in
+	 * get actions per second. `arrivalRateTrend` smooths how quickly that
+	 * rate changes, per second, and `averageSessions` smooths the number of
+	 * sessions that the enabled processes have open.
+	 */
+	unsigned long long getActionsReceived;
+	SpeedMeter<double, 4, 1000000, 60 * 1000000, 1000000> arrivalRateMeter;
+	DiscExpMovingAverage<300, 5 * 1000000, 5 * 1000000> arrivalRateTrend;
+	DiscExpMovingAverage<300, 5 * 1000000, 5 * 1000000> averageSessions;
+	double arrivalRate;
+	double predictedArrivalRate;
+	unsigned long long lastDemandForecastTime;
+	/**
+	 * The number of processes that the last forecast calls for, within the
+	 * group's process limits. 0 if there is no forecast, or if no processes
+	 * are needed at all.
+	 */
+	unsigned int predictedProcesses;
+	DemandForecastDecision lastDemandForecastDecision;
+	/** The number of times processes were spawned because of a forecast. */
+	unsigned int predictiveSpawns;
+	/** The number of processes that were retired because of a forecast. */
+	unsigned int predictiveRetirements;
+
+	/**
+	 * The number of processes that were recycled because they went over
+	 * `options.memoryLimit`. See `Pool::recycleProcessesOverMemoryLimit()`.
+	 */
+	unsigned int memoryRecycles;
+
 	string restartFile;
 	string alwaysRestartFile;
 	ProcessPtr nullProcess;
@@ -186,7 +277,7 @@ public:
 	 * whether any of the Processes can be shut down.
 	 */
 	bool detachedProcessesCheckerActive;
-	boost::condition_variable detachedProcessesCheckerCond;
+	boost::condition_variable_any detachedProcessesCheckerCond;
 	Callback shutdownCallback;
 	GroupPtr selfPointer;
 
@@ -203,6 +294,8 @@ public:
 
 	RouteResult route(const Options &options) const;
 	SessionPtr newSession(Process *process, unsigned long long now = 0);
+	SessionPtr getWithSharedPoolLock(const Options &newOptions);
+	bool closeSessionWithSharedPoolLock(Process *process, Session *session);
 	static void _onSessionInitiateFailure(Session *session);
 	static void _onSessionClose(Session *session);
 	OXT_FORCE_INLINE void onSessionInitiateFailure(Process *process, Session *session);
@@ -214,6 +307,13 @@ public:
 		unsigned int restartsInitiated);
 	void spawnThreadRealMain(const SpawningKit::SpawnerPtr &spawner, const Options &options,
 		unsigned int restartsInitiated);
+	void startSpawnLoop();
+	bool needsParallelSpawning() const;
+	bool shouldSpawnInParallel() const;
+	bool needsStandbyProcesses() const;
+	bool needsPredictedProcesses() const;
+	void recordSpawnLatency(unsigned long long usec);
+	bool restartCheckDue(const Options &options) const;
 	void finalizeRestart(GroupPtr self, Options oldOptions, Options newOptions,
 		RestartMethod method, SpawningKit::FactoryPtr spawningKitFactory,
 		unsigned int restartsInitiated, boost::container::vector<Callback> postLockActions);
@@ -221,9 +321,9 @@ public:
 	/****** Process list management ******/
 
 	Process *findProcessWithStickySessionId(unsigned int id) const;
-	Process *findProcessWithStickySessionIdOrLowestBusyness(unsigned int id) const;
+	Process *findProcessWithStickySessionIdOrSelectEnabledProcess(unsigned int id) const;
 	Process *findProcessWithLowestBusyness(const ProcessList &processes) const;
-	Process *findEnabledProcessWithLowestBusyness() const;
+	Process *selectEnabledProcess() const;
 
 	void addProcessToList(const ProcessPtr &process, ProcessList &destination);
 	void removeProcessFromList(const ProcessPtr &process, ProcessList &source);
@@ -232,10 +332,25 @@ public:
 	void clearDisableWaitlist(DisableResult result,
 		boost::container::vector<Callback> &postLockActions);
 	void enableAllDisablingProcesses(boost::container::vector<Callback> &postLockActions);
+	bool shouldAttachAsStandby() const;
+	AttachResult attachAsStandby(const ProcessPtr &process,
+		boost::container::vector<Callback> &postLockActions);
+	bool canPromoteStandbyProcess() const;
+	bool shouldPromoteStandbyProcess() const;
+	void promoteStandbyProcess(boost::container::vector<Callback> &postLockActions);
+	void promoteStandbyProcess(const ProcessPtr &process,
+		boost::container::vector<Callback> &postLockActions);
 
 	void startCheckingDetachedProcesses(bool immediately);
 	void detachedProcessesCheckerMain(GroupPtr self);
 
+	/****** Demand forecasting ******/
+
+	unsigned int countEnabledSessions() const;
+	double getDemandForecastHorizon() const;
+	unsigned int calculatePredictedProcesses(double predictedSessions, int concurrency) const;
+	ProcessPtr findProcessToRetire(unsigned long long now) const;
+
 	/****** Out-of-band work ******/
 
 	bool oobwAllowed() const;
@@ -263,6 +378,7 @@ public:
 	unsigned int generateStickySessionId();
 	ProcessPtr createProcessObject(const Json::Value &json);
 	bool poolAtFullCapacity() const;
+	bool poolCountsStandbyProcesses() const;
 	ProcessPtr poolForceFreeCapacity(const Group *exclude, boost::container::vector<Callback> &postLockActions);
 	void wakeUpGarbageCollector();
 	bool anotherGroupIsWaitingForCapacity() const;
@@ -360,11 +476,48 @@ public:
 	ProcessList detachedProcesses;
 
 	/**
-	 * A cache of the processes' busyness. It's in a compact structure
-	 * so that `findProcessWithLowestBusyness()` can work very quickly
-	 * when there are a large number of processes.
+	 * Fully spawned processes that don't handle requests yet. They're
+	 * kept around so that the group can scale up without waiting for a
+	 * spawn. Up to `options.standbyProcesses` processes are parked here.
+	 * When `get()` would otherwise spawn a process, it promotes the last
+	 * process in this list to `enabledProcesses` instead, in constant time.
+	 *
+	 * Standby processes only count towards the pool's capacity when the
+	 * pool is configured so; see `standbyCapacityUsed()`.
+	 *
+	 * Invariants:
+	 *    standbyCount >= 0
+	 *    standbyProcesses.size() == standbyCount
+	 *
+	 *    for all process in standbyProcesses:
+	 *       process.enabled == Process::STANDBY
+	 *       process.isAlive()
+	 *       process.sessions == 0
+	 */
+	int standbyCount;
+	ProcessList standbyProcesses;
+	/** The number of times a standby process was promoted. */
+	unsigned int standbyPromotions;
+
+	/**
+	 * A cache of the enabled processes' busyness, indexed by their position
+	 * in `enabledProcesses`. It's a min-heap so that finding the least busy
+	 * enabled process takes constant time, and so that updating a process's
+	 * busyness doesn't take time proportional to the number of processes either.
+	 *
+	 *    for all 0 <= i < enabledProcesses.size():
+	 *       enabledProcessBusynessLevels.get(i) == enabledProcesses[i]->busyness()
 	 */
-	boost::container::vector<int> enabledProcessBusynessLevels;
+	IndexedMinHeap<int> enabledProcessBusynessLevels;
+
+	/**
+	 * Decides which enabled process a request is routed to. Recreated
+	 * whenever `options` is reset, so that it follows `options.routingPolicy`.
+	 *
+	 * Invariant:
+	 *    routingPolicy != NULL
+	 */
+	RoutingPolicyPtr routingPolicy;
 
 	/**
 	 * get() requests for this group that cannot be immediately satisfied are
@@ -474,11 +627,21 @@ public:
 	bool allEnabledProcessesAreTotallyBusy() const;
 
 	unsigned int capacityUsed() const;
+	unsigned int standbyCapacityUsed() const;
 	bool isWaitingForCapacity() const;
 	bool garbageCollectable(unsigned long long now = 0) const;
 
+	void inspectSpawnLatencyXml(std::ostream &stream) const;
 	void inspectXml(std::ostream &stream, bool includeSecrets = true) const;
 
+	/****** Demand forecasting ******/
+
+	void updateDemandForecast(unsigned long long now,
+		boost::container::vector<Callback> &postLockActions);
+	unsigned int getMinProcessesToKeep() const;
+	static const char *getDemandForecastDecisionString(DemandForecastDecision decision);
+	void inspectDemandForecastXml(std::ostream &stream) const;
+
 	/****** Out-of-band work ******/
 
 	void requestOOBW(const ProcessPtr &process);
@@ -0,0 +1,269 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2016 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#include <Core/ApplicationPool/Group.h>
+#include <cmath>
+
+/*************************************************************************
+ *
+ * Demand forecasting functions for ApplicationPool2::Group
+ *
+ *************************************************************************/
+
+namespace Passenger {
+namespace ApplicationPool2 {
+
+using namespace std;
+using namespace boost;
+
+
+/****************************
+ *
+ * Private methods
+ *
+ ****************************/
+
+
+unsigned int
+Group::countEnabledSessions() const {
+	ProcessList::const_iterator it, end = enabledProcesses.end();
+	unsigned int result = 0;
+
+	for (it = enabledProcesses.begin(); it != end; it++) {
+		result += (*it)->sessions;
+	}
+	return result;
+}
+
+/**
+ * How far ahead, in seconds, the forecast must look: a process that is
+ * spawned now only becomes available after the average spawn time, and the
+ * forecast is not revisited until the next forecast interval.
+ */
+double
+Group::getDemandForecastHorizon() const {
+	unsigned long long averageSpawnTime = 0;
+
+	if (spawnsCompleted > 0) {
+		averageSpawnTime = totalSpawnTime / spawnsCompleted;
+	}
+	return (averageSpawnTime + DEMAND_FORECAST_INTERVAL) / 1000000.0;
+}
+
+/**
+ * Calculates how many processes with the given concurrency are needed to
+ * handle the given number of concurrent sessions, within the group's and
+ * the pool's process limits.
+ */
+unsigned int
+Group::calculatePredictedProcesses(double predictedSessions, int concurrency) const {
+	unsigned int result = (unsigned int) ceil(predictedSessions / concurrency);
+	result = std::max<unsigned int>(result, options.minProcesses);
+	if (options.maxProcesses > 0) {
+		result = std::min<unsigned int>(result, options.maxProcesses);
+	}
+	return std::min(result, pool->max);
+}
+
+/**
+ * Returns the enabled process that has been idle for the longest time, if it
+ * has been idle for at least a forecast interval. Otherwise returns NULL.
+ */
+ProcessPtr
+Group::findProcessToRetire(unsigned long long now) const {
+	ProcessList::const_iterator it, end = enabledProcesses.end();
+	ProcessPtr result;
+
+	for (it = enabledProcesses.begin(); it != end; it++) {
+		const ProcessPtr &process = *it;
+		if (process->sessions == 0
+		 && process->lastUsed + DEMAND_FORECAST_INTERVAL <= now
+		 && (result == NULL || process->lastUsed < result->lastUsed))
+		{
+			result = process;
+		}
+	}
+	return result;
+}
+
+
+/****************************
+ *
+ * Public methods
+ *
+ ****************************/
+
+
+/**
+ * Updates the arrival rate statistics and forecasts how many processes this
+ * group needs by the time a newly spawned process would be ready.
+ *
+ * The forecast extrapolates the arrival rate along its smoothed trend, and
+ * scales the average number of open sessions by the predicted change in
+ * arrival rate (Little's law). If `options.predictiveScaling` is set, then a
+ * process is spawned (or a standby process is promoted) when the forecast
+ * calls for more processes than the group has, and an idle process is retired
+ * when it calls for fewer. At most one process is retired per forecast, so
+ * that capacity is given up gradually, and the last process is left to the
+ * garbage collector.
+ *
+ * Called by the pool every `DEMAND_FORECAST_INTERVAL`.
+ */
+void
+Group::updateDemandForecast(unsigned long long now,
+	boost::container::vector<Callback> &postLockActions)
+{
+	double rate, sessions, predictedSessions;
+
+	arrivalRateMeter.addSample(getActionsReceived, now);
+	rate = arrivalRateMeter.currentSpeed();
+	if (rate == arrivalRateMeter.unknownSpeed()) {
+		lastDemandForecastTime = 0;
+		predictedProcesses = 0;
+		lastDemandForecastDecision = DFD_NONE;
+		return;
+	}
+
+	if (lastDemandForecastTime != 0 && now > lastDemandForecastTime) {
+		arrivalRateTrend.update((rate - arrivalRate) * 1000000.0
+			/ (now - lastDemandForecastTime), now);
+	}
+	averageSessions.update(countEnabledSessions(), now);
+	arrivalRate = rate;
+	lastDemandForecastTime = now;
+
+	predictedArrivalRate = rate;
+	if (arrivalRateTrend.available()) {
+		predictedArrivalRate = std::max(0.0, rate
+			+ arrivalRateTrend.average() * getDemandForecastHorizon());
+	}
+	sessions = averageSessions.average();
+	if (rate > 0) {
+		predictedSessions = sessions * predictedArrivalRate / rate;
+	} else {
+		predictedSessions = sessions;
+	}
+	if (enabledCount == 0 || enabledProcesses[0]->getConcurrency() == 0) {
+		// Without a process to tell us its concurrency, or with processes
+		// that can handle any number of sessions, we can't tell how many
+		// processes are needed.
+		predictedProcesses = 0;
+		lastDemandForecastDecision = DFD_NONE;
+		return;
+	}
+	predictedProcesses = calculatePredictedProcesses(predictedSessions,
+		enabledProcesses[0]->getConcurrency());
+
+	if (!options.predictiveScaling) {
+		lastDemandForecastDecision = DFD_NONE;
+	} else if (restarting()) {
+		lastDemandForecastDecision = DFD_HOLD;
+	} else if (needsPredictedProcesses() && canPromoteStandbyProcess()) {
+		P_DEBUG("Demand forecast for group " << info.name << " calls for " <<
+			predictedProcesses << " processes; promoting a standby process");
+		promoteStandbyProcess(postLockActions);
+		predictiveSpawns++;
+		lastDemandForecastDecision = DFD_SPAWN;
+	} else if (needsPredictedProcesses() && allowSpawn()) {
+		P_DEBUG("Demand forecast for group " << info.name << " calls for " <<
+			predictedProcesses << " processes; spawning");
+		SpawnResult result = spawn();
+		if (result == SR_OK) {
+			predictiveSpawns++;
+		}
+		lastDemandForecastDecision = DFD_SPAWN;
+	} else if ((unsigned int) enabledCount > std::max(predictedProcesses, 1u)
+		&& getWaitlist.empty()
+		&& !m_spawning)
+	{
+		ProcessPtr process = findProcessToRetire(now);
+		if (process != NULL) {
+			P_DEBUG("Demand forecast for group " << info.name << " calls for " <<
+				predictedProcesses << " processes; retiring idle process " <<
+				process->inspect());
+			detach(process, postLockActions);
+			predictiveRetirements++;
+			lastDemandForecastDecision = DFD_RETIRE;
+		} else {
+			lastDemandForecastDecision = DFD_HOLD;
+		}
+	} else {
+		lastDemandForecastDecision = DFD_HOLD;
+	}
+}
+
+/**
+ * The number of processes that the garbage collector must keep alive. With
+ * predictive scaling, processes that the forecast calls for are kept even if
+ * they have been idle for longer than the max idle time.
+ */
+unsigned int
+Group::getMinProcessesToKeep() const {
+	if (options.predictiveScaling && predictedProcesses > options.minProcesses) {
+		return predictedProcesses;
+	} else {
+		return options.minProcesses;
+	}
+}
+
+const char *
+Group::getDemandForecastDecisionString(DemandForecastDecision decision) {
+	switch (decision) {
+	case DFD_NONE:
+		return "NONE";
+	case DFD_HOLD:
+		return "HOLD";
+	case DFD_SPAWN:
+		return "SPAWN";
+	case DFD_RETIRE:
+		return "RETIRE";
+	default:
+		return "UNKNOWN";
+	}
+}
+
+void
+Group::inspectDemandForecastXml(std::ostream &stream) const {
+	stream << "<demand_forecast>";
+	if (lastDemandForecastTime != 0) {
+		stream << "<arrival_rate>" << arrivalRate << "</arrival_rate>";
+		stream << "<predicted_arrival_rate>" << predictedArrivalRate << "</predicted_arrival_rate>";
+	}
+	if (arrivalRateTrend.available()) {
+		stream << "<arrival_rate_trend>" << arrivalRateTrend.average() << "</arrival_rate_trend>";
+	}
+	if (averageSessions.available()) {
+		stream << "<average_sessions>" << averageSessions.average() << "</average_sessions>";
+	}
+	stream << "<predicted_processes>" << predictedProcesses << "</predicted_processes>";
+	stream << "<last_decision>" << getDemandForecastDecisionString(lastDemandForecastDecision) << "</last_decision>";
+	stream << "<spawns>" << predictiveSpawns << "</spawns>";
+	stream << "<retirements>" << predictiveRetirements << "</retirements>";
+	stream << "</demand_forecast>";
+}
+
+
+} // namespace ApplicationPool2
+} // namespace Passenger
@@ -64,6 +64,7 @@ Group::shutdownCanFinish() const {
 		&& enabledCount == 0
 		&& disablingCount == 0
  		&& disabledCount == 0
+ 		&& standbyCount == 0
  		&& detachedProcesses.empty();
 }
 
@@ -108,16 +109,34 @@ Group::Group(Pool *_pool, const Options &_options)
 	enabledCount   = 0;
 	disablingCount = 0;
 	disabledCount  = 0;
+	standbyCount   = 0;
+	standbyPromotions = 0;
 	nEnabledProcessesTotallyBusy = 0;
 	spawner        = getContext()->getSpawningKitFactory()->create(options);
 	restartsInitiated = 0;
 	processesBeingSpawned = 0;
+	spawnLoopsActive = 0;
 	m_spawning     = false;
 	m_restarting   = false;
 	lifeStatus.store(ALIVE, boost::memory_order_relaxed);
 	lastRestartFileMtime = 0;
 	lastRestartFileCheckTime = 0;
 	alwaysRestartFileExists = false;
+	for (unsigned int i = 0; i < SPAWN_LATENCY_HISTOGRAM_BUCKETS; i++) {
+		spawnLatencyHistogram[i] = 0;
+	}
+	spawnsCompleted = 0;
+	totalSpawnTime = 0;
+	maxSpawnTime = 0;
+	getActionsReceived = 0;
+	arrivalRate = 0;
+	predictedArrivalRate = 0;
+	lastDemandForecastTime = 0;
+	predictedProcesses = 0;
+	lastDemandForecastDecision = DFD_NONE;
+	predictiveSpawns = 0;
+	predictiveRetirements = 0;
+	memoryRecycles = 0;
 	if (options.restartDir.empty()) {
 		restartFile = options.appRoot + "/tmp/restart.txt";
 		alwaysRestartFile = options.appRoot + "/tmp/always_restart.txt";
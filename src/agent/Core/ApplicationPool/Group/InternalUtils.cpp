@@ -77,6 +77,10 @@ Group::resetOptions(const Options &newOptions, Options *destination) {
 	destination->clearPerRequestFields();
 	destination->apiKey    = getApiKey().toStaticString();
 	destination->groupUuid = uuid;
+	if (destination == &this->options) {
+		routingPolicy = createRoutingPolicy(options.routingPolicy,
+			(boost::uint32_t) pool->getRandomGenerator()->generateInt());
+	}
 }
 
 /**
@@ -86,6 +90,11 @@ void
 Group::mergeOptions(const Options &other) {
 	options.maxRequests      = other.maxRequests;
 	options.minProcesses     = other.minProcesses;
+	options.spawnConcurrency = other.spawnConcurrency;
+	options.standbyProcesses = other.standbyProcesses;
+	options.predictiveScaling = other.predictiveScaling;
+	options.memoryLimit      = other.memoryLimit;
+	options.memoryLimitRecyclePercentage = other.memoryLimitRecyclePercentage;
 	options.statThrottleRate = other.statThrottleRate;
 	options.maxPreloaderIdleTime = other.maxPreloaderIdleTime;
 }
@@ -179,6 +188,11 @@ Group::poolAtFullCapacity() const {
 	return getPool()->atFullCapacityUnlocked();
 }
 
+bool
+Group::poolCountsStandbyProcesses() const {
+	return getPool()->countStandbyProcesses;
+}
+
 ProcessPtr
 Group::poolForceFreeCapacity(const Group *exclude,
 	boost::container::vector<Callback> &postLockActions)
@@ -58,26 +58,12 @@ Group::findProcessWithStickySessionId(unsigned int id) const {
 }
 
 Process *
-Group::findProcessWithStickySessionIdOrLowestBusyness(unsigned int id) const {
-	int leastBusyProcessIndex = -1;
-	int lowestBusyness = 0;
-	unsigned int i, size = enabledProcessBusynessLevels.size();
-	const int *enabledProcessBusynessLevels = &this->enabledProcessBusynessLevels[0];
-
-	for (i = 0; i < size; i++) {
-		Process *process = enabledProcesses[i].get();
-		if (process->getStickySessionId() == id) {
-			return process;
-		} else if (leastBusyProcessIndex == -1 || enabledProcessBusynessLevels[i] < lowestBusyness) {
-			leastBusyProcessIndex = i;
-			lowestBusyness = enabledProcessBusynessLevels[i];
-		}
-	}
-
-	if (leastBusyProcessIndex == -1) {
-		return NULL;
+Group::findProcessWithStickySessionIdOrSelectEnabledProcess(unsigned int id) const {
+	Process *process = findProcessWithStickySessionId(id);
+	if (process != NULL) {
+		return process;
 	} else {
-		return enabledProcesses[leastBusyProcessIndex].get();
+		return selectEnabledProcess();
 	}
 }
 
@@ -103,31 +89,21 @@ Group::findProcessWithLowestBusyness(const ProcessList &processes) const {
 }
 
 /**
- * Cache-optimized version of findProcessWithLowestBusyness() for the common case.
+ * Selects an enabled process according to the routing policy.
  */
 Process *
-Group::findEnabledProcessWithLowestBusyness() const {
+Group::selectEnabledProcess() const {
 	if (enabledProcesses.empty()) {
 		return NULL;
+	} else {
+		return routingPolicy->selectEnabledProcess(enabledProcesses,
+			enabledProcessBusynessLevels);
 	}
-
-	int leastBusyProcessIndex = -1;
-	int lowestBusyness = 0;
-	unsigned int i, size = enabledProcessBusynessLevels.size();
-	const int *enabledProcessBusynessLevels = &this->enabledProcessBusynessLevels[0];
-
-	for (i = 0; i < size; i++) {
-		if (leastBusyProcessIndex == -1 || enabledProcessBusynessLevels[i] < lowestBusyness) {
-			leastBusyProcessIndex = i;
-			lowestBusyness = enabledProcessBusynessLevels[i];
-		}
-	}
-	return enabledProcesses[leastBusyProcessIndex].get();
 }
 
 /**
- * Adds a process to the given list (enabledProcess, disablingProcesses, disabledProcesses)
- * and sets the process->enabled flag accordingly.
+ * Adds a process to the given list (enabledProcess, disablingProcesses, disabledProcesses,
+ * standbyProcesses, detachedProcesses) and sets the process->enabled flag accordingly.
  * The process must currently not be in any list. This function does not fix
  * getWaitlist invariants or other stuff.
  */
@@ -149,6 +125,10 @@ Group::addProcessToList(const ProcessPtr &process, ProcessList &destination) {
 		assert(process->sessions == 0);
 		process->enabled = Process::DISABLED;
 		disabledCount++;
+	} else if (&destination == &standbyProcesses) {
+		assert(process->sessions == 0);
+		process->enabled = Process::STANDBY;
+		standbyCount++;
 	} else if (&destination == &detachedProcesses) {
 		assert(process->isAlive());
 		process->enabled = Process::DETACHED;
@@ -166,14 +146,16 @@ Group::addProcessToList(const ProcessPtr &process, ProcessList &destination) {
 }
 
 /**
- * Removes a process to the given list (enabledProcess, disablingProcesses, disabledProcesses).
+ * Removes a process to the given list (enabledProcess, disablingProcesses, disabledProcesses,
+ * standbyProcesses, detachedProcesses). Removing the last process in a list takes constant time.
  * This function does not fix getWaitlist invariants or other stuff.
  */
 void
 Group::removeProcessFromList(const ProcessPtr &process, ProcessList &source) {
 	ProcessPtr p = process; // Keep an extra reference count just in case.
+	unsigned int index = process->getIndex();
 
-	source.erase(source.begin() + process->getIndex());
+	source.erase(source.begin() + index);
 	process->setIndex(-1);
 
 	switch (process->enabled) {
@@ -192,6 +174,10 @@ Group::removeProcessFromList(const ProcessPtr &process, ProcessList &source) {
 		assert(&source == &disabledProcesses);
 		disabledCount--;
 		break;
+	case Process::STANDBY:
+		assert(&source == &standbyProcesses);
+		standbyCount--;
+		break;
 	case Process::DETACHED:
 		assert(&source == &detachedProcesses);
 		break;
@@ -199,22 +185,16 @@ Group::removeProcessFromList(const ProcessPtr &process, ProcessList &source) {
 		P_BUG("Unknown 'enabled' state " << (int) process->enabled);
 	}
 
-	// Rebuild indices
+	// Rebuild the indices of the processes that came after it.
 	ProcessList::iterator it, end = source.end();
-	unsigned int i = 0;
-	for (it = source.begin(); it != end; it++, i++) {
+	unsigned int i = index;
+	for (it = source.begin() + index; it != end; it++, i++) {
 		const ProcessPtr &process = *it;
 		process->setIndex(i);
 	}
 
-	// Rebuild enabledProcessBusynessLevels
 	if (&source == &enabledProcesses) {
-		enabledProcessBusynessLevels.clear();
-		for (it = source.begin(); it != end; it++, i++) {
-			const ProcessPtr &process = *it;
-			enabledProcessBusynessLevels.push_back(process->busyness());
-		}
-		enabledProcessBusynessLevels.shrink_to_fit();
+		enabledProcessBusynessLevels.erase(index);
 	}
 }
 
@@ -270,6 +250,120 @@ Group::enableAllDisablingProcesses(boost::container::vector<Callback> &postLockA
 	clearDisableWaitlist(DR_ERROR, postLockActions);
 }
 
+/**
+ * Whether a process that was just spawned should be parked in `standbyProcesses`
+ * instead of being enabled: the group doesn't need it right now, and the
+ * standby list isn't full.
+ */
+bool
+Group::shouldAttachAsStandby() const {
+	return needsStandbyProcesses()
+		&& enabledCount > 0
+		&& getWaitlist.empty()
+		&& processLowerLimitsSatisfied()
+		&& !needsPredictedProcesses();
+}
+
+/**
+ * Attaches the given process to this Group as a standby process. Unlike
+ * `attach()`, this only checks the process limits if standby processes count
+ * towards the pool's capacity.
+ */
+AttachResult
+Group::attachAsStandby(const ProcessPtr &process,
+	boost::container::vector<Callback> &postLockActions)
+{
+	TRACE_POINT();
+	assert(process->getGroup() == NULL || process->getGroup() == this);
+	assert(process->isAlive());
+	assert(isAlive());
+
+	if (poolCountsStandbyProcesses()) {
+		if (processUpperLimitsReached()) {
+			return AR_GROUP_UPPER_LIMITS_REACHED;
+		} else if (poolAtFullCapacity()) {
+			return AR_POOL_AT_FULL_CAPACITY;
+		}
+	}
+
+	process->initializeStickySessionId(generateStickySessionId());
+	if (options.forceMaxConcurrentRequestsPerProcess != -1) {
+		process->forceMaxConcurrency(options.forceMaxConcurrentRequestsPerProcess);
+	}
+
+	P_DEBUG("Attaching process " << process->inspect() << " as standby process");
+	addProcessToList(process, standbyProcesses);
+	postLockActions.push_back(boost::bind(&Group::runAttachHooks, this, process));
+	return AR_OK;
+}
+
+/**
+ * Whether a standby process can be promoted right now. If standby processes
+ * don't count towards the pool's capacity, then promotion needs capacity just
+ * like spawning does.
+ */
+bool
+Group::canPromoteStandbyProcess() const {
+	return standbyCount > 0
+		&& (poolCountsStandbyProcesses() || allowSpawn());
+}
+
+/**
+ * Whether a standby process should be promoted in order to handle another
+ * get action, i.e. whether the group needs more capacity than its enabled
+ * processes provide.
+ */
+bool
+Group::shouldPromoteStandbyProcess() const {
+	return canPromoteStandbyProcess()
+		&& (
+			enabledCount == 0
+			|| allEnabledProcessesAreTotallyBusy()
+			|| !getWaitlist.empty()
+		);
+}
+
+/**
+ * Moves the most recently parked standby process to `enabledProcesses`,
+ * assigns sessions to any get waiters, and starts spawning a replacement
+ * standby process.
+ *
+ * @pre canPromoteStandbyProcess()
+ */
+void
+Group::promoteStandbyProcess(boost::container::vector<Callback> &postLockActions) {
+	assert(canPromoteStandbyProcess());
+	// Copy the pointer because promotion removes it from the list.
+	ProcessPtr process = standbyProcesses.back();
+	promoteStandbyProcess(process, postLockActions);
+}
+
+/**
+ * Like `promoteStandbyProcess(postLockActions)`, but promotes the given
+ * standby process. Does not check whether there is capacity for it.
+ */
+void
+Group::promoteStandbyProcess(const ProcessPtr &process,
+	boost::container::vector<Callback> &postLockActions)
+{
+	assert(process->enabled == Process::STANDBY);
+
+	P_DEBUG("Promoting standby process " << process->inspect());
+	removeProcessFromList(process, standbyProcesses);
+	// The process has been idle because it wasn't allowed to do anything,
+	// so don't let the garbage collector reap it right away.
+	process->lastUsed = SystemTime::getUsec();
+	addProcessToList(process, enabledProcesses);
+	standbyPromotions++;
+
+	if (!getWaitlist.empty()) {
+		assignSessionsToGetWaiters(postLockActions);
+	}
+	if (needsStandbyProcesses()) {
+		spawn();
+	}
+}
+
 /**
  * The `immediately` parameter only has effect if the detached processes checker
  * thread is active. It means that, if the thread is currently sleeping, it should
@@ -301,7 +395,7 @@ Group::detachedProcessesCheckerMain(GroupPtr self) {
 		debug->messages->recv("Proceed with starting detached processes checker");
 	}
 
-	boost::unique_lock<boost::mutex> lock(pool->syncher);
+	ScopedWriteLock lock(pool->syncher);
 	while (true) {
 		assert(detachedProcessesCheckerActive);
 
@@ -490,6 +584,9 @@ Group::detach(const ProcessPtr &process, boost::container::vector<Callback> &pos
 			removeProcessFromList(process, disablingProcesses);
 			removeFromDisableWaitlist(process, DR_NOOP, postLockActions);
 		}
+	} else if (process->enabled == Process::STANDBY) {
+		assert(!standbyProcesses.empty());
+		removeProcessFromList(process, standbyProcesses);
 	} else {
 		assert(process->enabled == Process::DISABLED);
 		assert(!disabledProcesses.empty());
@@ -520,14 +617,19 @@ Group::detachAll(boost::container::vector<Callback> &postLockActions) {
 	foreach (ProcessPtr process, disabledProcesses) {
 		addProcessToList(process, detachedProcesses);
 	}
+	foreach (ProcessPtr process, standbyProcesses) {
+		addProcessToList(process, detachedProcesses);
+	}
 
 	enabledProcesses.clear();
 	disablingProcesses.clear();
 	disabledProcesses.clear();
+	standbyProcesses.clear();
 	enabledProcessBusynessLevels.clear();
 	enabledCount = 0;
 	disablingCount = 0;
 	disabledCount = 0;
+	standbyCount = 0;
 	nEnabledProcessesTotallyBusy = 0;
 	clearDisableWaitlist(DR_NOOP, postLockActions);
 	startCheckingDetachedProcesses(false);
@@ -535,7 +637,8 @@ Group::detachAll(boost::container::vector<Callback> &postLockActions) {
 
 /**
  * Marks the given process as enabled. This function doesn't touch getWaitlist
- * so be sure to fix its invariants afterwards if necessary.
+ * so be sure to fix its invariants afterwards if necessary. The exception is
+ * a standby process, which is promoted, and that assigns sessions to get waiters.
  */
 void
 Group::enable(const ProcessPtr &process, boost::container::vector<Callback> &postLockActions) {
@@ -552,6 +655,14 @@ Group::enable(const ProcessPtr &process, boost::container::vector<Callback> &pos
 		P_DEBUG("Enabling DISABLED process " << process->inspect());
 		removeProcessFromList(process, disabledProcesses);
 		addProcessToList(process, enabledProcesses);
+	} else if (process->enabled == Process::STANDBY) {
+		if (canPromoteStandbyProcess()) {
+			P_DEBUG("Enabling STANDBY process " << process->inspect());
+			promoteStandbyProcess(process, postLockActions);
+		} else {
+			P_DEBUG("Not enabling STANDBY process " << process->inspect() <<
+				" because that would exceed the process limits");
+		}
 	} else {
 		P_DEBUG("Enabling ENABLED process " << process->inspect());
 	}
@@ -605,6 +716,13 @@ Group::disable(const ProcessPtr &process, const DisableCallback &callback) {
 		P_DEBUG("Disabling DISABLING process " << process->inspect() <<
 			info.name << "; command queued, deferring disable command completion");
 		return DR_DEFERRED;
+	} else if (process->enabled == Process::STANDBY) {
+		// Moving a standby process to `disabledProcesses` could make the
+		// pool exceed its capacity, because disabled processes are always
+		// counted. `Pool::disableProcess()` detaches standby processes instead.
+		P_WARN("Cannot disable STANDBY process " << process->inspect() <<
+			"; it must be detached instead");
+		return DR_ERROR;
 	} else {
 		assert(disabledCount > 0);
 		P_DEBUG("Disabling DISABLED process " << process->inspect() <<
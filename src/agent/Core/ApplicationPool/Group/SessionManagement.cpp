@@ -49,7 +49,8 @@ using namespace boost;
  * is guaranteed to be `canBeRoutedTo()`, i.e. not totally busy.
  *
  * A request is routed to an enabled processes, or if there are none,
- * from a disabling process. The rationale is as follows:
+ * from a disabling process. Which enabled process is decided by the
+ * routing policy, unless the request has a sticky session ID. The rationale is as follows:
  * If there are no enabled process, then waiting for one to spawn is too
  * expensive. The next best thing is to route to disabling processes
  * until more processes have been spawned.
@@ -58,14 +59,14 @@ Group::RouteResult
 Group::route(const Options &options) const {
 	if (OXT_LIKELY(enabledCount > 0)) {
 		if (options.stickySessionId == 0) {
-			Process *process = findEnabledProcessWithLowestBusyness();
+			Process *process = selectEnabledProcess();
 			if (process->canBeRoutedTo()) {
 				return RouteResult(process);
 			} else {
 				return RouteResult(NULL, true);
 			}
 		} else {
-			Process *process = findProcessWithStickySessionIdOrLowestBusyness(
+			Process *process = findProcessWithStickySessionIdOrSelectEnabledProcess(
 				options.stickySessionId);
 			if (process != NULL) {
 				if (process->canBeRoutedTo()) {
@@ -94,7 +95,7 @@ Group::newSession(Process *process, unsigned long long now) {
 	session->onInitiateFailure = _onSessionInitiateFailure;
 	session->onClose   = _onSessionClose;
 	if (process->enabled == Process::ENABLED) {
-		enabledProcessBusynessLevels[process->getIndex()] = process->busyness();
+		enabledProcessBusynessLevels.set(process->getIndex(), process->busyness());
 		if (!wasTotallyBusy && process->isTotallyBusy()) {
 			nEnabledProcessesTotallyBusy++;
 		}
@@ -102,6 +103,76 @@ Group::newSession(Process *process, unsigned long long now) {
 	return session;
 }
 
+/* The fast path of Pool::asyncGet(). Checks out a session while only holding
+ * the pool lock in shared mode, plus `sessionSyncher`. This is only possible
+ * when doing so would not change anything but session statistics: the group
+ * must not need a restart check, must not want to spawn, and must have an
+ * enabled process that can be routed to right away. Otherwise, returns NULL
+ * and the caller should retry with the pool lock held exclusively.
+ */
+SessionPtr
+Group::getWithSharedPoolLock(const Options &newOptions) {
+	boost::lock_guard<boost::mutex> l(sessionSyncher);
+
+	if (OXT_UNLIKELY(!isAlive()
+		|| restarting()
+		|| newOptions.noop
+		|| enabledCount == 0
+		|| restartCheckDue(newOptions)))
+	{
+		return SessionPtr();
+	}
+
+	mergeOptions(newOptions);
+	if (OXT_UNLIKELY(shouldSpawnForGetAction())) {
+		return SessionPtr();
+	}
+
+	RouteResult result = route(newOptions);
+	if (OXT_UNLIKELY(result.process == NULL)) {
+		return SessionPtr();
+	}
+
+	P_DEBUG("Session checked out from process " << result.process->inspect());
+	SessionPtr session = newSession(result.process, newOptions.currentTime);
+	getActionsReceived++;
+	verifyInvariants();
+	return session;
+}
+
+/* The fast path of onSessionClose(). Updates the statistics while only holding
+ * the pool lock in shared mode, plus `sessionSyncher`, if it can be predicted
+ * that closing the session will not trigger anything else: no detaching, no
+ * disabling, no out-of-band work and no get waiters to wake up.
+ * Returns whether the session was closed.
+ */
+bool
+Group::closeSessionWithSharedPoolLock(Process *process, Session *session) {
+	boost::lock_guard<boost::mutex> l(sessionSyncher);
+
+	if (OXT_UNLIKELY(process->enabled != Process::ENABLED
+		|| !isAlive()
+		|| !getWaitlist.empty()
+		|| process->oobwStatus == Process::OOBW_REQUESTED
+		|| (options.maxRequests > 0 && process->processed + 1 >= options.maxRequests)
+		|| (process->sessions == 1
+			&& (!getPool()->getWaitlist.empty() || anotherGroupIsWaitingForCapacity()))))
+	{
+		return false;
+	}
+
+	P_TRACE(2, "Session closed for process " << process->inspect());
+	bool wasTotallyBusy = process->isTotallyBusy();
+	process->sessionClosed(session);
+	enabledProcessBusynessLevels.set(process->getIndex(), process->busyness());
+	if (wasTotallyBusy) {
+		assert(nEnabledProcessesTotallyBusy >= 1);
+		nEnabledProcessesTotallyBusy--;
+	}
+	verifyInvariants();
+	return true;
+}
+
 void
 Group::_onSessionInitiateFailure(Session *session) {
 	Process *process = session->getProcess();
@@ -123,7 +194,7 @@ Group::onSessionInitiateFailure(Process *process, Session *session) {
 	TRACE_POINT();
 	// Standard resource management boilerplate stuff...
 	Pool *pool = getPool();
-	boost::unique_lock<boost::mutex> lock(pool->syncher);
+	ScopedWriteLock lock(pool->syncher);
 	assert(process->isAlive());
 	assert(isAlive() || getLifeStatus() == SHUTTING_DOWN);
 
@@ -141,9 +212,16 @@ Group::onSessionInitiateFailure(Process *process, Session *session) {
 OXT_FORCE_INLINE void
 Group::onSessionClose(Process *process, Session *session) {
 	TRACE_POINT();
-	// Standard resource management boilerplate stuff...
 	Pool *pool = getPool();
-	boost::unique_lock<boost::mutex> lock(pool->syncher);
+	{
+		ScopedReadLock readLock(pool->syncher);
+		if (OXT_LIKELY(closeSessionWithSharedPoolLock(process, session))) {
+			return;
+		}
+	}
+
+	// Standard resource management boilerplate stuff...
+	ScopedWriteLock lock(pool->syncher);
 	assert(process->isAlive());
 	assert(isAlive() || getLifeStatus() == SHUTTING_DOWN);
 
@@ -159,7 +237,7 @@ Group::onSessionClose(Process *process, Session *session) {
 		|| process->enabled == Process::DISABLING
 		|| process->enabled == Process::DETACHED);
 	if (process->enabled == Process::ENABLED) {
-		enabledProcessBusynessLevels[process->getIndex()] = process->busyness();
+		enabledProcessBusynessLevels.set(process->getIndex(), process->busyness());
 		if (wasTotallyBusy) {
 			assert(nEnabledProcessesTotallyBusy >= 1);
 			nEnabledProcessesTotallyBusy--;
@@ -264,7 +342,11 @@ Group::get(const Options &newOptions, const GetCallback &callback,
 		} else {
 			mergeOptions(newOptions);
 		}
-		if (OXT_UNLIKELY(!newOptions.noop && shouldSpawnForGetAction())) {
+		if (OXT_UNLIKELY(!newOptions.noop && shouldPromoteStandbyProcess())) {
+			// A standby process can serve right away, so we prefer that
+			// over spawning a new process.
+			promoteStandbyProcess(postLockActions);
+		} else if (OXT_UNLIKELY(!newOptions.noop && shouldSpawnForGetAction())) {
 			// If we're trying to spawn the first process for this group, and
 			// spawning failed because the pool is at full capacity, then we
 			// try to kill some random idle process in the pool and try again.
@@ -288,6 +370,8 @@ Group::get(const Options &newOptions, const GetCallback &callback,
 		return nullProcess->createSessionObject((Socket *) NULL);
 	}
 
+	getActionsReceived++;
+
 	if (OXT_UNLIKELY(enabledCount == 0)) {
 		/* We don't have any processes yet, but they're on the way.
 		 *
@@ -91,6 +91,7 @@ Group::spawnThreadRealMain(const SpawningKit::SpawnerPtr &spawner,
 
 		ProcessPtr process;
 		ExceptionPtr exception;
+		unsigned long long spawnStartTime = SystemTime::getUsec();
 		try {
 			UPDATE_TRACE_POINT();
 			this_thread::restore_interruption ri(di);
@@ -112,7 +113,7 @@ Group::spawnThreadRealMain(const SpawningKit::SpawnerPtr &spawner,
 
 		UPDATE_TRACE_POINT();
 		ScopeGuard guard(boost::bind(Process::forceTriggerShutdownAndCleanup, process));
-		boost::unique_lock<boost::mutex> lock(pool->syncher);
+		ScopedWriteLock lock(pool->syncher);
 
 		if (!isAlive()) {
 			if (process != NULL) {
@@ -143,14 +144,21 @@ Group::spawnThreadRealMain(const SpawningKit::SpawnerPtr &spawner,
 		verifyInvariants();
 		assert(m_spawning);
 		assert(processesBeingSpawned > 0);
+		assert(spawnLoopsActive > 0);
 
 		processesBeingSpawned--;
-		assert(processesBeingSpawned == 0);
+		assert(processesBeingSpawned < spawnLoopsActive);
 
 		UPDATE_TRACE_POINT();
 		boost::container::vector<Callback> actions;
 		if (process != NULL) {
-			AttachResult result = attach(process, actions);
+			recordSpawnLatency(SystemTime::getUsec() - spawnStartTime);
+			AttachResult result;
+			if (shouldAttachAsStandby()) {
+				result = attachAsStandby(process, actions);
+			} else {
+				result = attach(process, actions);
+			}
 			if (result == AR_OK) {
 				guard.clear();
 				if (getWaitlist.empty()) {
@@ -159,6 +167,7 @@ Group::spawnThreadRealMain(const SpawningKit::SpawnerPtr &spawner,
 					assignSessionsToGetWaiters(actions);
 				}
 				P_DEBUG("New process count = " << enabledCount <<
+					", standby process count = " << standbyCount <<
 					", remaining get waiters = " << getWaitlist.size());
 			} else {
 				done = true;
@@ -173,17 +182,30 @@ Group::spawnThreadRealMain(const SpawningKit::SpawnerPtr &spawner,
 			if (enabledCount == 0) {
 				enableAllDisablingProcesses(actions);
 			}
-			Pool::assignExceptionToGetWaiters(getWaitlist, exception, actions);
+			// Other spawn loops or enabled processes may still serve the
+			// get waiters, so only fail them if there is nothing left to
+			// wait for.
+			if (spawnLoopsActive == 1 && enabledCount == 0) {
+				Pool::assignExceptionToGetWaiters(getWaitlist, exception, actions);
+			} else {
+				P_DEBUG("Leaving " << getWaitlist.size() << " get waiters queued " <<
+					"because other spawn loops or enabled processes may serve them");
+			}
 			pool->assignSessionsToGetWaiters(actions);
 			done = true;
 		}
 
+		// If other spawn loops are working too, then this one only
+		// continues if there is enough work left for all of them.
 		done = done
-			|| (processLowerLimitsSatisfied() && getWaitlist.empty())
+			|| (processLowerLimitsSatisfied() && getWaitlist.empty()
+				&& !needsStandbyProcesses() && !needsPredictedProcesses())
 			|| processUpperLimitsReached()
-			|| pool->atFullCapacityUnlocked();
-		m_spawning = !done;
+			|| pool->atFullCapacityUnlocked()
+			|| (spawnLoopsActive > 1 && !needsParallelSpawning());
 		if (done) {
+			spawnLoopsActive--;
+			m_spawning = spawnLoopsActive > 0;
 			P_DEBUG("Spawn loop done");
 		} else {
 			processesBeingSpawned++;
@@ -203,6 +225,79 @@ Group::spawnThreadRealMain(const SpawningKit::SpawnerPtr &spawner,
 	}
 }
 
+void
+Group::startSpawnLoop() {
+	interruptableThreads.create_thread(
+		boost::bind(&Group::spawnThreadMain,
+			this, shared_from_this(), spawner,
+			options.copyAndPersist().clearPerRequestFields(),
+			restartsInitiated),
+		"Group process spawner: " + info.name,
+		POOL_HELPER_THREAD_STACK_SIZE);
+	m_spawning = true;
+	processesBeingSpawned++;
+	spawnLoopsActive++;
+}
+
+/**
+ * Whether there is enough work to keep more than one spawn loop busy: the
+ * lower process limits aren't satisfied yet, or more requests are waiting
+ * than there are processes being spawned.
+ */
+bool
+Group::needsParallelSpawning() const {
+	return !processLowerLimitsSatisfied()
+		|| getWaitlist.size() > (unsigned int) processesBeingSpawned
+		|| needsPredictedProcesses();
+}
+
+/**
+ * Whether another spawn loop should be started next to the ones that
+ * are already working.
+ */
+bool
+Group::shouldSpawnInParallel() const {
+	return (unsigned int) spawnLoopsActive < std::max(options.spawnConcurrency, 1u)
+		&& allowSpawn()
+		&& needsParallelSpawning();
+}
+
+/**
+ * Whether the standby list has room for more processes. Spawn loops keep
+ * running until it's full, once the group's other needs are satisfied.
+ */
+bool
+Group::needsStandbyProcesses() const {
+	return (unsigned int) standbyCount < options.standbyProcesses;
+}
+
+/**
+ * Whether the last demand forecast calls for more enabled processes than
+ * the group has or is spawning. See `updateDemandForecast()`.
+ */
+bool
+Group::needsPredictedProcesses() const {
+	return options.predictiveScaling
+		&& (unsigned int) (enabledCount + processesBeingSpawned) < predictedProcesses;
+}
+
+void
+Group::recordSpawnLatency(unsigned long long usec) {
+	unsigned int i;
+
+	for (i = 0; i < SPAWN_LATENCY_HISTOGRAM_BUCKETS - 1; i++) {
+		if (usec <= (100000ull << i)) {
+			break;
+		}
+	}
+	spawnLatencyHistogram[i]++;
+	spawnsCompleted++;
+	totalSpawnTime += usec;
+	if (usec > maxSpawnTime) {
+		maxSpawnTime = usec;
+	}
+}
+
 // The 'self' parameter is for keeping the current Group object alive while this thread is running.
 void
 Group::finalizeRestart(GroupPtr self,
@@ -238,7 +333,7 @@ Group::finalizeRestart(GroupPtr self,
 		debug->messages->recv("Finish restarting");
 	}
 
-	ScopedLock l(pool->syncher);
+	ScopedWriteLock l(pool->syncher);
 	if (!isAlive()) {
 		P_DEBUG("Group " << getName() << " is shutting down, so aborting restart");
 		return;
@@ -307,6 +402,7 @@ Group::restart(const Options &options, RestartMethod method) {
 	restartsInitiated++;
 
 	processesBeingSpawned = 0;
+	spawnLoopsActive = 0;
 	m_spawning   = false;
 	m_restarting = true;
 	uuid         = generateUuid(pool);
@@ -408,15 +504,40 @@ Group::needsRestart(const Options &options) {
 }
 
 /**
- * Attempts to increase the number of processes by one, while respecting the
+ * Whether `needsRestart()` would stat the restart files if it were called
+ * right now. Unlike `needsRestart()` this has no side effects, so it can be
+ * used by code that only holds the pool lock in shared mode, in order to
+ * decide whether it must fall back to code that holds it exclusively.
+ */
+bool
+Group::restartCheckDue(const Options &options) const {
+	time_t now;
+
+	if (alwaysRestartFileExists || lastRestartFileCheckTime == 0) {
+		return true;
+	}
+	if (options.currentTime != 0) {
+		now = options.currentTime / 1000000;
+	} else {
+		now = SystemTime::get();
+	}
+	return lastRestartFileCheckTime <= now - (time_t) options.statThrottleRate;
+}
+
+/**
+ * Attempts to increase the number of processes, while respecting the
  * resource limits. That is, this method will ensure that there are at least
  * `minProcesses` processes, but no more than `maxProcesses` processes, and no
  * more than `pool->max` processes in the entire pool.
+ *
+ * Up to `options.spawnConcurrency` spawn loops are started, as long as
+ * there is enough work for them (see `needsParallelSpawning()`). If the
+ * maximum number of loops is already working, then SR_IN_PROGRESS is returned.
  */
 SpawnResult
 Group::spawn() {
 	assert(isAlive());
-	if (m_spawning) {
+	if (m_spawning && !shouldSpawnInParallel()) {
 		return SR_IN_PROGRESS;
 	} else if (restarting()) {
 		return SR_ERR_RESTARTING;
@@ -426,15 +547,9 @@ Group::spawn() {
 		return SR_ERR_POOL_AT_FULL_CAPACITY;
 	} else {
 		P_DEBUG("Requested spawning of new process for group " << info.name);
-		interruptableThreads.create_thread(
-			boost::bind(&Group::spawnThreadMain,
-				this, shared_from_this(), spawner,
-				options.copyAndPersist().clearPerRequestFields(),
-				restartsInitiated),
-			"Group process spawner: " + info.name,
-			POOL_HELPER_THREAD_STACK_SIZE);
-		m_spawning = true;
-		processesBeingSpawned++;
+		do {
+			startSpawnLoop();
+		} while (shouldSpawnInParallel());
 		return SR_OK;
 	}
 }
@@ -57,7 +57,8 @@ Group::getProcessCount() const {
  */
 bool
 Group::processLowerLimitsSatisfied() const {
-	return capacityUsed() >= options.minProcesses;
+	// Standby processes don't handle requests, so they don't count here.
+	return capacityUsed() - standbyCapacityUsed() >= options.minProcesses;
 }
 
 /**
@@ -86,7 +87,21 @@ Group::allEnabledProcessesAreTotallyBusy() const {
  */
 unsigned int
 Group::capacityUsed() const {
-	return enabledCount + disablingCount + disabledCount + processesBeingSpawned;
+	return enabledCount + disablingCount + disabledCount + processesBeingSpawned
+		+ standbyCapacityUsed();
+}
+
+/**
+ * Returns the part of `capacityUsed()` that is taken by standby processes.
+ * This is 0 unless the pool is configured to count standby processes.
+ */
+unsigned int
+Group::standbyCapacityUsed() const {
+	if (poolCountsStandbyProcesses()) {
+		return standbyCount;
+	} else {
+		return 0;
+	}
 }
 
 /**
@@ -115,6 +130,25 @@ Group::garbageCollectable(unsigned long long now) const {
 	return false;
 }
 
+void
+Group::inspectSpawnLatencyXml(std::ostream &stream) const {
+	stream << "<spawn_latency>";
+	stream << "<spawns_completed>" << spawnsCompleted << "</spawns_completed>";
+	stream << "<total_time>" << totalSpawnTime << "</total_time>";
+	stream << "<max_time>" << maxSpawnTime << "</max_time>";
+	stream << "<histogram>";
+	for (unsigned int i = 0; i < SPAWN_LATENCY_HISTOGRAM_BUCKETS; i++) {
+		stream << "<bucket>";
+		if (i < SPAWN_LATENCY_HISTOGRAM_BUCKETS - 1) {
+			stream << "<max_time>" << (100000ull << i) << "</max_time>";
+		}
+		stream << "<spawns>" << spawnLatencyHistogram[i] << "</spawns>";
+		stream << "</bucket>";
+	}
+	stream << "</histogram>";
+	stream << "</spawn_latency>";
+}
+
 void
 Group::inspectXml(std::ostream &stream, bool includeSecrets) const {
 	ProcessList::const_iterator it;
@@ -128,13 +162,19 @@ Group::inspectXml(std::ostream &stream, bool includeSecrets) const {
 	stream << "<enabled_process_count>" << enabledCount << "</enabled_process_count>";
 	stream << "<disabling_process_count>" << disablingCount << "</disabling_process_count>";
 	stream << "<disabled_process_count>" << disabledCount << "</disabled_process_count>";
+	stream << "<standby_process_count>" << standbyCount << "</standby_process_count>";
+	stream << "<standby_promotions>" << standbyPromotions << "</standby_promotions>";
+	stream << "<memory_recycles>" << memoryRecycles << "</memory_recycles>";
 	stream << "<capacity_used>" << capacityUsed() << "</capacity_used>";
 	stream << "<get_wait_list_size>" << getWaitlist.size() << "</get_wait_list_size>";
 	stream << "<disable_wait_list_size>" << disableWaitlist.size() << "</disable_wait_list_size>";
 	stream << "<processes_being_spawned>" << processesBeingSpawned << "</processes_being_spawned>";
+	stream << "<spawn_loops_active>" << spawnLoopsActive << "</spawn_loops_active>";
 	if (m_spawning) {
 		stream << "<spawning/>";
 	}
+	inspectSpawnLatencyXml(stream);
+	inspectDemandForecastXml(stream);
 	if (restarting()) {
 		stream << "<restarting/>";
 	}
@@ -184,6 +224,11 @@ Group::inspectXml(std::ostream &stream, bool includeSecrets) const {
 		(*it)->inspectXml(stream, includeSecrets);
 		stream << "</process>";
 	}
+	for (it = standbyProcesses.begin(); it != standbyProcesses.end(); it++) {
+		stream << "<process>";
+		(*it)->inspectXml(stream, includeSecrets);
+		stream << "</process>";
+	}
 	for (it = detachedProcesses.begin(); it != detachedProcesses.end(); it++) {
 		stream << "<process>";
 		(*it)->inspectXml(stream, includeSecrets);
@@ -63,6 +63,7 @@ Group::verifyInvariants() const {
 	assert(enabledCount >= 0);
 	assert(disablingCount >= 0);
 	assert(disabledCount >= 0);
+	assert(standbyCount >= 0);
 	assert(nEnabledProcessesTotallyBusy >= 0);
 	assert(!( enabledCount == 0 && disablingCount > 0 ) || ( processesBeingSpawned > 0) );
 	assert(!( !m_spawning ) || ( enabledCount > 0 || disablingCount == 0 ));
@@ -77,8 +78,10 @@ Group::verifyInvariants() const {
 	// Verify disableWaitlist invariants.
 	assert((int) disableWaitlist.size() >= disablingCount);
 
-	// Verify processesBeingSpawned, m_spawning and m_restarting.
+	// Verify processesBeingSpawned, spawnLoopsActive, m_spawning and m_restarting.
 	assert(!( processesBeingSpawned > 0 ) || ( m_spawning ));
+	assert(processesBeingSpawned <= spawnLoopsActive);
+	assert(m_spawning == (spawnLoopsActive > 0));
 	assert(!( m_restarting ) || ( processesBeingSpawned == 0 ));
 
 	// Verify lifeStatus.
@@ -86,6 +89,7 @@ Group::verifyInvariants() const {
 		assert(enabledCount == 0);
 		assert(disablingCount == 0);
 		assert(disabledCount == 0);
+		assert(standbyCount == 0);
 		assert(nEnabledProcessesTotallyBusy == 0);
 	}
 
@@ -93,7 +97,10 @@ Group::verifyInvariants() const {
 	assert((int) enabledProcesses.size() == enabledCount);
 	assert((int) disablingProcesses.size() == disablingCount);
 	assert((int) disabledProcesses.size() == disabledCount);
+	assert((int) standbyProcesses.size() == standbyCount);
+	assert((int) enabledProcessBusynessLevels.size() == enabledCount);
 	assert(nEnabledProcessesTotallyBusy <= enabledCount);
+	assert(routingPolicy != NULL);
 	#endif
 }
 
@@ -115,6 +122,7 @@ Group::verifyExpensiveInvariants() const {
 		assert(process->isAlive());
 		assert(process->oobwStatus == Process::OOBW_NOT_ACTIVE
 			|| process->oobwStatus == Process::OOBW_REQUESTED);
+		assert(enabledProcessBusynessLevels.get(process->getIndex()) == process->busyness());
 	}
 
 	end = disablingProcesses.end();
@@ -135,6 +143,14 @@ Group::verifyExpensiveInvariants() const {
 			|| process->oobwStatus == Process::OOBW_IN_PROGRESS);
 	}
 
+	end = standbyProcesses.end();
+	for (it = standbyProcesses.begin(); it != end; it++) {
+		const ProcessPtr &process = *it;
+		assert(process->enabled == Process::STANDBY);
+		assert(process->isAlive());
+		assert(process->sessions == 0);
+	}
+
 	foreach (const ProcessPtr &process, detachedProcesses) {
 		assert(process->enabled == Process::DETACHED);
 	}
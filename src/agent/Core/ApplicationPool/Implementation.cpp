@@ -49,6 +49,7 @@
 #include <Core/ApplicationPool/Pool/InitializationAndShutdown.cpp>
 #include <Core/ApplicationPool/Pool/AnalyticsCollection.cpp>
 #include <Core/ApplicationPool/Pool/GarbageCollection.cpp>
+#include <Core/ApplicationPool/Pool/DemandForecasting.cpp>
 #include <Core/ApplicationPool/Pool/GeneralUtils.cpp>
 #include <Core/ApplicationPool/Pool/GroupUtils.cpp>
 #include <Core/ApplicationPool/Pool/ProcessUtils.cpp>
@@ -60,6 +61,7 @@
 #include <Core/ApplicationPool/Group/SpawningAndRestarting.cpp>
 #include <Core/ApplicationPool/Group/ProcessListManagement.cpp>
 #include <Core/ApplicationPool/Group/OutOfBandWork.cpp>
+#include <Core/ApplicationPool/Group/DemandForecasting.cpp>
 #include <Core/ApplicationPool/Group/Miscellaneous.cpp>
 #include <Core/ApplicationPool/Group/InternalUtils.cpp>
 #include <Core/ApplicationPool/Group/StateInspection.cpp>
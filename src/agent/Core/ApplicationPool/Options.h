@@ -117,6 +117,7 @@ private:
 		result.push_back(&options.hostName);
 		result.push_back(&options.uri);
 		result.push_back(&options.unionStationKey);
+		result.push_back(&options.routingPolicy);
 
 		return result;
 	}
@@ -353,6 +354,46 @@ public:
 	 */
 	unsigned int maxOutOfBandWorkInstances;
 
+	/**
+	 * The maximum number of processes that the group may be spawning at
+	 * the same time. Spawning still respects `maxProcesses` and the pool's
+	 * capacity.
+	 *
+	 * A value of 0 is treated as 1.
+	 */
+	unsigned int spawnConcurrency;
+
+	/**
+	 * The number of fully spawned processes that the group keeps on standby,
+	 * so that it can scale up without waiting for a spawn. Standby processes
+	 * don't handle requests until they're promoted. See
+	 * `Group::standbyProcesses`.
+	 */
+	unsigned int standbyProcesses;
+
+	/**
+	 * Whether the pool spawns and retires processes for this group ahead of
+	 * the demand that it predicts from the group's request arrival rate,
+	 * within `minProcesses` and `maxProcesses`. See
+	 * `Group::updateDemandForecast()`.
+	 */
+	bool predictiveScaling;
+
+	/**
+	 * The maximum amount of memory, in MB, that a process may use before it's
+	 * recycled: it stops receiving new sessions, finishes the sessions it
+	 * has, and is replaced by a new process. A value of 0 means unlimited.
+	 * Memory usage is checked by the pool's analytics collector.
+	 */
+	unsigned int memoryLimit;
+
+	/**
+	 * The maximum percentage of the group's processes that may be recycled
+	 * because of `memoryLimit` at the same time. At least one process may
+	 * always be recycled.
+	 */
+	unsigned int memoryLimitRecyclePercentage;
+
 	/**
 	 * The maximum number of requests that may live in the Group.getWaitlist queue.
 	 * A value of 0 means unlimited.
@@ -365,6 +406,13 @@ public:
 	 */
 	bool abortWebsocketsOnProcessShutdown;
 
+	/**
+	 * The name of the policy that decides which process a request is
+	 * routed to: "least-busy", "power-of-two-choices" or "ewma-latency".
+	 * See RoutingPolicy.h.
+	 */
+	StaticString routingPolicy;
+
 	/**
 	 * The Union Station key to use in case analytics logging is enabled.
 	 * It is used by Pool::collectAnalytics() and other administrative
@@ -487,8 +535,14 @@ public:
 		  maxProcesses(0),
 		  maxPreloaderIdleTime(-1),
 		  maxOutOfBandWorkInstances(1),
+		  spawnConcurrency(DEFAULT_SPAWN_CONCURRENCY),
+		  standbyProcesses(0),
+		  predictiveScaling(false),
+		  memoryLimit(0),
+		  memoryLimitRecyclePercentage(DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE),
 		  maxRequestQueueSize(100),
 		  abortWebsocketsOnProcessShutdown(true),
+		  routingPolicy(DEFAULT_ROUTING_POLICY, sizeof(DEFAULT_ROUTING_POLICY) - 1),
 
 		  stickySessionId(0),
 		  statThrottleRate(DEFAULT_STAT_THROTTLE_RATE),
@@ -569,6 +623,27 @@ public:
 		return detachFromUnionStationTransaction();
 	}
 
+	/**
+	 * Restores the fields that the Core may override on a per-request basis
+	 * to their values in `base`, which must be the Options object that this
+	 * one was last assigned from. All other fields still equal those in `base`,
+	 * so this is equivalent to `*this = base`, but much cheaper: it copies
+	 * only a handful of fields and leaves the string storage alone.
+	 */
+	Options &restorePerRequestFields(const Options &base) {
+		environmentVariables = base.environmentVariables;
+		maxRequests     = base.maxRequests;
+		analytics       = base.analytics;
+		unionStationKey = base.unionStationKey;
+		hostName        = base.hostName;
+		uri             = base.uri;
+		stickySessionId = base.stickySessionId;
+		currentTime     = base.currentTime;
+		noop            = base.noop;
+		transaction     = base.transaction;
+		return *this;
+	}
+
 	Options &detachFromUnionStationTransaction() {
 		transaction.reset();
 		return *this;
@@ -626,6 +701,12 @@ public:
 			appendKeyValue3(vec, "max_processes",       maxProcesses);
 			appendKeyValue2(vec, "max_preloader_idle_time", maxPreloaderIdleTime);
 			appendKeyValue3(vec, "max_out_of_band_work_instances", maxOutOfBandWorkInstances);
+			appendKeyValue3(vec, "spawn_concurrency",   spawnConcurrency);
+			appendKeyValue3(vec, "standby_processes",   standbyProcesses);
+			appendKeyValue4(vec, "predictive_scaling",  predictiveScaling);
+			appendKeyValue3(vec, "memory_limit",        memoryLimit);
+			appendKeyValue3(vec, "memory_limit_recycle_percentage", memoryLimitRecyclePercentage);
+			appendKeyValue (vec, "routing_policy",      routingPolicy);
 		}
 		if ((fields & SPAWN_OPTIONS) || (fields & PER_GROUP_POOL_OPTIONS)) {
 			appendKeyValue (vec, "union_station_key",   unionStationKey);
@@ -52,6 +52,7 @@
 #include <Exceptions.h>
 #include <Hooks.h>
 #include <Utils/Lock.h>
+#include <Utils/ReadWriteLock.h>
 #include <Utils/AnsiColorConstants.h>
 #include <Utils/SystemTime.h>
 #include <Utils/MessagePassing.h>
@@ -158,9 +159,27 @@ public:
 	friend class Process;
 	friend struct tut::ApplicationPool2_PoolTest;
 
-	mutable boost::mutex syncher;
+	/**
+	 * Protects the pool and all of its groups, processes and sockets.
+	 *
+	 * Anything that changes the structure of the pool (adding or removing
+	 * groups or processes, moving processes between lists, changing the
+	 * get waitlists, spawning, restarting, etc) must hold this lock in
+	 * exclusive mode. Session checkout and session close have a fast path
+	 * which holds this lock in shared mode only, together with the group's
+	 * `sessionSyncher`; see `Group::sessionSyncher` for what that protects.
+	 * The read-only accessors (`capacityUsed()`, `getProcessCount()`,
+	 * `inspect()`, `toXml()`, etc) hold this lock in shared mode too.
+	 */
+	mutable ReadWriteLock syncher;
 	unsigned int max;
 	unsigned long long maxIdleTime;
+	/**
+	 * Whether the groups' standby processes (see `Group::standbyProcesses`)
+	 * count towards `max`. If not, they only start counting once they're
+	 * promoted.
+	 */
+	bool countStandbyProcesses;
 	bool selfchecking;
 
 	Context context;
@@ -287,6 +306,11 @@ public:
 		const GroupPtr &group) const;
 	void prepareUnionStationSystemMetricsLogs(vector<UnionStationLogEntry> &logEntries,
 		const GroupPtr &group) const;
+	static unsigned int countProcessesRecyclingForMemory(const GroupPtr &group);
+	static ProcessPtr findLargestProcessOverMemoryLimit(const GroupPtr &group);
+	void recycleProcessesOverMemoryLimitInGroup(const GroupPtr &group,
+		boost::container::vector<Callback> &actions);
+	void recycleProcessesOverMemoryLimit(boost::container::vector<Callback> &actions);
 	void realCollectAnalytics();
 
 
@@ -298,7 +322,7 @@ public:
 		boost::container::vector<Callback> actions;
 	};
 
-	boost::condition_variable garbageCollectionCond;
+	boost::condition_variable_any garbageCollectionCond;
 
 	void initializeGarbageCollection();
 	static void garbageCollect(PoolPtr self);
@@ -308,10 +332,18 @@ public:
 	void garbageCollectProcessesInGroup(GarbageCollectorState &state,
 		const GroupPtr &group);
 	void maybeCleanPreloader(GarbageCollectorState &state, const GroupPtr &group);
+	void closeIdleConnectionsInGroup(GarbageCollectorState &state, const GroupPtr &group);
 	unsigned long long realGarbageCollect();
 	void wakeupGarbageCollector();
 
 
+	/****** Demand forecasting ******/
+
+	void initializeDemandForecasting();
+	static void forecastDemand(PoolPtr self);
+	void realForecastDemand(unsigned long long now = 0);
+
+
 	/****** General utilities ******/
 
 	static const char *maybeColorize(const InspectOptions &options, const char *color);
@@ -432,6 +464,7 @@ public:
 		const AuthenticationOptions &options = AuthenticationOptions::makeAuthorized());
 	bool detachProcess(const string &gupid,
 		const AuthenticationOptions &options = AuthenticationOptions::makeAuthorized());
+	bool enableProcess(const StaticString &gupid);
 	DisableResult disableProcess(const StaticString &gupid);
 
 
@@ -453,6 +486,7 @@ public:
 	SessionPtr get(const Options &options, Ticket *ticket);
 	void setMax(unsigned int max);
 	void setMaxIdleTime(unsigned long long value);
+	void setCountStandbyProcesses(bool value);
 	void enableSelfChecking(bool enabled);
 	bool isSpawning(bool lock = true) const;
 	bool authorizeByApiKey(const ApiKey &key, bool lock = true) const;
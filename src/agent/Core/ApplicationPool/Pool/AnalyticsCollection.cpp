@@ -146,6 +146,110 @@ Pool::prepareUnionStationSystemMetricsLogs(vector<UnionStationLogEntry> &logEntr
 	}
 }
 
+/**
+ * The number of processes in the given group that were recycled because of
+ * the memory limit, and that are still finishing their sessions or shutting
+ * down.
+ */
+unsigned int
+Pool::countProcessesRecyclingForMemory(const GroupPtr &group) {
+	unsigned int result = 0;
+	foreach (const ProcessPtr &process, group->detachedProcesses) {
+		if (process->recyclingForMemory) {
+			result++;
+		}
+	}
+	return result;
+}
+
+/**
+ * Returns the enabled process in the given group that uses the most memory,
+ * if it uses more than the group's memory limit. Otherwise returns NULL.
+ */
+ProcessPtr
+Pool::findLargestProcessOverMemoryLimit(const GroupPtr &group) {
+	// realMemory() is in KB.
+	size_t largest = (size_t) group->options.memoryLimit * 1024;
+	ProcessPtr result;
+
+	foreach (const ProcessPtr &process, group->enabledProcesses) {
+		if (process->metrics.isValid() && process->metrics.realMemory() > largest) {
+			largest = process->metrics.realMemory();
+			result = process;
+		}
+	}
+	return result;
+}
+
+/**
+ * Recycles enabled processes in the given group that use more memory than
+ * `options.memoryLimit`, starting with the largest one. A recycled process
+ * is detached, so it isn't given new sessions but is allowed to finish the
+ * sessions that it has before it's shut down, and a replacement process is
+ * spawned. At most `options.memoryLimitRecyclePercentage` percent of the
+ * group's processes are recycled at the same time, so that the group never
+ * loses too much capacity at once; processes that are still over the limit
+ * are recycled during a later analytics collection.
+ *
+ * The last enabled process is never recycled. Instead, a replacement is
+ * spawned first, and the process is recycled during a later analytics
+ * collection, once the replacement has been attached.
+ */
+void
+Pool::recycleProcessesOverMemoryLimitInGroup(const GroupPtr &group,
+	boost::container::vector<Callback> &actions)
+{
+	const Options &options = group->options;
+	if (options.memoryLimit == 0 || !group->isAlive() || group->restarting()) {
+		return;
+	}
+
+	unsigned int recycling = countProcessesRecyclingForMemory(group);
+	unsigned int maxRecycling = std::max(1u,
+		(group->getProcessCount() + recycling)
+		* options.memoryLimitRecyclePercentage / 100);
+	bool recycled = false;
+
+	while (recycling < maxRecycling) {
+		ProcessPtr process = findLargestProcessOverMemoryLimit(group);
+		if (process == NULL) {
+			break;
+		}
+		if (group->enabledCount <= 1) {
+			if (!group->spawning() && group->allowSpawn()) {
+				P_INFO("Process " << process->inspect() << " is over the " <<
+					"memory limit for group " << group->getName() << ". Spawning " <<
+					"a replacement before recycling it");
+				group->spawn();
+			}
+			break;
+		}
+
+		P_NOTICE("Process " << process->inspect() << " uses " <<
+			process->metrics.realMemory() / 1024 << " MB of memory, which is " <<
+			"more than the limit of " << options.memoryLimit << " MB for " <<
+			"group " << group->getName() << ". Recycling it");
+		process->recyclingForMemory = true;
+		group->memoryRecycles++;
+		detachProcessUnlocked(process, actions);
+		recycling++;
+		recycled = true;
+	}
+
+	if (recycled && group->allowSpawn()) {
+		group->spawn();
+	}
+}
+
+void
+Pool::recycleProcessesOverMemoryLimit(boost::container::vector<Callback> &actions) {
+	GroupMap::ConstIterator g_it(groups);
+	while (*g_it != NULL) {
+		recycleProcessesOverMemoryLimitInGroup(g_it.getValue(), actions);
+		g_it.next();
+	}
+}
+
 void
 Pool::realCollectAnalytics() {
 	TRACE_POINT();
@@ -158,13 +262,13 @@ Pool::realCollectAnalytics() {
 	// Collect all the PIDs.
 	{
 		UPDATE_TRACE_POINT();
-		LockGuard l(syncher);
+		WriteLockGuard l(syncher);
 		max = this->max;
 	}
 	pids.reserve(max);
 	{
 		UPDATE_TRACE_POINT();
-		LockGuard l(syncher);
+		WriteLockGuard l(syncher);
 		GroupMap::ConstIterator g_it(groups);
 
 		while (*g_it != NULL) {
@@ -172,6 +276,7 @@ Pool::realCollectAnalytics() {
 			collectPids(group->enabledProcesses, pids);
 			collectPids(group->disablingProcesses, pids);
 			collectPids(group->disabledProcesses, pids);
+			collectPids(group->standbyProcesses, pids);
 			g_it.next();
 		}
 	}
@@ -201,7 +306,7 @@ Pool::realCollectAnalytics() {
 		vector<UnionStationLogEntry> logEntries;
 		vector<ProcessPtr> processesToDetach;
 		boost::container::vector<Callback> actions;
-		ScopedLock l(syncher);
+		ScopedWriteLock l(syncher);
 		GroupMap::ConstIterator g_it(groups);
 
 		UPDATE_TRACE_POINT();
@@ -210,6 +315,7 @@ Pool::realCollectAnalytics() {
 			updateProcessMetrics(group->enabledProcesses, processMetrics, processesToDetach);
 			updateProcessMetrics(group->disablingProcesses, processMetrics, processesToDetach);
 			updateProcessMetrics(group->disabledProcesses, processMetrics, processesToDetach);
+			updateProcessMetrics(group->standbyProcesses, processMetrics, processesToDetach);
 			prepareUnionStationProcessStateLogs(logEntries, group);
 			prepareUnionStationSystemMetricsLogs(logEntries, group);
 			g_it.next();
@@ -222,6 +328,9 @@ Pool::realCollectAnalytics() {
 		UPDATE_TRACE_POINT();
 		processesToDetach.clear();
 
+		UPDATE_TRACE_POINT();
+		recycleProcessesOverMemoryLimit(actions);
+
 		l.unlock();
 		UPDATE_TRACE_POINT();
 		if (!logEntries.empty()) {
@@ -0,0 +1,105 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2016 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#include <Core/ApplicationPool/Pool.h>
+
+/*************************************************************************
+ *
+ * Demand forecasting functions for ApplicationPool2::Pool
+ *
+ *************************************************************************/
+
+namespace Passenger {
+namespace ApplicationPool2 {
+
+using namespace std;
+using namespace boost;
+
+
+void
+Pool::initializeDemandForecasting() {
+	interruptableThreads.create_thread(
+		boost::bind(forecastDemand, shared_from_this()),
+		"Pool demand forecaster",
+		POOL_HELPER_THREAD_STACK_SIZE
+	);
+}
+
+void
+Pool::forecastDemand(PoolPtr self) {
+	TRACE_POINT();
+	while (!this_thread::interruption_requested()) {
+		try {
+			UPDATE_TRACE_POINT();
+			syscalls::usleep(timeToNextMultipleULL(Group::DEMAND_FORECAST_INTERVAL,
+				SystemTime::getUsec()));
+			UPDATE_TRACE_POINT();
+			self->realForecastDemand();
+		} catch (const thread_interrupted &) {
+			break;
+		} catch (const tracable_exception &e) {
+			P_WARN("ERROR: " << e.what() << "\n  Backtrace:\n" << e.backtrace());
+		}
+	}
+}
+
+/**
+ * Updates the demand forecast of every group, which may spawn or retire
+ * processes. `now` may be passed by unit tests; it defaults to the
+ * current time.
+ */
+void
+Pool::realForecastDemand(unsigned long long now) {
+	TRACE_POINT();
+	ScopedWriteLock lock(syncher);
+	GroupMap::ConstIterator g_it(groups);
+	boost::container::vector<Callback> actions;
+
+	if (now == 0) {
+		now = SystemTime::getUsec();
+	}
+
+	P_DEBUG("Demand forecasting time...");
+	verifyInvariants();
+
+	while (*g_it != NULL) {
+		const GroupPtr group = g_it.getValue();
+		if (group->isAlive()) {
+			group->updateDemandForecast(now, actions);
+			group->verifyInvariants();
+		}
+		g_it.next();
+	}
+
+	verifyInvariants();
+	lock.unlock();
+
+	UPDATE_TRACE_POINT();
+	runAllActions(actions);
+}
+
+
+} // namespace ApplicationPool2
+} // namespace Passenger
@@ -51,7 +51,7 @@ void
 Pool::garbageCollect(PoolPtr self) {
 	TRACE_POINT();
 	{
-		ScopedLock lock(self->syncher);
+		ScopedWriteLock lock(self->syncher);
 		self->garbageCollectionCond.timed_wait(lock,
 			posix_time::seconds(5));
 	}
@@ -60,7 +60,7 @@ Pool::garbageCollect(PoolPtr self) {
 			UPDATE_TRACE_POINT();
 			unsigned long long sleepTime = self->realGarbageCollect();
 			UPDATE_TRACE_POINT();
-			ScopedLock lock(self->syncher);
+			ScopedWriteLock lock(self->syncher);
 			self->garbageCollectionCond.timed_wait(lock,
 				posix_time::microseconds(sleepTime));
 		} catch (const thread_interrupted &) {
@@ -113,7 +113,7 @@ Pool::garbageCollectProcessesInGroup(GarbageCollectorState &state,
 	p_it  = processesToGc.begin();
 	p_end = processesToGc.end();
 	while (p_it != p_end
-	 && (unsigned long) group->getProcessCount() > group->options.minProcesses)
+	 && group->getProcessCount() > group->getMinProcessesToKeep())
 	{
 		ProcessPtr process = *p_it;
 		P_DEBUG("Garbage collect idle process: " << process->inspect() <<
@@ -138,10 +138,35 @@ Pool::maybeCleanPreloader(GarbageCollectorState &state, const GroupPtr &group) {
 	}
 }
 
+void
+Pool::closeIdleConnectionsInGroup(GarbageCollectorState &state, const GroupPtr &group) {
+	const unsigned long long timeout = APP_CONNECTION_IDLE_TIMEOUT * 1000000ull;
+	ProcessList *lists[] = {
+		&group->enabledProcesses,
+		&group->disablingProcesses,
+		&group->disabledProcesses,
+		&group->standbyProcesses
+	};
+
+	if (state.now < timeout) {
+		return;
+	}
+	for (unsigned int i = 0; i < sizeof(lists) / sizeof(ProcessList *); i++) {
+		ProcessList::iterator p_it, p_end = lists[i]->end();
+		for (p_it = lists[i]->begin(); p_it != p_end; p_it++) {
+			unsigned long long oldest = (*p_it)->closeIdleConnections(
+				state.now - timeout);
+			if (oldest != 0) {
+				maybeUpdateNextGcRuntime(state, oldest + timeout);
+			}
+		}
+	}
+}
+
 unsigned long long
 Pool::realGarbageCollect() {
 	TRACE_POINT();
-	ScopedLock lock(syncher);
+	ScopedWriteLock lock(syncher);
 	GroupMap::ConstIterator g_it(groups);
 	GarbageCollectorState state;
 	state.now = SystemTime::getUsec();
@@ -164,6 +189,10 @@ Pool::realGarbageCollect() {
 		// ...cleanup the spawner if it's been idle for more than preloaderIdleTime.
 		maybeCleanPreloader(state, group);
 
+		// ...close connections to processes that haven't been reused for
+		// more than APP_CONNECTION_IDLE_TIMEOUT.
+		closeIdleConnectionsInGroup(state, group);
+
 		g_it.next();
 	}
 
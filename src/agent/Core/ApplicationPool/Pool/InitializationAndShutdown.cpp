@@ -56,6 +56,7 @@ Pool::Pool(const SpawningKit::FactoryPtr &spawningKitFactory,
 	lifeStatus   = ALIVE;
 	max          = 6;
 	maxIdleTime  = 60 * 1000000;
+	countStandbyProcesses = false;
 	selfchecking = true;
 	palloc       = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
 
@@ -76,14 +77,15 @@ Pool::~Pool() {
 /** Must be called right after construction. */
 void
 Pool::initialize() {
-	LockGuard l(syncher);
+	WriteLockGuard l(syncher);
 	initializeAnalyticsCollection();
 	initializeGarbageCollection();
+	initializeDemandForecasting();
 }
 
 void
 Pool::initDebugging() {
-	LockGuard l(syncher);
+	WriteLockGuard l(syncher);
 	debugSupport = boost::make_shared<DebugSupport>();
 }
 
@@ -97,7 +99,7 @@ Pool::initDebugging() {
 void
 Pool::prepareForShutdown() {
 	TRACE_POINT();
-	ScopedLock lock(syncher);
+	ScopedWriteLock lock(syncher);
 	assert(lifeStatus == ALIVE);
 	lifeStatus = PREPARED_FOR_SHUTDOWN;
 	if (abortLongRunningConnectionsCallback != NULL) {
@@ -114,7 +116,7 @@ Pool::prepareForShutdown() {
 void
 Pool::destroy() {
 	TRACE_POINT();
-	ScopedLock lock(syncher);
+	ScopedWriteLock lock(syncher);
 	assert(lifeStatus == ALIVE || lifeStatus == PREPARED_FOR_SHUTDOWN);
 
 	lifeStatus = SHUTTING_DOWN;
@@ -42,7 +42,27 @@ using namespace boost;
 // should never call the callback while holding the lock.
 void
 Pool::asyncGet(const Options &options, const GetCallback &callback, bool lockNow, UnionStation::StopwatchLog **stopwatchLog) {
-	DynamicScopedLock lock(syncher, lockNow);
+	if (OXT_LIKELY(lockNow && stopwatchLog == NULL)) {
+		/* Fast path: if the group exists and has an enabled process that can
+		 * be routed to right away, then checking out a session only changes
+		 * that group's session statistics. Those are protected by the group's
+		 * own lock, so that requests for different groups, or for the same
+		 * group on different threads, don't serialize on the pool lock.
+		 */
+		ScopedReadLock readLock(syncher);
+		Group *existingGroup = findMatchingGroup(options);
+		if (existingGroup != NULL) {
+			SessionPtr session = existingGroup->getWithSharedPoolLock(options);
+			if (session != NULL) {
+				readLock.unlock();
+				P_TRACE(2, "asyncGet() finished through the fast path");
+				callback(session, ExceptionPtr());
+				return;
+			}
+		}
+	}
+
+	DynamicScopedWriteLock lock(syncher, lockNow);
 
 	assert(lifeStatus == ALIVE || lifeStatus == PREPARED_FOR_SHUTDOWN);
 	verifyInvariants();
@@ -193,7 +213,7 @@ Pool::get(const Options &options, Ticket *ticket) {
 
 void
 Pool::setMax(unsigned int max) {
-	ScopedLock l(syncher);
+	ScopedWriteLock l(syncher);
 	assert(max > 0);
 	fullVerifyInvariants();
 	bool bigger = max > this->max;
@@ -222,14 +242,20 @@ Pool::setMax(unsigned int max) {
 
 void
 Pool::setMaxIdleTime(unsigned long long value) {
-	LockGuard l(syncher);
+	WriteLockGuard l(syncher);
 	maxIdleTime = value;
 	wakeupGarbageCollector();
 }
 
+void
+Pool::setCountStandbyProcesses(bool value) {
+	WriteLockGuard l(syncher);
+	countStandbyProcesses = value;
+}
+
 void
 Pool::enableSelfChecking(bool enabled) {
-	LockGuard l(syncher);
+	WriteLockGuard l(syncher);
 	selfchecking = enabled;
 }
 
@@ -238,7 +264,7 @@ Pool::enableSelfChecking(bool enabled) {
  */
 bool
 Pool::isSpawning(bool lock) const {
-	DynamicScopedLock l(syncher, lock);
+	DynamicScopedWriteLock l(syncher, lock);
 	GroupMap::ConstIterator g_it(groups);
 	while (*g_it != NULL) {
 		const GroupPtr &group = g_it.getValue();
@@ -261,7 +287,7 @@ Pool::authorizeByUid(uid_t uid, bool lock) const {
 		return true;
 	}
 
-	DynamicScopedLock l(syncher, lock);
+	DynamicScopedWriteLock l(syncher, lock);
 	GroupMap::ConstIterator g_it(groups);
 	while (*g_it != NULL) {
 		const GroupPtr &group = g_it.getValue();
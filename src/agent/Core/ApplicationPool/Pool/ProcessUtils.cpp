@@ -56,6 +56,14 @@ Pool::findOldestIdleProcess(const Group *exclude) const {
 			g_it.next();
 			continue;
 		}
+		if (countStandbyProcesses && !group->standbyProcesses.empty()
+		 && group->getWaitlist.empty())
+		{
+			// Standby processes are idle by definition, and shutting
+			// one down doesn't take serving capacity away.
+			return group->standbyProcesses.back();
+		}
+
 		const ProcessList &processes = group->enabledProcesses;
 		ProcessList::const_iterator p_it, p_end = processes.end();
 		for (p_it = processes.begin(); p_it != p_end; p_it++) {
@@ -194,7 +202,7 @@ Pool::possiblySpawnMoreProcessesForExistingGroups() {
 
 vector<ProcessPtr>
 Pool::getProcesses(bool lock) const {
-	DynamicScopedLock l(syncher, lock);
+	DynamicScopedWriteLock l(syncher, lock);
 	vector<ProcessPtr> result;
 	GroupMap::ConstIterator g_it(groups);
 	while (*g_it != NULL) {
@@ -210,6 +218,9 @@ Pool::getProcesses(bool lock) const {
 		for (p_it = group->disabledProcesses.begin(); p_it != group->disabledProcesses.end(); p_it++) {
 			result.push_back(*p_it);
 		}
+		for (p_it = group->standbyProcesses.begin(); p_it != group->standbyProcesses.end(); p_it++) {
+			result.push_back(*p_it);
+		}
 
 		g_it.next();
 	}
@@ -244,7 +255,7 @@ Pool::findProcessByPid(pid_t pid, bool lock) const {
 
 bool
 Pool::detachProcess(const ProcessPtr &process) {
-	ScopedLock l(syncher);
+	ScopedWriteLock l(syncher);
 	boost::container::vector<Callback> actions;
 	bool result = detachProcessUnlocked(process, actions);
 	fullVerifyInvariants();
@@ -255,7 +266,7 @@ Pool::detachProcess(const ProcessPtr &process) {
 
 bool
 Pool::detachProcess(pid_t pid, const AuthenticationOptions &options) {
-	ScopedLock l(syncher);
+	ScopedWriteLock l(syncher);
 	ProcessPtr process = findProcessByPid(pid, false);
 	if (process != NULL) {
 		const Group *group = process->getGroup();
@@ -278,7 +289,7 @@ Pool::detachProcess(pid_t pid, const AuthenticationOptions &options) {
 
 bool
 Pool::detachProcess(const string &gupid, const AuthenticationOptions &options) {
-	ScopedLock l(syncher);
+	ScopedWriteLock l(syncher);
 	ProcessPtr process = findProcessByGupid(gupid, false);
 	if (process != NULL) {
 		const Group *group = process->getGroup();
@@ -299,11 +310,47 @@ Pool::detachProcess(const string &gupid, const AuthenticationOptions &options) {
 	}
 }
 
+/**
+ * Enables the process with the given gupid. Returns whether the process was
+ * found and is enabled afterwards. A standby process is not enabled if that
+ * would exceed the process limits.
+ */
+bool
+Pool::enableProcess(const StaticString &gupid) {
+	ScopedWriteLock l(syncher);
+	ProcessPtr process = findProcessByGupid(gupid, false);
+	if (process != NULL) {
+		Group *group = process->getGroup();
+		boost::container::vector<Callback> actions;
+		group->enable(process, actions);
+		group->verifyInvariants();
+		group->verifyExpensiveInvariants();
+		bool result = process->enabled == Process::ENABLED;
+		l.unlock();
+		runAllActions(actions);
+		return result;
+	} else {
+		return false;
+	}
+}
+
 DisableResult
 Pool::disableProcess(const StaticString &gupid) {
-	ScopedLock l(syncher);
+	ScopedWriteLock l(syncher);
 	ProcessPtr process = findProcessByGupid(gupid, false);
-	if (process != NULL) {
+	if (process != NULL && process->enabled == Process::STANDBY) {
+		// A standby process has no sessions, so it is shut down right away.
+		// It is not moved to the disabled process list because, unlike
+		// standby processes, disabled processes always count towards the
+		// pool's capacity.
+		boost::container::vector<Callback> actions;
+		P_DEBUG("Disabling STANDBY process " << process->inspect() <<
+			" by detaching it");
+		detachProcessUnlocked(process, actions);
+		l.unlock();
+		runAllActions(actions);
+		return DR_SUCCESS;
+	} else if (process != NULL) {
 		Group *group = process->getGroup();
 		// Must be a boost::shared_ptr to be interruption-safe.
 		boost::shared_ptr<DisableWaitTicket> ticket = boost::make_shared<DisableWaitTicket>();
@@ -103,8 +103,14 @@ Pool::inspectProcessList(const InspectOptions &options, stringstream &result,
 			result << "    Disabling..." << endl;
 		} else if (process->enabled == Process::DISABLED) {
 			result << "    DISABLED" << endl;
+		} else if (process->enabled == Process::STANDBY) {
+			result << "    Standby" << endl;
 		} else if (process->enabled == Process::DETACHED) {
-			result << "    Shutting down..." << endl;
+			if (process->recyclingForMemory) {
+				result << "    Shutting down (over memory limit)..." << endl;
+			} else {
+				result << "    Shutting down..." << endl;
+			}
 		}
 
 		const Socket *socket;
@@ -125,7 +131,7 @@ Pool::inspectProcessList(const InspectOptions &options, stringstream &result,
 
 string
 Pool::inspect(const InspectOptions &options, bool lock) const {
-	DynamicScopedLock l(syncher, lock);
+	DynamicScopedReadLock l(syncher, lock);
 	stringstream result;
 	const char *headerColor = maybeColorize(options, ANSI_COLOR_YELLOW ANSI_COLOR_BLUE_BG ANSI_COLOR_BOLD);
 	const char *resetColor  = maybeColorize(options, ANSI_COLOR_RESET);
@@ -162,6 +168,8 @@ Pool::inspect(const InspectOptions &options, bool lock) const {
 		}
 
 		ProcessList::const_iterator p_it;
+		// The session checkout and close fast paths may be running.
+		boost::lock_guard<boost::mutex> l2(group->sessionSyncher);
 
 		result << group->getName() << ":" << endl;
 		result << "  App root: " << group->options.appRoot << endl;
@@ -181,6 +189,7 @@ Pool::inspect(const InspectOptions &options, bool lock) const {
 		inspectProcessList(options, result, group.get(), group->enabledProcesses);
 		inspectProcessList(options, result, group.get(), group->disablingProcesses);
 		inspectProcessList(options, result, group.get(), group->disabledProcesses);
+		inspectProcessList(options, result, group.get(), group->standbyProcesses);
 		inspectProcessList(options, result, group.get(), group->detachedProcesses);
 		result << endl;
 
@@ -191,7 +200,7 @@ Pool::inspect(const InspectOptions &options, bool lock) const {
 
 string
 Pool::toXml(const ToXmlOptions &options, bool lock) const {
-	DynamicScopedLock l(syncher, lock);
+	DynamicScopedReadLock l(syncher, lock);
 	stringstream result;
 	GroupMap::ConstIterator g_it(groups);
 	ProcessList::const_iterator p_it;
@@ -210,6 +219,9 @@ Pool::toXml(const ToXmlOptions &options, bool lock) const {
 	result << "<process_count>" << getProcessCount(false) << "</process_count>";
 	result << "<max>" << max << "</max>";
 	result << "<capacity_used>" << capacityUsedUnlocked() << "</capacity_used>";
+	if (countStandbyProcesses) {
+		result << "<count_standby_processes/>";
+	}
 	result << "<get_wait_list_size>" << getWaitlist.size() << "</get_wait_list_size>";
 
 	if (options.secrets) {
@@ -235,6 +247,8 @@ Pool::toXml(const ToXmlOptions &options, bool lock) const {
 			continue;
 		}
 
+		// The session checkout and close fast paths may be running.
+		boost::lock_guard<boost::mutex> l2(group->sessionSyncher);
 		result << "<supergroup>";
 		result << "<name>" << escapeForXml(group->getName()) << "</name>";
 		result << "<state>READY</state>";
@@ -261,13 +275,13 @@ Pool::toXml(const ToXmlOptions &options, bool lock) const {
 
 unsigned int
 Pool::capacityUsed() const {
-	LockGuard l(syncher);
+	ScopedReadLock l(syncher);
 	return capacityUsedUnlocked();
 }
 
 bool
 Pool::atFullCapacity() const {
-	LockGuard l(syncher);
+	ScopedReadLock l(syncher);
 	return atFullCapacityUnlocked();
 }
 
@@ -278,7 +292,7 @@ Pool::atFullCapacity() const {
  */
 unsigned int
 Pool::getProcessCount(bool lock) const {
-	DynamicScopedLock l(syncher, lock);
+	DynamicScopedReadLock l(syncher, lock);
 	unsigned int result = 0;
 	GroupMap::ConstIterator g_it(groups);
 	while (*g_it != NULL) {
@@ -291,7 +305,7 @@ Pool::getProcessCount(bool lock) const {
 
 unsigned int
 Pool::getGroupCount() const {
-	LockGuard l(syncher);
+	ScopedReadLock l(syncher);
 	return groups.size();
 }
 
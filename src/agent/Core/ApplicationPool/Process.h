@@ -368,6 +368,13 @@ public:
 	int sessions;
 	/** Number of sessions opened so far. */
 	unsigned int processed;
+	/**
+	 * Exponentially weighted moving average of the time, in microseconds,
+	 * between initiating a session and the app starting to respond. Used by
+	 * latency-aware routing policies. 0 if no response times have been
+	 * recorded yet.
+	 */
+	unsigned int responseTimeEwma;
 	/** Do not access directly, always use `isAlive()`/`isDead()`/`getLifeStatus()` or
 	 * through `lifetimeSyncher`. */
 	enum LifeStatus {
@@ -397,6 +404,11 @@ public:
 		 * the Out-of-Band-Work trigger.
 		 */
 		DISABLED,
+		/** Process is fully spawned, but parked in the Group's standby list
+		 * until the Group needs more capacity. It doesn't handle any
+		 * requests until it's promoted to ENABLED.
+		 */
+		STANDBY,
 		/**
 		 * Process has been detached. It will be removed from the Group
 		 * as soon we have detected that the OS process has exited. Detached
@@ -419,6 +431,9 @@ public:
 	/** Caches whether or not the OS process still exists. */
 	mutable bool m_osProcessExists: 1;
 	bool longRunningConnectionsAborted: 1;
+	/** Whether this process is being recycled because it went over the
+	 * group's memory limit. See `Pool::recycleProcessesOverMemoryLimit()`. */
+	bool recyclingForMemory: 1;
 	/** Time at which shutdown began. */
 	time_t shutdownStartTime;
 	/** Collected by Pool::collectAnalytics(). */
@@ -438,11 +453,13 @@ public:
 		  lastUsed(spawnEndTime),
 		  sessions(0),
 		  processed(0),
+		  responseTimeEwma(0),
 		  lifeStatus(ALIVE),
 		  enabled(ENABLED),
 		  oobwStatus(OOBW_NOT_ACTIVE),
 		  m_osProcessExists(true),
 		  longRunningConnectionsAborted(false),
+		  recyclingForMemory(false),
 		  shutdownStartTime(0)
 	{
 		initializeSocketsAndStringFields(json);
@@ -562,6 +579,25 @@ public:
 		}
 	}
 
+	/**
+	 * Closes the idle connections to this process's sockets that were
+	 * checked in before the given time (in microseconds). Returns the time at
+	 * which the oldest remaining idle connection was checked in, or 0 if there
+	 * are none.
+	 */
+	unsigned long long closeIdleConnections(unsigned long long checkedInBefore) {
+		unsigned long long oldest = 0;
+		SocketList::iterator it, end = sockets.end();
+
+		for (it = sockets.begin(); it != end; it++) {
+			unsigned long long time = it->closeIdleConnections(checkedInBefore);
+			if (time != 0 && (oldest == 0 || time < oldest)) {
+				oldest = time;
+			}
+		}
+		return oldest;
+	}
+
 	bool shutdownTimeoutExpired() const {
 		return SystemTime::get() >= shutdownStartTime + PROCESS_SHUTDOWN_TIMEOUT;
 	}
@@ -719,6 +755,14 @@ public:
 		}
 	}
 
+	/**
+	 * The maximum number of concurrent sessions that this process can handle.
+	 * 0 means unlimited.
+	 */
+	int getConcurrency() const {
+		return concurrency;
+	}
+
 	/**
 	 * Whether we've reached the maximum number of concurrent sessions for this
 	 * process.
@@ -760,7 +804,9 @@ public:
 			} else {
 				lastUsed = SystemTime::getUsec();
 			}
-			return createSessionObject(socket);
+			SessionPtr session = createSessionObject(socket);
+			session->setTookLastFreeSlot(isTotallyBusy());
+			return session;
 		}
 	}
 
@@ -803,9 +849,29 @@ public:
 		socket->sessions--;
 		this->sessions--;
 		processed++;
+		if (session->getResponseTime() != 0) {
+			recordResponseTime(session->getResponseTime());
+		}
 		assert(!isTotallyBusy());
 	}
 
+	/**
+	 * Updates `responseTimeEwma` with a new response time sample, in microseconds.
+	 * Each sample accounts for 1/4th of the average, so that a process that
+	 * suddenly becomes slow (e.g. because it's garbage collecting) is noticed
+	 * within a few requests.
+	 */
+	void recordResponseTime(unsigned int usec) {
+		usec = std::max(usec, 1u);
+		if (responseTimeEwma == 0) {
+			responseTimeEwma = usec;
+		} else {
+			responseTimeEwma = (unsigned int)
+				(((unsigned long long) responseTimeEwma * 3 + usec) / 4);
+			responseTimeEwma = std::max(responseTimeEwma, 1u);
+		}
+	}
+
 	/**
 	 * Returns the uptime of this process so far, as a string.
 	 */
@@ -829,6 +895,7 @@ public:
 		stream << "<sessions>" << sessions << "</sessions>";
 		stream << "<busyness>" << busyness() << "</busyness>";
 		stream << "<processed>" << processed << "</processed>";
+		stream << "<response_time_ewma>" << responseTimeEwma << "</response_time_ewma>";
 		stream << "<spawner_creation_time>" << spawnerCreationTime << "</spawner_creation_time>";
 		stream << "<spawn_start_time>" << spawnStartTime << "</spawn_start_time>";
 		stream << "<spawn_end_time>" << spawnEndTime << "</spawn_end_time>";
@@ -861,12 +928,18 @@ public:
 		case DISABLED:
 			stream << "<enabled>DISABLED</enabled>";
 			break;
+		case STANDBY:
+			stream << "<enabled>STANDBY</enabled>";
+			break;
 		case DETACHED:
 			stream << "<enabled>DETACHED</enabled>";
 			break;
 		default:
 			P_BUG("Unknown 'enabled' state " << (int) enabled);
 		}
+		if (recyclingForMemory) {
+			stream << "<recycling_for_memory/>";
+		}
 		if (metrics.isValid()) {
 			stream << "<has_metrics>true</has_metrics>";
 			stream << "<cpu>" << (int) metrics.cpu << "</cpu>";
@@ -881,6 +954,7 @@ public:
 		}
 		if (includeSockets) {
 			SocketList::const_iterator it;
+			unsigned long long connectionsReused, connects;
 
 			stream << "<sockets>";
 			for (it = sockets.begin(); it != sockets.end(); it++) {
@@ -891,6 +965,11 @@ public:
 				stream << "<protocol>" << escapeForXml(socket.protocol) << "</protocol>";
 				stream << "<concurrency>" << socket.concurrency << "</concurrency>";
 				stream << "<sessions>" << socket.sessions << "</sessions>";
+				socket.getConnectionStatistics(connectionsReused, connects);
+				stream << "<connections>" << socket.totalConnections.load(boost::memory_order_relaxed) << "</connections>";
+				stream << "<idle_connections>" << socket.getIdleConnectionCount() << "</idle_connections>";
+				stream << "<connections_reused>" << connectionsReused << "</connections_reused>";
+				stream << "<connects>" << connects << "</connects>";
 				stream << "</socket>";
 			}
 			stream << "</sockets>";
@@ -0,0 +1,239 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2011-2015 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#ifndef _PASSENGER_APPLICATION_POOL2_ROUTING_POLICY_H_
+#define _PASSENGER_APPLICATION_POOL2_ROUTING_POLICY_H_
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/cstdint.hpp>
+#include <StaticString.h>
+#include <Logging.h>
+#include <DataStructures/IndexedMinHeap.h>
+#include <Core/ApplicationPool/Process.h>
+
+namespace Passenger {
+namespace ApplicationPool2 {
+
+using namespace std;
+
+
+/**
+ * Decides which of a Group's enabled processes a request (without a sticky
+ * session ID) is routed to. Each Group owns one RoutingPolicy, which is
+ * selected through `Options::routingPolicy`.
+ *
+ * A RoutingPolicy is accessed either while holding the ApplicationPool lock
+ * exclusively, or while holding it shared together with the Group's
+ * `sessionSyncher` (see `Group::getWithSharedPoolLock()`). Only one thread
+ * accesses a Group's RoutingPolicy at a time, but a shared pool lock alone
+ * does not guarantee that, so any state that `selectEnabledProcess()`
+ * modifies relies on `sessionSyncher`.
+ */
+class RoutingPolicy {
+public:
+	virtual ~RoutingPolicy() { }
+
+	virtual StaticString getName() const = 0;
+
+	/**
+	 * Selects one of the processes in `enabledProcesses`, which is non-empty.
+	 * `busynessLevels` contains the processes' busyness levels, indexed by
+	 * their position in `enabledProcesses`.
+	 *
+	 * The returned process may only be totally busy if all enabled processes
+	 * are totally busy, because Group relies on that to decide whether a
+	 * request must be put on the wait list.
+	 */
+	virtual Process *selectEnabledProcess(const ProcessList &enabledProcesses,
+		const IndexedMinHeap<int> &busynessLevels) = 0;
+};
+
+typedef boost::shared_ptr<RoutingPolicy> RoutingPolicyPtr;
+
+
+/**
+ * Routes to the least busy process. This is the default.
+ */
+class LeastBusyRoutingPolicy: public RoutingPolicy {
+public:
+	virtual StaticString getName() const {
+		return P_STATIC_STRING("least-busy");
+	}
+
+	virtual Process *selectEnabledProcess(const ProcessList &enabledProcesses,
+		const IndexedMinHeap<int> &busynessLevels)
+	{
+		return enabledProcesses[busynessLevels.top()].get();
+	}
+};
+
+/**
+ * Picks two distinct enabled processes at random and routes to the less
+ * busy one. Unlike the least-busy policy, this does not make all concurrent
+ * routing decisions converge on the same process while busyness levels are
+ * momentarily equal, which spreads load more evenly over large groups.
+ */
+class PowerOfTwoChoicesRoutingPolicy: public RoutingPolicy {
+private:
+	boost::uint32_t state;
+
+	boost::uint32_t random() {
+		// xorshift32. Statistical quality is not important here, speed is.
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+public:
+	PowerOfTwoChoicesRoutingPolicy(boost::uint32_t seed)
+		: state(seed == 0 ? 1 : seed)
+		{ }
+
+	virtual StaticString getName() const {
+		return P_STATIC_STRING("power-of-two-choices");
+	}
+
+	virtual Process *selectEnabledProcess(const ProcessList &enabledProcesses,
+		const IndexedMinHeap<int> &busynessLevels)
+	{
+		unsigned int count = enabledProcesses.size();
+		if (count == 1) {
+			return enabledProcesses[0].get();
+		}
+
+		unsigned int first = random() % count;
+		unsigned int second = random() % (count - 1);
+		if (second >= first) {
+			second++;
+		}
+
+		int firstBusyness = busynessLevels.get(first);
+		int secondBusyness = busynessLevels.get(second);
+		unsigned int chosen;
+		if (firstBusyness < secondBusyness
+		 || (firstBusyness == secondBusyness && first < second))
+		{
+			chosen = first;
+		} else {
+			chosen = second;
+		}
+
+		Process *process = enabledProcesses[chosen].get();
+		if (OXT_LIKELY(process->canBeRoutedTo())) {
+			return process;
+		} else {
+			// Both candidates are totally busy, but others may not be.
+			return enabledProcesses[busynessLevels.top()].get();
+		}
+	}
+};
+
+/**
+ * Routes to the process with the lowest expected latency, which is estimated
+ * as its response time EWMA (see `Process::responseTimeEwma`) multiplied by
+ * the number of requests it would be handling. This steers traffic away from
+ * processes that are slow, e.g. because they are garbage collecting, even if
+ * they are not busier than others.
+ *
+ * Processes without response time samples yet are assumed to be as fast as
+ * the fastest process, so that they get traffic but are not flooded with it.
+ *
+ * This policy looks at all enabled processes, so routing takes O(n) time.
+ */
+class EwmaLatencyRoutingPolicy: public RoutingPolicy {
+public:
+	virtual StaticString getName() const {
+		return P_STATIC_STRING("ewma-latency");
+	}
+
+	virtual Process *selectEnabledProcess(const ProcessList &enabledProcesses,
+		const IndexedMinHeap<int> &busynessLevels)
+	{
+		ProcessList::const_iterator it, end = enabledProcesses.end();
+		unsigned int fastest = 0;
+
+		for (it = enabledProcesses.begin(); it != end; it++) {
+			unsigned int ewma = (*it)->responseTimeEwma;
+			if (ewma != 0 && (fastest == 0 || ewma < fastest)) {
+				fastest = ewma;
+			}
+		}
+		if (fastest == 0) {
+			fastest = 1;
+		}
+
+		Process *best = NULL;
+		boost::uint64_t lowestCost = 0;
+		for (it = enabledProcesses.begin(); it != end; it++) {
+			Process *process = it->get();
+			if (!process->canBeRoutedTo()) {
+				continue;
+			}
+
+			unsigned int ewma = process->responseTimeEwma;
+			boost::uint64_t cost = (boost::uint64_t) (ewma == 0 ? fastest : ewma)
+				* (process->sessions + 1);
+			if (best == NULL || cost < lowestCost) {
+				best = process;
+				lowestCost = cost;
+			}
+		}
+
+		if (best != NULL) {
+			return best;
+		} else {
+			// All processes are totally busy.
+			return enabledProcesses[busynessLevels.top()].get();
+		}
+	}
+};
+
+
+/**
+ * Creates the RoutingPolicy with the given name. Falls back to the
+ * least-busy policy if the name is not recognized. `seed` is used by
+ * policies that make random decisions.
+ */
+inline RoutingPolicyPtr
+createRoutingPolicy(const StaticString &name, boost::uint32_t seed) {
+	if (name.empty() || name == P_STATIC_STRING("least-busy")) {
+		return boost::make_shared<LeastBusyRoutingPolicy>();
+	} else if (name == P_STATIC_STRING("power-of-two-choices")) {
+		return boost::make_shared<PowerOfTwoChoicesRoutingPolicy>(seed);
+	} else if (name == P_STATIC_STRING("ewma-latency")) {
+		return boost::make_shared<EwmaLatencyRoutingPolicy>();
+	} else {
+		P_WARN("Unknown routing policy '" << name << "', using 'least-busy' instead");
+		return boost::make_shared<LeastBusyRoutingPolicy>();
+	}
+}
+
+
+} // namespace ApplicationPool2
+} // namespace Passenger
+
+#endif /* _PASSENGER_APPLICATION_POOL2_ROUTING_POLICY_H_ */
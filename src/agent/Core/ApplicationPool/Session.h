@@ -27,6 +27,8 @@
 #define _PASSENGER_APPLICATION_POOL_SESSION_H_
 
 #include <sys/types.h>
+#include <algorithm>
+#include <climits>
 #include <boost/atomic.hpp>
 #include <oxt/macros.hpp>
 #include <oxt/system_calls.hpp>
@@ -86,6 +88,10 @@ private:
 
 	Connection connection;
 	mutable boost::atomic<int> refcount;
+	/** See `reportResponseTime()`. 0 if not reported. */
+	unsigned int responseTime;
+	/** See `tookLastFreeSlot()`. */
+	bool lastFreeSlot;
 	bool closed;
 
 	void deinitiate(bool success, bool wantKeepAlive) {
@@ -123,6 +129,8 @@ public:
 		  processInfo(_processInfo),
 		  socket(_socket),
 		  refcount(1),
+		  responseTime(0),
+		  lastFreeSlot(false),
 		  closed(false),
 		  onInitiateFailure(NULL),
 		  onClose(NULL)
@@ -225,6 +233,22 @@ public:
 
 	virtual void requestOOBW();
 
+	virtual void reportResponseTime(unsigned long long usec) {
+		responseTime = (unsigned int) std::min<unsigned long long>(usec, UINT_MAX);
+	}
+
+	unsigned int getResponseTime() const {
+		return responseTime;
+	}
+
+	virtual bool tookLastFreeSlot() const {
+		return lastFreeSlot;
+	}
+
+	void setTookLastFreeSlot(bool value) {
+		lastFreeSlot = value;
+	}
+
 
 	virtual void ref() const {
 		refcount.fetch_add(1, boost::memory_order_relaxed);
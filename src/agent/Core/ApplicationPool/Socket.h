@@ -27,8 +27,11 @@
 #define _PASSENGER_APPLICATION_POOL_SOCKET_H_
 
 #include <vector>
+#include <algorithm>
 #include <oxt/macros.hpp>
+#include <oxt/spin_lock.hpp>
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
 #include <climits>
@@ -37,7 +40,9 @@
 #include <Logging.h>
 #include <StaticString.h>
 #include <MemoryKit/palloc.h>
+#include <Constants.h>
 #include <Utils/IOUtils.h>
+#include <Utils/SystemTime.h>
 #include <Core/ApplicationPool/Common.h>
 
 namespace Passenger {
@@ -71,14 +76,95 @@ struct Connection {
 	}
 };
 
+/**
+ * Returns the index of the connection cache slot that belongs to the calling
+ * thread. Every thread is assigned a slot the first time it calls this
+ * function, round-robin, so as long as there are no more than
+ * APP_CONNECTION_CACHE_SLOTS threads (e.g. Core threads) that use the
+ * connection pools, each of them has a slot of its own.
+ */
+inline unsigned int
+getConnectionCacheSlot() {
+	#ifdef OXT_THREAD_LOCAL_KEYWORD_SUPPORTED
+		static boost::atomic<unsigned int> nextSlot(0);
+		static __thread int slot = -1;
+		if (OXT_UNLIKELY(slot == -1)) {
+			slot = nextSlot.fetch_add(1, boost::memory_order_relaxed)
+				% APP_CONNECTION_CACHE_SLOTS;
+		}
+		return slot;
+	#else
+		return (unsigned int) (((unsigned long) pthread_self() >> 6)
+			% APP_CONNECTION_CACHE_SLOTS);
+	#endif
+}
+
 /**
  * Not thread-safe except for the connection pooling methods, so only use
  * within the ApplicationPool lock.
+ *
+ * Idle connections are pooled per thread: every thread checks connections
+ * in and out of its own slot (see `getConnectionCacheSlot()`), so that
+ * threads that serve requests for the same process don't contend on a shared
+ * lock. A thread only looks at other threads' slots if its own slot is empty,
+ * before resorting to creating a new connection. Each slot is protected by a
+ * spin lock that is normally only ever taken by its own thread. The number
+ * of idle connections over all slots is limited to `connectionPoolLimit()`.
  */
 class Socket {
 private:
-	boost::mutex connectionPoolLock;
-	vector<Connection> idleConnections;
+	struct IdleConnection {
+		Connection connection;
+		/** Time at which the connection was checked in, in microseconds. */
+		unsigned long long idleSince;
+
+		IdleConnection(const Connection &c, unsigned long long _idleSince)
+			: connection(c),
+			  idleSince(_idleSince)
+			{ }
+	};
+
+	struct ConnectionCacheSlot {
+		oxt::spin_lock lock;
+		vector<IdleConnection> idleConnections;
+		/** Number of checkouts that were satisfied by an idle connection. */
+		unsigned long long reused;
+		/** Number of checkouts that had to create a new connection. */
+		unsigned long long connected;
+		// Keeps adjacent slots off each other's cache lines.
+		char padding[64];
+
+		ConnectionCacheSlot()
+			: reused(0),
+			  connected(0)
+			{ }
+
+		ConnectionCacheSlot(const ConnectionCacheSlot &other)
+			: idleConnections(other.idleConnections),
+			  reused(other.reused),
+			  connected(other.connected)
+			{ }
+
+		ConnectionCacheSlot &operator=(const ConnectionCacheSlot &other) {
+			idleConnections = other.idleConnections;
+			reused = other.reused;
+			connected = other.connected;
+			return *this;
+		}
+
+		bool tryCheckout(Connection &connection) {
+			if (idleConnections.empty()) {
+				return false;
+			} else {
+				connection = idleConnections.back().connection;
+				idleConnections.pop_back();
+				reused++;
+				return true;
+			}
+		}
+	};
+
+	mutable ConnectionCacheSlot connectionCache[APP_CONNECTION_CACHE_SLOTS];
 
 	OXT_FORCE_INLINE
 	int connectionPoolLimit() const {
@@ -96,6 +182,22 @@ private:
 		return connection;
 	}
 
+	bool stealIdleConnection(unsigned int ownSlot, Connection &connection) {
+		for (unsigned int i = 1; i < APP_CONNECTION_CACHE_SLOTS; i++) {
+			ConnectionCacheSlot &slot =
+				connectionCache[(ownSlot + i) % APP_CONNECTION_CACHE_SLOTS];
+			if (slot.lock.try_lock()) {
+				bool result = slot.tryCheckout(connection);
+				slot.lock.unlock();
+				if (result) {
+					idleConnectionCount.fetch_sub(1, boost::memory_order_relaxed);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
 public:
 	// Socket properties. Read-only.
 	StaticString name;
@@ -105,15 +207,19 @@ public:
 	int concurrency;
 
 	// Private. In public section as alignment optimization.
-	int totalConnections;
-	int totalIdleConnections;
+	boost::atomic<int> totalConnections;
+	/** The number of connections in all connection cache slots. */
+	boost::atomic<int> idleConnectionCount;
 
 	/** Invariant: sessions >= 0 */
 	int sessions;
 
 	Socket()
 		: pid(-1),
-		  concurrency(0)
+		  concurrency(0),
+		  totalConnections(0),
+		  idleConnectionCount(0),
+		  sessions(0)
 		{ }
 
 	Socket(pid_t _pid, const StaticString &_name, const StaticString &_address,
@@ -124,26 +230,31 @@ public:
 		  pid(_pid),
 		  concurrency(_concurrency),
 		  totalConnections(0),
-		  totalIdleConnections(0),
+		  idleConnectionCount(0),
 		  sessions(0)
 		{ }
 
 	Socket(const Socket &other)
-		: idleConnections(other.idleConnections),
-		  name(other.name),
+		: name(other.name),
 		  address(other.address),
 		  protocol(other.protocol),
 		  pid(other.pid),
 		  concurrency(other.concurrency),
-		  totalConnections(other.totalConnections),
-		  totalIdleConnections(other.totalIdleConnections),
+		  totalConnections(other.totalConnections.load(boost::memory_order_relaxed)),
+		  idleConnectionCount(other.idleConnectionCount.load(boost::memory_order_relaxed)),
 		  sessions(other.sessions)
-		{ }
+	{
+		std::copy(other.connectionCache, other.connectionCache + APP_CONNECTION_CACHE_SLOTS,
+			connectionCache);
+	}
 
 	Socket &operator=(const Socket &other) {
-		totalConnections = other.totalConnections;
-		totalIdleConnections = other.totalIdleConnections;
-		idleConnections = other.idleConnections;
+		totalConnections.store(other.totalConnections.load(boost::memory_order_relaxed),
+			boost::memory_order_relaxed);
+		idleConnectionCount.store(other.idleConnectionCount.load(boost::memory_order_relaxed),
+			boost::memory_order_relaxed);
+		std::copy(other.connectionCache, other.connectionCache + APP_CONNECTION_CACHE_SLOTS,
+			connectionCache);
 		name = other.name;
 		address = other.address;
 		protocol = other.protocol;
@@ -160,62 +271,154 @@ public:
 	 * Failure to do so will result in a resource leak.
 	 */
 	Connection checkoutConnection() {
-		boost::unique_lock<boost::mutex> l(connectionPoolLock);
-
-		if (!idleConnections.empty()) {
-			P_TRACE(3, "Socket " << address << ": checking out connection from connection pool (" <<
-				idleConnections.size() << " -> " << (idleConnections.size() - 1) <<
-				" items). Current total number of connections: " << totalConnections);
-			Connection connection = idleConnections.back();
-			idleConnections.pop_back();
-			totalIdleConnections--;
-			return connection;
-		} else {
-			Connection connection = connect();
-			totalConnections++;
-			P_TRACE(3, "Socket " << address << ": there are now " <<
-				totalConnections << " total connections");
-			l.unlock();
+		unsigned int slotIndex = getConnectionCacheSlot();
+		ConnectionCacheSlot &slot = connectionCache[slotIndex];
+		Connection connection;
+		bool result;
+
+		slot.lock.lock();
+		result = slot.tryCheckout(connection);
+		slot.lock.unlock();
+		if (result) {
+			idleConnectionCount.fetch_sub(1, boost::memory_order_relaxed);
+		}
+		if (result || stealIdleConnection(slotIndex, connection)) {
+			P_TRACE(3, "Socket " << address << ": checked out connection from "
+				"connection pool. Current total number of connections: " <<
+				totalConnections.load(boost::memory_order_relaxed));
 			return connection;
 		}
+
+		connection = connect();
+		slot.lock.lock();
+		slot.connected++;
+		slot.lock.unlock();
+		int total = totalConnections.fetch_add(1, boost::memory_order_relaxed) + 1;
+		P_TRACE(3, "Socket " << address << ": there are now " <<
+			total << " total connections");
+		(void) total;
+		return connection;
 	}
 
+	/**
+	 * Returns the connection to the calling thread's slot in the connection
+	 * pool, or closes it if it cannot be reused or if the connection pool
+	 * is full.
+	 */
 	void checkinConnection(Connection &connection) {
-		boost::unique_lock<boost::mutex> l(connectionPoolLock);
-
-		if (connection.fail || !connection.wantKeepAlive || totalIdleConnections >= connectionPoolLimit()) {
-			totalConnections--;
-			assert(totalConnections >= 0);
-			P_TRACE(3, "Socket " << address << ": connection not checked back into "
-				"connection pool. There are now " << totalConnections <<
-				" connections in total");
-			l.unlock();
-			connection.close();
-		} else {
-			P_TRACE(3, "Socket " << address << ": checking in connection into connection pool (" <<
-				totalIdleConnections << " -> " << (totalIdleConnections + 1) <<
-				" items). Current total number of connections: " << totalConnections);
-			totalIdleConnections++;
-			idleConnections.push_back(connection);
+		if (!connection.fail && connection.wantKeepAlive) {
+			// Reserve a place in the connection pool before adding
+			// the connection to a slot.
+			if (idleConnectionCount.fetch_add(1, boost::memory_order_relaxed)
+				< connectionPoolLimit())
+			{
+				ConnectionCacheSlot &slot = connectionCache[getConnectionCacheSlot()];
+				unsigned long long now = SystemTime::getUsec();
+				oxt::spin_lock::scoped_lock l(slot.lock);
+				slot.idleConnections.push_back(IdleConnection(connection, now));
+				return;
+			}
+			idleConnectionCount.fetch_sub(1, boost::memory_order_relaxed);
+		}
+
+		int total = totalConnections.fetch_sub(1, boost::memory_order_relaxed) - 1;
+		assert(total >= 0);
+		P_TRACE(3, "Socket " << address << ": connection not checked back into "
+			"connection pool. There are now " << total <<
+			" connections in total");
+		(void) total;
+		connection.close();
+	}
+
+	/**
+	 * Closes all idle connections that were checked in before the given time
+	 * (in microseconds). Returns the time at which the oldest remaining idle
+	 * connection was checked in, or 0 if there are none left.
+	 */
+	unsigned long long closeIdleConnections(unsigned long long checkedInBefore) {
+		unsigned long long oldest = 0;
+
+		for (unsigned int i = 0; i < APP_CONNECTION_CACHE_SLOTS; i++) {
+			ConnectionCacheSlot &slot = connectionCache[i];
+			SmallVector<Connection, 4> connectionsToClose;
+			{
+				oxt::spin_lock::scoped_lock l(slot.lock);
+				vector<IdleConnection>::iterator it = slot.idleConnections.begin();
+				while (it != slot.idleConnections.end()) {
+					if (it->idleSince < checkedInBefore) {
+						connectionsToClose.push_back(it->connection);
+						it = slot.idleConnections.erase(it);
+					} else {
+						if (oldest == 0 || it->idleSince < oldest) {
+							oldest = it->idleSince;
+						}
+						it++;
+					}
+				}
+			}
+
+			SmallVector<Connection, 4>::iterator it, end = connectionsToClose.end();
+			for (it = connectionsToClose.begin(); it != end; it++) {
+				P_TRACE(3, "Socket " << address << ": closing idle connection");
+				totalConnections.fetch_sub(1, boost::memory_order_relaxed);
+				idleConnectionCount.fetch_sub(1, boost::memory_order_relaxed);
+				try {
+					it->close();
+				} catch (const SystemException &e) {
+					P_ERROR("Cannot close a connection with socket " << address << ": " << e.what());
+				}
+			}
 		}
+
+		return oldest;
 	}
 
 	void closeAllConnections() {
-		boost::unique_lock<boost::mutex> l(connectionPoolLock);
 		assert(sessions == 0);
-		assert(totalConnections == totalIdleConnections);
-		vector<Connection>::iterator it, end = idleConnections.end();
-
-		for (it = idleConnections.begin(); it != end; it++) {
-			try {
-				it->close();
-			} catch (const SystemException &e) {
-				P_ERROR("Cannot close a connection with socket " << address << ": " << e.what());
+		assert(totalConnections.load(boost::memory_order_relaxed) == getIdleConnectionCount());
+		for (unsigned int i = 0; i < APP_CONNECTION_CACHE_SLOTS; i++) {
+			ConnectionCacheSlot &slot = connectionCache[i];
+			oxt::spin_lock::scoped_lock l(slot.lock);
+			vector<IdleConnection>::iterator it, end = slot.idleConnections.end();
+
+			for (it = slot.idleConnections.begin(); it != end; it++) {
+				try {
+					it->connection.close();
+				} catch (const SystemException &e) {
+					P_ERROR("Cannot close a connection with socket " << address << ": " << e.what());
+				}
 			}
+			slot.idleConnections.clear();
+		}
+		totalConnections.store(0, boost::memory_order_relaxed);
+		idleConnectionCount.store(0, boost::memory_order_relaxed);
+	}
+
+	int getIdleConnectionCount() const {
+		int result = 0;
+		for (unsigned int i = 0; i < APP_CONNECTION_CACHE_SLOTS; i++) {
+			ConnectionCacheSlot &slot = connectionCache[i];
+			oxt::spin_lock::scoped_lock l(slot.lock);
+			result += slot.idleConnections.size();
+		}
+		return result;
+	}
+
+	/**
+	 * Returns the number of connection checkouts that reused an idle connection,
+	 * and the number of checkouts that had to connect() to the socket.
+	 */
+	void getConnectionStatistics(unsigned long long &reused,
+		unsigned long long &connected) const
+	{
+		reused = 0;
+		connected = 0;
+		for (unsigned int i = 0; i < APP_CONNECTION_CACHE_SLOTS; i++) {
+			ConnectionCacheSlot &slot = connectionCache[i];
+			oxt::spin_lock::scoped_lock l(slot.lock);
+			reused += slot.reused;
+			connected += slot.connected;
 		}
-		idleConnections.clear();
-		totalConnections = 0;
-		totalIdleConnections = 0;
 	}
 
 
@@ -50,6 +50,7 @@ private:
 	SocketPair connection;
 	BufferedIO peerBufferedIO;
 	unsigned int stickySessionId;
+	bool lastFreeSlot;
 	mutable bool closed;
 	mutable bool success;
 	mutable bool wantKeepAlive;
@@ -61,6 +62,7 @@ public:
 		  gupid("gupid-123"),
 		  protocol("session"),
 		  stickySessionId(0),
+		  lastFreeSlot(false),
 		  closed(false),
 		  success(false),
 		  wantKeepAlive(false)
@@ -129,6 +131,16 @@ public:
 		return apiKey;
 	}
 
+	virtual bool tookLastFreeSlot() const {
+		boost::lock_guard<boost::mutex> l(syncher);
+		return lastFreeSlot;
+	}
+
+	void setTookLastFreeSlot(bool v) {
+		boost::lock_guard<boost::mutex> l(syncher);
+		lastFreeSlot = v;
+	}
+
 	virtual int fd() const {
 		boost::lock_guard<boost::mutex> l(syncher);
 		return connection.first;
@@ -82,6 +82,7 @@
 #include <Core/Controller/Client.h>
 #include <Core/Controller/AppResponse.h>
 #include <Core/Controller/TurboCaching.h>
+#include <Core/Controller/OpenFileCache.h>
 #include <Core/UnionStation/Context.h>
 
 namespace Passenger {
@@ -122,6 +123,19 @@ private:
 	// If you change this value, make sure that Request::sessionCheckoutTry
 	// has enough bits.
 	static const unsigned int MAX_SESSION_CHECKOUT_TRY = 10;
+	// Responses are only spliced if at least this many body bytes remain.
+	static const unsigned int MIN_SPLICED_RESPONSE_BODY_SIZE = 1024 * 1024;
+	static const unsigned int RESPONSE_SPLICE_PIPE_SIZE = 256 * 1024;
+	// Maximum number of splice() rounds before yielding to the event loop.
+	static const unsigned int MAX_RESPONSE_SPLICE_ROUNDS = 16;
+	// If the client accepts no data for this many milliseconds while a response
+	// is being spliced, then the rest of the response body is buffered instead.
+	static const unsigned int RESPONSE_SPLICE_CLIENT_STALL_TIMEOUT = 100;
+	static const unsigned int OPEN_FILE_CACHE_SIZE = 64;
+	// Maximum number of bytes that a single sendfile() call may send.
+	static const unsigned int MAX_SENDFILE_CHUNK_SIZE = 1024 * 1024;
+	// Maximum number of sendfile() rounds before yielding to the event loop.
+	static const unsigned int MAX_SENDFILE_ROUNDS = 16;
 
 	unsigned int statThrottleRate;
 	unsigned int responseBufferHighWatermark;
@@ -129,6 +143,8 @@ private:
 	bool singleAppMode: 1;
 	bool showVersionInHeader: 1;
 	bool stickySessions: 1;
+	bool coalesceChunkedFrames: 1;
+	bool spliceResponses: 1;
 	bool gracefulExit: 1;
 
 	const VariantMap *agentsOptions;
@@ -145,6 +161,12 @@ private:
 	StaticString serverSoftware;
 	StaticString defaultStickySessionsCookieName;
 	StaticString defaultVaryTurbocacheByCookie;
+	/** Directory that internal redirect paths are resolved against. */
+	StaticString internalRedirectRoot;
+	/** Lowercase name of the app response header that triggers an internal
+	 * redirect. Empty if internal redirects are disabled.
+	 */
+	HashedStaticString internalRedirectHeader;
 
 	HashedStaticString PASSENGER_APP_GROUP_NAME;
 	HashedStaticString PASSENGER_ENV_VARS;
@@ -166,9 +188,24 @@ private:
 	HashedStaticString HTTP_CONNECTION;
 	HashedStaticString HTTP_STATUS;
 	HashedStaticString HTTP_TRANSFER_ENCODING;
+	HashedStaticString HTTP_RANGE;
+	HashedStaticString HTTP_IF_RANGE;
+	HashedStaticString HTTP_ACCEPT_RANGES;
+	HashedStaticString HTTP_CONTENT_RANGE;
 
 	unsigned int threadNumber;
 	StaticString serverLogName;
+	/** This thread's ring for batched Union Station logging, or NULL if
+	 * transaction messages are written synchronously.
+	 */
+	UnionStation::LogRing *unionStationLogRing;
+
+	unsigned int splicedResponses;
+	unsigned int responseSpliceFallbacks;
+	boost::uint64_t splicedResponseBytes;
+	unsigned int internalRedirects;
+	boost::uint64_t internalRedirectBytes;
+	OpenFileCache openFileCache;
 
 	friend class TurboCaching<Request>;
 	friend class ResponseCache<Request>;
@@ -188,6 +225,8 @@ private:
 	void initializeFlags(Client *client, Request *req, RequestAnalysis &analysis);
 	bool respondFromTurboCache(Client *client, Request *req);
 	void initializePoolOptions(Client *client, Request *req, RequestAnalysis &analysis);
+	void usePoolOptions(Request *req, const Options *options);
+	void applyPerRequestPoolOptions(Request *req);
 	void fillPoolOptionsFromAgentsOptions(Options &options);
 	static void fillPoolOption(Request *req, StaticString &field,
 		const HashedStaticString &name);
@@ -220,8 +259,15 @@ private:
 	/****** Stage: checkout session ******/
 
 	void checkoutSession(Client *client, Request *req);
+	void prefetchSession(Client *client, Request *req);
 	static void sessionCheckedOut(const AbstractSessionPtr &session,
 		const ExceptionPtr &e, void *userData);
+	static void sessionPrefetched(const AbstractSessionPtr &session,
+		const ExceptionPtr &e, void *userData);
+	void sessionPrefetchedFromAnotherThread(Client *client, Request *req,
+		AbstractSessionPtr session, ExceptionPtr e);
+	void sessionPrefetchedFromEventLoopThread(Client *client, Request *req,
+		const AbstractSessionPtr &session, const ExceptionPtr &e);
 	void sessionCheckedOutFromAnotherThread(Client *client, Request *req,
 		AbstractSessionPtr session, ExceptionPtr e);
 	void sessionCheckedOutFromEventLoopThread(Client *client, Request *req,
@@ -318,6 +364,36 @@ private:
 	void finalizeUnionStationWithSuccess(Client *client, Request *req);
 
 
+	/****** Stage: splice application response body to client ******/
+
+	bool shouldSpliceResponse(Client *client, Request *req);
+	void startSplicingResponse(Client *client, Request *req);
+	#ifdef PSG_HAVE_SPLICE
+		static void _onResponseSpliceIoReady(EV_P_ struct ev_io *io, int revents);
+		static void _onResponseSpliceStalled(EV_P_ struct ev_timer *timer, int revents);
+		void pumpResponseSplice(Client *client, Request *req);
+		void waitForClientDuringResponseSplice(Client *client, Request *req);
+		void fallBackFromResponseSplice(Client *client, Request *req);
+		void stopSplicingResponse(Client *client, Request *req);
+	#endif
+
+
+	/****** Stage: serve internal redirect target ******/
+
+	bool shouldServeInternalRedirect(Client *client, Request *req);
+	bool prepareInternalRedirect(Client *client, Request *req);
+	void startSendingInternalRedirect(Client *client, Request *req);
+	#ifdef PSG_HAVE_SENDFILE
+		bool resolveInternalRedirectPath(Request *req, StaticString &path);
+		void releaseSessionForInternalRedirect(Client *client, Request *req);
+		void applyRangeToInternalRedirect(Client *client, Request *req);
+		static void _onInternalRedirectClientWritable(EV_P_ struct ev_io *io, int revents);
+		static void _internalRedirectOutputFlushed(FileBufferedChannel *_channel);
+		void pumpInternalRedirect(Client *client, Request *req);
+		void stopInternalRedirect(Client *client, Request *req);
+	#endif
+
+
 	/***** Hooks ******/
 
 	static Channel::Result onBodyBufferData(Channel *_channel,
@@ -365,6 +441,7 @@ protected:
 	/****** Stage: initiatelize request ******/
 
 	virtual void onRequestBegin(Client *client, Request *req);
+	virtual void onPipelinedRequestParsed(Client *client, Request *req);
 
 
 	/****** Hooks ******/
@@ -398,7 +475,8 @@ public:
 	/****** Initialization and shutdown ******/
 
 	Controller(ServerKit::Context *context, const VariantMap *_agentsOptions,
-		unsigned int _threadNumber = 1);
+		unsigned int _threadNumber = 1,
+		SharedResponseCache<Request> *sharedResponseCache = NULL);
 	virtual ~Controller();
 	void initialize();
 
@@ -418,6 +496,19 @@ public:
 	virtual Json::Value inspectRequestStateAsJson(const Request *req) const;
 
 
+	/****** Request initialization (for microbenchmarks) ******/
+
+	void initializeSingleAppPoolOptions(Request *req);
+
+
+	/****** Request header construction (for microbenchmarks) ******/
+
+	unsigned int constructSessionProtocolHeader(Request *req, char *buffer,
+		unsigned int bufsize);
+	unsigned int constructHttpProtocolHeaderBuffers(Request *req,
+		struct iovec *buffers, unsigned int maxbuffers, unsigned int &dataSize);
+
+
 	/****** Miscellaneous *******/
 
 	static BenchmarkMode parseBenchmarkMode(const StaticString mode);
@@ -61,6 +61,18 @@ Controller::checkoutSession(Client *client, Request *req) {
 		assert(!req->bodyChannel.isStarted());
 	}
 
+	if (req->prefetchingSession) {
+		// Continues in sessionPrefetchedFromEventLoopThread().
+		SKC_TRACE(client, 2, "Waiting for prefetched session");
+		return;
+	} else if (req->prefetchedSession != NULL) {
+		AbstractSessionPtr session;
+		session.swap(req->prefetchedSession);
+		SKC_TRACE(client, 2, "Using prefetched session");
+		sessionCheckedOutFromEventLoopThread(client, req, session, ExceptionPtr());
+		return;
+	}
+
 	callback.func = sessionCheckedOut;
 	callback.userData = req;
 
@@ -81,6 +93,36 @@ Controller::checkoutSession(Client *client, Request *req) {
 	#endif
 }
 
+/**
+ * Checks out a session for a pipelined request before it becomes the
+ * client's current request, so that the app is ready for it by the time
+ * the previous request is done. checkoutSession() picks up the result.
+ *
+ * A prefetched session occupies one of the process's slots while the
+ * previous request is still running. It is only kept if the process has
+ * slots left for other clients; see sessionPrefetchedFromEventLoopThread().
+ */
+void
+Controller::prefetchSession(Client *client, Request *req) {
+	GetCallback callback;
+
+	SKC_TRACE(client, 2, "Prefetching session for pipelined request: appRoot=" <<
+		req->options.appRoot);
+	assert(!req->useUnionStation());
+	req->prefetchingSession = true;
+
+	callback.func = sessionPrefetched;
+	callback.userData = req;
+
+	req->options.currentTime = (unsigned long long) (ev_now(getLoop()) * 1000000);
+
+	refRequest(req, __FILE__, __LINE__);
+	#ifdef DEBUG_CC_EVENT_LOOP_BLOCKING
+		req->timeBeforeAccessingApplicationPool = ev_now(getLoop());
+	#endif
+	asyncGetFromApplicationPool(req, callback);
+}
+
 void
 Controller::asyncGetFromApplicationPool(Request *req, ApplicationPool2::GetCallback callback) {
 	appPool->asyncGet(req->options, callback, true,
@@ -116,6 +158,71 @@ Controller::sessionCheckedOutFromAnotherThread(Client *client, Request *req,
 	unrefRequest(req, __FILE__, __LINE__);
 }
 
+void
+Controller::sessionPrefetched(const AbstractSessionPtr &session, const ExceptionPtr &e,
+	void *userData)
+{
+	Request *req = static_cast<Request *>(userData);
+	Client *client = static_cast<Client *>(req->client);
+	Controller *self = static_cast<Controller *>(getServerFromClient(client));
+
+	if (self->getContext()->libev->onEventLoopThread()) {
+		self->sessionPrefetchedFromEventLoopThread(client, req, session, e);
+		self->unrefRequest(req, __FILE__, __LINE__);
+	} else {
+		self->getContext()->libev->runLater(
+			boost::bind(&Controller::sessionPrefetchedFromAnotherThread,
+				self, client, req, session, e));
+	}
+}
+
+void
+Controller::sessionPrefetchedFromAnotherThread(Client *client, Request *req,
+	AbstractSessionPtr session, ExceptionPtr e)
+{
+	SKC_LOG_EVENT(Controller, client, "sessionPrefetchedFromAnotherThread");
+	sessionPrefetchedFromEventLoopThread(client, req, session, e);
+	unrefRequest(req, __FILE__, __LINE__);
+}
+
+void
+Controller::sessionPrefetchedFromEventLoopThread(Client *client, Request *req,
+	const AbstractSessionPtr &session, const ExceptionPtr &e)
+{
+	req->prefetchingSession = false;
+	if (req->ended()) {
+		// The session, if any, is closed when it goes out of scope.
+		return;
+	}
+
+	if (req->state == Request::CHECKING_OUT_SESSION) {
+		// The request has become the current request in the mean time,
+		// and checkoutSession() is waiting for us.
+		if (e == NULL) {
+			sessionCheckedOutFromEventLoopThread(client, req, session, e);
+		} else {
+			// Retry, so that errors are handled and logged
+			// like any other checkout error.
+			checkoutSession(client, req);
+		}
+	} else if (e == NULL && session->tookLastFreeSlot()) {
+		// Holding on to the session would keep other clients' requests
+		// from being routed to this process, even though the session
+		// stays idle until the previous request is done.
+		SKC_TRACE(client, 2, "Prefetched session took the last free slot of " <<
+			"process " << session->getPid() << "; releasing it and checking out " <<
+			"a session after the previous request is done");
+		session->close(false);
+	} else if (e == NULL) {
+		SKC_TRACE(client, 2, "Session prefetched: pid=" << session->getPid() <<
+			", gupid=" << session->getGupid());
+		req->prefetchedSession = session;
+	} else {
+		SKC_TRACE(client, 2, "Could not prefetch session; will check out "
+			"a session after the previous request is done");
+	}
+}
+
 void
 Controller::sessionCheckedOutFromEventLoopThread(Client *client, Request *req,
 	const AbstractSessionPtr &session, const ExceptionPtr &e)
@@ -207,6 +314,7 @@ Controller::initiateSession(Client *client, Request *req) {
 
 	UPDATE_TRACE_POINT();
 	SKC_DEBUG(client, "Session initiated: fd=" << req->session->fd());
+	req->sessionInitiatedAt = ev_now(getLoop());
 	req->appSink.reinitialize(req->session->fd());
 	req->appSource.reinitialize(req->session->fd());
 	/***************/
@@ -105,7 +105,15 @@ Controller::onAppSourceData(Client *client, Request *req, const MemoryKit::mbuf
 			case AppResponse::PARSING_CHUNKED_BODY:
 				SKC_TRACE(client, 2, "Expecting a chunked app response body");
 				prepareAppResponseChunkedBodyParsing(client, req);
+				if (coalesceChunkedFrames && !req->dechunkResponse && ret < buffer.size()) {
+					// The first chunks arrived together with the headers. Hold back
+					// the headers so that they're written together with those chunks.
+					client->output.cork();
+				}
 				onAppResponseBegin(client, req);
+				if (req->ended() || !req->appSource.isStarted()) {
+					client->output.uncork();
+				}
 				return Channel::Result(ret, false);
 			case AppResponse::UPGRADED:
 				SKC_TRACE(client, 2, "Application upgraded connection");
@@ -165,6 +173,8 @@ Controller::onAppSourceData(Client *client, Request *req, const MemoryKit::mbuf
 						SKC_TRACE(client, 2, "End of application response body reached");
 						handleAppResponseBodyEnd(client, req);
 						endRequest(&client, &req);
+					} else if (shouldSpliceResponse(client, req)) {
+						startSplicingResponse(client, req);
 					} else {
 						maybeThrottleAppSource(client, req);
 					}
@@ -241,9 +251,17 @@ Controller::onAppSourceData(Client *client, Request *req, const MemoryKit::mbuf
 				case ServerKit::HttpChunkedEvent::NONE:
 				case ServerKit::HttpChunkedEvent::DATA:
 					assert(!event.end);
+					if (coalesceChunkedFrames && event.consumed < buffer.size()) {
+						// More chunks follow in this buffer. Write them
+						// all at once when we've reached the end of it.
+						client->output.cork();
+					}
 					writeResponse(client, MemoryKit::mbuf(buffer, 0, event.consumed));
 					markResponsePartForTurboCaching(client, req, event.data);
 					maybeThrottleAppSource(client, req);
+					if (event.consumed == buffer.size() || !req->appSource.isStarted()) {
+						client->output.uncork();
+					}
 					return Channel::Result(event.consumed, false);
 				case ServerKit::HttpChunkedEvent::END:
 					assert(event.end);
@@ -251,6 +269,7 @@ Controller::onAppSourceData(Client *client, Request *req, const MemoryKit::mbuf
 					resp->aux.bodyInfo.endReached = true;
 					handleAppResponseBodyEnd(client, req);
 					writeResponse(client, MemoryKit::mbuf(buffer, 0, event.consumed));
+					client->output.uncork();
 					if (!req->ended()) {
 						endRequest(&client, &req);
 					}
@@ -317,7 +336,7 @@ Controller::onAppResponseBegin(Client *client, Request *req) {
 	TRACE_POINT();
 	AppResponse *resp = &req->appResponse;
 	ssize_t bytesWritten;
-	bool oobw;
+	bool oobw, internalRedirect;
 
 	#ifdef DEBUG_CC_EVENT_LOOP_BLOCKING
 		req->timeOnRequestHeaderSent = ev_now(getLoop());
@@ -357,8 +376,10 @@ Controller::onAppResponseBegin(Client *client, Request *req) {
 			req->wantKeepAlive = false;
 		}
 	}
-	if (resp->headers.lookup(ServerKit::HTTP_X_SENDFILE) != NULL
-	 || resp->headers.lookup(ServerKit::HTTP_X_ACCEL_REDIRECT) != NULL)
+	internalRedirect = shouldServeInternalRedirect(client, req);
+	if (!internalRedirect
+	 && (resp->headers.lookup(ServerKit::HTTP_X_SENDFILE) != NULL
+	  || resp->headers.lookup(ServerKit::HTTP_X_ACCEL_REDIRECT) != NULL))
 	{
 		// If X-Sendfile or X-Accel-Redirect is set, then HttpHeaderParser
 		// treats the app response as having no body, and removes the
@@ -370,6 +391,12 @@ Controller::onAppResponseBegin(Client *client, Request *req) {
 
 	prepareAppResponseCaching(client, req);
 
+	if (req->session != NULL && req->sessionInitiatedAt != 0) {
+		// Feeds latency-aware routing.
+		req->session->reportResponseTime((unsigned long long)
+			((ev_now(getLoop()) - req->sessionInitiatedAt) * 1000000));
+	}
+
 	if (OXT_UNLIKELY(oobw)) {
 		SKC_TRACE(client, 2, "Response with OOBW detected");
 		if (req->session != NULL) {
@@ -377,8 +404,16 @@ Controller::onAppResponseBegin(Client *client, Request *req) {
 		}
 	}
 
+	if (OXT_UNLIKELY(internalRedirect) && !prepareInternalRedirect(client, req)) {
+		return;
+	}
+
 	UPDATE_TRACE_POINT();
-	if (!sendResponseHeaderWithWritev(client, req, bytesWritten)) {
+	if (client->output.isCorked() && benchmarkMode != BM_RESPONSE_BEGIN) {
+		// The caller wants the headers to be written together with
+		// the body data that follows.
+		sendResponseHeaderWithBuffering(client, req, 0);
+	} else if (!sendResponseHeaderWithWritev(client, req, bytesWritten)) {
 		UPDATE_TRACE_POINT();
 		if (bytesWritten >= 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
 			sendResponseHeaderWithBuffering(client, req, bytesWritten);
@@ -389,7 +424,12 @@ Controller::onAppResponseBegin(Client *client, Request *req) {
 		}
 	}
 
-	if (!req->ended() && !resp->hasBody() && !resp->upgraded()) {
+	if (req->ended()) {
+		return;
+	} else if (OXT_UNLIKELY(internalRedirect)) {
+		UPDATE_TRACE_POINT();
+		startSendingInternalRedirect(client, req);
+	} else if (!resp->hasBody() && !resp->upgraded()) {
 		UPDATE_TRACE_POINT();
 		handleAppResponseBodyEnd(client, req);
 		endRequest(&client, &req);
@@ -988,7 +1028,7 @@ Controller::markResponsePartForTurboCaching(Client *client, Request *req,
 		unsigned int totalSize = req->appResponse.bodyCacheBuffer.size + buffer.size();
 		if (totalSize > ResponseCache<Request>::MAX_BODY_SIZE) {
 			SKC_DEBUG(client, "Response body larger than " <<
-				ResponseCache<Request>::MAX_HEADER_SIZE <<
+				ResponseCache<Request>::MAX_BODY_SIZE <<
 				" bytes, so response is not eligible for turbocaching");
 			// Decrease store success ratio.
 			turboCaching.responseCache.incStores();
@@ -1118,18 +1158,24 @@ Controller::storeAppResponseInTurboCache(Client *client, Request *req) {
 			SKC_DEBUG(client, "Storing app response in turbocache");
 			SKC_TRACE(client, 2, "Turbocache entries:\n" << turboCaching.responseCache.inspect());
 
-			gatherBuffers(entry.body->httpHeaderData,
-				ResponseCache<Request>::MAX_HEADER_SIZE,
-				resp->headerCacheBuffers, resp->nHeaderCacheBuffers);
+			unsigned int offset = 0;
+			for (i = 0; i < resp->nHeaderCacheBuffers; i++) {
+				turboCaching.responseCache.storeHeaderData(entry, offset,
+					(const char *) resp->headerCacheBuffers[i].iov_base,
+					resp->headerCacheBuffers[i].iov_len);
+				offset += resp->headerCacheBuffers[i].iov_len;
+			}
 
-			char *pos = entry.body->httpBodyData;
-			const char *end = entry.body->httpBodyData
-				+ ResponseCache<Request>::MAX_BODY_SIZE;
+			offset = 0;
 			const LString::Part *part = resp->bodyCacheBuffer.start;
 			while (part != NULL) {
-				pos = appendData(pos, end, part->data, part->size);
+				turboCaching.responseCache.storeBodyData(entry, offset,
+					part->data, part->size);
+				offset += part->size;
 				part = part->next;
 			}
+
+			turboCaching.responseCache.commit(entry);
 		} else {
 			SKC_DEBUG(client, "Could not store app response for turbocaching");
 		}
@@ -107,6 +107,19 @@ Controller::onRequestObjectCreated(Client *client, Request *req) {
 	req->bodyBuffer.setContext(getContext());
 	req->bodyBuffer.setHooks(&req->hooks);
 	req->bodyBuffer.setDataCallback(onBodyBufferData);
+
+	#ifdef PSG_HAVE_SPLICE
+		ev_init(&req->responseSpliceWatcher, _onResponseSpliceIoReady);
+		req->responseSpliceWatcher.data = req;
+		ev_init(&req->responseSpliceStallTimer, _onResponseSpliceStalled);
+		req->responseSpliceStallTimer.data = req;
+		req->responseSplicePipe[0] = -1;
+		req->responseSplicePipe[1] = -1;
+	#endif
+	#ifdef PSG_HAVE_SENDFILE
+		ev_init(&req->internalRedirectWatcher, _onInternalRedirectClientWritable);
+		req->internalRedirectWatcher.data = req;
+	#endif
 }
 
 void
@@ -124,6 +137,7 @@ Controller::reinitializeRequest(Client *client, Request *req) {
 	// appSink and appSource are initialized in Controller::checkoutSession().
 
 	req->startedAt = 0;
+	req->sessionInitiatedAt = 0;
 	req->state = Request::ANALYZING_REQUEST;
 	req->dechunkResponse = false;
 	req->requestBodyBuffering = false;
@@ -134,6 +148,8 @@ Controller::reinitializeRequest(Client *client, Request *req) {
 	req->appResponseInitialized = false;
 	req->strip100ContinueHeader = false;
 	req->hasPragmaHeader = false;
+	req->responseSpliceTried = false;
+	req->prefetchingSession = false;
 	req->host = NULL;
 	req->bodyBytesBuffered = 0;
 	req->cacheKey = HashedStaticString();
@@ -153,7 +169,15 @@ Controller::reinitializeRequest(Client *client, Request *req) {
 
 void
 Controller::deinitializeRequest(Client *client, Request *req) {
+	#ifdef PSG_HAVE_SPLICE
+		// Must happen before the session closes the app socket.
+		stopSplicingResponse(client, req);
+	#endif
+	#ifdef PSG_HAVE_SENDFILE
+		stopInternalRedirect(client, req);
+	#endif
 	req->session.reset();
+	req->prefetchedSession.reset();
 
 	req->endStopwatchLog(&req->stopwatchLogs.getFromPool, false);
 	req->endStopwatchLog(&req->stopwatchLogs.bufferingRequestBody, false);
@@ -30,6 +30,8 @@
 #include <Core/Controller/CheckoutSession.cpp>
 #include <Core/Controller/SendRequest.cpp>
 #include <Core/Controller/ForwardResponse.cpp>
+#include <Core/Controller/SpliceResponse.cpp>
+#include <Core/Controller/InternalRedirect.cpp>
 #include <Core/Controller/Hooks.cpp>
 #include <Core/Controller/InitializationAndShutdown.cpp>
 #include <Core/Controller/InternalUtils.cpp>
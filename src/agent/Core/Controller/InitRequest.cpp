@@ -139,7 +139,7 @@ Controller::initializePoolOptions(Client *client, Request *req, RequestAnalysis
 	if (singleAppMode) {
 		P_ASSERT_EQ(poolOptionsCache.size(), 1);
 		poolOptionsCache.lookupRandom(NULL, &options);
-		req->options = **options;
+		usePoolOptions(req, options->get());
 	} else {
 		ServerKit::HeaderTable::Cell *appGroupNameCell = analysis.appGroupNameCell;
 		if (appGroupNameCell != NULL && appGroupNameCell->header->val.size > 0) {
@@ -152,7 +152,7 @@ Controller::initializePoolOptions(Client *client, Request *req, RequestAnalysis
 			poolOptionsCache.lookup(hAppGroupName, &options);
 
 			if (options != NULL) {
-				req->options = **options;
+				usePoolOptions(req, options->get());
 			} else {
 				createNewPoolOptions(client, req, hAppGroupName);
 			}
@@ -162,20 +162,58 @@ Controller::initializePoolOptions(Client *client, Request *req, RequestAnalysis
 	}
 
 	if (!req->ended()) {
-		// See comment for req->envvars to learn how it is different
-		// from req->options.environmentVariables.
-		req->envvars = req->secureHeaders.lookup(PASSENGER_ENV_VARS);
-		if (req->envvars != NULL && req->envvars->size > 0) {
-			req->envvars = psg_lstr_make_contiguous(req->envvars, req->pool);
-			req->options.environmentVariables = StaticString(
-				req->envvars->start->data,
-				req->envvars->size);
-		}
+		applyPerRequestPoolOptions(req);
+	}
+}
 
-		fillPoolOption(req, req->options.maxRequests, PASSENGER_MAX_REQUESTS);
+/**
+ * Makes `req->options` equal to the given cached pool options. The
+ * request object may still hold a copy of those from a previous request,
+ * in which case only the fields that applyPerRequestPoolOptions() and
+ * later stages may have overridden are restored. This avoids copying the
+ * whole Options struct, and the reference counting on its string storage,
+ * for most requests.
+ */
+void
+Controller::usePoolOptions(Request *req, const Options *options) {
+	if (OXT_LIKELY(req->baseOptions == options)) {
+		req->options.restorePerRequestFields(*options);
+	} else {
+		req->options = *options;
+		req->baseOptions = options;
 	}
 }
 
+void
+Controller::applyPerRequestPoolOptions(Request *req) {
+	// See comment for req->envvars to learn how it is different
+	// from req->options.environmentVariables.
+	req->envvars = req->secureHeaders.lookup(PASSENGER_ENV_VARS);
+	if (req->envvars != NULL && req->envvars->size > 0) {
+		req->envvars = psg_lstr_make_contiguous(req->envvars, req->pool);
+		req->options.environmentVariables = StaticString(
+			req->envvars->start->data,
+			req->envvars->size);
+	}
+
+	fillPoolOption(req, req->options.maxRequests, PASSENGER_MAX_REQUESTS);
+}
+
+/**
+ * Initializes `req->options` in single-app mode, exactly like
+ * initializePoolOptions() does, except that it doesn't check whether the
+ * client is still connected.
+ */
+void
+Controller::initializeSingleAppPoolOptions(Request *req) {
+	boost::shared_ptr<Options> *options;
+
+	P_ASSERT_EQ(poolOptionsCache.size(), 1);
+	poolOptionsCache.lookupRandom(NULL, &options);
+	usePoolOptions(req, options->get());
+	applyPerRequestPoolOptions(req);
+}
+
 void
 Controller::fillPoolOptionsFromAgentsOptions(Options &options) {
 	options.ruby = defaultRuby;
@@ -203,8 +241,14 @@ Controller::fillPoolOptionsFromAgentsOptions(Options &options) {
 		options.defaultGroup = agentsOptions->get("default_group");
 	}
 	options.minProcesses = agentsOptions->getInt("min_instances");
+	options.spawnConcurrency = agentsOptions->getInt("spawn_concurrency");
+	options.standbyProcesses = agentsOptions->getInt("standby_processes");
+	options.predictiveScaling = agentsOptions->getBool("predictive_scaling");
+	options.memoryLimit = agentsOptions->getInt("memory_limit");
+	options.memoryLimitRecyclePercentage = agentsOptions->getInt("memory_limit_recycle_percentage");
 	options.maxPreloaderIdleTime = agentsOptions->getInt("max_preloader_idle_time");
 	options.maxRequestQueueSize = agentsOptions->getInt("max_request_queue_size");
+	options.routingPolicy = agentsOptions->get("routing_policy");
 	options.abortWebsocketsOnProcessShutdown = agentsOptions->getBool("abort_websockets_on_process_shutdown");
 	options.forceMaxConcurrentRequestsPerProcess = agentsOptions->getInt("force_max_concurrent_requests_per_process");
 	options.spawnMethod = agentsOptions->get("spawn_method");
@@ -300,6 +344,7 @@ Controller::createNewPoolOptions(Client *client, Request *req,
 	SKC_TRACE(client, 2, "Creating new pool options: app group name=" << appGroupName);
 
 	options = Options();
+	req->baseOptions = NULL;
 
 	const LString *scriptName = secureHeaders.lookup("!~SCRIPT_NAME");
 	const LString *appRoot = secureHeaders.lookup("!~PASSENGER_APP_ROOT");
@@ -368,11 +413,17 @@ Controller::createNewPoolOptions(Client *client, Request *req,
 	fillPoolOption(req, options.group, "!~PASSENGER_GROUP");
 	fillPoolOption(req, options.minProcesses, "!~PASSENGER_MIN_PROCESSES");
 	fillPoolOption(req, options.maxProcesses, "!~PASSENGER_MAX_PROCESSES");
+	fillPoolOption(req, options.spawnConcurrency, "!~PASSENGER_SPAWN_CONCURRENCY");
+	fillPoolOption(req, options.standbyProcesses, "!~PASSENGER_STANDBY_PROCESSES");
+	fillPoolOption(req, options.predictiveScaling, "!~PASSENGER_PREDICTIVE_SCALING");
+	fillPoolOption(req, options.memoryLimit, "!~PASSENGER_MEMORY_LIMIT");
+	fillPoolOption(req, options.memoryLimitRecyclePercentage, "!~PASSENGER_MEMORY_LIMIT_RECYCLE_PERCENTAGE");
 	fillPoolOption(req, options.spawnMethod, "!~PASSENGER_SPAWN_METHOD");
 	fillPoolOption(req, options.startCommand, "!~PASSENGER_START_COMMAND");
 	fillPoolOptionSecToMsec(req, options.startTimeout, "!~PASSENGER_START_TIMEOUT");
 	fillPoolOption(req, options.maxPreloaderIdleTime, "!~PASSENGER_MAX_PRELOADER_IDLE_TIME");
 	fillPoolOption(req, options.maxRequestQueueSize, "!~PASSENGER_MAX_REQUEST_QUEUE_SIZE");
+	fillPoolOption(req, options.routingPolicy, "!~PASSENGER_ROUTING_POLICY");
 	fillPoolOption(req, options.abortWebsocketsOnProcessShutdown, "!~PASSENGER_ABORT_WEBSOCKETS_ON_PROCESS_SHUTDOWN");
 	fillPoolOption(req, options.forceMaxConcurrentRequestsPerProcess, "!~PASSENGER_FORCE_MAX_CONCURRENT_REQUESTS_PER_PROCESS");
 	fillPoolOption(req, options.restartDir, "!~PASSENGER_RESTART_DIR");
@@ -386,6 +437,7 @@ Controller::createNewPoolOptions(Client *client, Request *req,
 	optionsCopy->clearPerRequestFields();
 	optionsCopy->detachFromUnionStationTransaction();
 	poolOptionsCache.insert(options.getAppGroupName(), optionsCopy);
+	usePoolOptions(req, optionsCopy.get());
 }
 
 void
@@ -411,7 +463,8 @@ Controller::initializeUnionStation(Client *client, Request *req, RequestAnalysis
 			string(key->start->data, key->size),
 			(filters != NULL)
 				? string(filters->start->data, filters->size)
-				: string());
+				: string(),
+			unionStationLogRing);
 		if (!options.transaction->isNull()) {
 			options.analytics = true;
 			options.unionStationKey = StaticString(key->start->data, key->size);
@@ -516,6 +569,49 @@ Controller::onRequestBegin(Client *client, Request *req) {
 	}
 }
 
+void
+Controller::onPipelinedRequestParsed(Client *client, Request *req) {
+	ParentClass::onPipelinedRequestParsed(client, req);
+
+	RequestAnalysis analysis;
+	analysis.flags = NULL;
+	analysis.appGroupNameCell = singleAppMode
+		? NULL
+		: req->secureHeaders.lookupCell(PASSENGER_APP_GROUP_NAME);
+	analysis.unionStationSupport = unionStationContext != NULL
+		&& getBoolOption(req, UNION_STATION_SUPPORT, false);
+
+	// Only prefetch a session if initializePoolOptions() can't fail and
+	// no Union Station transaction is needed. Anything else is left to
+	// onRequestBegin(), which also reports errors.
+	if (analysis.unionStationSupport) {
+		return;
+	}
+	if (!singleAppMode) {
+		ServerKit::HeaderTable::Cell *appGroupNameCell = analysis.appGroupNameCell;
+		if (appGroupNameCell == NULL || appGroupNameCell->header->val.size == 0) {
+			return;
+		}
+		const LString *appGroupName = psg_lstr_make_contiguous(
+			&appGroupNameCell->header->val,
+			req->pool);
+		if (poolOptionsCache.lookupCell(HashedStaticString(appGroupName->start->data,
+			appGroupName->size)) == NULL)
+		{
+			return;
+		}
+	}
+
+	req->stickySession = getBoolOption(req, PASSENGER_STICKY_SESSIONS,
+		this->stickySessions);
+	initializePoolOptions(client, req, analysis);
+	if (req->ended()) {
+		return;
+	}
+	setStickySessionId(client, req);
+	prefetchSession(client, req);
+}
+
 
 } // namespace Core
 } // namespace Passenger
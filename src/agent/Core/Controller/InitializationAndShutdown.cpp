@@ -46,7 +46,7 @@ using namespace boost;
 
 
 Controller::Controller(ServerKit::Context *context, const VariantMap *_agentsOptions,
-	unsigned int _threadNumber)
+	unsigned int _threadNumber, SharedResponseCache<Request> *sharedResponseCache)
 	: ParentClass(context),
 
 	  statThrottleRate(_agentsOptions->getInt("stat_throttle_rate")),
@@ -55,6 +55,8 @@ Controller::Controller(ServerKit::Context *context, const VariantMap *_agentsOpt
 	  singleAppMode(false),
 	  showVersionInHeader(_agentsOptions->getBool("show_version_in_header")),
 	  stickySessions(_agentsOptions->getBool("sticky_sessions")),
+	  coalesceChunkedFrames(_agentsOptions->getBool("coalesce_chunked_frames", false, false)),
+	  spliceResponses(_agentsOptions->getBool("splice_responses", false, false)),
 	  gracefulExit(_agentsOptions->getBool("core_graceful_exit")),
 
 	  agentsOptions(_agentsOptions),
@@ -81,9 +83,25 @@ Controller::Controller(ServerKit::Context *context, const VariantMap *_agentsOpt
 	  HTTP_CONNECTION("connection"),
 	  HTTP_STATUS("status"),
 	  HTTP_TRANSFER_ENCODING("transfer-encoding"),
+	  HTTP_RANGE("range"),
+	  HTTP_IF_RANGE("if-range"),
+	  HTTP_ACCEPT_RANGES("accept-ranges"),
+	  HTTP_CONTENT_RANGE("content-range"),
 
 	  threadNumber(_threadNumber),
-	  turboCaching(getTurboCachingInitialState(_agentsOptions))
+	  unionStationLogRing(NULL),
+	  splicedResponses(0),
+	  responseSpliceFallbacks(0),
+	  splicedResponseBytes(0),
+	  internalRedirects(0),
+	  internalRedirectBytes(0),
+	  openFileCache(OPEN_FILE_CACHE_SIZE),
+	  turboCaching(getTurboCachingInitialState(_agentsOptions),
+		  _agentsOptions->getUint("turbocache_max_entries", false,
+			  DEFAULT_TURBOCACHE_MAX_ENTRIES),
+		  _agentsOptions->getULL("turbocache_max_size", false,
+			  DEFAULT_TURBOCACHE_MAX_SIZE),
+		  sharedResponseCache)
 {
 	defaultRuby = psg_pstrdup(stringPool,
 		agentsOptions->get("default_ruby"));
@@ -109,6 +127,18 @@ Controller::Controller(ServerKit::Context *context, const VariantMap *_agentsOpt
 			agentsOptions->get("vary_turbocache_by_cookie"));
 	}
 
+	if (!agentsOptions->get("internal_redirect_header", false).empty()
+	 && !agentsOptions->get("internal_redirect_root", false).empty())
+	{
+		string header = agentsOptions->get("internal_redirect_header");
+		char *downcasedHeader = (char *) psg_pnalloc(stringPool, header.size());
+		convertLowerCase((const unsigned char *) header.data(),
+			(unsigned char *) downcasedHeader, header.size());
+		internalRedirectHeader = HashedStaticString(downcasedHeader, header.size());
+		internalRedirectRoot = psg_pstrdup(stringPool,
+			agentsOptions->get("internal_redirect_root"));
+	}
+
 	generateServerLogName(_threadNumber);
 
 	if (!agentsOptions->getBool("multi_app")) {
@@ -159,6 +189,9 @@ Controller::initialize() {
 	if (unionStationContext == NULL) {
 		unionStationContext = appPool->getUnionStationContext();
 	}
+	if (unionStationContext != NULL) {
+		unionStationLogRing = unionStationContext->createLogRing();
+	}
 }
 
 
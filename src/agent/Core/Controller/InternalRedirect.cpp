@@ -0,0 +1,461 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2016 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#include <Core/Controller.h>
+
+#ifdef PSG_HAVE_SENDFILE
+	#include <sys/sendfile.h>
+#endif
+
+/*************************************************************************
+ *
+ * Implements Core::Controller methods pertaining to internal redirects.
+ * When the application responds with the configured internal redirect
+ * header (e.g. X-Sendfile or X-Accel-Redirect), the application session
+ * is released right away, and the file that the header points to is sent
+ * to the client with sendfile().
+ *
+ *************************************************************************/
+
+namespace Passenger {
+namespace Core {
+
+using namespace std;
+using namespace boost;
+
+
+/****************************
+ *
+ * Private methods
+ *
+ ****************************/
+
+
+#ifdef PSG_HAVE_SENDFILE
+
+enum ByteRangeParseResult {
+	BYTE_RANGE_IGNORED,
+	BYTE_RANGE_SATISFIABLE,
+	BYTE_RANGE_UNSATISFIABLE
+};
+
+static bool
+parseByteRangeNumber(const char *&pos, const char *end, boost::uint64_t &result) {
+	const char *begin = pos;
+
+	result = 0;
+	while (pos < end && *pos >= '0' && *pos <= '9') {
+		if (result > (~(boost::uint64_t) 0 - 9) / 10) {
+			return false;
+		}
+		result = result * 10 + (*pos - '0');
+		pos++;
+	}
+	return pos != begin;
+}
+
+/**
+ * Parses a Range header value as per RFC 7233. Only a single byte range is
+ * supported. Multiple ranges and malformed values are ignored, which means
+ * that the whole file is sent.
+ */
+static ByteRangeParseResult
+parseByteRange(const StaticString &value, boost::uint64_t size,
+	boost::uint64_t &start, boost::uint64_t &end)
+{
+	const char *pos = value.data() + sizeof("bytes=") - 1;
+	const char *valueEnd = value.data() + value.size();
+	boost::uint64_t first, last;
+	bool openEnded;
+
+	if (!startsWith(value, P_STATIC_STRING("bytes="))) {
+		return BYTE_RANGE_IGNORED;
+	}
+
+	if (pos < valueEnd && *pos == '-') {
+		// "bytes=-N": the last N bytes.
+		pos++;
+		if (!parseByteRangeNumber(pos, valueEnd, last) || pos != valueEnd) {
+			return BYTE_RANGE_IGNORED;
+		}
+		if (last == 0 || size == 0) {
+			return BYTE_RANGE_UNSATISFIABLE;
+		}
+		start = (last >= size) ? 0 : size - last;
+		end = size - 1;
+		return BYTE_RANGE_SATISFIABLE;
+	}
+
+	// "bytes=M-N" or "bytes=M-".
+	if (!parseByteRangeNumber(pos, valueEnd, first) || pos == valueEnd || *pos != '-') {
+		return BYTE_RANGE_IGNORED;
+	}
+	pos++;
+	openEnded = pos == valueEnd;
+	if (!openEnded
+	 && (!parseByteRangeNumber(pos, valueEnd, last) || pos != valueEnd || last < first))
+	{
+		return BYTE_RANGE_IGNORED;
+	}
+	if (first >= size) {
+		return BYTE_RANGE_UNSATISFIABLE;
+	}
+	start = first;
+	end = openEnded ? size - 1 : std::min<boost::uint64_t>(last, size - 1);
+	return BYTE_RANGE_SATISFIABLE;
+}
+
+#endif /* PSG_HAVE_SENDFILE */
+
+
+/**
+ * Internal redirects are only served once the entire request has been
+ * sent to the application. Otherwise the application session cannot be
+ * released yet, and the response is forwarded as-is.
+ */
+bool
+Controller::shouldServeInternalRedirect(Client *client, Request *req) {
+	#ifdef PSG_HAVE_SENDFILE
+		if (internalRedirectHeader.empty()
+		 || req->appResponse.headers.lookup(internalRedirectHeader) == NULL)
+		{
+			return false;
+		}
+		if (req->state != Request::WAITING_FOR_APP_OUTPUT) {
+			SKC_DEBUG(client, "Not serving internal redirect because the request body "
+				"has not been fully sent to the application yet");
+			return false;
+		}
+		return true;
+	#else
+		return false;
+	#endif
+}
+
+/**
+ * Releases the application session, opens the file that the internal
+ * redirect points to and turns the application response into a response
+ * for that file. Returns false if the request has been ended with an
+ * error response instead.
+ */
+bool
+Controller::prepareInternalRedirect(Client *client, Request *req) {
+	#ifdef PSG_HAVE_SENDFILE
+		TRACE_POINT();
+		AppResponse *resp = &req->appResponse;
+		StaticString path;
+		int e;
+
+		releaseSessionForInternalRedirect(client, req);
+
+		if (!resolveInternalRedirectPath(req, path)) {
+			SKC_ERROR(client, "The application sent an invalid " <<
+				internalRedirectHeader << " header");
+			endRequestWithSimpleResponse(&client, &req,
+				"<h1>Internal Server Error</h1>", 500);
+			return false;
+		}
+
+		UPDATE_TRACE_POINT();
+		SKC_DEBUG(client, "Serving internal redirect to " << path);
+		req->internalRedirectFile = openFileCache.open(path, statThrottleRate, e);
+		if (req->internalRedirectFile == NULL) {
+			SKC_WARN(client, "Cannot open internal redirect target " << path <<
+				": " << strerror(e) << " (errno=" << e << ")");
+			if (e == ENOENT || e == ENOTDIR) {
+				endRequestWithSimpleResponse(&client, &req, "<h1>Not Found</h1>", 404);
+			} else if (e == EACCES || e == EISDIR) {
+				endRequestWithSimpleResponse(&client, &req, "<h1>Forbidden</h1>", 403);
+			} else {
+				endRequestWithSimpleResponse(&client, &req,
+					"<h1>Internal Server Error</h1>", 500);
+			}
+			return false;
+		}
+
+		UPDATE_TRACE_POINT();
+		resp->headers.erase(internalRedirectHeader);
+		resp->headers.erase(HTTP_CONTENT_LENGTH);
+		resp->headers.erase(HTTP_TRANSFER_ENCODING);
+		resp->headers.erase(HTTP_ACCEPT_RANGES);
+		resp->headers.erase(HTTP_CONTENT_RANGE);
+		resp->httpState = AppResponse::COMPLETE;
+		resp->bodyType = AppResponse::RBT_CONTENT_LENGTH;
+		resp->bodyAlreadyRead = 0;
+		applyRangeToInternalRedirect(client, req);
+		resp->aux.bodyInfo.contentLength = req->internalRedirectRemaining;
+		internalRedirects++;
+		return true;
+	#else
+		P_BUG("Internal redirects are not supported on this platform");
+		return false;
+	#endif
+}
+
+void
+Controller::startSendingInternalRedirect(Client *client, Request *req) {
+	#ifdef PSG_HAVE_SENDFILE
+		if (req->method == HTTP_HEAD || req->internalRedirectRemaining == 0) {
+			stopInternalRedirect(client, req);
+			finalizeUnionStationWithSuccess(client, req);
+			endRequest(&client, &req);
+			return;
+		}
+
+		ev_io_set(&req->internalRedirectWatcher, client->getFd(), EV_WRITE);
+		if (client->output.flushed()) {
+			pumpInternalRedirect(client, req);
+		} else {
+			// The response header hasn't been written to the socket yet.
+			SKC_TRACE(client, 3, "Waiting for response header to be flushed "
+				"before sending internal redirect target");
+			client->output.setDataFlushedCallback(_internalRedirectOutputFlushed);
+		}
+	#else
+		P_BUG("Internal redirects are not supported on this platform");
+	#endif
+}
+
+#ifdef PSG_HAVE_SENDFILE
+
+/**
+ * Resolves the internal redirect header value against internalRedirectRoot.
+ * The value must be an absolute path without ".." components, so that
+ * the application cannot make us serve files outside the root.
+ */
+bool
+Controller::resolveInternalRedirectPath(Request *req, StaticString &path) {
+	LString *value = req->appResponse.headers.lookup(internalRedirectHeader);
+	const char *data, *end, *pos;
+	StaticString root = internalRedirectRoot;
+	char *result;
+
+	value = psg_lstr_make_contiguous(value, req->pool);
+	if (value->size == 0 || value->start->data[0] != '/') {
+		return false;
+	}
+	data = value->start->data;
+	end = data + value->size;
+	if (memchr(data, '\0', value->size) != NULL) {
+		return false;
+	}
+	for (pos = data; pos < end; pos++) {
+		if (*pos == '/'
+		 && end - pos >= 3 && pos[1] == '.' && pos[2] == '.'
+		 && (end - pos == 3 || pos[3] == '/'))
+		{
+			return false;
+		}
+	}
+
+	if (!root.empty() && root[root.size() - 1] == '/') {
+		root = root.substr(0, root.size() - 1);
+	}
+	result = (char *) psg_pnalloc(req->pool, root.size() + value->size + 1);
+	memcpy(result, root.data(), root.size());
+	memcpy(result + root.size(), data, value->size);
+	result[root.size() + value->size] = '\0';
+	path = StaticString(result, root.size() + value->size);
+	return true;
+}
+
+void
+Controller::releaseSessionForInternalRedirect(Client *client, Request *req) {
+	AppResponse *resp = &req->appResponse;
+
+	// The response body isn't passed through us, so it cannot be cached.
+	if (turboCaching.isEnabled() && !req->cacheKey.empty()) {
+		SKC_TRACE(client, 2, "Turbocache: internal redirect responses are not "
+			"eligible for turbocaching");
+		// Decrease store success ratio.
+		turboCaching.responseCache.incStores();
+		req->cacheKey = HashedStaticString();
+	}
+
+	if (resp->hasBody()) {
+		// Nobody is going to read this body, so the connection cannot be reused.
+		SKC_TRACE(client, 2, "Not keep-aliving application session connection"
+			" because the internal redirect response has a body");
+		req->session->close(true, false);
+	} else {
+		keepAliveAppConnection(client, req);
+	}
+
+	// The channels must let go of the socket before anybody else uses it.
+	req->appSink.setConsumedCallback(NULL);
+	req->appSink.deinitialize();
+	req->appSource.stop();
+	req->appSource.deinitialize();
+	req->session.reset();
+	// There is no application socket left to half-close.
+	req->halfClosePolicy = Request::HALF_CLOSE_PERFORMED;
+}
+
+void
+Controller::applyRangeToInternalRedirect(Client *client, Request *req) {
+	AppResponse *resp = &req->appResponse;
+	boost::uint64_t size = req->internalRedirectFile->info.st_size;
+	boost::uint64_t start, end;
+	LString *value;
+	char *header;
+	unsigned int pos;
+
+	req->internalRedirectOffset = 0;
+	req->internalRedirectRemaining = size;
+	resp->headers.insert(req->pool, "Accept-Ranges", "bytes");
+
+	// We don't support If-Range, so we serve the whole file as RFC 7233
+	// allows us to.
+	value = req->headers.lookup(HTTP_RANGE);
+	if (value == NULL
+	 || resp->statusCode != 200
+	 || req->headers.lookup(HTTP_IF_RANGE) != NULL)
+	{
+		return;
+	}
+
+	value = psg_lstr_make_contiguous(value, req->pool);
+	header = (char *) psg_pnalloc(req->pool, 64);
+	switch (parseByteRange(StaticString(value->start->data, value->size),
+		size, start, end))
+	{
+	case BYTE_RANGE_SATISFIABLE:
+		SKC_TRACE(client, 2, "Serving bytes " << start << "-" << end <<
+			" of internal redirect target");
+		pos = snprintf(header, 64, "bytes %llu-%llu/%llu",
+			(unsigned long long) start, (unsigned long long) end,
+			(unsigned long long) size);
+		resp->statusCode = 206;
+		resp->headers.insert(req->pool, "Content-Range", StaticString(header, pos));
+		req->internalRedirectOffset = start;
+		req->internalRedirectRemaining = end - start + 1;
+		break;
+	case BYTE_RANGE_UNSATISFIABLE:
+		SKC_TRACE(client, 2, "Requested range of internal redirect target not satisfiable");
+		pos = snprintf(header, 64, "bytes */%llu", (unsigned long long) size);
+		resp->statusCode = 416;
+		resp->headers.insert(req->pool, "Content-Range", StaticString(header, pos));
+		req->internalRedirectRemaining = 0;
+		break;
+	default:
+		break;
+	}
+}
+
+void
+Controller::_onInternalRedirectClientWritable(EV_P_ struct ev_io *io, int revents) {
+	Request *req = static_cast<Request *>(io->data);
+	Client *client = static_cast<Client *>(req->client);
+	Controller *self = static_cast<Controller *>(getServerFromClient(client));
+	ServerKit::RefGuard guard(&req->hooks, io, __FILE__, __LINE__);
+
+	SKC_LOG_EVENT_FROM_STATIC(self, Controller, client, "onInternalRedirectClientWritable");
+	self->pumpInternalRedirect(client, req);
+}
+
+void
+Controller::_internalRedirectOutputFlushed(FileBufferedChannel *_channel) {
+	FileBufferedFdSinkChannel *channel = reinterpret_cast<FileBufferedFdSinkChannel *>(_channel);
+	Client *client = static_cast<Client *>(static_cast<
+		ServerKit::BaseClient *>(channel->getHooks()->userData));
+	Request *req = static_cast<Request *>(client->currentRequest);
+	Controller *self = static_cast<Controller *>(getServerFromClient(client));
+
+	getClientOutputDataFlushedCallback()(_channel);
+	if (client->connected() && req != NULL && !req->ended()) {
+		SKC_TRACE_FROM_STATIC(self, client, 3, "Response header flushed. "
+			"Sending internal redirect target");
+		client->output.setDataFlushedCallback(getClientOutputDataFlushedCallback());
+		self->pumpInternalRedirect(client, req);
+	}
+}
+
+void
+Controller::pumpInternalRedirect(Client *client, Request *req) {
+	TRACE_POINT();
+	int fd = req->internalRedirectFile->fd;
+	int clientFd = client->getFd();
+	unsigned int i;
+	off_t offset;
+	ssize_t ret;
+	int e;
+
+	for (i = 0; i < MAX_SENDFILE_ROUNDS && req->internalRedirectRemaining > 0; i++) {
+		offset = (off_t) req->internalRedirectOffset;
+		do {
+			ret = sendfile(clientFd, fd, &offset, std::min<boost::uint64_t>(
+				MAX_SENDFILE_CHUNK_SIZE, req->internalRedirectRemaining));
+		} while (OXT_UNLIKELY(ret == -1 && errno == EINTR));
+		if (ret > 0) {
+			req->internalRedirectOffset += ret;
+			req->internalRedirectRemaining -= ret;
+			req->lastDataSendTime = ev_now(getLoop());
+			internalRedirectBytes += ret;
+		} else if (ret == 0) {
+			// We've already sent a Content-Length, so all we can do is
+			// to let the client know that something is wrong.
+			SKC_WARN(client, "Internal redirect target " <<
+				req->internalRedirectFile->path << " was truncated while being sent");
+			disconnectWithError(&client, "internal redirect target truncated");
+			return;
+		} else if (errno == EAGAIN) {
+			if (!ev_is_active(&req->internalRedirectWatcher)) {
+				ev_io_start(getLoop(), &req->internalRedirectWatcher);
+			}
+			return;
+		} else {
+			e = errno;
+			disconnectWithClientSocketWriteError(&client, e);
+			return;
+		}
+	}
+
+	if (req->internalRedirectRemaining == 0) {
+		UPDATE_TRACE_POINT();
+		SKC_TRACE(client, 2, "Internal redirect target sent");
+		stopInternalRedirect(client, req);
+		finalizeUnionStationWithSuccess(client, req);
+		endRequest(&client, &req);
+	} else if (!ev_is_active(&req->internalRedirectWatcher)) {
+		// Give other clients a chance. The client socket is still
+		// writable, so the watcher fires in the next event loop iteration.
+		ev_io_start(getLoop(), &req->internalRedirectWatcher);
+	}
+}
+
+void
+Controller::stopInternalRedirect(Client *client, Request *req) {
+	ev_io_stop(getLoop(), &req->internalRedirectWatcher);
+	if (client->output.getDataFlushedCallback() == _internalRedirectOutputFlushed) {
+		client->output.setDataFlushedCallback(getClientOutputDataFlushedCallback());
+	}
+	req->internalRedirectFile.reset();
+}
+
+#endif /* PSG_HAVE_SENDFILE */
+
+
+} // namespace Core
+} // namespace Passenger
@@ -0,0 +1,203 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2016 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#ifndef _PASSENGER_CORE_OPEN_FILE_CACHE_H_
+#define _PASSENGER_CORE_OPEN_FILE_CACHE_H_
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <list>
+#include <string>
+#include <StaticString.h>
+#include <FileDescriptor.h>
+#include <Utils/StringMap.h>
+#include <Utils/CachedFileStat.hpp>
+
+namespace Passenger {
+namespace Core {
+
+using namespace std;
+
+
+/**
+ * Caches open file descriptors for files that the Core serves by itself,
+ * such as the targets of internal redirects. Files are stat()ed through a
+ * CachedFileStat, so that the filesystem is hit at most once per
+ * `throttleRate` seconds per file. A cached file descriptor is reused for
+ * as long as the stat information of its path doesn't change.
+ *
+ * Entries are reference counted: evicting an entry does not close the file
+ * descriptor while a request is still sending the file.
+ *
+ * Not thread-safe. Each Controller has its own OpenFileCache.
+ */
+class OpenFileCache {
+public:
+	struct File {
+		FileDescriptor fd;
+		/** The fstat() information of `fd`. The file size to serve comes from here. */
+		struct stat info;
+		/** The stat() information of the path at the time `fd` was opened. */
+		struct stat stamp;
+		string path;
+	};
+
+	typedef boost::shared_ptr<File> FilePtr;
+
+private:
+	typedef list<FilePtr> FileList;
+	typedef StringMap<FileList::iterator> FileMap;
+
+	CachedFileStat stats;
+	FileList files;
+	FileMap index;
+	unsigned int maxSize;
+	unsigned int hits;
+	unsigned int misses;
+
+	static bool sameFile(const struct stat &a, const struct stat &b) {
+		return a.st_dev == b.st_dev
+			&& a.st_ino == b.st_ino
+			&& a.st_size == b.st_size
+			&& a.st_mtime == b.st_mtime;
+	}
+
+	void remove(const StaticString &path) {
+		FileList::iterator it(index.get(path, files.end()));
+		if (it != files.end()) {
+			FilePtr file(*it);
+			index.remove(file->path);
+			files.erase(it);
+		}
+	}
+
+	FilePtr openFile(const StaticString &path, const struct stat &stamp, int &errcode) {
+		FilePtr file;
+		int fd;
+
+		// Opening a FIFO or a device may block, and this runs on the
+		// event loop. The stat result may be outdated, so O_NONBLOCK
+		// guards against the file being replaced in the meantime.
+		if (!S_ISREG(stamp.st_mode)) {
+			errcode = EISDIR;
+			return FilePtr();
+		}
+		do {
+			fd = ::open(string(path.data(), path.size()).c_str(),
+				O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+		} while (fd == -1 && errno == EINTR);
+		if (fd == -1) {
+			errcode = errno;
+			return FilePtr();
+		}
+		file = boost::make_shared<File>();
+		file->fd.assign(fd, __FILE__, __LINE__);
+		if (fstat(fd, &file->info) == -1) {
+			errcode = errno;
+			return FilePtr();
+		}
+		if (!S_ISREG(file->info.st_mode)) {
+			errcode = EISDIR;
+			return FilePtr();
+		}
+		file->stamp = stamp;
+		file->path = string(path.data(), path.size());
+		return file;
+	}
+
+public:
+	OpenFileCache(unsigned int _maxSize)
+		: stats(_maxSize),
+		  maxSize(_maxSize),
+		  hits(0),
+		  misses(0)
+		{ }
+
+	/**
+	 * Returns an open file descriptor for the regular file at `path`,
+	 * either from the cache or by opening the file. On failure, returns
+	 * an empty pointer and sets `errcode` to an errno value. Anything
+	 * that is not a regular file results in EISDIR.
+	 *
+	 * @throws SystemException Something went wrong while retrieving the system time.
+	 * @throws boost::thread_interrupted
+	 */
+	FilePtr open(const StaticString &path, unsigned int throttleRate, int &errcode) {
+		struct stat stamp;
+		FileList::iterator it;
+		FilePtr file;
+
+		if (stats.stat(path, &stamp, throttleRate) == -1) {
+			errcode = errno;
+			remove(path);
+			return FilePtr();
+		}
+
+		it = index.get(path, files.end());
+		if (it != files.end()) {
+			if (sameFile((*it)->stamp, stamp)) {
+				hits++;
+				files.splice(files.begin(), files, it);
+				return *it;
+			}
+			remove(path);
+		}
+
+		misses++;
+		file = openFile(path, stamp, errcode);
+		if (file == NULL) {
+			return FilePtr();
+		}
+		if (files.size() == maxSize) {
+			index.remove(files.back()->path);
+			files.pop_back();
+		}
+		files.push_front(file);
+		index.set(file->path, files.begin());
+		return file;
+	}
+
+	unsigned int size() const {
+		return files.size();
+	}
+
+	unsigned int getHits() const {
+		return hits;
+	}
+
+	unsigned int getMisses() const {
+		return misses;
+	}
+};
+
+
+} // namespace Core
+} // namespace Passenger
+
+#endif /* _PASSENGER_CORE_OPEN_FILE_CACHE_H_ */
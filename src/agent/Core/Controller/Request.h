@@ -39,6 +39,12 @@
 #include <Core/UnionStation/Transaction.h>
 #include <Core/UnionStation/StopwatchLog.h>
 #include <Core/Controller/AppResponse.h>
+#include <Core/Controller/OpenFileCache.h>
+
+#ifdef __linux__
+	#define PSG_HAVE_SPLICE
+	#define PSG_HAVE_SENDFILE
+#endif
 
 namespace Passenger {
 namespace Core {
@@ -67,6 +73,8 @@ public:
 	};
 
 	ev_tstamp startedAt;
+	/** When the session with the app was initiated. 0 if not yet. */
+	ev_tstamp sessionInitiatedAt;
 
 	State state: 3;
 	bool dechunkResponse: 1;
@@ -80,9 +88,26 @@ public:
 	bool appResponseInitialized: 1;
 	bool strip100ContinueHeader: 1;
 	bool hasPragmaHeader: 1;
+	bool responseSpliceTried: 1;
+	/** Whether a session is being checked out ahead of time. See `prefetchedSession`. */
+	bool prefetchingSession: 1;
 
 	Options options;
+	/**
+	 * The cached pool options that `options` was last assigned from, or NULL.
+	 * Cached pool options are immutable and live as long as the Controller,
+	 * so if the next request on this object is for the same app group, then
+	 * only the per-request fields in `options` need to be restored.
+	 * See Controller::usePoolOptions().
+	 */
+	const Options *baseOptions;
 	AbstractSessionPtr session;
+	/**
+	 * A session that was checked out ahead of time, while this request was
+	 * pipelined behind another request on the same connection.
+	 * checkoutSession() uses it instead of checking out a new session.
+	 */
+	AbstractSessionPtr prefetchedSession;
 	const LString *host;
 
 	ServerKit::FdSinkChannel appSink;
@@ -92,6 +117,30 @@ public:
 	ServerKit::FileBufferedChannel bodyBuffer;
 	boost::uint64_t bodyBytesBuffered; // After dechunking
 
+	#ifdef PSG_HAVE_SPLICE
+		// Pipe through which the app response body is spliced to the client
+		// socket. Both ends are -1 while the response is not being spliced.
+		int responseSplicePipe[2];
+		unsigned int responseSplicePipeBytes;
+		// Watches the app socket while appSource is stopped for splicing,
+		// or the client socket while the client is not accepting data.
+		struct ev_io responseSpliceWatcher;
+		// Runs while the client is not accepting data. If it fires, the
+		// client is considered slow and the response body is buffered instead.
+		struct ev_timer responseSpliceStallTimer;
+	#endif
+
+	#ifdef PSG_HAVE_SENDFILE
+		// The file that an internal redirect response points to, and the
+		// part of it that remains to be sent. `internalRedirectFile` is NULL
+		// while no file is being sent.
+		OpenFileCache::FilePtr internalRedirectFile;
+		boost::uint64_t internalRedirectOffset;
+		boost::uint64_t internalRedirectRemaining;
+		// Watches the client socket while it is not accepting data.
+		struct ev_io internalRedirectWatcher;
+	#endif
+
 	struct {
 		UnionStation::StopwatchLog *requestProcessing;
 		UnionStation::StopwatchLog *bufferingRequestBody;
@@ -119,7 +168,8 @@ public:
 
 
 	Request()
-		: BaseHttpRequest()
+		: BaseHttpRequest(),
+		  baseOptions(NULL)
 	{
 		memset(&stopwatchLogs, 0, sizeof(stopwatchLogs));
 	}
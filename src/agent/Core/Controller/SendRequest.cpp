@@ -1101,5 +1101,63 @@ Controller::logAppSocketWriteError(Client *client, int errcode) {
 }
 
 
+/****************************
+ *
+ * Public methods
+ *
+ ****************************/
+
+
+/**
+ * Constructs the 'session' protocol header for `req` into `buffer`, exactly
+ * like sendHeaderToAppWithSessionProtocol() does, but without sending it.
+ * Returns the header size, or 0 if `bufsize` is too small.
+ *
+ * @pre req->session != NULL
+ */
+unsigned int
+Controller::constructSessionProtocolHeader(Request *req, char *buffer,
+	unsigned int bufsize)
+{
+	SessionProtocolWorkingState state;
+	std::string delta_monotonic = boost::to_string(SystemTime::getUsec() - (uv_hrtime() / 1000));
+	unsigned int size = determineHeaderSizeForSessionProtocol(req,
+		state, delta_monotonic);
+
+	if (size > bufsize) {
+		return 0;
+	}
+	size = bufsize;
+	if (constructHeaderForSessionProtocol(req, buffer, size, state, delta_monotonic)) {
+		return size;
+	} else {
+		return 0;
+	}
+}
+
+/**
+ * Constructs the 'http' protocol header buffers for `req`, exactly like
+ * sendHeaderToAppWithHttpProtocolAndWritev() does, but without sending them.
+ * Returns the number of buffers, or 0 if more than `maxbuffers` are
+ * necessary.
+ */
+unsigned int
+Controller::constructHttpProtocolHeaderBuffers(Request *req,
+	struct iovec *buffers, unsigned int maxbuffers, unsigned int &dataSize)
+{
+	HttpHeaderConstructionCache cache;
+	unsigned int nbuffers;
+
+	cache.cached = false;
+	if (constructHeaderBuffersForHttpProtocol(req, buffers, maxbuffers,
+		nbuffers, dataSize, cache))
+	{
+		return nbuffers;
+	} else {
+		return 0;
+	}
+}
+
+
 } // namespace Core
 } // namespace Passenger
@@ -0,0 +1,319 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2014-2015 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#include <Core/Controller.h>
+
+#ifdef PSG_HAVE_SPLICE
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+/*************************************************************************
+ *
+ * Implements Core::Controller methods pertaining to splicing the
+ * application response body to the client socket. The body is moved
+ * from the application socket into a pipe and from the pipe into the
+ * client socket, without being copied through user space.
+ *
+ *************************************************************************/
+
+namespace Passenger {
+namespace Core {
+
+using namespace std;
+using namespace boost;
+
+
+/****************************
+ *
+ * Private methods
+ *
+ ****************************/
+
+
+/**
+ * Called while forwarding a response body with a known length, after
+ * appSource has delivered a part of it. Splicing is only possible if
+ * Passenger does not need to see the rest of the body, and if everything
+ * written to the client so far has already reached the client socket.
+ */
+bool
+Controller::shouldSpliceResponse(Client *client, Request *req) {
+	#ifdef PSG_HAVE_SPLICE
+		const AppResponse *resp = &req->appResponse;
+
+		return spliceResponses
+			&& !req->responseSpliceTried
+			&& resp->httpState == AppResponse::PARSING_BODY_WITH_LENGTH
+			&& resp->aux.bodyInfo.contentLength - resp->bodyAlreadyRead
+				>= MIN_SPLICED_RESPONSE_BODY_SIZE
+			// The body must be buffered in order to be stored in the turbocache...
+			&& !(turboCaching.isEnabled() && !req->cacheKey.empty())
+			// ...and in order to be logged.
+			&& !req->useUnionStation()
+			&& getLogLevel() < LVL_DEBUG3
+			&& client->output.flushed();
+	#else
+		return false;
+	#endif
+}
+
+void
+Controller::startSplicingResponse(Client *client, Request *req) {
+	#ifdef PSG_HAVE_SPLICE
+		int fds[2];
+
+		req->responseSpliceTried = true;
+		if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) == -1) {
+			int e = errno;
+			SKC_WARN(client, "Cannot create a pipe for splicing the response body: " <<
+				strerror(e) << " (errno=" << e << ")");
+			maybeThrottleAppSource(client, req);
+			return;
+		}
+		P_LOG_FILE_DESCRIPTOR_OPEN(fds[0]);
+		P_LOG_FILE_DESCRIPTOR_OPEN(fds[1]);
+		P_LOG_FILE_DESCRIPTOR_PURPOSE(fds[0], "Controller: response splice pipe[0]");
+		P_LOG_FILE_DESCRIPTOR_PURPOSE(fds[1], "Controller: response splice pipe[1]");
+		// A larger pipe means fewer splice() calls. If the kernel refuses
+		// (e.g. because of /proc/sys/fs/pipe-max-size), the default is fine.
+		fcntl(fds[1], F_SETPIPE_SZ, RESPONSE_SPLICE_PIPE_SIZE);
+
+		SKC_TRACE(client, 2, "Splicing the remaining " <<
+			(req->appResponse.aux.bodyInfo.contentLength - req->appResponse.bodyAlreadyRead) <<
+			" bytes of the application response body");
+		req->responseSplicePipe[0] = fds[0];
+		req->responseSplicePipe[1] = fds[1];
+		req->responseSplicePipeBytes = 0;
+		splicedResponses++;
+
+		// We're called from appSource's data callback, so appSource has
+		// not read past the data it just passed us. The watcher picks up
+		// from there during the next event loop iteration.
+		req->appSource.stop();
+		ev_io_set(&req->responseSpliceWatcher, req->appSource.getFd(), EV_READ);
+		ev_io_start(getLoop(), &req->responseSpliceWatcher);
+	#else
+		P_BUG("Response splicing is not supported on this platform");
+	#endif
+}
+
+#ifdef PSG_HAVE_SPLICE
+
+void
+Controller::_onResponseSpliceIoReady(EV_P_ struct ev_io *io, int revents) {
+	Request *req = static_cast<Request *>(io->data);
+	Client *client = static_cast<Client *>(req->client);
+	Controller *self = static_cast<Controller *>(getServerFromClient(client));
+	ServerKit::RefGuard guard(&req->hooks, io, __FILE__, __LINE__);
+
+	SKC_LOG_EVENT_FROM_STATIC(self, Controller, client, "onResponseSpliceIoReady");
+	if (io->events & EV_WRITE) {
+		// The client is accepting data again.
+		SKC_TRACE_FROM_STATIC(self, client, 3, "Client socket writable. Resuming response splicing");
+		ev_timer_stop(EV_A_ &req->responseSpliceStallTimer);
+		ev_io_stop(EV_A_ io);
+		ev_io_set(io, req->appSource.getFd(), EV_READ);
+		ev_io_start(EV_A_ io);
+	}
+	self->pumpResponseSplice(client, req);
+}
+
+void
+Controller::_onResponseSpliceStalled(EV_P_ struct ev_timer *timer, int revents) {
+	Request *req = static_cast<Request *>(timer->data);
+	Client *client = static_cast<Client *>(req->client);
+	Controller *self = static_cast<Controller *>(getServerFromClient(client));
+	ServerKit::RefGuard guard(&req->hooks, timer, __FILE__, __LINE__);
+
+	SKC_LOG_EVENT_FROM_STATIC(self, Controller, client, "onResponseSpliceStalled");
+	self->fallBackFromResponseSplice(client, req);
+}
+
+void
+Controller::pumpResponseSplice(Client *client, Request *req) {
+	TRACE_POINT();
+	AppResponse *resp = &req->appResponse;
+	int appFd = req->appSource.getFd();
+	int clientFd = client->getFd();
+	bool appDrained = false;
+	unsigned int i;
+	ssize_t ret;
+	int e;
+
+	for (i = 0; i < MAX_RESPONSE_SPLICE_ROUNDS; i++) {
+		if (!appDrained && !resp->bodyFullyRead()) {
+			UPDATE_TRACE_POINT();
+			do {
+				ret = splice(appFd, NULL, req->responseSplicePipe[1], NULL,
+					std::min<boost::uint64_t>(RESPONSE_SPLICE_PIPE_SIZE,
+						resp->aux.bodyInfo.contentLength - resp->bodyAlreadyRead),
+					SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+			} while (OXT_UNLIKELY(ret == -1 && errno == EINTR));
+			if (ret > 0) {
+				resp->bodyAlreadyRead += ret;
+				req->responseSplicePipeBytes += ret;
+			} else if (ret == 0 || errno == ECONNRESET) {
+				SKC_WARN(client, "Application sent EOF before finishing response body: " <<
+					resp->bodyAlreadyRead << " bytes already read, " <<
+					resp->aux.bodyInfo.contentLength << " bytes expected");
+				endRequestWithAppSocketIncompleteResponse(&client, &req);
+				return;
+			} else if (errno == EAGAIN) {
+				// Either the app socket has no data, or the pipe is full.
+				// The latter is handled by draining the pipe below.
+				appDrained = true;
+			} else {
+				e = errno;
+				SKC_DEBUG(client, "Application socket read error occurred while splicing response body");
+				endRequestWithAppSocketReadError(&client, &req, e);
+				return;
+			}
+		}
+
+		if (req->responseSplicePipeBytes > 0) {
+			UPDATE_TRACE_POINT();
+			do {
+				ret = splice(req->responseSplicePipe[0], NULL, clientFd, NULL,
+					req->responseSplicePipeBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+			} while (OXT_UNLIKELY(ret == -1 && errno == EINTR));
+			if (ret != -1) {
+				req->responseSplicePipeBytes -= ret;
+				req->lastDataSendTime = ev_now(getLoop());
+				splicedResponseBytes += ret;
+			} else if (errno == EAGAIN) {
+				waitForClientDuringResponseSplice(client, req);
+				return;
+			} else {
+				e = errno;
+				disconnectWithClientSocketWriteError(&client, e);
+				return;
+			}
+		}
+
+		if (req->responseSplicePipeBytes == 0) {
+			if (resp->bodyFullyRead()) {
+				UPDATE_TRACE_POINT();
+				SKC_TRACE(client, 2, "End of application response body reached");
+				stopSplicingResponse(client, req);
+				handleAppResponseBodyEnd(client, req);
+				endRequest(&client, &req);
+				return;
+			} else if (appDrained) {
+				// Wait until the app socket becomes readable.
+				return;
+			}
+		}
+	}
+
+	// Give other clients a chance.
+	ev_feed_event(getLoop(), &req->responseSpliceWatcher, EV_READ);
+}
+
+/**
+ * Called when the client socket cannot accept more data. Splicing is paused
+ * (which also throttles the app) until the client socket becomes writable.
+ * Clients that stay unwritable for too long are handled by
+ * fallBackFromResponseSplice(), so that they don't hold up the app.
+ */
+void
+Controller::waitForClientDuringResponseSplice(Client *client, Request *req) {
+	SKC_TRACE(client, 3, "Client socket not writable. Pausing response splicing");
+	ev_io_stop(getLoop(), &req->responseSpliceWatcher);
+	ev_io_set(&req->responseSpliceWatcher, client->getFd(), EV_WRITE);
+	ev_io_start(getLoop(), &req->responseSpliceWatcher);
+	ev_timer_set(&req->responseSpliceStallTimer,
+		RESPONSE_SPLICE_CLIENT_STALL_TIMEOUT / 1000.0, 0);
+	ev_timer_start(getLoop(), &req->responseSpliceStallTimer);
+}
+
+/**
+ * Called when the client is slower than the app. Moves whatever is left in
+ * the pipe into the client output channel, and lets appSource forward the
+ * rest of the body so that it is buffered like usual.
+ */
+void
+Controller::fallBackFromResponseSplice(Client *client, Request *req) {
+	TRACE_POINT();
+	SKC_TRACE(client, 2, "Client did not accept data for " <<
+		RESPONSE_SPLICE_CLIENT_STALL_TIMEOUT << " msec. Falling back to "
+		"buffering the response body");
+	responseSpliceFallbacks++;
+
+	while (req->responseSplicePipeBytes > 0 && !req->ended()) {
+		MemoryKit::mbuf buffer(MemoryKit::mbuf_get(&getContext()->mbuf_pool));
+		ssize_t ret;
+
+		do {
+			ret = read(req->responseSplicePipe[0], buffer.start,
+				std::min<unsigned int>(buffer.size(), req->responseSplicePipeBytes));
+		} while (OXT_UNLIKELY(ret == -1 && errno == EINTR));
+		if (ret <= 0) {
+			// Cannot happen: the pipe holds responseSplicePipeBytes bytes.
+			int e = errno;
+			P_BUG("Cannot read from the response splice pipe: " << strerror(e) <<
+				" (errno=" << e << ")");
+		}
+		req->responseSplicePipeBytes -= ret;
+		writeResponse(client, MemoryKit::mbuf(buffer, 0, ret));
+	}
+
+	if (req->ended()) {
+		return;
+	}
+
+	UPDATE_TRACE_POINT();
+	stopSplicingResponse(client, req);
+	if (req->appResponse.bodyFullyRead()) {
+		SKC_TRACE(client, 2, "End of application response body reached");
+		handleAppResponseBodyEnd(client, req);
+		endRequest(&client, &req);
+	} else {
+		req->appSource.start();
+		maybeThrottleAppSource(client, req);
+	}
+}
+
+void
+Controller::stopSplicingResponse(Client *client, Request *req) {
+	// Also clears any event fed by pumpResponseSplice().
+	ev_io_stop(getLoop(), &req->responseSpliceWatcher);
+	ev_timer_stop(getLoop(), &req->responseSpliceStallTimer);
+	if (req->responseSplicePipe[0] != -1) {
+		close(req->responseSplicePipe[0]);
+		close(req->responseSplicePipe[1]);
+		P_LOG_FILE_DESCRIPTOR_CLOSE(req->responseSplicePipe[0]);
+		P_LOG_FILE_DESCRIPTOR_CLOSE(req->responseSplicePipe[1]);
+		req->responseSplicePipe[0] = -1;
+		req->responseSplicePipe[1] = -1;
+		req->responseSplicePipeBytes = 0;
+	}
+}
+
+#endif /* PSG_HAVE_SPLICE */
+
+
+} // namespace Core
+} // namespace Passenger
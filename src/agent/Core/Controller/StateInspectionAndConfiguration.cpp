@@ -51,6 +51,12 @@ Controller::getConfigAsJson() const {
 	doc["single_app_mode"] = singleAppMode;
 	doc["stat_throttle_rate"] = statThrottleRate;
 	doc["show_version_in_header"] = showVersionInHeader;
+	doc["coalesce_chunked_frames"] = coalesceChunkedFrames;
+	doc["splice_responses"] = spliceResponses;
+	if (!internalRedirectHeader.empty()) {
+		doc["internal_redirect_header"] = internalRedirectHeader.toString();
+		doc["internal_redirect_root"] = internalRedirectRoot.toString();
+	}
 	doc["data_buffer_dir"] = getContext()->defaultFileBufferedChannelConfig.bufferDir;
 	return doc;
 }
@@ -61,6 +67,12 @@ Controller::configure(const Json::Value &doc) {
 	if (doc.isMember("show_version_in_header")) {
 		showVersionInHeader = doc["show_version_in_header"].asBool();
 	}
+	if (doc.isMember("coalesce_chunked_frames")) {
+		coalesceChunkedFrames = doc["coalesce_chunked_frames"].asBool();
+	}
+	if (doc.isMember("splice_responses")) {
+		spliceResponses = doc["splice_responses"].asBool();
+	}
 	if (doc.isMember("data_buffer_dir")) {
 		getContext()->defaultFileBufferedChannelConfig.bufferDir =
 			doc["data_buffer_dir"].asString();
@@ -78,8 +90,36 @@ Controller::inspectStateAsJson() const {
 		subdoc["stores"] = turboCaching.responseCache.getStores();
 		subdoc["store_successes"] = turboCaching.responseCache.getStoreSuccesses();
 		subdoc["store_success_ratio"] = turboCaching.responseCache.getStoreSuccessRatio();
+		subdoc["total_hits"] = (Json::UInt64) turboCaching.responseCache.getTotalHits();
+		subdoc["total_misses"] = (Json::UInt64) turboCaching.responseCache.getTotalMisses();
+		subdoc["total_evictions"] = (Json::UInt64) turboCaching.responseCache.getTotalEvictions();
+		subdoc["entries"] = turboCaching.responseCache.getEntryCount();
+		subdoc["max_entries"] = turboCaching.responseCache.getMaxEntries();
+		subdoc["size"] = byteSizeToJson(turboCaching.responseCache.getSize());
+		subdoc["max_size"] = byteSizeToJson(turboCaching.responseCache.getMaxSize());
+		subdoc["shared"] = turboCaching.responseCache.isShared();
 		doc["turbocaching"] = subdoc;
 	}
+	if (spliceResponses) {
+		Json::Value subdoc;
+		subdoc["responses"] = splicedResponses;
+		subdoc["fallbacks"] = responseSpliceFallbacks;
+		subdoc["bytes"] = byteSizeToJson(splicedResponseBytes);
+		doc["response_splicing"] = subdoc;
+	}
+	if (!internalRedirectHeader.empty()) {
+		Json::Value subdoc;
+		subdoc["responses"] = internalRedirects;
+		subdoc["bytes"] = byteSizeToJson(internalRedirectBytes);
+		subdoc["open_files"] = openFileCache.size();
+		subdoc["open_file_hits"] = openFileCache.getHits();
+		subdoc["open_file_misses"] = openFileCache.getMisses();
+		doc["internal_redirects"] = subdoc;
+	}
+	if (unionStationContext != NULL && unionStationContext->getBatchedLogWriter() != NULL) {
+		doc["union_station_log_writer"] =
+			unionStationContext->getBatchedLogWriter()->inspectStateAsJson();
+	}
 	return doc;
 }
 
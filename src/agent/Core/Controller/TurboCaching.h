@@ -37,6 +37,7 @@
 #include <Logging.h>
 #include <Utils/StrIntUtils.h>
 #include <Core/ResponseCache.h>
+#include <Core/SharedResponseCache.h>
 
 namespace Passenger {
 namespace Core {
@@ -138,8 +139,9 @@ private:
 
 		result += entry->body->httpHeaderSize;
 		if (output != NULL) {
-			pos = appendData(pos, end, entry->body->httpHeaderData,
-				entry->body->httpHeaderSize);
+			assert(pos + entry->body->httpHeaderSize <= end);
+			responseCache.copyHeaderData(*entry, pos);
+			pos += entry->body->httpHeaderSize;
 		}
 
 		PUSH_STATIC_STRING("Content-Length: ");
@@ -192,10 +194,14 @@ private:
 public:
 	ResponseCache<Request> responseCache;
 
-	TurboCaching(State initialState = ENABLED)
+	TurboCaching(State initialState = ENABLED,
+		unsigned int maxEntries = DEFAULT_TURBOCACHE_MAX_ENTRIES,
+		size_t maxSize = DEFAULT_TURBOCACHE_MAX_SIZE,
+		SharedResponseCache<Request> *sharedCache = NULL)
 		: state(initialState),
 		  lastTimeout((ev_tstamp) time(NULL)),
-		  nextTimeout((ev_tstamp) time(NULL) + ENABLED_TIMEOUT)
+		  nextTimeout((ev_tstamp) time(NULL) + ENABLED_TIMEOUT),
+		  responseCache(maxEntries, maxSize, sharedCache)
 	{
 		if (initialState != ENABLED && initialState != DISABLED) {
 			throw RuntimeException("The initial turbocaching state may "
@@ -230,6 +236,7 @@ public:
 					"for " << TEMPORARY_DISABLE_TIMEOUT << " seconds");
 				state = TEMPORARILY_DISABLED;
 				nextTimeout = now + TEMPORARY_DISABLE_TIMEOUT;
+				responseCache.clear();
 			} else if (responseCache.getStores() >= STORE_THRESHOLD
 				&& responseCache.getStoreSuccessRatio() < MIN_STORE_SUCCESS_RATIO())
 			{
@@ -241,12 +248,14 @@ public:
 					"for " << TEMPORARY_DISABLE_TIMEOUT << " seconds");
 				state = TEMPORARILY_DISABLED;
 				nextTimeout = now + TEMPORARY_DISABLE_TIMEOUT;
+				responseCache.clear();
 			} else {
-				P_DEBUG("Clearing turbocache");
+				// Entries are evicted on an LRU basis and expire according
+				// to their own freshness information, so there is no need
+				// to clear the cache here.
 				nextTimeout = now + ENABLED_TIMEOUT;
 			}
 			responseCache.resetStatistics();
-			responseCache.clear();
 			break;
 		case TEMPORARILY_DISABLED:
 			P_INFO("Re-enabling turbocaching");
@@ -261,6 +270,7 @@ public:
 		lastTimeout = now;
 	}
 
+	// @post entry has been released
 	template<typename Server, typename Client>
 	void writeResponse(Server *server, Client *client, Request *req, ResponseCacheEntryType &entry) {
 		MemoryKit::mbuf_pool &mbuf_pool = server->getContext()->mbuf_pool;
@@ -271,23 +281,25 @@ public:
 		prepareResponseHeader(prep, server, req, entry);
 		headerSize = buildResponseHeader(prep, server, NULL, 0);
 
-		if (headerSize + entry.body->httpBodySize <= MBUF_MAX_SIZE) {
-			// Header and body fit inside a single mbuf
+		if (headerSize <= MBUF_MAX_SIZE) {
 			MemoryKit::mbuf buffer(MemoryKit::mbuf_get(&mbuf_pool));
-			buffer = MemoryKit::mbuf(buffer, 0, headerSize + entry.body->httpBodySize);
-
+			buffer = MemoryKit::mbuf(buffer, 0, headerSize);
 			buildResponseHeader(prep, server, buffer.start, buffer.size());
-			memcpy(buffer.start + headerSize, entry.body->httpBodyData, entry.body->httpBodySize);
-
 			server->writeResponse(client, buffer);
 		} else {
-			char *buffer = (char *) psg_pnalloc(req->pool, headerSize + entry.body->httpBodySize);
-			buildResponseHeader(prep, server, buffer,
-				headerSize + entry.body->httpBodySize);
-			memcpy(buffer + headerSize, entry.body->httpBodyData, entry.body->httpBodySize);
+			char *buffer = (char *) psg_pnalloc(req->pool, headerSize);
+			buildResponseHeader(prep, server, buffer, headerSize);
+			server->writeResponse(client, buffer, headerSize);
+		}
 
-			server->writeResponse(client, buffer, headerSize + entry.body->httpBodySize);
+		// The body is written directly from the response cache's storage
+		// blocks, without copying.
+		unsigned int offset = 0;
+		while (offset < entry.body->httpBodySize && !req->ended()) {
+			server->writeResponse(client, responseCache.getBodyPart(entry, offset));
 		}
+
+		responseCache.release(entry);
 	}
 };
 
@@ -125,6 +125,13 @@ namespace Core {
 
 	struct WorkingObjects {
 		int serverFds[SERVER_KIT_MAX_SERVER_ENDPOINTS];
+		/**
+		 * If `core_reuse_port` is enabled, then for each TCP endpoint,
+		 * serverFds[i] is the SO_REUSEPORT socket of the first core thread,
+		 * and reusePortServerFds[i] contains those of the other threads.
+		 * Endpoints for which this is empty go through the load balancer.
+		 */
+		vector<int> reusePortServerFds[SERVER_KIT_MAX_SERVER_ENDPOINTS];
 		int apiServerFds[SERVER_KIT_MAX_SERVER_ENDPOINTS];
 		string password;
 		ApiAccountDatabase apiAccountDatabase;
@@ -135,8 +142,10 @@ namespace Core {
 		SpawningKit::ConfigPtr spawningKitConfig;
 		SpawningKit::FactoryPtr spawningKitFactory;
 		PoolPtr appPool;
+		SharedResponseCache<Request> *sharedResponseCache;
 
 		ServerKit::AcceptLoadBalancer<Controller> loadBalancer;
+		bool loadBalancerActive;
 		vector<ThreadWorkingObjects> threadWorkingObjects;
 		struct ev_signal sigintWatcher;
 		struct ev_signal sigtermWatcher;
@@ -151,7 +160,9 @@ namespace Core {
 		oxt::thread *prestarterThread;
 
 		WorkingObjects()
-			: exitEvent(__FILE__, __LINE__, "WorkingObjects: exitEvent"),
+			: sharedResponseCache(NULL),
+			  loadBalancerActive(false),
+			  exitEvent(__FILE__, __LINE__, "WorkingObjects: exitEvent"),
 			  allClientsDisconnectedEvent(__FILE__, __LINE__, "WorkingObjects: allClientsDisconnectedEvent"),
 			  terminationCount(0),
 			  shutdownCounter(0)
@@ -171,6 +182,7 @@ namespace Core {
 				delete it->serverKitContext;
 				delete it->bgloop;
 			}
+			delete sharedResponseCache;
 
 			delete apiWorkingObjects.apiServer;
 			delete apiWorkingObjects.serverKitContext;
@@ -309,6 +321,26 @@ makeFileWorldReadableAndWritable(const string &path) {
 	}
 #endif
 
+/**
+ * Whether every core thread should get its own SO_REUSEPORT socket for the
+ * given address, and accept clients on it directly instead of through the
+ * AcceptLoadBalancer. Only applicable to TCP addresses with an explicit port.
+ */
+static bool
+shouldReusePort(const string &address) {
+	if (!agentsOptions->getBool("core_reuse_port")
+	 || agentsOptions->getInt("core_threads") <= 1
+	 || getSocketAddressType(address) != SAT_TCP)
+	{
+		return false;
+	}
+
+	string host;
+	unsigned short port;
+	parseTcpSocketAddress(address, host, port);
+	return port != 0;
+}
+
 static void
 startListening() {
 	TRACE_POINT();
@@ -323,8 +355,9 @@ startListening() {
 	#endif
 
 	for (unsigned int i = 0; i < addresses.size(); i++) {
+		bool reusePort = shouldReusePort(addresses[i]);
 		wo->serverFds[i] = createServer(addresses[i], agentsOptions->getInt("socket_backlog"), true,
-			__FILE__, __LINE__);
+			__FILE__, __LINE__, reusePort);
 		#ifdef USE_SELINUX
 			resetSelinuxSocketContext();
 		#endif
@@ -333,6 +366,18 @@ startListening() {
 		if (getSocketAddressType(addresses[i]) == SAT_UNIX) {
 			makeFileWorldReadableAndWritable(parseUnixSocketAddress(addresses[i]));
 		}
+
+		if (reusePort) {
+			// One more socket on the same address for every other core thread.
+			unsigned int nthreads = agentsOptions->getInt("core_threads");
+			for (unsigned int j = 1; j < nthreads; j++) {
+				int fd = createServer(addresses[i], agentsOptions->getInt("socket_backlog"),
+					true, __FILE__, __LINE__, true);
+				P_LOG_FILE_DESCRIPTOR_PURPOSE(fd,
+					"Server address: " << addresses[i] << " (thread " << (j + 1) << ")");
+				wo->reusePortServerFds[i].push_back(fd);
+			}
+		}
 	}
 	for (unsigned int i = 0; i < apiAddresses.size(); i++) {
 		wo->apiServerFds[i] = createServer(apiAddresses[i], 0, true,
@@ -551,6 +596,9 @@ initializeNonPrivilegedWorkingObjects() {
 			options.get("ust_router_address"),
 			"logging",
 			options.get("ust_router_password"));
+		if (options.getBool("union_station_batching")) {
+			wo->unionStationContext->enableBatching();
+		}
 	}
 
 	UPDATE_TRACE_POINT();
@@ -573,9 +621,21 @@ initializeNonPrivilegedWorkingObjects() {
 	wo->appPool->initialize();
 	wo->appPool->setMax(options.getInt("max_pool_size"));
 	wo->appPool->setMaxIdleTime(options.getInt("pool_idle_time") * 1000000ULL);
+	wo->appPool->setCountStandbyProcesses(options.getBool("count_standby_processes"));
 	wo->appPool->enableSelfChecking(options.getBool("selfchecks"));
 	wo->appPool->abortLongRunningConnectionsCallback = abortLongRunningConnections;
 
+	UPDATE_TRACE_POINT();
+	if (options.getBool("turbocaching", false, true)
+	 && options.getBool("shared_turbocache", false, false))
+	{
+		wo->sharedResponseCache = new SharedResponseCache<Request>(
+			options.getUint("turbocache_max_entries", false,
+				DEFAULT_TURBOCACHE_MAX_ENTRIES),
+			options.getULL("turbocache_max_size", false,
+				DEFAULT_TURBOCACHE_MAX_SIZE));
+	}
+
 	UPDATE_TRACE_POINT();
 	unsigned int nthreads = options.getInt("core_threads");
 	BackgroundEventLoop *firstLoop = NULL; // Avoid compiler warning
@@ -598,9 +658,18 @@ initializeNonPrivilegedWorkingObjects() {
 			options.get("data_buffer_dir");
 		two.serverKitContext->defaultFileBufferedChannelConfig.threshold =
 			options.getUint("file_buffer_threshold");
+		if (options.getBool("file_buffer_io_uring")) {
+			int e = two.serverKitContext->enableIoUring();
+			if (e != 0) {
+				P_WARN("Cannot use io_uring for data buffers on core thread " << (i + 1)
+					<< ", using a thread pool instead: " << strerror(e)
+					<< " (errno=" << e << ")");
+			}
+		}
 
 		UPDATE_TRACE_POINT();
-		two.controller = new Core::Controller(two.serverKitContext, agentsOptions, i + 1);
+		two.controller = new Core::Controller(two.serverKitContext, agentsOptions, i + 1,
+			wo->sharedResponseCache);
 		two.controller->minSpareClients = 128;
 		two.controller->clientFreelistLimit = 1024;
 		two.controller->resourceLocator = &wo->resourceLocator;
@@ -664,15 +733,24 @@ initializeNonPrivilegedWorkingObjects() {
 		if (nthreads == 1) {
 			ThreadWorkingObjects *two = &wo->threadWorkingObjects[0];
 			two->controller->listen(wo->serverFds[i]);
+		} else if (!wo->reusePortServerFds[i].empty()) {
+			P_DEBUG("Core threads accept clients on " << addresses[i] <<
+				" directly, through SO_REUSEPORT sockets");
+			wo->threadWorkingObjects[0].controller->listen(wo->serverFds[i]);
+			for (unsigned int j = 1; j < nthreads; j++) {
+				ThreadWorkingObjects *two = &wo->threadWorkingObjects[j];
+				two->controller->listen(wo->reusePortServerFds[i][j - 1]);
+			}
 		} else {
 			wo->loadBalancer.listen(wo->serverFds[i]);
+			wo->loadBalancerActive = true;
 		}
 	}
 	for (unsigned int i = 0; i < nthreads; i++) {
 		ThreadWorkingObjects *two = &wo->threadWorkingObjects[i];
 		two->controller->createSpareClients();
 	}
-	if (nthreads > 1) {
+	if (wo->loadBalancerActive) {
 		wo->loadBalancer.servers.reserve(nthreads);
 		for (unsigned int i = 0; i < nthreads; i++) {
 			ThreadWorkingObjects *two = &wo->threadWorkingObjects[i];
@@ -773,7 +851,7 @@ mainLoop() {
 	if (wo->apiWorkingObjects.apiServer != NULL) {
 		wo->apiWorkingObjects.bgloop->start("API event loop", 0);
 	}
-	if (wo->threadWorkingObjects.size() > 1) {
+	if (wo->loadBalancerActive) {
 		wo->loadBalancer.start();
 	}
 	waitForExitEvent();
@@ -880,7 +958,7 @@ waitForExitEvent() {
 			ThreadWorkingObjects *two = &wo->threadWorkingObjects[i];
 			two->bgloop->safe->runLater(boost::bind(shutdownController, two));
 		}
-		if (wo->threadWorkingObjects.size() > 1) {
+		if (wo->loadBalancerActive) {
 			wo->loadBalancer.shutdown();
 		}
 		if (wo->apiWorkingObjects.apiServer != NULL) {
@@ -932,6 +1010,9 @@ cleanup() {
 		if (wo->serverFds[i] != -1) {
 			close(wo->serverFds[i]);
 		}
+		for (unsigned int j = 0; j < wo->reusePortServerFds[i].size(); j++) {
+			close(wo->reusePortServerFds[i][j]);
+		}
 		if (wo->apiServerFds[i] != -1) {
 			close(wo->apiServerFds[i]);
 		}
@@ -1060,21 +1141,33 @@ setAgentsOptionsDefaults() {
 	options.setDefaultInt("max_pool_size", DEFAULT_MAX_POOL_SIZE);
 	options.setDefaultInt("pool_idle_time", DEFAULT_POOL_IDLE_TIME);
 	options.setDefaultInt("min_instances", 1);
+	options.setDefaultInt("spawn_concurrency", DEFAULT_SPAWN_CONCURRENCY);
+	options.setDefaultInt("standby_processes", 0);
+	options.setDefaultBool("count_standby_processes", false);
+	options.setDefaultBool("predictive_scaling", false);
+	options.setDefaultInt("memory_limit", 0);
+	options.setDefaultInt("memory_limit_recycle_percentage", DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE);
 	options.setDefaultInt("max_preloader_idle_time", DEFAULT_MAX_PRELOADER_IDLE_TIME);
 	options.setDefaultUint("max_request_queue_size", DEFAULT_MAX_REQUEST_QUEUE_SIZE);
+	options.setDefault("routing_policy", DEFAULT_ROUTING_POLICY);
 	options.setDefaultUint("stat_throttle_rate", DEFAULT_STAT_THROTTLE_RATE);
 	options.setDefault("server_software", SERVER_TOKEN_NAME "/" PASSENGER_VERSION);
 	options.setDefaultBool("show_version_in_header", true);
+	options.setDefaultBool("coalesce_chunked_frames", false);
+	options.setDefaultBool("splice_responses", false);
 	options.setDefaultBool("sticky_sessions", false);
 	options.setDefault("sticky_sessions_cookie_name", DEFAULT_STICKY_SESSIONS_COOKIE_NAME);
 	options.setDefaultBool("turbocaching", true);
 	options.setDefault("data_buffer_dir", getSystemTempDir());
 	options.setDefaultUint("file_buffer_threshold", DEFAULT_FILE_BUFFERED_CHANNEL_THRESHOLD);
+	options.setDefaultBool("file_buffer_io_uring", false);
+	options.setDefaultBool("union_station_batching", false);
 	options.setDefaultInt("response_buffer_high_watermark", DEFAULT_RESPONSE_BUFFER_HIGH_WATERMARK);
 	options.setDefaultBool("selfchecks", false);
 	options.setDefaultBool("core_graceful_exit", true);
 	options.setDefaultInt("core_threads", boost::thread::hardware_concurrency());
 	options.setDefaultBool("core_cpu_affine", false);
+	options.setDefaultBool("core_reuse_port", false);
 	options.setDefault("friendly_error_pages", "auto");
 	options.setDefaultBool("rolling_restarts", false);
 	options.setDefaultBool("resist_deployment_errors", false);
@@ -1159,13 +1252,9 @@ sanityCheckOptions() {
 			ok = false;
 		#endif
 	}
-	if (options.has("memory_limit")) {
-		#ifndef PASSENGER_IS_ENTERPRISE
-			fprintf(stderr, "ERROR: the --memory-limit option is only supported in "
-				PROGRAM_NAME " Enterprise.\nYou are currently using the open source "
-				PROGRAM_NAME ". Buy " PROGRAM_NAME " Enterprise here: https://www.phusionpassenger.com/enterprise\n");
-			ok = false;
-		#endif
+	if (options.getInt("memory_limit_recycle_percentage") < 1) {
+		fprintf(stderr, "ERROR: the value passed to --memory-limit-recycle-percentage must be at least 1.\n");
+		ok = false;
 	}
 	if (options.has("max_request_time")) {
 		if (options.getInt("max_request_time", false, 0) < 1) {
@@ -139,8 +139,25 @@ coreUsage() {
 	printf("                            process can handle the given number of concurrent\n");
 	printf("                            requests per process\n");
 	printf("      --min-instances N     Minimum number of application processes. Default: 1\n");
+	printf("      --spawn-concurrency N Maximum number of processes per application that\n");
+	printf("                            may be spawned at the same time. Default: %d\n",
+		DEFAULT_SPAWN_CONCURRENCY);
+	printf("      --standby-processes N Number of spawned processes per application to\n");
+	printf("                            keep on standby, ready to handle requests as soon\n");
+	printf("                            as the application needs more capacity. Default: 0\n");
+	printf("      --count-standby-processes\n");
+	printf("                            Count standby processes towards the maximum\n");
+	printf("                            pool size\n");
+	printf("      --predictive-scaling  Spawn and retire application processes ahead of\n");
+	printf("                            the demand predicted from the request arrival\n");
+	printf("                            rate\n");
 	printf("      --memory-limit MB     Restart application processes that go over the\n");
-    printf("                            given memory limit (Enterprise only)\n");
+	printf("                            given memory limit\n");
+	printf("      --memory-limit-recycle-percentage N\n");
+	printf("                            Maximum percentage of an application's processes\n");
+	printf("                            that may be restarted at the same time because of\n");
+	printf("                            the memory limit. Default: %d\n",
+		DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE);
 	printf("\n");
 	printf("Request handling options (optional):\n");
 	printf("      --max-request-time    Abort requests that take too much time (Enterprise\n");
@@ -148,6 +165,9 @@ coreUsage() {
 	printf("      --max-request-queue-size NUMBER\n");
 	printf("                            Specify request queue size. Default: %d\n",
 		DEFAULT_MAX_REQUEST_QUEUE_SIZE);
+	printf("      --routing-policy NAME How to pick the process that handles a request:\n");
+	printf("                            'least-busy', 'power-of-two-choices' or\n");
+	printf("                            'ewma-latency'. Default: " DEFAULT_ROUTING_POLICY "\n");
 	printf("      --sticky-sessions     Enable sticky sessions\n");
 	printf("      --sticky-sessions-cookie-name NAME\n");
 	printf("                            Cookie name to use for sticky sessions.\n");
@@ -156,6 +176,15 @@ coreUsage() {
 	printf("                            Vary the turbocache by the cookie of the given name\n");
 	printf("      --disable-turbocaching\n");
 	printf("                            Disable turbocaching\n");
+	printf("      --turbocache-max-entries NUMBER\n");
+	printf("                            Maximum number of entries in each core thread's\n");
+	printf("                            turbocache. Default: %d\n", DEFAULT_TURBOCACHE_MAX_ENTRIES);
+	printf("      --turbocache-max-size BYTES\n");
+	printf("                            Maximum amount of memory that each core thread's\n");
+	printf("                            turbocache may use. Default: %d\n", DEFAULT_TURBOCACHE_MAX_SIZE);
+	printf("      --shared-turbocache   Use a single turbocache for all core threads instead\n");
+	printf("                            of one per thread. The above limits then apply to\n");
+	printf("                            the shared turbocache\n");
 	printf("      --no-abort-websockets-on-process-shutdown\n");
 	printf("                            Do not abort WebSocket connections on process\n");
 	printf("                            shutdown or restart\n");
@@ -170,9 +199,32 @@ coreUsage() {
 	printf("      --no-show-version-in-header\n");
 	printf("                            Do not show " PROGRAM_NAME " version number in\n");
 	printf("                            HTTP headers.\n");
+	printf("      --coalesce-chunked-frames\n");
+	printf("                            When forwarding a chunked response, write the\n");
+	printf("                            headers and the chunks that arrive together with\n");
+	printf("                            a single system call\n");
+	printf("      --splice-responses    Forward large response bodies from the\n");
+	printf("                            application to the client with splice(), without\n");
+	printf("                            copying them through user space (Linux only)\n");
+	printf("      --internal-redirect-header NAME\n");
+	printf("                            Serve the file that this application response\n");
+	printf("                            header points to (e.g. X-Sendfile), instead of\n");
+	printf("                            forwarding the response body. Requires\n");
+	printf("                            --internal-redirect-root (Linux only)\n");
+	printf("      --internal-redirect-root PATH\n");
+	printf("                            Directory that internal redirect paths are\n");
+	printf("                            relative to\n");
 	printf("      --data-buffer-dir PATH\n");
 	printf("                            Directory to store data buffers in. Default:\n");
 	printf("                            %s\n", getSystemTempDir());
+	printf("      --file-buffer-io-uring\n");
+	printf("                            Read and write data buffers through io_uring\n");
+	printf("                            instead of a thread pool, if the kernel supports\n");
+	printf("                            it (Linux only)\n");
+	printf("      --union-station-batching\n");
+	printf("                            Write Union Station transaction logs from a\n");
+	printf("                            background thread in batches. Logs are dropped\n");
+	printf("                            instead of delaying requests if it falls behind\n");
 	printf("      --no-graceful-exit    When exiting, exit immediately instead of waiting\n");
 	printf("                            for all connections to terminate\n");
 	printf("      --benchmark MODE      Enable benchmark mode. Available modes:\n");
@@ -185,6 +237,9 @@ coreUsage() {
 	printf("                            Default: number of CPU cores (%d)\n",
 		boost::thread::hardware_concurrency());
 	printf("      --cpu-affine          Enable per-thread CPU affinity (Linux only)\n");
+	printf("      --reuse-port          Give every thread its own SO_REUSEPORT socket\n");
+	printf("                            on TCP addresses, instead of distributing\n");
+	printf("                            clients through a load balancer thread\n");
 	printf("  -h, --help                Show this help\n");
 	printf("\n");
 	printf("API account privilege levels (ordered from most to least privileges):\n");
@@ -279,9 +334,24 @@ parseCoreOption(int argc, const char *argv[], int &i, VariantMap &options) {
 	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--min-instances")) {
 		options.setInt("min_instances", atoi(argv[i + 1]));
 		i += 2;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--spawn-concurrency")) {
+		options.setInt("spawn_concurrency", atoi(argv[i + 1]));
+		i += 2;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--standby-processes")) {
+		options.setInt("standby_processes", atoi(argv[i + 1]));
+		i += 2;
+	} else if (p.isFlag(argv[i], '\0', "--count-standby-processes")) {
+		options.setBool("count_standby_processes", true);
+		i++;
+	} else if (p.isFlag(argv[i], '\0', "--predictive-scaling")) {
+		options.setBool("predictive_scaling", true);
+		i++;
 	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--memory-limit")) {
 		options.setInt("memory_limit", atoi(argv[i + 1]));
 		i += 2;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--memory-limit-recycle-percentage")) {
+		options.setInt("memory_limit_recycle_percentage", atoi(argv[i + 1]));
+		i += 2;
 	} else if (p.isValueFlag(argc, i, argv[i], 'e', "--environment")) {
 		options.set("environment", argv[i + 1]);
 		i += 2;
@@ -318,6 +388,9 @@ parseCoreOption(int argc, const char *argv[], int &i, VariantMap &options) {
 	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--max-request-queue-size")) {
 		options.setInt("max_request_queue_size", atoi(argv[i + 1]));
 		i += 2;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--routing-policy")) {
+		options.set("routing_policy", argv[i + 1]);
+		i += 2;
 	} else if (p.isFlag(argv[i], '\0', "--sticky-sessions")) {
 		options.setBool("sticky_sessions", true);
 		i++;
@@ -330,6 +403,21 @@ parseCoreOption(int argc, const char *argv[], int &i, VariantMap &options) {
 	} else if (p.isFlag(argv[i], '\0', "--disable-turbocaching")) {
 		options.setBool("turbocaching", false);
 		i++;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--turbocache-max-entries")) {
+		int value = atoi(argv[i + 1]);
+		if (value < 1) {
+			fprintf(stderr, "ERROR: the value passed to --turbocache-max-entries "
+				"must be at least 1.\n");
+			exit(1);
+		}
+		options.setInt("turbocache_max_entries", value);
+		i += 2;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--turbocache-max-size")) {
+		options.setULL("turbocache_max_size", stringToULL(argv[i + 1]));
+		i += 2;
+	} else if (p.isFlag(argv[i], '\0', "--shared-turbocache")) {
+		options.setBool("shared_turbocache", true);
+		i++;
 	} else if (p.isFlag(argv[i], '\0', "--no-abort-websockets-on-process-shutdown")) {
 		options.setBool("abort_websockets_on_process_shutdown", false);
 		i++;
@@ -375,9 +463,27 @@ parseCoreOption(int argc, const char *argv[], int &i, VariantMap &options) {
 	} else if (p.isFlag(argv[i], '\0', "--no-show-version-in-header")) {
 		options.setBool("show_version_in_header", false);
 		i++;
+	} else if (p.isFlag(argv[i], '\0', "--coalesce-chunked-frames")) {
+		options.setBool("coalesce_chunked_frames", true);
+		i++;
+	} else if (p.isFlag(argv[i], '\0', "--splice-responses")) {
+		options.setBool("splice_responses", true);
+		i++;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--internal-redirect-header")) {
+		options.set("internal_redirect_header", argv[i + 1]);
+		i += 2;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--internal-redirect-root")) {
+		options.set("internal_redirect_root", argv[i + 1]);
+		i += 2;
 	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--data-buffer-dir")) {
 		options.setInt("data_buffer_dir", atoi(argv[i + 1]));
 		i += 2;
+	} else if (p.isFlag(argv[i], '\0', "--file-buffer-io-uring")) {
+		options.setBool("file_buffer_io_uring", true);
+		i++;
+	} else if (p.isFlag(argv[i], '\0', "--union-station-batching")) {
+		options.setBool("union_station_batching", true);
+		i++;
 	} else if (p.isFlag(argv[i], '\0', "--no-graceful-exit")) {
 		options.setBool("core_graceful_exit", false);
 		i++;
@@ -393,6 +499,9 @@ parseCoreOption(int argc, const char *argv[], int &i, VariantMap &options) {
 	} else if (p.isFlag(argv[i], '\0', "--cpu-affine")) {
 		options.setBool("core_cpu_affine", true);
 		i++;
+	} else if (p.isFlag(argv[i], '\0', "--reuse-port")) {
+		options.setBool("core_reuse_port", true);
+		i++;
 	} else if (!startsWith(argv[i], "-")) {
 		if (!options.has("app_root")) {
 			options.set("app_root", argv[i]);
@@ -30,60 +30,92 @@
 #include <time.h>
 #include <cassert>
 #include <cstring>
+#include <vector>
+#include <MemoryKit/mbuf.h>
 #include <DataStructures/HashedStaticString.h>
 #include <ServerKit/http_parser.h>
 #include <ServerKit/CookieUtils.h>
 #include <StaticString.h>
+#include <Constants.h>
 #include <Utils/DateParsing.h>
 #include <Utils/StrIntUtils.h>
 
 namespace Passenger {
 
+template<typename Request> class SharedResponseCache;
+struct SharedResponseCacheReader;
+
 /**
  * Relevant RFCs:
  * https://tools.ietf.org/html/rfc7234    HTTP 1.1 Caching
  * https://tools.ietf.org/html/rfc2109    HTTP State Management Mechanism
+ *
+ * The cache holds at most `maxEntries` entries, whose key, header and body
+ * data may occupy at most `maxSize` bytes in total. Entries are indexed by
+ * a chained hash table and kept on an LRU list, so fetching, storing and
+ * evicting are all O(1) regardless of the capacity. When either limit is
+ * reached, the least recently used entries are evicted.
+ *
+ * Entry data is stored in a chain of fixed-size mbuf blocks from a pool that
+ * is private to the cache. Responses served from the cache reference these
+ * blocks directly, so no body data is copied on a cache hit. Because mbuf
+ * reference counting is not thread-safe, a ResponseCache may only be used
+ * from a single thread (i.e. one per Core::Controller).
+ *
+ * Alternatively, a ResponseCache can be constructed on top of a
+ * SharedResponseCache. It then stores nothing itself, but keeps applying
+ * the caching policy and keeping per-thread statistics, while entries are
+ * stored in and served from the process-wide shared cache.
  */
 template<typename Request>
 class ResponseCache {
 public:
-	static const unsigned int MAX_ENTRIES     = 8; // Fits in exactly 2 cache lines
 	static const unsigned int MAX_KEY_LENGTH  = 256;
 	static const unsigned int MAX_HEADER_SIZE = 4096;
-	static const unsigned int MAX_BODY_SIZE   = 1024 * 32;
+	static const unsigned int MAX_BODY_SIZE   = 1024 * 256;
+	static const unsigned int STORAGE_BLOCK_SIZE = 4096;
 	static const unsigned int DEFAULT_HEURISTIC_FRESHNESS = 10;
 	static const unsigned int MIN_HEURISTIC_FRESHNESS = 1;
+	static const unsigned int NO_INDEX = ~0u;
 
 	struct Header {
 		bool valid;
 		unsigned short keySize;
 		boost::uint32_t hash;
 		time_t date;
+		/** Links in the LRU list (for valid entries) or the free list
+		 * (for invalid entries). */
+		unsigned int lruPrev, lruNext;
+		/** Next entry in the same hash bucket. */
+		unsigned int bucketNext;
 
 		Header()
 			: valid(false),
 			  keySize(0),
 			  hash(0),
-			  date(0)
+			  date(0),
+			  lruPrev(NO_INDEX),
+			  lruNext(NO_INDEX),
+			  bucketNext(NO_INDEX)
 			{ }
 	};
 
 	struct Body {
-		unsigned short httpHeaderSize;
-		unsigned short httpBodySize;
+		unsigned int httpHeaderSize;
+		unsigned int httpBodySize;
 		time_t expiryDate;
-		char key[MAX_KEY_LENGTH];
-		char httpHeaderData[MAX_HEADER_SIZE];
-		// This data is dechunked.
-		char httpBodyData[MAX_BODY_SIZE];
+		/**
+		 * The key, the HTTP header data and the HTTP body data, stored
+		 * back-to-back in a chain of storage blocks. The key always fits
+		 * in the first block. The body data is dechunked.
+		 */
+		vector<MemoryKit::mbuf> storage;
 
 		Body()
 			: httpHeaderSize(0),
 			  httpBodySize(0),
 			  expiryDate(0)
-		{
-			key[0] = httpHeaderData[0] = httpBodyData[0] = '\0';
-		}
+			{ }
 	};
 
 	struct Entry {
@@ -141,9 +173,160 @@ private:
 	HashedStaticString PASSENGER_VARY_TURBOCACHE_BY_COOKIE;
 
 	unsigned int fetches, hits, stores, storeSuccesses;
+	boost::uint64_t totalHits, totalMisses, totalEvictions;
+
+	const unsigned int maxEntries;
+	const size_t maxSize;
+	unsigned int nEntries;
+	size_t usedSize;
+	unsigned int lruHead, lruTail, freeHead;
+
+	vector<Header> headers;
+	vector<Body> bodies;
+	vector<unsigned int> buckets;
+	struct MemoryKit::mbuf_pool storagePool;
+
+	SharedResponseCache<Request> *shared;
+	SharedResponseCacheReader *reader;
+
+	static unsigned int calculateBucketCount(unsigned int maxEntries) {
+		unsigned int result = 16;
+		while (result < maxEntries) {
+			result *= 2;
+		}
+		return result;
+	}
+
+	OXT_FORCE_INLINE
+	unsigned int bucketFor(boost::uint32_t hash) const {
+		return hash & (buckets.size() - 1);
+	}
+
+	OXT_FORCE_INLINE
+	size_t storageBlockDataSize() const {
+		return storagePool.mbuf_block_offset;
+	}
+
+	OXT_FORCE_INLINE
+	const char *keyData(unsigned int index) const {
+		return bodies[index].storage[0].start;
+	}
+
+	void lruUnlink(unsigned int index) {
+		Header &header = headers[index];
+		if (header.lruPrev == NO_INDEX) {
+			lruHead = header.lruNext;
+		} else {
+			headers[header.lruPrev].lruNext = header.lruNext;
+		}
+		if (header.lruNext == NO_INDEX) {
+			lruTail = header.lruPrev;
+		} else {
+			headers[header.lruNext].lruPrev = header.lruPrev;
+		}
+		header.lruPrev = header.lruNext = NO_INDEX;
+	}
+
+	void lruPushFront(unsigned int index) {
+		Header &header = headers[index];
+		header.lruPrev = NO_INDEX;
+		header.lruNext = lruHead;
+		if (lruHead != NO_INDEX) {
+			headers[lruHead].lruPrev = index;
+		}
+		lruHead = index;
+		if (lruTail == NO_INDEX) {
+			lruTail = index;
+		}
+	}
+
+	void touch(unsigned int index) {
+		if (lruHead != index) {
+			lruUnlink(index);
+			lruPushFront(index);
+		}
+	}
+
+	void bucketUnlink(unsigned int index) {
+		unsigned int *link = &buckets[bucketFor(headers[index].hash)];
+		while (*link != index) {
+			assert(*link != NO_INDEX);
+			link = &headers[*link].bucketNext;
+		}
+		*link = headers[index].bucketNext;
+		headers[index].bucketNext = NO_INDEX;
+	}
+
+	void releaseStorage(unsigned int index) {
+		Body &body = bodies[index];
+		usedSize -= body.storage.size() * storagePool.mbuf_block_chunk_size;
+		body.storage.clear();
+	}
+
+	/**
+	 * Makes sure that `body` has storage blocks for exactly `size` bytes,
+	 * evicting least recently used entries other than `index` as necessary.
+	 */
+	bool allocateStorage(unsigned int index, size_t size) {
+		Body &body = bodies[index];
+		size_t blockDataSize = storageBlockDataSize();
+		size_t nblocks = (size + blockDataSize - 1) / blockDataSize;
+		size_t needed = nblocks * storagePool.mbuf_block_chunk_size;
+
+		releaseStorage(index);
+		if (needed > maxSize) {
+			return false;
+		}
+		while (usedSize + needed > maxSize) {
+			unsigned int victim = (lruTail == index)
+				? headers[lruTail].lruPrev
+				: lruTail;
+			assert(victim != NO_INDEX);
+			evict(victim);
+		}
 
-	Header headers[MAX_ENTRIES];
-	Body bodies[MAX_ENTRIES];
+		body.storage.reserve(nblocks);
+		for (size_t i = 0; i < nblocks; i++) {
+			MemoryKit::mbuf block(MemoryKit::mbuf_get(&storagePool));
+			if (OXT_UNLIKELY(block.is_null())) {
+				releaseStorage(index);
+				return false;
+			}
+			body.storage.push_back(block);
+			usedSize += storagePool.mbuf_block_chunk_size;
+		}
+		return true;
+	}
+
+	void writeStorage(Body *body, size_t offset, const char *data, size_t size) {
+		size_t blockDataSize = storageBlockDataSize();
+		while (size > 0) {
+			MemoryKit::mbuf &block = body->storage[offset / blockDataSize];
+			size_t blockOffset = offset % blockDataSize;
+			size_t len = std::min(size, blockDataSize - blockOffset);
+			memcpy(block.start + blockOffset, data, len);
+			offset += len;
+			data += len;
+			size -= len;
+		}
+	}
+
+	unsigned int allocateEntry() {
+		if (freeHead == NO_INDEX) {
+			assert(lruTail != NO_INDEX);
+			evict(lruTail);
+		}
+
+		unsigned int index = freeHead;
+		freeHead = headers[index].lruNext;
+		headers[index].lruNext = NO_INDEX;
+		return index;
+	}
+
+	void evict(unsigned int index) {
+		totalEvictions++;
+		erase(index);
+	}
 
 	unsigned int calculateKeyLength(const LString * restrict host,
 		const LString * restrict varyCookie,
@@ -216,35 +399,68 @@ private:
 		}
 	}
 
-	Entry lookup(const HashedStaticString &cacheKey) {
-		for (unsigned int i = 0; i < MAX_ENTRIES; i++) {
-			if (headers[i].valid
-			 && headers[i].hash == cacheKey.hash()
-			 && cacheKey == StaticString(bodies[i].key, headers[i].keySize))
-			{
-				return Entry(i, &headers[i], &bodies[i]);
+	Entry fetchFromSharedCache(Request *req, ev_tstamp now) {
+		shared->beginRead(reader);
+		Entry entry(shared->fetch(req->cacheKey));
+		if (entry.valid()) {
+			hits++;
+			if (isFresh(entry, now)) {
+				totalHits++;
+				// Stay in the read-side critical section until release().
+				return entry;
+			} else {
+				totalMisses++;
+				shared->erase(entry);
+				shared->endRead(reader);
+				Entry result;
+				result.cacheMissReason = Entry::NOT_FRESH;
+				return result;
 			}
+		} else {
+			totalMisses++;
+			shared->endRead(reader);
+			entry.cacheMissReason = Entry::NOT_FOUND;
+			return entry;
 		}
-		return Entry();
 	}
 
-	Entry lookupInvalidOrOldest() {
-		int oldest = -1;
+	void eraseKey(const HashedStaticString &cacheKey) {
+		if (shared != NULL) {
+			shared->erase(cacheKey);
+		} else {
+			Entry entry(lookup(cacheKey));
+			if (entry.valid()) {
+				erase(entry.index);
+			}
+		}
+	}
 
-		for (unsigned int i = 0; i < MAX_ENTRIES; i++) {
-			if (!headers[i].valid) {
+	Entry lookup(const HashedStaticString &cacheKey) {
+		unsigned int i = buckets[bucketFor(cacheKey.hash())];
+		while (i != NO_INDEX) {
+			const Header &header = headers[i];
+			if (header.hash == cacheKey.hash()
+			 && cacheKey == StaticString(keyData(i), header.keySize))
+			{
 				return Entry(i, &headers[i], &bodies[i]);
-			} else if (oldest == -1 || headers[i].date < headers[oldest].date) {
-				oldest = i;
 			}
+			i = header.bucketNext;
 		}
-
-		return Entry(oldest, &headers[oldest], &bodies[oldest]);
+		return Entry();
 	}
 
-	OXT_FORCE_INLINE
 	void erase(unsigned int index) {
-		headers[index].valid = false;
+		Header &header = headers[index];
+		if (!header.valid) {
+			return;
+		}
+		bucketUnlink(index);
+		lruUnlink(index);
+		releaseStorage(index);
+		header.valid = false;
+		header.lruNext = freeHead;
+		freeHead = index;
+		nEntries--;
 	}
 
 	time_t parseDate(psg_pool_t *pool, const LString *date, ev_tstamp now) const {
@@ -401,15 +617,17 @@ private:
 
 		char *key = (char *) psg_pnalloc(req->pool, keySize);
 		generateKey(https, path, req->host, req->varyCookie, key, keySize);
-
-		Entry entry(lookup(StaticString(key, keySize)));
-		if (entry.valid()) {
-			entry.header->valid = false;
-		}
+		eraseKey(StaticString(key, keySize));
 	}
 
 public:
-	ResponseCache()
+	/**
+	 * If `_shared` is given, then `_maxEntries` and `_maxSize` are ignored
+	 * in favor of the shared cache's limits.
+	 */
+	ResponseCache(unsigned int _maxEntries = DEFAULT_TURBOCACHE_MAX_ENTRIES,
+		size_t _maxSize = DEFAULT_TURBOCACHE_MAX_SIZE,
+		SharedResponseCache<Request> *_shared = NULL)
 		: CACHE_CONTROL("cache-control"),
 		  PRAGMA_CONST("pragma"),
 		  AUTHORIZATION("authorization"),
@@ -426,8 +644,46 @@ public:
 		  fetches(0),
 		  hits(0),
 		  stores(0),
-		  storeSuccesses(0)
-		{ }
+		  storeSuccesses(0),
+		  totalHits(0),
+		  totalMisses(0),
+		  totalEvictions(0),
+		  maxEntries((_shared != NULL) ? 1 : std::max(_maxEntries, 1u)),
+		  maxSize((_shared != NULL) ? 0 : _maxSize),
+		  nEntries(0),
+		  usedSize(0),
+		  lruHead(NO_INDEX),
+		  lruTail(NO_INDEX),
+		  freeHead(NO_INDEX),
+		  headers(maxEntries),
+		  bodies(maxEntries),
+		  buckets(calculateBucketCount(maxEntries), (unsigned int) NO_INDEX),
+		  shared(_shared),
+		  reader(NULL)
+	{
+		for (unsigned int i = maxEntries; i > 0; i--) {
+			headers[i - 1].lruNext = freeHead;
+			freeHead = i - 1;
+		}
+		storagePool.mbuf_block_chunk_size = STORAGE_BLOCK_SIZE;
+		MemoryKit::mbuf_pool_init(&storagePool);
+		if (shared != NULL) {
+			reader = shared->registerReader();
+		}
+	}
+
+	~ResponseCache() {
+		clear();
+		MemoryKit::mbuf_pool_deinit(&storagePool);
+		if (shared != NULL) {
+			shared->unregisterReader(reader);
+		}
+	}
+
+	OXT_FORCE_INLINE
+	bool isShared() const {
+		return shared != NULL;
+	}
 
 	OXT_FORCE_INLINE
 	unsigned int getFetches() const {
@@ -446,7 +702,7 @@ public:
 
 	OXT_FORCE_INLINE
 	unsigned int getStores() const {
-		return fetches;
+		return stores;
 	}
 
 	OXT_FORCE_INLINE
@@ -459,6 +715,36 @@ public:
 		return storeSuccesses / (double) stores;
 	}
 
+	OXT_FORCE_INLINE
+	boost::uint64_t getTotalHits() const {
+		return totalHits;
+	}
+
+	OXT_FORCE_INLINE
+	boost::uint64_t getTotalMisses() const {
+		return totalMisses;
+	}
+
+	boost::uint64_t getTotalEvictions() const {
+		return (shared != NULL) ? shared->getTotalEvictions() : totalEvictions;
+	}
+
+	unsigned int getEntryCount() const {
+		return (shared != NULL) ? shared->getEntryCount() : nEntries;
+	}
+
+	unsigned int getMaxEntries() const {
+		return (shared != NULL) ? shared->getMaxEntries() : maxEntries;
+	}
+
+	size_t getSize() const {
+		return (shared != NULL) ? shared->getSize() : usedSize;
+	}
+
+	size_t getMaxSize() const {
+		return (shared != NULL) ? shared->getMaxSize() : maxSize;
+	}
+
 	// For decreasing the store success ratio without calling store().
 	OXT_FORCE_INLINE
 	void incStores() {
@@ -472,10 +758,15 @@ public:
 		storeSuccesses = 0;
 	}
 
+	/**
+	 * Removes all entries. A shared cache is left alone, because other
+	 * threads may still be benefiting from it.
+	 */
 	void clear() {
-		for (unsigned int i = 0; i < MAX_ENTRIES; i++) {
-			headers[i].valid = false;
+		while (lruHead != NO_INDEX) {
+			erase(lruHead);
 		}
+		MemoryKit::mbuf_pool_compact(&storagePool);
 	}
 
 
@@ -537,7 +828,12 @@ public:
 			&& !req->hasPragmaHeader;
 	}
 
-	// @pre requestAllowsFetching()
+	/**
+	 * In shared mode, a valid entry returned by this method may only be
+	 * accessed until it is passed to `release()`.
+	 *
+	 * @pre requestAllowsFetching()
+	 */
 	Entry fetch(Request *req, ev_tstamp now) {
 		fetches++;
 		if (OXT_UNLIKELY(fetches == 0)) {
@@ -546,24 +842,40 @@ public:
 			hits = 0;
 		}
 
+		if (shared != NULL) {
+			return fetchFromSharedCache(req, now);
+		}
+
 		Entry entry(lookup(req->cacheKey));
 		if (entry.valid()) {
 			hits++;
 			if (isFresh(entry, now)) {
+				totalHits++;
+				touch(entry.index);
 				return entry;
 			} else {
+				totalMisses++;
 				erase(entry.index);
 				Entry result;
 				result.cacheMissReason = Entry::NOT_FRESH;
 				return result;
 			}
 		} else {
+			totalMisses++;
 			entry.cacheMissReason = Entry::NOT_FOUND;
 			return entry;
 		}
 	}
 
 
+	// @pre entry was returned by fetch() and is valid
+	void release(const Entry &entry) {
+		if (shared != NULL) {
+			shared->endRead(reader);
+		}
+	}
+
+
 	// @pre prepareRequest() returned true
 	OXT_FORCE_INLINE
 	bool requestAllowsStoring(Request *req) const {
@@ -625,8 +937,14 @@ public:
 			|| req->appResponse.expiresHeader != NULL;
 	}
 
-	// @pre requestAllowsStoring()
-	// @pre prepareRequestForStoring()
+	/**
+	 * Creates or replaces the entry for the request and allocates storage
+	 * for it. The caller must fill it in with `storeHeaderData()` and
+	 * `storeBodyData()`, then pass it to `commit()`.
+	 *
+	 * @pre requestAllowsStoring()
+	 * @pre prepareRequestForStoring()
+	 */
 	Entry store(Request *req, ev_tstamp now, unsigned int headerSize, unsigned int bodySize) {
 		stores++;
 
@@ -645,14 +963,41 @@ public:
 		}
 
 		const HashedStaticString &cacheKey = req->cacheKey;
-		Entry entry(lookup(cacheKey));
-		if (!entry.valid()) {
-			entry = lookupInvalidOrOldest();
+		Entry entry;
+		if (shared != NULL) {
+			entry = shared->allocate(cacheKey, cacheKey.size() + headerSize + bodySize);
+			if (!entry.valid()) {
+				return Entry();
+			}
+			entry.header->date     = responseDate;
+			entry.body->expiryDate = expiryDate;
+			entry.body->httpHeaderSize = headerSize;
+			entry.body->httpBodySize   = bodySize;
+			storeSuccesses++;
+			return entry;
+		}
+
+		entry = lookup(cacheKey);
+		if (entry.valid()) {
+			touch(entry.index);
+		} else {
+			unsigned int index = allocateEntry();
+			entry = Entry(index, &headers[index], &bodies[index]);
 			entry.header->valid   = true;
 			entry.header->hash    = cacheKey.hash();
 			entry.header->keySize = cacheKey.size();
-			memcpy(entry.body->key, cacheKey.data(), cacheKey.size());
+			entry.header->bucketNext = buckets[bucketFor(cacheKey.hash())];
+			buckets[bucketFor(cacheKey.hash())] = index;
+			lruPushFront(index);
+			nEntries++;
 		}
+
+		if (!allocateStorage(entry.index, cacheKey.size() + headerSize + bodySize)) {
+			erase(entry.index);
+			return Entry();
+		}
+		writeStorage(entry.body, 0, cacheKey.data(), cacheKey.size());
+
 		entry.header->date     = responseDate;
 		entry.body->expiryDate = expiryDate;
 		entry.body->httpHeaderSize = headerSize;
@@ -661,6 +1006,78 @@ public:
 		return entry;
 	}
 
+	// @pre entry was returned by store()
+	void storeHeaderData(const Entry &entry, unsigned int offset, const char *data,
+		unsigned int size)
+	{
+		assert(offset + size <= entry.body->httpHeaderSize);
+		writeStorage(entry.body, entry.header->keySize + offset, data, size);
+	}
+
+	// @pre entry was returned by store()
+	void storeBodyData(const Entry &entry, unsigned int offset, const char *data,
+		unsigned int size)
+	{
+		assert(offset + size <= entry.body->httpBodySize);
+		writeStorage(entry.body, entry.header->keySize + entry.body->httpHeaderSize
+			+ offset, data, size);
+	}
+
+	/**
+	 * Makes an entry returned by `store()` available for fetching. In
+	 * shared mode, it only becomes visible to other threads at this point.
+	 */
+	void commit(const Entry &entry) {
+		if (shared != NULL) {
+			shared->publish(entry);
+		}
+	}
+
+	/**
+	 * Copies the HTTP header data of the given entry into `output`, which must
+	 * be at least `entry.body->httpHeaderSize` bytes large.
+	 *
+	 * @pre entry.valid()
+	 */
+	void copyHeaderData(const Entry &entry, char *output) const {
+		size_t blockDataSize = storageBlockDataSize();
+		size_t offset = entry.header->keySize;
+		size_t size = entry.body->httpHeaderSize;
+
+		while (size > 0) {
+			const MemoryKit::mbuf &block = entry.body->storage[offset / blockDataSize];
+			size_t blockOffset = offset % blockDataSize;
+			size_t len = std::min(size, blockDataSize - blockOffset);
+			memcpy(output, block.start + blockOffset, len);
+			output += len;
+			offset += len;
+			size -= len;
+		}
+	}
+
+	/**
+	 * Returns an mbuf referencing the HTTP body data of the given entry,
+	 * starting at body offset `offset` and extending to the end of the storage
+	 * block that contains it. `offset` is advanced past the returned data.
+	 * Keep calling this method until `offset == entry.body->httpBodySize`
+	 * to obtain the entire body without copying it.
+	 *
+	 * @pre entry.valid()
+	 * @pre offset < entry.body->httpBodySize
+	 */
+	MemoryKit::mbuf getBodyPart(const Entry &entry, unsigned int &offset) const {
+		size_t blockDataSize = storageBlockDataSize();
+		size_t storageOffset = entry.header->keySize + entry.body->httpHeaderSize + offset;
+		const MemoryKit::mbuf &block = entry.body->storage[storageOffset / blockDataSize];
+		size_t blockOffset = storageOffset % blockDataSize;
+		size_t len = std::min<size_t>(entry.body->httpBodySize - offset,
+			blockDataSize - blockOffset);
+
+		assert(offset < entry.body->httpBodySize);
+		offset += len;
+		return MemoryKit::mbuf(block, blockOffset, len);
+	}
+
 
 	// @pre prepareRequest() returned true
 	// @pre !requestAllowsStoring() || !prepareRequestForStoring()
@@ -670,10 +1087,7 @@ public:
 
 	// @pre requestAllowsInvalidating()
 	void invalidate(Request *req) {
-		Entry entry(lookup(req->cacheKey));
-		if (entry.valid()) {
-			entry.header->valid = false;
-		}
+		eraseKey(req->cacheKey);
 
 		invalidateLocation(req, LOCATION);
 		invalidateLocation(req, CONTENT_LOCATION);
@@ -681,14 +1095,20 @@ public:
 
 
 	string inspect() const {
+		if (shared != NULL) {
+			return shared->inspect();
+		}
+
 		stringstream stream;
-		for (unsigned int i = 0; i < MAX_ENTRIES; i++) {
+		unsigned int i = lruHead;
+		while (i != NO_INDEX) {
 			time_t expiryDate = bodies[i].expiryDate;
-			stream << " #" << i << ": valid=" << headers[i].valid
-				<< ", hash=" << headers[i].hash
+			stream << " #" << i << ": hash=" << headers[i].hash
 				<< ", expiryDate=" << expiryDate
 				<< ", keySize=" << headers[i].keySize << ", key=\""
-				<< cEscapeString(StaticString(bodies[i].key, headers[i].keySize)) << "\"\n";
+				<< cEscapeString(StaticString(keyData(i), headers[i].keySize))
+				<< "\", storageBlocks=" << bodies[i].storage.size() << "\n";
+			i = headers[i].lruNext;
 		}
 		return stream.str();
 	}
@@ -0,0 +1,549 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2015 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#ifndef _PASSENGER_SHARED_RESPONSE_CACHE_H_
+#define _PASSENGER_SHARED_RESPONSE_CACHE_H_
+
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/cstdint.hpp>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <MemoryKit/mbuf.h>
+#include <DataStructures/HashedStaticString.h>
+#include <StaticString.h>
+#include <Utils/StrIntUtils.h>
+#include <Core/ResponseCache.h>
+
+namespace Passenger {
+
+using namespace std;
+
+
+/**
+ * Read-side state of a thread that uses a SharedResponseCache. Each
+ * reader is allocated separately and padded to a cache line of its own,
+ * so that readers never write to memory that other threads read often.
+ */
+struct SharedResponseCacheReader {
+	static const boost::uint64_t OFFLINE = ~(boost::uint64_t) 0;
+
+	/** The global epoch at the time this reader entered its current
+	 * read-side critical section, or OFFLINE if it's not in one. */
+	boost::atomic<boost::uint64_t> epoch;
+	/** Read-side critical section nesting level. Only accessed by the
+	 * owning thread. */
+	unsigned int depth;
+	char padding[64 - sizeof(boost::uint64_t) - sizeof(unsigned int)];
+
+	SharedResponseCacheReader()
+		: epoch(OFFLINE),
+		  depth(0)
+		{ }
+};
+
+
+/**
+ * A response cache storage that is shared by all Core::Controller threads,
+ * so that a response stored by one thread can be served by all of them
+ * and so that memory usage is not multiplied by the number of threads.
+ * Every thread keeps using its own ResponseCache, which remains responsible
+ * for the caching policy and for statistics, but which delegates storage
+ * to this class.
+ *
+ * Lookups never take a lock. Entries are immutable once published: stores,
+ * invalidations and evictions are serialized by a mutex and replace or
+ * unlink entries instead of modifying them. Unlinked entries are reclaimed
+ * RCU-style: every reader advertises the global epoch at which it entered
+ * its current read-side critical section, and a retired entry is only
+ * destroyed once no reader can still be looking at it.
+ *
+ * Entry data is stored in blocks from a thread-safe mbuf pool. Responses
+ * are therefore served with zero-copy mbuf references, which remain valid
+ * even if the entry is reclaimed while they're still being written out.
+ *
+ * Because readers can only afford to set a flag, not to relink lists,
+ * entries are evicted according to the CLOCK algorithm instead of
+ * strict LRU order.
+ */
+template<typename Request>
+class SharedResponseCache: public boost::noncopyable {
+public:
+	typedef ResponseCache<Request> ResponseCacheType;
+	typedef typename ResponseCacheType::Header Header;
+	typedef typename ResponseCacheType::Body Body;
+	typedef typename ResponseCacheType::Entry Entry;
+	typedef SharedResponseCacheReader Reader;
+
+private:
+	struct Node: public Header {
+		Body body;
+		/** Next node in the same hash bucket. Read without locking. */
+		boost::atomic<Node *> chainNext;
+		/** CLOCK reference bit. Set by readers. */
+		boost::atomic<bool> referenced;
+		/** CLOCK ring links. Protected by the mutex. */
+		Node *clockPrev, *clockNext;
+		/** Link in the list of retired nodes. Protected by the mutex. */
+		Node *retiredNext;
+		boost::uint64_t retireEpoch;
+
+		Node()
+			: chainNext(NULL),
+			  referenced(false),
+			  clockPrev(NULL),
+			  clockNext(NULL),
+			  retiredNext(NULL),
+			  retireEpoch(0)
+			{ }
+	};
+
+	mutable boost::mutex syncher;
+	boost::atomic<boost::uint64_t> epoch;
+	boost::atomic<Node *> *buckets;
+	unsigned int bucketMask;
+
+	const unsigned int maxEntries;
+	const size_t maxSize;
+	unsigned int nEntries;
+	size_t usedSize;
+	boost::uint64_t totalEvictions;
+	Node *clockHand;
+	Node *retired;
+	unsigned int nRetired;
+
+	vector<Reader *> readers;
+	struct MemoryKit::mbuf_pool storagePool;
+
+	static Node *nodeFor(const Entry &entry) {
+		return static_cast<Node *>(entry.header);
+	}
+
+	static Entry entryFor(Node *node) {
+		return Entry(ResponseCacheType::NO_INDEX, node, &node->body);
+	}
+
+	size_t storageSizeOf(const Node *node) const {
+		return node->body.storage.size() * storagePool.mbuf_block_chunk_size;
+	}
+
+	Node *lookup(const HashedStaticString &key) const {
+		Node *node = buckets[key.hash() & bucketMask].load(boost::memory_order_acquire);
+		while (node != NULL) {
+			if (node->hash == key.hash()
+			 && key == StaticString(node->body.storage[0].start, node->keySize))
+			{
+				return node;
+			}
+			node = node->chainNext.load(boost::memory_order_acquire);
+		}
+		return NULL;
+	}
+
+	void clockInsert(Node *node) {
+		if (clockHand == NULL) {
+			node->clockPrev = node->clockNext = node;
+			clockHand = node;
+		} else {
+			// Insert just behind the hand, so that the new node is
+			// the last one to be considered for eviction.
+			node->clockNext = clockHand;
+			node->clockPrev = clockHand->clockPrev;
+			clockHand->clockPrev->clockNext = node;
+			clockHand->clockPrev = node;
+		}
+	}
+
+	void clockRemove(Node *node) {
+		if (node->clockNext == node) {
+			clockHand = NULL;
+		} else {
+			node->clockPrev->clockNext = node->clockNext;
+			node->clockNext->clockPrev = node->clockPrev;
+			if (clockHand == node) {
+				clockHand = node->clockNext;
+			}
+		}
+		node->clockPrev = node->clockNext = NULL;
+	}
+
+	/**
+	 * Unlinks a published node so that new readers can't find it anymore,
+	 * and schedules it for destruction.
+	 */
+	void unlink(Node *node) {
+		boost::atomic<Node *> *link = &buckets[node->hash & bucketMask];
+		Node *current;
+
+		while ((current = link->load(boost::memory_order_relaxed)) != node) {
+			assert(current != NULL);
+			link = &current->chainNext;
+		}
+		link->store(node->chainNext.load(boost::memory_order_relaxed),
+			boost::memory_order_release);
+
+		clockRemove(node);
+		node->valid = false;
+		nEntries--;
+		usedSize -= storageSizeOf(node);
+
+		node->retireEpoch = epoch.fetch_add(1, boost::memory_order_seq_cst) + 1;
+		node->retiredNext = retired;
+		retired = node;
+		nRetired++;
+	}
+
+	bool evictOne() {
+		// Readers may keep setting reference bits, so give up on second
+		// chances after two full rotations.
+		unsigned int budget = 2 * nEntries;
+
+		while (clockHand != NULL) {
+			Node *node = clockHand;
+			clockHand = node->clockNext;
+			if (budget > 0 && node->referenced.load(boost::memory_order_relaxed)) {
+				node->referenced.store(false, boost::memory_order_relaxed);
+				budget--;
+			} else {
+				totalEvictions++;
+				unlink(node);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Destroys retired nodes that are no longer visible to any reader.
+	 */
+	void reclaim() {
+		if (retired == NULL) {
+			return;
+		}
+
+		boost::uint64_t minEpoch = Reader::OFFLINE;
+		typename vector<Reader *>::const_iterator it, end = readers.end();
+		for (it = readers.begin(); it != end; it++) {
+			minEpoch = std::min(minEpoch,
+				(*it)->epoch.load(boost::memory_order_seq_cst));
+		}
+
+		Node **link = &retired;
+		while (*link != NULL) {
+			Node *node = *link;
+			if (node->retireEpoch <= minEpoch) {
+				*link = node->retiredNext;
+				nRetired--;
+				delete node;
+			} else {
+				link = &node->retiredNext;
+			}
+		}
+	}
+
+	void writeKey(Node *node, const HashedStaticString &key) {
+		// The key always fits in the first storage block.
+		assert(key.size() <= storagePool.mbuf_block_offset);
+		memcpy(node->body.storage[0].start, key.data(), key.size());
+	}
+
+public:
+	SharedResponseCache(unsigned int _maxEntries = DEFAULT_TURBOCACHE_MAX_ENTRIES,
+		size_t _maxSize = DEFAULT_TURBOCACHE_MAX_SIZE)
+		: epoch(0),
+		  buckets(NULL),
+		  maxEntries(std::max(_maxEntries, 1u)),
+		  maxSize(_maxSize),
+		  nEntries(0),
+		  usedSize(0),
+		  totalEvictions(0),
+		  clockHand(NULL),
+		  retired(NULL),
+		  nRetired(0)
+	{
+		unsigned int nbuckets = 16;
+		while (nbuckets < maxEntries) {
+			nbuckets *= 2;
+		}
+		buckets = new boost::atomic<Node *>[nbuckets];
+		for (unsigned int i = 0; i < nbuckets; i++) {
+			buckets[i].store(NULL, boost::memory_order_relaxed);
+		}
+		bucketMask = nbuckets - 1;
+
+		storagePool.mbuf_block_chunk_size = ResponseCacheType::STORAGE_BLOCK_SIZE;
+		MemoryKit::mbuf_pool_init(&storagePool, true);
+	}
+
+	/**
+	 * @pre No thread is in a read-side critical section.
+	 */
+	~SharedResponseCache() {
+		clear();
+		assert(retired == NULL);
+		delete[] buckets;
+
+		typename vector<Reader *>::iterator it, end = readers.end();
+		for (it = readers.begin(); it != end; it++) {
+			delete *it;
+		}
+		MemoryKit::mbuf_pool_deinit(&storagePool);
+	}
+
+
+	/***** Reader registration and read-side critical sections *****/
+
+	Reader *registerReader() {
+		boost::lock_guard<boost::mutex> l(syncher);
+		readers.push_back(new Reader());
+		return readers.back();
+	}
+
+	void unregisterReader(Reader *reader) {
+		boost::lock_guard<boost::mutex> l(syncher);
+		assert(reader->depth == 0);
+		readers.erase(std::remove(readers.begin(), readers.end(), reader),
+			readers.end());
+		delete reader;
+		reclaim();
+	}
+
+	/**
+	 * Enters a read-side critical section. Entries obtained through
+	 * `fetch()` may only be accessed until the matching `endRead()`.
+	 * Critical sections may be nested.
+	 */
+	void beginRead(Reader *reader) {
+		if (reader->depth++ == 0) {
+			reader->epoch.store(epoch.load(boost::memory_order_seq_cst),
+				boost::memory_order_seq_cst);
+		}
+	}
+
+	void endRead(Reader *reader) {
+		assert(reader->depth > 0);
+		if (--reader->depth == 0) {
+			reader->epoch.store(Reader::OFFLINE, boost::memory_order_release);
+		}
+	}
+
+
+	/***** Reading *****/
+
+	/**
+	 * Looks up the entry with the given key. Does not lock.
+	 *
+	 * @pre The calling thread is in a read-side critical section.
+	 */
+	Entry fetch(const HashedStaticString &key) {
+		Node *node = lookup(key);
+		if (node != NULL) {
+			if (!node->referenced.load(boost::memory_order_relaxed)) {
+				node->referenced.store(true, boost::memory_order_relaxed);
+			}
+			return entryFor(node);
+		} else {
+			return Entry();
+		}
+	}
+
+
+	/***** Writing *****/
+
+	/**
+	 * Allocates an unpublished entry with storage for `size` bytes
+	 * (including the key, which is written immediately), evicting other
+	 * entries as necessary. The caller fills in the rest of the entry and
+	 * then passes it to `publish()` or `discard()`.
+	 */
+	Entry allocate(const HashedStaticString &key, size_t size) {
+		size_t blockDataSize = storagePool.mbuf_block_offset;
+		size_t nblocks = (size + blockDataSize - 1) / blockDataSize;
+		size_t needed = nblocks * storagePool.mbuf_block_chunk_size;
+		boost::lock_guard<boost::mutex> l(syncher);
+
+		if (needed > maxSize) {
+			return Entry();
+		}
+		while (usedSize + needed > maxSize) {
+			if (!evictOne()) {
+				// The remaining space is taken by unpublished entries.
+				reclaim();
+				return Entry();
+			}
+		}
+
+		Node *node = new Node();
+		node->body.storage.reserve(nblocks);
+		for (size_t i = 0; i < nblocks; i++) {
+			MemoryKit::mbuf block(MemoryKit::mbuf_get(&storagePool));
+			if (OXT_UNLIKELY(block.is_null())) {
+				delete node;
+				reclaim();
+				return Entry();
+			}
+			node->body.storage.push_back(block);
+		}
+		usedSize += needed;
+
+		node->hash = key.hash();
+		node->keySize = key.size();
+		writeKey(node, key);
+		reclaim();
+		return entryFor(node);
+	}
+
+	/**
+	 * Makes an entry returned by `allocate()` visible to all readers,
+	 * replacing any existing entry with the same key.
+	 */
+	void publish(const Entry &entry) {
+		Node *node = nodeFor(entry);
+		HashedStaticString key(node->body.storage[0].start, node->keySize);
+		boost::lock_guard<boost::mutex> l(syncher);
+
+		Node *existing = lookup(key);
+		if (existing != NULL) {
+			unlink(existing);
+		} else if (nEntries >= maxEntries) {
+			evictOne();
+		}
+
+		boost::atomic<Node *> &bucket = buckets[node->hash & bucketMask];
+		node->valid = true;
+		node->chainNext.store(bucket.load(boost::memory_order_relaxed),
+			boost::memory_order_relaxed);
+		// Publishes the node's contents along with the node itself.
+		bucket.store(node, boost::memory_order_release);
+		clockInsert(node);
+		nEntries++;
+		reclaim();
+	}
+
+	/**
+	 * Destroys an entry returned by `allocate()` without publishing it.
+	 */
+	void discard(const Entry &entry) {
+		Node *node = nodeFor(entry);
+		boost::lock_guard<boost::mutex> l(syncher);
+		assert(!node->valid);
+		usedSize -= storageSizeOf(node);
+		delete node;
+	}
+
+	/**
+	 * Removes the given entry, if it hasn't already been removed.
+	 */
+	void erase(const Entry &entry) {
+		Node *node = nodeFor(entry);
+		boost::lock_guard<boost::mutex> l(syncher);
+		if (node->valid) {
+			unlink(node);
+		}
+		reclaim();
+	}
+
+	/**
+	 * Removes the entry with the given key, if any.
+	 */
+	void erase(const HashedStaticString &key) {
+		boost::lock_guard<boost::mutex> l(syncher);
+		Node *node = lookup(key);
+		if (node != NULL) {
+			unlink(node);
+		}
+		reclaim();
+	}
+
+	void clear() {
+		boost::lock_guard<boost::mutex> l(syncher);
+		while (clockHand != NULL) {
+			unlink(clockHand);
+		}
+		reclaim();
+	}
+
+
+	/***** Introspection *****/
+
+	unsigned int getEntryCount() const {
+		boost::lock_guard<boost::mutex> l(syncher);
+		return nEntries;
+	}
+
+	unsigned int getMaxEntries() const {
+		return maxEntries;
+	}
+
+	size_t getSize() const {
+		boost::lock_guard<boost::mutex> l(syncher);
+		return usedSize;
+	}
+
+	size_t getMaxSize() const {
+		return maxSize;
+	}
+
+	boost::uint64_t getTotalEvictions() const {
+		boost::lock_guard<boost::mutex> l(syncher);
+		return totalEvictions;
+	}
+
+	/** The number of entries that have been removed, but that may still
+	 * be in use by readers. */
+	unsigned int getRetiredCount() const {
+		boost::lock_guard<boost::mutex> l(syncher);
+		return nRetired;
+	}
+
+	string inspect() const {
+		boost::lock_guard<boost::mutex> l(syncher);
+		stringstream stream;
+		const Node *node = clockHand;
+
+		if (node == NULL) {
+			return string();
+		}
+		do {
+			stream << " " << (const void *) node << ": hash=" << node->hash
+				<< ", expiryDate=" << node->body.expiryDate
+				<< ", referenced=" << node->referenced.load(boost::memory_order_relaxed)
+				<< ", keySize=" << node->keySize << ", key=\""
+				<< cEscapeString(StaticString(node->body.storage[0].start, node->keySize))
+				<< "\", storageBlocks=" << node->body.storage.size() << "\n";
+			node = node->clockNext;
+		} while (node != clockHand);
+		return stream.str();
+	}
+};
+
+
+} // namespace Passenger
+
+#endif /* _PASSENGER_SHARED_RESPONSE_CACHE_H_ */
@@ -66,9 +66,11 @@ private:
 	map<string, string> preloaderAnnotations;
 	Options options;
 
-	// Protects m_lastUsed and pid.
+	// Protects m_lastUsed, pid and preloaderAnnotations.
 	mutable boost::mutex simpleFieldSyncher;
-	// Protects everything else.
+	// Protects everything else. It's only held while talking to the
+	// preloader, not while negotiating with the spawned process, so that
+	// multiple processes can be spawned through the preloader in parallel.
 	mutable boost::mutex syncher;
 
 	// Preloader information.
@@ -302,7 +304,10 @@ private:
 			watcher->initialize();
 			watcher->start();
 
-			preloaderAnnotations = debugDir->readAll();
+			{
+				boost::lock_guard<boost::mutex> l(simpleFieldSyncher);
+				preloaderAnnotations = debugDir->readAll();
+			}
 			P_INFO("Preloader for " << options.appRoot <<
 				" started on PID " << pid <<
 				", listening on " << socketAddress);
@@ -736,6 +741,7 @@ private:
 protected:
 	virtual void annotateAppSpawnException(SpawnException &e, NegotiationDetails &details) {
 		Spawner::annotateAppSpawnException(e, details);
+		boost::lock_guard<boost::mutex> l(simpleFieldSyncher);
 		e.addAnnotations(preloaderAnnotations);
 	}
 
@@ -773,14 +779,24 @@ public:
 			m_lastUsed = SystemTime::getUsec();
 		}
 		UPDATE_TRACE_POINT();
-		boost::lock_guard<boost::mutex> l(syncher);
-		if (!preloaderStarted()) {
+		NegotiationDetails details;
+		SpawnPreparationInfo preparation;
+		{
+			boost::lock_guard<boost::mutex> l(syncher);
+			if (!preloaderStarted()) {
+				UPDATE_TRACE_POINT();
+				startPreloader();
+			}
+
 			UPDATE_TRACE_POINT();
-			startPreloader();
+			details = sendSpawnCommandAndGetNegotiationDetails(options);
+			// The preloader may be restarted by another thread while we
+			// negotiate, so work with a copy of its preparation info.
+			preparation = this->preparation;
 		}
 
 		UPDATE_TRACE_POINT();
-		NegotiationDetails details = sendSpawnCommandAndGetNegotiationDetails(options);
+		details.preparation = &preparation;
 		Result result = negotiateSpawn(details);
 		P_DEBUG("Process spawning done: appRoot=" << options.appRoot <<
 			", pid=" << result["pid"].asInt());
@@ -0,0 +1,492 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2015 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#ifndef _PASSENGER_UNION_STATION_BATCHED_LOG_WRITER_H_
+#define _PASSENGER_UNION_STATION_BATCHED_LOG_WRITER_H_
+
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <oxt/thread.hpp>
+#include <oxt/backtrace.hpp>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <cstddef>
+#include <sys/types.h>
+
+#include <jsoncpp/json.h>
+#include <Logging.h>
+#include <Exceptions.h>
+#include <Utils/IOUtils.h>
+#include <Core/UnionStation/Connection.h>
+
+namespace Passenger {
+namespace UnionStation {
+
+using namespace std;
+using namespace boost;
+
+
+class BatchedLogWriter;
+
+
+/**
+ * A transaction message that has already been serialized in the UstRouter
+ * protocol, and that must be written to the given connection.
+ */
+struct LogRecord {
+	ConnectionPtr connection;
+	string data;
+	/** Whether this record closes the transaction. After writing it, the
+	 * connection is checked back into the Context's connection pool.
+	 */
+	bool close;
+
+	LogRecord()
+		: close(false)
+		{ }
+
+	void swap(LogRecord &other) {
+		connection.swap(other.connection);
+		data.swap(other.data);
+		std::swap(close, other.close);
+	}
+};
+
+
+/**
+ * A bounded, lock-free queue of LogRecords. Any thread may push records,
+ * and only the BatchedLogWriter pops them. Each Core thread has its own
+ * ring, so in practice each ring has one producer.
+ *
+ * This is Dmitry Vyukov's bounded MPMC queue: every slot has a sequence
+ * number that tells producers and the consumer whether it's their turn.
+ */
+class LogRing: public boost::noncopyable {
+private:
+	struct Slot {
+		boost::atomic<size_t> sequence;
+		LogRecord record;
+	};
+
+	BatchedLogWriter * const writer;
+	Slot *slots;
+	const size_t mask;
+	// Keep the producer and consumer positions on different cache lines.
+	char padding1[64];
+	boost::atomic<size_t> enqueuePos;
+	char padding2[64];
+	boost::atomic<size_t> dequeuePos;
+	char padding3[64];
+
+	static size_t roundUpToPowerOfTwo(size_t value) {
+		size_t result = 2;
+		while (result < value) {
+			result *= 2;
+		}
+		return result;
+	}
+
+public:
+	/** Number of records that were accepted. */
+	boost::atomic<boost::uint64_t> queued;
+	/** Number of records that were dropped because the ring was full. */
+	boost::atomic<boost::uint64_t> dropped;
+
+	LogRing(BatchedLogWriter *_writer, size_t capacity)
+		: writer(_writer),
+		  mask(roundUpToPowerOfTwo(capacity) - 1),
+		  enqueuePos(0),
+		  dequeuePos(0),
+		  queued(0),
+		  dropped(0)
+	{
+		slots = new Slot[mask + 1];
+		for (size_t i = 0; i <= mask; i++) {
+			slots[i].sequence.store(i, boost::memory_order_relaxed);
+		}
+	}
+
+	~LogRing() {
+		delete[] slots;
+	}
+
+	/**
+	 * Moves `record` into the ring. Returns false, and leaves `record`
+	 * untouched, if the ring is full. Never blocks.
+	 */
+	bool tryPush(LogRecord &record) {
+		Slot *slot;
+		size_t pos = enqueuePos.load(boost::memory_order_relaxed);
+
+		while (true) {
+			slot = &slots[pos & mask];
+			size_t sequence = slot->sequence.load(boost::memory_order_acquire);
+			ssize_t diff = (ssize_t) sequence - (ssize_t) pos;
+			if (diff == 0) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+					boost::memory_order_relaxed))
+				{
+					break;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = enqueuePos.load(boost::memory_order_relaxed);
+			}
+		}
+
+		slot->record.swap(record);
+		slot->sequence.store(pos + 1, boost::memory_order_release);
+		queued.fetch_add(1, boost::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * Pushes a log record, or drops it and counts the drop if the ring
+	 * is full. Returns whether the record was queued.
+	 */
+	bool pushOrDrop(LogRecord &record) {
+		if (tryPush(record)) {
+			return true;
+		} else {
+			dropped.fetch_add(1, boost::memory_order_relaxed);
+			return false;
+		}
+	}
+
+	/**
+	 * Pushes a record that must not be dropped, because dropping it would
+	 * leak the connection. If the ring is full, the record is handed to
+	 * the writer's overflow list instead, which involves a short lock.
+	 */
+	void pushOrOverflow(LogRecord &record);
+
+	/**
+	 * Moves the oldest record into `record`. Returns false if the ring
+	 * is empty. Only the BatchedLogWriter may call this.
+	 */
+	bool tryPop(LogRecord &record) {
+		Slot *slot;
+		size_t pos = dequeuePos.load(boost::memory_order_relaxed);
+
+		while (true) {
+			slot = &slots[pos & mask];
+			size_t sequence = slot->sequence.load(boost::memory_order_acquire);
+			ssize_t diff = (ssize_t) sequence - (ssize_t) (pos + 1);
+			if (diff == 0) {
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+					boost::memory_order_relaxed))
+				{
+					break;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = dequeuePos.load(boost::memory_order_relaxed);
+			}
+		}
+
+		record.swap(slot->record);
+		slot->record = LogRecord();
+		slot->sequence.store(pos + mask + 1, boost::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const {
+		return mask + 1;
+	}
+};
+
+
+/**
+ * Writes the transaction messages that Core threads queue into their
+ * LogRings, from a background thread. Every `flushInterval` microseconds it
+ * drains all rings, concatenates the records per UstRouter connection, and
+ * writes each concatenation with a single system call.
+ *
+ * Request handling threads therefore never block on the UstRouter socket.
+ * If the writer cannot keep up, the rings fill up and further messages are
+ * dropped and counted, instead of slowing down requests.
+ */
+class BatchedLogWriter: public boost::noncopyable {
+public:
+	static const unsigned int DEFAULT_RING_CAPACITY = 4096;
+	static const unsigned int DEFAULT_FLUSH_INTERVAL = 10000; // In microseconds.
+	static const unsigned long long IO_TIMEOUT = 5000000; // In microseconds.
+
+	typedef boost::function<void (const ConnectionPtr &)> CheckinConnectionFunction;
+
+private:
+	struct Batch {
+		ConnectionPtr connection;
+		string data;
+		unsigned int nrecords;
+		bool close;
+
+		Batch()
+			: nrecords(0),
+			  close(false)
+			{ }
+	};
+
+	const unsigned int ringCapacity;
+	const unsigned int flushInterval;
+	CheckinConnectionFunction checkinConnection;
+
+	/** Protects `rings` and `overflow`. */
+	mutable boost::mutex syncher;
+	vector<LogRing *> rings;
+	deque<LogRecord> overflow;
+
+	/** Ensures that only one thread flushes at a time, so that the records
+	 * of a connection are written in order.
+	 */
+	boost::mutex flushSyncher;
+
+	oxt::thread *thr;
+	boost::mutex quitSyncher;
+	boost::condition_variable quitCond;
+	bool quit;
+
+	void threadMain() {
+		TRACE_POINT();
+		boost::unique_lock<boost::mutex> l(quitSyncher);
+		while (!quit) {
+			quitCond.timed_wait(l, posix_time::microseconds(flushInterval));
+			if (!quit) {
+				l.unlock();
+				flush();
+				l.lock();
+			}
+		}
+	}
+
+	void addToBatch(vector<Batch> &batches, map<Connection *, size_t> &index,
+		LogRecord &record)
+	{
+		map<Connection *, size_t>::iterator it = index.find(record.connection.get());
+		Batch *batch;
+
+		if (it == index.end()) {
+			index.insert(make_pair(record.connection.get(), batches.size()));
+			batches.push_back(Batch());
+			batch = &batches.back();
+			batch->connection = record.connection;
+		} else {
+			batch = &batches[it->second];
+		}
+
+		batch->data.append(record.data);
+		batch->nrecords++;
+		if (record.close) {
+			batch->close = true;
+		}
+	}
+
+	void writeBatch(Batch &batch) {
+		TRACE_POINT();
+		ConnectionLock l(batch.connection);
+		if (!batch.connection->connected()) {
+			recordsLost.fetch_add(batch.nrecords, boost::memory_order_relaxed);
+			return;
+		}
+
+		ConnectionGuard guard(batch.connection.get());
+		try {
+			unsigned long long timeout = IO_TIMEOUT;
+			writeExact(batch.connection->fd, batch.data.data(), batch.data.size(),
+				&timeout);
+			guard.clear();
+			batchesWritten.fetch_add(1, boost::memory_order_relaxed);
+			recordsWritten.fetch_add(batch.nrecords, boost::memory_order_relaxed);
+			if (batch.close && checkinConnection) {
+				checkinConnection(batch.connection);
+			}
+		} catch (const std::exception &e) {
+			UPDATE_TRACE_POINT();
+			guard.clear();
+			batch.connection->disconnect();
+			recordsLost.fetch_add(batch.nrecords, boost::memory_order_relaxed);
+			P_WARN("Cannot write Union Station transaction messages to the UstRouter: " <<
+				e.what());
+		}
+	}
+
+public:
+	/** Number of system calls that wrote batches. */
+	boost::atomic<boost::uint64_t> batchesWritten;
+	/** Number of records that were written. */
+	boost::atomic<boost::uint64_t> recordsWritten;
+	/** Number of records that were lost because of connection errors. */
+	boost::atomic<boost::uint64_t> recordsLost;
+
+	BatchedLogWriter(const CheckinConnectionFunction &_checkinConnection,
+		unsigned int _ringCapacity = DEFAULT_RING_CAPACITY,
+		unsigned int _flushInterval = DEFAULT_FLUSH_INTERVAL)
+		: ringCapacity(_ringCapacity),
+		  flushInterval(_flushInterval),
+		  checkinConnection(_checkinConnection),
+		  thr(NULL),
+		  quit(false),
+		  batchesWritten(0),
+		  recordsWritten(0),
+		  recordsLost(0)
+		{ }
+
+	~BatchedLogWriter() {
+		stop();
+		flush();
+		for (unsigned int i = 0; i < rings.size(); i++) {
+			delete rings[i];
+		}
+	}
+
+	void start() {
+		assert(thr == NULL);
+		thr = new oxt::thread(boost::bind(&BatchedLogWriter::threadMain, this),
+			"Union Station batched log writer", 1024 * 128);
+	}
+
+	/**
+	 * Stops the background thread. Records that are still queued are
+	 * written by the next `flush()` call, or by the destructor.
+	 */
+	void stop() {
+		if (thr != NULL) {
+			{
+				boost::lock_guard<boost::mutex> l(quitSyncher);
+				quit = true;
+				quitCond.notify_one();
+			}
+			thr->join();
+			delete thr;
+			thr = NULL;
+		}
+	}
+
+	/**
+	 * Creates a new ring. The ring is owned by this BatchedLogWriter.
+	 */
+	LogRing *createRing() {
+		LogRing *ring = new LogRing(this, ringCapacity);
+		boost::lock_guard<boost::mutex> l(syncher);
+		rings.push_back(ring);
+		return ring;
+	}
+
+	void addOverflowRecord(LogRecord &record) {
+		boost::lock_guard<boost::mutex> l(syncher);
+		overflow.push_back(LogRecord());
+		overflow.back().swap(record);
+	}
+
+	/**
+	 * Writes all queued records. Returns the number of records that
+	 * were processed.
+	 */
+	unsigned int flush() {
+		TRACE_POINT();
+		boost::lock_guard<boost::mutex> fl(flushSyncher);
+		vector<LogRing *> ringsCopy;
+		deque<LogRecord> overflowCopy;
+		vector<Batch> batches;
+		map<Connection *, size_t> index;
+		LogRecord record;
+		unsigned int nrecords = 0;
+
+		// Overflow records are only created while a ring is full, so the
+		// earlier records of the same transaction are still in a ring at
+		// this point. By grabbing the overflow list before draining the
+		// rings, and processing it after them, we keep them in order.
+		{
+			boost::lock_guard<boost::mutex> l(syncher);
+			ringsCopy = rings;
+			overflowCopy.swap(overflow);
+		}
+
+		for (unsigned int i = 0; i < ringsCopy.size(); i++) {
+			while (ringsCopy[i]->tryPop(record)) {
+				addToBatch(batches, index, record);
+				nrecords++;
+			}
+		}
+		while (!overflowCopy.empty()) {
+			addToBatch(batches, index, overflowCopy.front());
+			overflowCopy.pop_front();
+			nrecords++;
+		}
+
+		UPDATE_TRACE_POINT();
+		for (unsigned int i = 0; i < batches.size(); i++) {
+			writeBatch(batches[i]);
+		}
+		return nrecords;
+	}
+
+	Json::Value inspectStateAsJson() const {
+		Json::Value doc;
+		boost::uint64_t queued = 0, dropped = 0;
+
+		{
+			boost::lock_guard<boost::mutex> l(syncher);
+			for (unsigned int i = 0; i < rings.size(); i++) {
+				queued += rings[i]->queued.load(boost::memory_order_relaxed);
+				dropped += rings[i]->dropped.load(boost::memory_order_relaxed);
+			}
+			doc["overflow"] = (Json::UInt) overflow.size();
+			doc["rings"] = (Json::UInt) rings.size();
+		}
+		doc["ring_capacity"] = ringCapacity;
+		doc["flush_interval"] = flushInterval;
+		doc["queued"] = (Json::UInt64) queued;
+		doc["dropped"] = (Json::UInt64) dropped;
+		doc["batches_written"] = (Json::UInt64) batchesWritten.load(boost::memory_order_relaxed);
+		doc["records_written"] = (Json::UInt64) recordsWritten.load(boost::memory_order_relaxed);
+		doc["records_lost"] = (Json::UInt64) recordsLost.load(boost::memory_order_relaxed);
+		return doc;
+	}
+};
+
+
+inline void
+LogRing::pushOrOverflow(LogRecord &record) {
+	if (tryPush(record)) {
+		return;
+	}
+	writer->addOverflowRecord(record);
+}
+
+
+} // namespace UnionStation
+} // namespace Passenger
+
+#endif /* _PASSENGER_UNION_STATION_BATCHED_LOG_WRITER_H_ */
@@ -27,7 +27,9 @@
 #define _PASSENGER_UNION_STATION_CONTEXT_H_
 
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/bind.hpp>
 #include <boost/thread.hpp>
 #include <oxt/backtrace.hpp>
 
@@ -45,6 +47,7 @@
 #include <Utils/SystemTime.h>
 #include <Core/UnionStation/Connection.h>
 #include <Core/UnionStation/Transaction.h>
+#include <Core/UnionStation/BatchedLogWriter.h>
 
 namespace Passenger {
 namespace UnionStation {
@@ -80,6 +83,11 @@ private:
 	 */
 	unsigned long long nextReconnectTime;
 
+	/** If not NULL, transactions that are given a LogRing write their
+	 * messages through this writer. See `enableBatching()`.
+	 */
+	boost::scoped_ptr<BatchedLogWriter> batchedLogWriter;
+
 	static bool isNetworkError(int code) {
 		return code == EPIPE || code == ECONNREFUSED || code == ECONNRESET
 			|| code == EHOSTUNREACH || code == ENETDOWN || code == ENETUNREACH
@@ -187,6 +195,12 @@ public:
 		initialize();
 	}
 
+	~Context() {
+		// Flushes remaining messages, which may check connections
+		// back into the pool.
+		batchedLogWriter.reset();
+	}
+
 
 	/***** Connection pool methods *****/
 
@@ -377,10 +391,46 @@ public:
 		}
 	}
 
+	/**
+	 * Starts a background thread that writes transaction messages in
+	 * batches. Only transactions created with a LogRing (see
+	 * `createLogRing()`) use it.
+	 */
+	void enableBatching(unsigned int ringCapacity = BatchedLogWriter::DEFAULT_RING_CAPACITY,
+		unsigned int flushInterval = BatchedLogWriter::DEFAULT_FLUSH_INTERVAL)
+	{
+		assert(batchedLogWriter == NULL);
+		batchedLogWriter.reset(new BatchedLogWriter(
+			boost::bind(&Context::checkinConnection, this, _1),
+			ringCapacity, flushInterval));
+		batchedLogWriter->start();
+	}
+
+	/**
+	 * Creates a LogRing for a thread that creates transactions, such as
+	 * a Core thread. Returns NULL if batching is not enabled.
+	 */
+	LogRing *createLogRing() {
+		if (batchedLogWriter == NULL) {
+			return NULL;
+		} else {
+			return batchedLogWriter->createRing();
+		}
+	}
+
+	BatchedLogWriter *getBatchedLogWriter() const {
+		return batchedLogWriter.get();
+	}
+
+	/**
+	 * @param logRing If not NULL, the transaction's messages are queued into
+	 *                this ring instead of being written synchronously.
+	 */
 	TransactionPtr newTransaction(const string &groupName,
 		const string &category = "requests",
 		const string &unionStationKey = "-",
-		const string &filters = string())
+		const string &filters = string(),
+		LogRing *logRing = NULL)
 	{
 		if (isNull()) {
 			return createNullTransaction();
@@ -428,7 +478,9 @@ public:
 				txnId,
 				groupName,
 				category,
-				unionStationKey);
+				unionStationKey,
+				PRINT,
+				logRing);
 			guard.clear();
 			P_TRACE(2, "Created new Union Station transaction: group=" << groupName <<
 				", category=" << category << ", txnId=" << txnId);
@@ -43,6 +43,7 @@
 #include <Utils/SystemTime.h>
 #include <Utils/StrIntUtils.h>
 #include <Core/UnionStation/Connection.h>
+#include <Core/UnionStation/BatchedLogWriter.h>
 
 namespace Passenger {
 namespace UnionStation {
@@ -76,6 +77,11 @@ private:
 	const string category;
 	const string unionStationKey;
 	const ExceptionHandlingMode exceptionHandlingMode;
+	/**
+	 * If not NULL, messages are queued into this ring and written by the
+	 * Context's BatchedLogWriter, instead of being written synchronously.
+	 */
+	LogRing * const logRing;
 
 	/**
 	 * Buffer must be at least txnId.size() + 1 + INT64_STR_BUFSIZE + 1 bytes.
@@ -125,9 +131,45 @@ private:
 		}
 	}
 
+	void queueMessage(const StaticString &text) {
+		char timestamp[2 * sizeof(unsigned long long) + 1];
+		integerToHexatri<unsigned long long>(SystemTime::getUsec(), timestamp);
+		P_TRACE(3, "[Union Station log] " << txnId << " " << timestamp << " " << text);
+
+		StaticString args[] = {
+			P_STATIC_STRING("log"),
+			txnId,
+			timestamp
+		};
+		LogRecord record;
+		record.connection = connection;
+		appendArrayMessage(record.data, args, sizeof(args) / sizeof(StaticString));
+		appendScalarMessage(record.data, text);
+		if (!logRing->pushOrDrop(record)) {
+			P_TRACE(3, "[Union Station log dropped] " << txnId << " " << text);
+		}
+	}
+
+	void queueCloseTransaction() {
+		char timestamp[2 * sizeof(unsigned long long) + 1];
+		integerToHexatri<unsigned long long>(SystemTime::getUsec(), timestamp);
+
+		StaticString args[] = {
+			P_STATIC_STRING("closeTransaction"),
+			txnId,
+			timestamp
+		};
+		LogRecord record;
+		record.connection = connection;
+		record.close = true;
+		appendArrayMessage(record.data, args, sizeof(args) / sizeof(StaticString));
+		logRing->pushOrOverflow(record);
+	}
+
 public:
 	Transaction()
-		: exceptionHandlingMode(PRINT)
+		: exceptionHandlingMode(PRINT),
+		  logRing(NULL)
 		{ }
 
 	Transaction(const ContextPtr &_context,
@@ -136,14 +178,16 @@ public:
 		const string &_groupName,
 		const string &_category,
 		const string &_unionStationKey,
-		ExceptionHandlingMode _exceptionHandlingMode = PRINT)
+		ExceptionHandlingMode _exceptionHandlingMode = PRINT,
+		LogRing *_logRing = NULL)
 		: context(_context),
 		  connection(_connection),
 		  txnId(_txnId),
 		  groupName(_groupName),
 		  category(_category),
 		  unionStationKey(_unionStationKey),
-		  exceptionHandlingMode(_exceptionHandlingMode)
+		  exceptionHandlingMode(_exceptionHandlingMode),
+		  logRing(_logRing)
 		{ }
 
 	~Transaction() {
@@ -151,6 +195,10 @@ public:
 		if (connection == NULL) {
 			return;
 		}
+		if (logRing != NULL) {
+			queueCloseTransaction();
+			return;
+		}
 		ConnectionLock l(connection);
 		if (!connection->connected()) {
 			return;
@@ -186,6 +234,10 @@ public:
 			P_TRACE(3, "[Union Station log to null] " << text);
 			return;
 		}
+		if (logRing != NULL) {
+			queueMessage(text);
+			return;
+		}
 		ConnectionLock l(connection);
 		if (!connection->connected()) {
 			P_TRACE(3, "[Union Station log to null] " << text);
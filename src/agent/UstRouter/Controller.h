@@ -64,6 +64,7 @@ class Controller: public ServerKit::BaseServer<Controller, Client> {
 private:
 	static const unsigned int GARBAGE_COLLECTION_TIMEOUT = 60; // 1 minute
 	static const unsigned int LOG_SINK_MAX_IDLE_TIME = 5 * 60; // 5 minutes
+	static const unsigned int TRANSACTION_BODY_BLOCK_SIZE = 1024 * 4;
 	static const unsigned int TXN_ID_MAX_SIZE =
 		2 * sizeof(unsigned int) +    // max hex timestamp size
 		11 +                          // space for a random identifier
@@ -82,6 +83,14 @@ private:
 	string dumpDir;
 	string defaultNodeName;
 	bool devMode;
+	FileSinkConfig fileSinkConfig;
+
+	/** Storage for transaction bodies. Log sinks pass references to these
+	 * blocks on to their I/O and sender threads, which is why this pool is
+	 * thread-safe and declared before the members that hold transactions:
+	 * it must outlive all of them.
+	 */
+	struct MemoryKit::mbuf_pool transactionBodyPool;
 
 	RandomGenerator randomGenerator;
 	TransactionMap transactions;
@@ -436,7 +445,7 @@ private:
 			}
 
 			transaction = boost::make_shared<Transaction>(
-				txnId, groupName, nodeName, category,
+				&transactionBodyPool, txnId, groupName, nodeName, category,
 				unionStationKey, ev_now(getLoop()), filters
 			);
 			transaction->enableCrashProtect(crashProtect);
@@ -904,7 +913,7 @@ private:
 		if (sink == NULL) {
 			string dumpFile = dumpDir + "/" + category;
 			SKC_DEBUG(client, "Creating dump file: " << dumpFile);
-			sink = boost::make_shared<FileSink>(this, dumpFile);
+			sink = boost::make_shared<FileSink>(this, dumpFile, fileSinkConfig);
 			sink->opened = 1;
 			logSinkCache.set(StaticString(cacheKey, cacheKeySize), sink);
 		} else {
@@ -959,7 +968,7 @@ private:
 					transaction->getNodeName(), transaction->getCategory());
 			}
 			P_DEBUG("Closing transaction " << transaction->getTxnId() <<
-				": appending " << transaction->getBody().size() << " bytes "
+				": appending " << transaction->getBodySize() << " bytes "
 				"to sink " << logSink->inspect());
 			logSink->append(transaction);
 			closeLogSink(logSink);
@@ -1025,7 +1034,7 @@ private:
 			return true;
 		}
 
-		StaticString body   = transaction->getBody();
+		string body         = transaction->getBodyAsString();
 		const char *current = filters.data();
 		const char *end     = filters.data() + filters.size();
 		bool result         = true;
@@ -1148,7 +1157,8 @@ public:
 		      options.get("union_station_gateway_address", false, DEFAULT_UNION_STATION_GATEWAY_ADDRESS),
 		      options.getInt("union_station_gateway_port", false, DEFAULT_UNION_STATION_GATEWAY_PORT),
 		      options.get("union_station_gateway_cert", false, ""),
-		      options.get("union_station_proxy_address", false, "")),
+		      options.get("union_station_proxy_address", false, ""),
+		      options.getUint("ust_router_sender_threads", false, RemoteSender::DEFAULT_THREADS)),
 		  gcTimer(getLoop()),
 		  flushTimer(getLoop())
 	{
@@ -1156,6 +1166,16 @@ public:
 			defaultNodeName = getHostName();
 		}
 
+		transactionBodyPool.mbuf_block_chunk_size = TRANSACTION_BODY_BLOCK_SIZE;
+		MemoryKit::mbuf_pool_init(&transactionBodyPool, true);
+
+		fileSinkConfig.bufferSize = options.getUint("ust_router_dump_buffer_size",
+			false, FileSinkConfig::DEFAULT_BUFFER_SIZE);
+		fileSinkConfig.flushDelay = options.getUint("ust_router_dump_flush_delay",
+			false, FileSinkConfig::DEFAULT_FLUSH_DELAY);
+		fileSinkConfig.fdatasync = options.getBool("ust_router_dump_fdatasync",
+			false, false);
+
 		gcTimer.set<Controller, &Controller::garbageCollect>(this);
 		gcTimer.start(GARBAGE_COLLECTION_TIMEOUT, GARBAGE_COLLECTION_TIMEOUT);
 
@@ -1183,6 +1203,8 @@ public:
 		doc["dev_mode"] = devMode;
 		doc["log_sink_cache"] = inspectLogSinkCacheStateAsJson();
 		doc["transactions"] = inspectTransactionsStateAsJson();
+		doc["transaction_body_memory"] = byteSizeToJson(
+			MemoryKit::mbuf_pool_active_memory(&transactionBodyPool));
 		if (devMode) {
 			doc["dump_dir"] = dumpDir;
 		} else {
@@ -26,12 +26,28 @@
 #ifndef _PASSENGER_UST_ROUTER_FILE_SINK_H_
 #define _PASSENGER_UST_ROUTER_FILE_SINK_H_
 
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <oxt/thread.hpp>
+#include <oxt/system_calls.hpp>
+#include <oxt/backtrace.hpp>
 #include <string>
+#include <vector>
 #include <ctime>
-#include <oxt/system_calls.hpp>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <ev++.h>
+#include <Logging.h>
 #include <Exceptions.h>
 #include <FileDescriptor.h>
+#include <StaticString.h>
+#include <MemoryKit/mbuf.h>
 #include <UstRouter/LogSink.h>
+#include <Utils/IOUtils.h>
+#include <Utils/JsonUtils.h>
 #include <Utils/StrIntUtils.h>
 
 namespace Passenger {
@@ -41,16 +57,99 @@ using namespace std;
 using namespace oxt;
 
 
+struct FileSinkConfig {
+	static const unsigned int DEFAULT_BUFFER_SIZE = 64 * 1024;
+	static const unsigned int DEFAULT_FLUSH_DELAY = 100; // In milliseconds.
+	static const unsigned int DEFAULT_MAX_PENDING_SIZE = 64 * 1024 * 1024;
+
+	/** Once this many bytes have been appended, they are handed to the
+	 * I/O thread without waiting for `flushDelay`.
+	 */
+	unsigned int bufferSize;
+	/** Appended data is handed to the I/O thread at most this many
+	 * milliseconds after it was appended.
+	 */
+	unsigned int flushDelay;
+	/** If the I/O thread falls this many bytes behind, further data is
+	 * dropped instead of being buffered.
+	 */
+	unsigned int maxPendingSize;
+	/** Whether to call fdatasync() after every group of writes. */
+	bool fdatasync;
+
+	FileSinkConfig()
+		: bufferSize(DEFAULT_BUFFER_SIZE),
+		  flushDelay(DEFAULT_FLUSH_DELAY),
+		  maxPendingSize(DEFAULT_MAX_PENDING_SIZE),
+		  fdatasync(false)
+		{ }
+};
+
+
+/**
+ * Appends transactions to a dump file, without doing any disk I/O on the
+ * event loop thread.
+ *
+ * Appended transactions are collected in a buffer. When the buffer reaches
+ * `bufferSize`, or `flushDelay` after the first transaction was appended,
+ * the buffer is handed to an I/O thread. That thread writes everything that
+ * has been handed to it since its last write with a single writev() call,
+ * optionally followed by a single fdatasync() (group commit).
+ *
+ * The I/O thread also notices when the dump file has been rotated, i.e.
+ * renamed or removed, and then reopens it.
+ */
 class FileSink: public LogSink {
-public:
-	string filename;
-	FileDescriptor fd;
+private:
+	static const unsigned int ROTATION_CHECK_INTERVAL = 1; // In seconds.
 
-	FileSink(Controller *controller, const string &_filename)
-		: LogSink(controller),
-		  filename(_filename)
-	{
-		fd.assign(syscalls::open(_filename.c_str(),
+	const FileSinkConfig config;
+
+	/** Data that has been appended, but not yet handed to the I/O thread.
+	 * These are references to the transaction bodies, not copies.
+	 * Only accessed from the event loop thread.
+	 */
+	vector<MemoryKit::mbuf> buffer;
+	size_t bufferSize;
+	ev::timer flushTimer;
+
+
+	/****** Shared between the event loop thread and the I/O thread ******/
+
+	mutable boost::mutex syncher;
+	boost::condition_variable cond;
+	/** Buffers that have been handed to the I/O thread. */
+	vector<MemoryKit::mbuf> pending;
+	size_t pendingSize;
+	/** When the oldest buffer in `pending` was handed over. */
+	ev_tstamp pendingSince;
+	bool quit;
+
+	// Statistics.
+	unsigned long long writeCalls;
+	unsigned long long syncCalls;
+	unsigned long long bytesFlushed;
+	unsigned long long bytesDropped;
+	unsigned long long writeErrors;
+	unsigned long long reopened;
+	/** Total time spent in writev() and fdatasync(), in microseconds. */
+	unsigned long long ioTime;
+	/** Latencies between handing data to the I/O thread and that data
+	 * being written, in microseconds.
+	 */
+	unsigned long long lastFlushLatency;
+	unsigned long long maxFlushLatency;
+	unsigned long long totalFlushLatency;
+
+
+	/****** Only accessed from the I/O thread ******/
+
+	ev_tstamp lastRotationCheck;
+	oxt::thread *thr;
+
+
+	void openFile() {
+		fd.assign(syscalls::open(filename.c_str(),
 			O_CREAT | O_WRONLY | O_APPEND,
 			0600), __FILE__, __LINE__);
 		if (fd == -1) {
@@ -60,16 +159,253 @@ public:
 		}
 	}
 
+	void onFlushTimeout(ev::timer &timer, int revents) {
+		handOff();
+	}
+
+	/**
+	 * Hands the buffer to the I/O thread. Never blocks on disk I/O.
+	 */
+	bool handOff() {
+		flushTimer.stop();
+		if (bufferSize == 0) {
+			return false;
+		}
+
+		boost::lock_guard<boost::mutex> l(syncher);
+		if (pendingSize + bufferSize > config.maxPendingSize) {
+			if (bytesDropped == 0) {
+				P_WARN(inspect() << ": the disk cannot keep up; dropping data");
+			}
+			bytesDropped += bufferSize;
+			buffer.clear();
+			bufferSize = 0;
+			return false;
+		}
+		if (pending.empty()) {
+			pendingSince = ev_time();
+			pending.swap(buffer);
+		} else {
+			pending.insert(pending.end(), buffer.begin(), buffer.end());
+			buffer.clear();
+		}
+		pendingSize += bufferSize;
+		bufferSize = 0;
+		cond.notify_one();
+		return true;
+	}
+
+	void threadMain() {
+		TRACE_POINT();
+		boost::unique_lock<boost::mutex> l(syncher);
+		vector<MemoryKit::mbuf> batch;
+		ev_tstamp batchSince;
+
+		while (true) {
+			while (pending.empty() && !quit) {
+				cond.wait(l);
+			}
+			if (pending.empty()) {
+				break;
+			}
+
+			batch.swap(pending);
+			batchSince = pendingSince;
+			pendingSize = 0;
+			l.unlock();
+
+			UPDATE_TRACE_POINT();
+			writeBatch(batch, batchSince);
+			batch.clear();
+
+			l.lock();
+		}
+	}
+
+	void writeBatch(const vector<MemoryKit::mbuf> &batch, ev_tstamp batchSince) {
+		TRACE_POINT();
+		vector<StaticString> data;
+		size_t size = 0;
+		bool synced = false;
+		ev_tstamp startTime, endTime;
+		int e = 0;
+
+		checkRotation();
+
+		data.reserve(batch.size());
+		for (unsigned int i = 0; i < batch.size(); i++) {
+			data.push_back(StaticString(batch[i].start, batch[i].size()));
+			size += batch[i].size();
+		}
+
+		startTime = ev_time();
+		try {
+			gatheredWrite(fd, &data[0], data.size());
+			if (config.fdatasync) {
+				int ret;
+				do {
+					#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+						ret = ::fsync(fd);
+					#else
+						ret = ::fdatasync(fd);
+					#endif
+				} while (ret == -1 && errno == EINTR);
+				if (ret == -1) {
+					e = errno;
+				} else {
+					synced = true;
+				}
+			}
+		} catch (const SystemException &ex) {
+			e = ex.code();
+		}
+		endTime = ev_time();
+
+		if (e != 0) {
+			P_ERROR("Cannot write to " << filename << ": " << strerror(e) <<
+				" (errno=" << e << ")");
+		}
+
+		boost::lock_guard<boost::mutex> l(syncher);
+		if (e == 0) {
+			bytesFlushed += size;
+		} else {
+			writeErrors++;
+		}
+		writeCalls++;
+		if (synced) {
+			syncCalls++;
+		}
+		ioTime += (unsigned long long) ((endTime - startTime) * 1000000);
+		lastFlushLatency = (unsigned long long) ((endTime - batchSince) * 1000000);
+		maxFlushLatency = std::max(maxFlushLatency, lastFlushLatency);
+		totalFlushLatency += lastFlushLatency;
+	}
+
+	/**
+	 * Reopens the file if it has been renamed or removed, e.g. by logrotate.
+	 */
+	void checkRotation() {
+		ev_tstamp now = ev_time();
+		if (now - lastRotationCheck < ROTATION_CHECK_INTERVAL) {
+			return;
+		}
+		lastRotationCheck = now;
+
+		struct stat pathInfo, fdInfo;
+		int ret;
+		do {
+			ret = stat(filename.c_str(), &pathInfo);
+		} while (ret == -1 && errno == EINTR);
+		if (ret == -1 && errno != ENOENT) {
+			return;
+		}
+		if (ret == 0 && fstat(fd, &fdInfo) == 0
+		 && pathInfo.st_dev == fdInfo.st_dev
+		 && pathInfo.st_ino == fdInfo.st_ino)
+		{
+			return;
+		}
+
+		P_INFO(filename << " has been rotated; reopening it");
+		try {
+			openFile();
+			boost::lock_guard<boost::mutex> l(syncher);
+			reopened++;
+		} catch (const FileSystemException &ex) {
+			P_ERROR(ex.what());
+		}
+	}
+
+public:
+	string filename;
+	FileDescriptor fd;
+
+	FileSink(Controller *controller, const string &_filename,
+		const FileSinkConfig &_config = FileSinkConfig())
+		: LogSink(controller),
+		  config(_config),
+		  bufferSize(0),
+		  flushTimer(Controller_getLoop(controller)),
+		  pendingSize(0),
+		  pendingSince(0),
+		  quit(false),
+		  writeCalls(0),
+		  syncCalls(0),
+		  bytesFlushed(0),
+		  bytesDropped(0),
+		  writeErrors(0),
+		  reopened(0),
+		  ioTime(0),
+		  lastFlushLatency(0),
+		  maxFlushLatency(0),
+		  totalFlushLatency(0),
+		  lastRotationCheck(ev_time()),
+		  thr(NULL),
+		  filename(_filename)
+	{
+		openFile();
+		flushTimer.set<FileSink, &FileSink::onFlushTimeout>(this);
+		thr = new oxt::thread(boost::bind(&FileSink::threadMain, this),
+			"FileSink I/O thread: " + filename, 1024 * 64);
+	}
+
+	~FileSink() {
+		handOff();
+		{
+			boost::lock_guard<boost::mutex> l(syncher);
+			quit = true;
+			cond.notify_one();
+		}
+		// The I/O thread writes all pending data before exiting.
+		thr->join();
+		delete thr;
+	}
+
 	virtual void append(const TransactionPtr &transaction) {
-		StaticString data = transaction->getBody();
 		LogSink::append(transaction);
-		syscalls::write(fd, data.data(), data.size());
+		transaction->getBody(buffer);
+		bufferSize += transaction->getBodySize();
+		if (bufferSize >= config.bufferSize) {
+			handOff();
+		} else if (!flushTimer.is_active()) {
+			flushTimer.start(config.flushDelay / 1000.0, 0);
+		}
+	}
+
+	virtual bool flush() {
+		LogSink::flush();
+		return handOff();
 	}
 
 	virtual Json::Value inspectStateAsJson() const {
 		Json::Value doc = LogSink::inspectStateAsJson();
 		doc["type"] = "file";
 		doc["filename"] = filename;
+		doc["buffer_size"] = byteSizeToJson(bufferSize);
+		doc["fdatasync"] = config.fdatasync;
+
+		boost::lock_guard<boost::mutex> l(syncher);
+		doc["pending_size"] = byteSizeToJson(pendingSize);
+		doc["bytes_flushed"] = byteSizeToJson(bytesFlushed);
+		doc["bytes_dropped"] = byteSizeToJson(bytesDropped);
+		doc["write_calls"] = (Json::UInt64) writeCalls;
+		doc["sync_calls"] = (Json::UInt64) syncCalls;
+		doc["write_errors"] = (Json::UInt64) writeErrors;
+		doc["reopened"] = (Json::UInt64) reopened;
+		if (ioTime == 0) {
+			doc["write_throughput"] = byteSpeedToJson(-1, -1, "second");
+		} else {
+			doc["write_throughput"] = byteSpeedToJson(
+				bytesFlushed * 1000000.0 / ioTime, "second");
+		}
+		doc["last_flush_latency"] = durationToJson(lastFlushLatency);
+		doc["max_flush_latency"] = durationToJson(maxFlushLatency);
+		if (writeCalls == 0) {
+			doc["average_flush_latency"] = durationToJson(0);
+		} else {
+			doc["average_flush_latency"] = durationToJson(totalFlushLatency / writeCalls);
+		}
 		return doc;
 	}
 
@@ -103,7 +103,7 @@ public:
 	virtual void append(const TransactionPtr &transaction) {
 		assert(!transaction->isDiscarded());
 		lastWrittenTo = ev_now(Controller_getLoop(controller));
-		totalBytesWritten += transaction->getBody().size();
+		totalBytesWritten += transaction->getBodySize();
 	}
 
 	virtual bool flush() {
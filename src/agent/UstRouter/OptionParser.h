@@ -69,6 +69,14 @@ ustRouterUsage() {
 	printf("      --dev-mode              Enable development mode: dump data to a directory\n");
 	printf("                              instead of sending them to the Union Station gateway\n");
 	printf("      --dump-dir  PATH        Directory to dump to\n");
+	printf("      --dump-buffer-size BYTES\n");
+	printf("                              Write dump data to disk once this much has been\n");
+	printf("                              buffered. Default: 65536\n");
+	printf("      --dump-flush-delay MSEC Write buffered dump data to disk after at most\n");
+	printf("                              this many milliseconds. Default: 100\n");
+	printf("      --dump-fdatasync        Call fdatasync() after every group of dump writes\n");
+	printf("      --sender-threads NUM    Number of threads that compress and send data to\n");
+	printf("                              the Union Station gateways. Default: 2\n");
 	printf("\n");
 	printf("Other options (optional):\n");
 	printf("      --user USERNAME         Lower privilege to the given user. Only has\n");
@@ -146,6 +154,18 @@ parseUstRouterOption(int argc, const char *argv[], int &i, VariantMap &options)
 	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--dump-dir")) {
 		options.set("ust_router_dump_dir", argv[i + 1]);
 		i += 2;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--dump-buffer-size")) {
+		options.setInt("ust_router_dump_buffer_size", atoi(argv[i + 1]));
+		i += 2;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--dump-flush-delay")) {
+		options.setInt("ust_router_dump_flush_delay", atoi(argv[i + 1]));
+		i += 2;
+	} else if (p.isFlag(argv[i], '\0', "--dump-fdatasync")) {
+		options.setBool("ust_router_dump_fdatasync", true);
+		i++;
+	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--sender-threads")) {
+		options.setInt("ust_router_sender_threads", atoi(argv[i + 1]));
+		i += 2;
 	} else if (p.isValueFlag(argc, i, argv[i], '\0', "--user")) {
 		options.set("analytics_log_user", argv[i + 1]);
 		i += 2;
@@ -33,16 +33,22 @@
 #include <zlib.h>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
 #include <oxt/thread.hpp>
 #include <string>
 #include <list>
+#include <vector>
+#include <algorithm>
+#include <cstring>
 #include <jsoncpp/json.h>
 #include <modp_b64.h>
 
 #include <Logging.h>
 #include <StaticString.h>
+#include <MemoryKit/mbuf.h>
 #include <Utils.h>
 #include <Utils/BlockingQueue.h>
 #include <Utils/SystemTime.h>
@@ -72,6 +78,10 @@ private:
 		string nodeName;
 		string category;
 		string data;
+		/** Uncompressed data that is referenced rather than copied.
+		 * Used instead of `data` until the item has been compressed.
+		 */
+		vector<MemoryKit::mbuf> buffers;
 
 		Item() {
 			exit = false;
@@ -79,6 +89,89 @@ private:
 		}
 	};
 
+	typedef boost::shared_ptr<Item> ItemPtr;
+
+	/**
+	 * A zlib stream that is reset for every packet instead of being
+	 * reallocated. Each sender thread has its own.
+	 */
+	class Compressor {
+	private:
+		z_stream strm;
+		bool initialized;
+
+	public:
+		Compressor() {
+			memset(&strm, 0, sizeof(strm));
+			strm.zalloc = Z_NULL;
+			strm.zfree  = Z_NULL;
+			strm.opaque = Z_NULL;
+			initialized = deflateInit(&strm, Z_DEFAULT_COMPRESSION) == Z_OK;
+		}
+
+		~Compressor() {
+			if (initialized) {
+				deflateEnd(&strm);
+			}
+		}
+
+		/**
+		 * Compresses the concatenation of the given pieces into a
+		 * single zlib stream.
+		 */
+		bool compress(const StaticString data[], unsigned int count, string &output) {
+			size_t size = 0;
+			unsigned int i;
+			int ret;
+
+			if (!initialized || deflateReset(&strm) != Z_OK) {
+				return false;
+			}
+
+			for (i = 0; i < count; i++) {
+				size += data[i].size();
+			}
+			// deflateBound() is enough to compress everything without
+			// growing the buffer, but we don't rely on it when the
+			// input consists of multiple pieces.
+			output.resize(deflateBound(&strm, size));
+			strm.avail_out = output.size();
+			strm.next_out  = (unsigned char *) &output[0];
+
+			i = 0;
+			do {
+				int flush = (i + 1 >= count) ? Z_FINISH : Z_NO_FLUSH;
+				if (i < count) {
+					strm.avail_in = data[i].size();
+					strm.next_in  = (unsigned char *) data[i].data();
+				} else {
+					strm.avail_in = 0;
+					strm.next_in  = Z_NULL;
+				}
+
+				do {
+					if (strm.avail_out == 0) {
+						size_t used = strm.total_out;
+						output.resize(output.size() * 2);
+						strm.avail_out = output.size() - used;
+						strm.next_out  = (unsigned char *) &output[used];
+					}
+					ret = deflate(&strm, flush);
+					if (ret == Z_STREAM_ERROR) {
+						return false;
+					}
+				} while (flush == Z_FINISH
+					? ret != Z_STREAM_END
+					: strm.avail_in > 0);
+
+				i++;
+			} while (i < count);
+
+			output.resize(strm.total_out);
+			return true;
+		}
+	};
+
 	class Server {
 	public:
 		enum SendResult {
@@ -109,21 +202,36 @@ private:
 		};
 
 	private:
+		/**
+		 * A libcurl handle plus its per-request state. A Server keeps a pool
+		 * of these, so that multiple sender threads can upload to the same
+		 * gateway concurrently.
+		 */
+		struct CurlConnection {
+			CURL *curl;
+			char lastCurlErrorMessage[CURL_ERROR_SIZE];
+			string responseBody;
+
+			CurlConnection()
+				: curl(NULL)
+			{
+				lastCurlErrorMessage[0] = '\0';
+			}
+		};
+
 		string ip;
 		unsigned short port;
 		string certificate;
 		const CurlProxyInfo *proxyInfo;
 
-		CURL *curl;
 		struct curl_slist *headers;
-		char lastCurlErrorMessage[CURL_ERROR_SIZE];
 		string hostHeader;
-		string responseBody;
 
 		string pingURL;
 		string sinkURL;
 
 		mutable boost::mutex syncher;
+		vector<CurlConnection *> idleConnections;
 		string lastErrorMessage;
 		unsigned long long lastErrorTime;
 		unsigned long long lastSuccessTime;
@@ -132,7 +240,8 @@ private:
 		unsigned int packetsRejected;
 		unsigned int packetsDropped;
 
-		void resetConnection() {
+		void resetConnection(CurlConnection *conn) {
+			CURL *&curl = conn->curl;
 			if (curl != NULL) {
 				#ifdef HAS_CURL_EASY_RESET
 					curl_easy_reset(curl);
@@ -149,10 +258,10 @@ private:
 			}
 			curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
 			curl_easy_setopt(curl, CURLOPT_TIMEOUT, 180);
-			curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, lastCurlErrorMessage);
+			curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, conn->lastCurlErrorMessage);
 			curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curlDataReceived);
-			curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
+			curl_easy_setopt(curl, CURLOPT_WRITEDATA, conn);
 			if (certificate.empty()) {
 				curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0);
 			} else {
@@ -165,12 +274,37 @@ private:
 			 */
 			curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0);
 			setCurlProxy(curl, *proxyInfo);
-			responseBody.clear();
+			conn->responseBody.clear();
 		}
 
-		void prepareRequest(const string &url) {
-			curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-			responseBody.clear();
+		CurlConnection *checkoutConnection() {
+			{
+				boost::lock_guard<boost::mutex> l(syncher);
+				if (!idleConnections.empty()) {
+					CurlConnection *conn = idleConnections.back();
+					idleConnections.pop_back();
+					return conn;
+				}
+			}
+
+			CurlConnection *conn = new CurlConnection();
+			try {
+				resetConnection(conn);
+			} catch (...) {
+				delete conn;
+				throw;
+			}
+			return conn;
+		}
+
+		void checkinConnection(CurlConnection *conn) {
+			boost::lock_guard<boost::mutex> l(syncher);
+			idleConnections.push_back(conn);
+		}
+
+		void prepareRequest(CurlConnection *conn, const string &url) {
+			curl_easy_setopt(conn->curl, CURLOPT_URL, url.c_str());
+			conn->responseBody.clear();
 		}
 
 		static bool validateResponse(const Json::Value &response) {
@@ -188,12 +322,13 @@ private:
 			}
 		}
 
-		SendResult handleSendResponse(const Item &item) {
+		SendResult handleSendResponse(CurlConnection *conn, const Item &item) {
+			const string &responseBody = conn->responseBody;
 			Json::Reader reader;
 			Json::Value response;
 			long httpCode = -1;
 
-			curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+			curl_easy_getinfo(conn->curl, CURLINFO_RESPONSE_CODE, &httpCode);
 
 			if (!reader.parse(responseBody, response, false) || !validateResponse(response)) {
 				setRequestError(
@@ -232,11 +367,11 @@ private:
 			}
 		}
 
-		void handleSendError(const Item &item) {
+		void handleSendError(CurlConnection *conn, const Item &item) {
 			setRequestError(
 				"Could not send data to Union Station gateway server " +
 				ip + ". It might be down. Key: " + item.unionStationKey +
-				". Error: " + lastCurlErrorMessage);
+				". Error: " + conn->lastCurlErrorMessage);
 		}
 
 		void setPingError(const string &message) {
@@ -281,14 +416,15 @@ private:
 		}
 
 		static size_t curlDataReceived(void *buffer, size_t size, size_t nmemb, void *userData) {
-			Server *self = (Server *) userData;
-			self->responseBody.append((const char *) buffer, size * nmemb);
+			CurlConnection *conn = (CurlConnection *) userData;
+			conn->responseBody.append((const char *) buffer, size * nmemb);
 			return size * nmemb;
 		}
 
 	public:
 		Server(const string &ip, const string &hostName, unsigned short port,
-			const string &cert, const CurlProxyInfo *proxyInfo)
+			const string &cert, const CurlProxyInfo *proxyInfo,
+			const string &scheme = "https")
 		{
 			this->ip = ip;
 			this->port = port;
@@ -304,24 +440,23 @@ private:
 
 			// Older libcurl versions didn't strdup() any option
 			// strings so we need to keep these in memory.
-			pingURL = string("https://") + ip + ":" + toString(port) +
+			pingURL = scheme + "://" + ip + ":" + toString(port) +
 				"/ping";
-			sinkURL = string("https://") + ip + ":" + toString(port) +
+			sinkURL = scheme + "://" + ip + ":" + toString(port) +
 				"/sink";
 
-			curl = NULL;
 			lastErrorTime = 0;
 			lastSuccessTime = 0;
 			pingErrors = 0;
 			packetsAccepted = 0;
 			packetsRejected = 0;
 			packetsDropped = 0;
-			resetConnection();
 		}
 
 		~Server() {
-			if (curl != NULL) {
-				curl_easy_cleanup(curl);
+			foreach (CurlConnection *conn, idleConnections) {
+				curl_easy_cleanup(conn->curl);
+				delete conn;
 			}
 			curl_slist_free_all(headers);
 		}
@@ -332,31 +467,40 @@ private:
 
 		bool ping() {
 			P_INFO("Pinging Union Station gateway " << ip << ":" << port);
-			ScopeGuard guard(boost::bind(&Server::resetConnection, this));
-			prepareRequest(pingURL);
+			CurlConnection *conn = checkoutConnection();
+			ScopeGuard checkinGuard(boost::bind(&Server::checkinConnection, this, conn));
+			ScopeGuard guard(boost::bind(&Server::resetConnection, this, conn));
+			prepareRequest(conn, pingURL);
 
-			curl_easy_setopt(curl, CURLOPT_HTTPGET, 1);
-			if (curl_easy_perform(curl) != 0) {
+			curl_easy_setopt(conn->curl, CURLOPT_HTTPGET, 1);
+			if (curl_easy_perform(conn->curl) != 0) {
 				setPingError(
 					"Could not ping Union Station gateway server " +
-					ip + ": " + lastCurlErrorMessage);
+					ip + ": " + conn->lastCurlErrorMessage);
 				return false;
 			}
-			if (responseBody == "pong") {
+			if (conn->responseBody == "pong") {
 				guard.clear();
 				return true;
 			} else {
 				setPingError(
 					"Union Station gateway server " + ip +
 					" returned an unexpected ping message: " +
-					responseBody);
+					conn->responseBody);
 				return false;
 			}
 		}
 
+		/**
+		 * Sends a packet to this gateway. May be called from multiple
+		 * threads concurrently.
+		 */
 		SendResult send(const Item &item) {
-			ScopeGuard guard(boost::bind(&Server::resetConnection, this));
-			prepareRequest(sinkURL);
+			CurlConnection *conn = checkoutConnection();
+			ScopeGuard checkinGuard(boost::bind(&Server::checkinConnection, this, conn));
+			ScopeGuard guard(boost::bind(&Server::resetConnection, this, conn));
+			CURL *curl = conn->curl;
+			prepareRequest(conn, sinkURL);
 
 			struct curl_httppost *post = NULL;
 			struct curl_httppost *last = NULL;
@@ -411,9 +555,9 @@ private:
 
 			if (code == CURLE_OK) {
 				guard.clear();
-				return handleSendResponse(item);
+				return handleSendResponse(conn, item);
 			} else {
-				handleSendError(item);
+				handleSendError(conn, item);
 				return SR_DOWN;
 			}
 		}
@@ -439,6 +583,8 @@ private:
 				doc["last_success_time"] = timeToJson(lastSuccessTime);
 			}
 
+			doc["idle_connections"] = (Json::UInt) idleConnections.size();
+
 			errorDoc["ping_errors"] = pingErrors;
 			errorDoc["packets_dropped"] = packetsDropped;
 			errorDoc["packets_rejected"] = packetsRejected;
@@ -455,22 +601,31 @@ private:
 	string gatewayAddress;
 	unsigned short gatewayPort;
 	string certificate;
+	string gatewayScheme;
 	CurlProxyInfo proxyInfo;
-	BlockingQueue<Item> queue;
-	oxt::thread *thr;
+	BlockingQueue<ItemPtr> queue;
+	vector<oxt::thread *> threads;
 
 	mutable boost::mutex syncher;
+	boost::condition_variable checkupFinished;
 	list<ServerPtr> upServers;
 	vector<ServerPtr> downServers;
+	/** Incremented every time the server lists are replaced by a checkup. */
+	unsigned int serversGeneration;
+	/** Whether a thread is currently rechecking the servers. */
+	bool checkingServers;
 	time_t lastCheckupTime, nextCheckupTime;
 	string lastDnsErrorMessage;
 	unsigned int packetsAccepted, packetsRejected, packetsDropped;
+	size_t queuedBytes;
+	unsigned long long bytesCompressed, compressedBytesProduced;
 
 	void threadMain() {
-		ScopeGuard guard(boost::bind(&RemoteSender::freeThreadData, this));
+		Compressor compressor;
+		string buffer;
 
 		while (true) {
-			Item item;
+			ItemPtr item;
 			bool hasItem;
 
 			if (firstStarted()) {
@@ -481,25 +636,131 @@ private:
 			}
 
 			if (hasItem) {
-				if (item.exit) {
+				if (item->exit) {
 					return;
 				} else {
-					if (timeForCheckup()) {
-						recheckServers();
-					}
-					sendOut(item);
+					recheckServersIfNecessary();
+					compressItem(compressor, *item, buffer);
+					sendOut(*item);
 				}
-			} else if (timeForCheckup()) {
-				recheckServers();
+			} else {
+				recheckServersIfNecessary();
 			}
 		}
 	}
 
+	bool reserveQueueSpace(size_t size) {
+		boost::lock_guard<boost::mutex> l(syncher);
+		if (queuedBytes + size > MAX_QUEUED_BYTES) {
+			P_WARN("The Union Station gateway isn't responding quickly enough; dropping packet.");
+			packetsDropped++;
+			return false;
+		}
+		queuedBytes += size;
+		return true;
+	}
+
+	static ItemPtr createItem(const string &unionStationKey, const StaticString &nodeName,
+		const StaticString &category)
+	{
+		ItemPtr item = boost::make_shared<Item>();
+		item->unionStationKey = unionStationKey;
+		item->nodeName = nodeName;
+		item->category = category;
+		return item;
+	}
+
+	void enqueue(const ItemPtr &item, size_t size) {
+		P_DEBUG("Scheduling Union Station packet: key=" << item->unionStationKey <<
+			", node=" << item->nodeName << ", category=" << item->category <<
+			", dataSize=" << size);
+
+		if (!queue.tryAdd(item)) {
+			P_WARN("The Union Station gateway isn't responding quickly enough; dropping packet.");
+			boost::lock_guard<boost::mutex> l(syncher);
+			queuedBytes -= size;
+			packetsDropped++;
+		}
+	}
+
 	bool firstStarted() const {
 		boost::lock_guard<boost::mutex> l(syncher);
 		return nextCheckupTime == 0;
 	}
 
+	void compressItem(Compressor &compressor, Item &item, string &buffer) {
+		vector<StaticString> pieces;
+		size_t size = 0;
+		unsigned int i;
+
+		if (item.buffers.empty()) {
+			pieces.push_back(item.data);
+		} else {
+			pieces.reserve(item.buffers.size());
+			for (i = 0; i < item.buffers.size(); i++) {
+				pieces.push_back(StaticString(item.buffers[i].start,
+					item.buffers[i].size()));
+			}
+		}
+		for (i = 0; i < pieces.size(); i++) {
+			size += pieces[i].size();
+		}
+
+		if (compressor.compress(&pieces[0], pieces.size(), buffer)) {
+			// Swap so that both buffers are reused for the next item.
+			item.data.swap(buffer);
+			item.compressed = true;
+		} else if (!item.buffers.empty()) {
+			// Send the data uncompressed.
+			item.data.clear();
+			item.data.reserve(size);
+			for (i = 0; i < pieces.size(); i++) {
+				item.data.append(pieces[i].data(), pieces[i].size());
+			}
+		}
+		// Release the referenced data as early as possible.
+		item.buffers.clear();
+
+		boost::lock_guard<boost::mutex> l(syncher);
+		queuedBytes -= size;
+		if (item.compressed) {
+			bytesCompressed += size;
+			compressedBytesProduced += item.data.size();
+		}
+	}
+
+	/**
+	 * Rechecks the servers if it's time to. Only one thread performs the
+	 * checkup at a time. Other threads keep using the current server list,
+	 * unless it is empty: then they wait for the checkup to finish.
+	 */
+	void recheckServersIfNecessary() {
+		boost::unique_lock<boost::mutex> l(syncher);
+		if (checkingServers) {
+			while (checkingServers && upServers.empty()) {
+				checkupFinished.wait(l);
+			}
+			return;
+		}
+		if (SystemTime::get() < nextCheckupTime) {
+			return;
+		}
+
+		checkingServers = true;
+		l.unlock();
+		try {
+			recheckServers();
+		} catch (...) {
+			l.lock();
+			checkingServers = false;
+			checkupFinished.notify_all();
+			throw;
+		}
+		l.lock();
+		checkingServers = false;
+		checkupFinished.notify_all();
+	}
+
 	void recheckServers() {
 		P_INFO("Rechecking Union Station gateway servers (" << gatewayAddress << ")...");
 
@@ -512,13 +773,13 @@ private:
 			ips = resolveHostname(gatewayAddress, gatewayPort);
 		} catch (const tracable_exception &e) {
 			P_ERROR(e.what());
+			boost::lock_guard<boost::mutex> l(syncher);
 			// DNS errors tend to be temporary, so retry
 			// after a short timeout.
 			scheduleNextCheckup(1 * 60);
 			// Take note of the error, but do not change the server
 			// list so that the RemoteSender can keep working with
 			// the last known server list.
-			boost::lock_guard<boost::mutex> l(syncher);
 			this->lastCheckupTime = SystemTime::get();
 			this->lastDnsErrorMessage = e.what();
 			return;
@@ -530,7 +791,7 @@ private:
 		for (it = ips.begin(); it != ips.end(); it++) {
 			ServerPtr server = boost::make_shared<Server>(
 				*it, gatewayAddress, gatewayPort, certificate,
-				&proxyInfo);
+				&proxyInfo, gatewayScheme);
 			if (server->ping()) {
 				upServers.push_back(server);
 			} else {
@@ -539,6 +800,7 @@ private:
 		}
 		P_INFO(upServers.size() << " Union Station gateway servers are up");
 
+		boost::lock_guard<boost::mutex> l(syncher);
 		if (downServers.empty()) {
 			if (upServers.empty()) {
 				// The DNS lookup was successful, but returned no results.
@@ -560,16 +822,15 @@ private:
 			scheduleNextCheckup(1 * 60);
 		}
 
-		boost::lock_guard<boost::mutex> l(syncher);
 		this->lastCheckupTime = SystemTime::get();
 		this->upServers = upServers;
 		this->downServers = downServers;
+		this->serversGeneration++;
 		this->lastDnsErrorMessage.clear();
 	}
 
 	void freeThreadData() {
 		boost::lock_guard<boost::mutex> l(syncher);
-		// Invoke destructors inside this thread.
 		upServers.clear();
 		downServers.clear();
 	}
@@ -578,6 +839,8 @@ private:
 	 * Schedules the next checkup to be run after the given number
 	 * of seconds, unless there's already a checkup scheduled for
 	 * earlier.
+	 *
+	 * @pre The lock is held.
 	 */
 	void scheduleNextCheckup(unsigned int seconds) {
 		time_t now = SystemTime::get();
@@ -590,18 +853,16 @@ private:
 	unsigned int msecUntilNextCheckup() const {
 		boost::lock_guard<boost::mutex> l(syncher);
 		time_t now = SystemTime::get();
-		if (now >= nextCheckupTime) {
+		if (checkingServers) {
+			// Another thread is busy with the checkup.
+			return 1000;
+		} else if (now >= nextCheckupTime) {
 			return 0;
 		} else {
 			return (nextCheckupTime - now) * 1000;
 		}
 	}
 
-	bool timeForCheckup() const {
-		boost::lock_guard<boost::mutex> l(syncher);
-		return SystemTime::get() >= nextCheckupTime;
-	}
-
 	void sendOut(const Item &item) {
 		boost::unique_lock<boost::mutex> l(syncher);
 		bool done = false;
@@ -611,26 +872,33 @@ private:
 
 		while (!done && !upServers.empty()) {
 			// Pick first available server and put it on the back of the list
-			// for round-robin load balancing.
+			// for round-robin load balancing. We do this before sending, so
+			// that other threads pick the next server in the meantime and
+			// uploads to multiple gateways happen concurrently.
 			ServerPtr server = upServers.front();
+			unsigned int generation = serversGeneration;
+			upServers.pop_front();
+			upServers.push_back(server);
 
 			l.unlock();
 			Server::SendResult result = server->send(item);
 			l.lock();
 
 			if (result == Server::SR_OK) {
-				upServers.pop_front();
-				upServers.push_back(server);
 				accepted = true;
 				done = true;
 			} else if (result == Server::SR_REJECTED) {
-				upServers.pop_front();
-				upServers.push_back(server);
 				rejected = true;
 				done = true;
-			} else {
-				upServers.pop_front();
-				downServers.push_back(server);
+			} else if (generation == serversGeneration) {
+				// Another thread may have already marked this server
+				// as down while we were sending.
+				upServers.remove(server);
+				if (std::find(downServers.begin(), downServers.end(), server)
+					== downServers.end())
+				{
+					downServers.push_back(server);
+				}
 			}
 		}
 
@@ -671,46 +939,6 @@ private:
 		}
 	}
 
-	bool compress(const StaticString data[], unsigned int count, string &output) {
-		if (count == 0) {
-			StaticString newdata;
-			return compress(&newdata, 1, output);
-		}
-
-		unsigned char out[128 * 1024];
-		z_stream strm;
-		int ret, flush;
-		unsigned int i, have;
-
-		strm.zalloc = Z_NULL;
-		strm.zfree  = Z_NULL;
-		strm.opaque = Z_NULL;
-		ret = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
-		if (ret != Z_OK) {
-			return false;
-		}
-
-		for (i = 0; i < count; i++) {
-			strm.avail_in = data[i].size();
-			strm.next_in  = (unsigned char *) data[i].c_str();
-			flush = (i == count - 1) ? Z_FINISH : Z_NO_FLUSH;
-
-			do {
-				strm.avail_out = sizeof(out);
-				strm.next_out  = out;
-				ret = deflate(&strm, flush);
-				assert(ret != Z_STREAM_ERROR);
-				have = sizeof(out) - strm.avail_out;
-				output.append((const char *) out, have);
-			} while (strm.avail_out == 0);
-			assert(strm.avail_in == 0);
-		}
-		assert(ret == Z_STREAM_END);
-
-		deflateEnd(&strm);
-		return true;
-	}
-
 	Json::Value inspectUpServersStateAsJson() const {
 		Json::Value doc(Json::arrayValue);
 		foreach (const ServerPtr server, upServers) {
@@ -728,79 +956,124 @@ private:
 	}
 
 public:
+	static const unsigned int DEFAULT_THREADS = 2;
+	static const unsigned int MAX_QUEUED_ITEMS = 1024;
+	static const size_t MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+	/**
+	 * @param nthreads The number of threads that compress and send packets.
+	 *                Each thread compresses and uploads one packet at a time.
+	 * @param gatewayScheme Only meant to be changed by tests, in order to
+	 *                      use a plain HTTP stand-in gateway.
+	 */
 	RemoteSender(const string &gatewayAddress, unsigned short gatewayPort,
-		const string &certificate, const string &proxyAddress)
-		: queue(1024)
+		const string &certificate, const string &proxyAddress,
+		unsigned int nthreads = DEFAULT_THREADS,
+		const string &gatewayScheme = "https")
+		: queue(MAX_QUEUED_ITEMS)
 	{
 		TRACE_POINT();
 		this->gatewayAddress = gatewayAddress;
 		this->gatewayPort = gatewayPort;
 		this->certificate = certificate;
+		this->gatewayScheme = gatewayScheme;
 		try {
 			this->proxyInfo = prepareCurlProxy(proxyAddress);
 		} catch (const ArgumentException &e) {
 			throw RuntimeException("Invalid Union Station proxy address \"" +
 				proxyAddress + "\": " + e.what());
 		}
+		serversGeneration = 0;
+		checkingServers = false;
 		lastCheckupTime = 0;
 		nextCheckupTime = 0;
 		packetsAccepted = 0;
 		packetsRejected = 0;
 		packetsDropped = 0;
-		thr = new oxt::thread(
-			boost::bind(&RemoteSender::threadMain, this),
-			"RemoteSender thread",
-			1024 * 512
-		);
+		queuedBytes = 0;
+		bytesCompressed = 0;
+		compressedBytesProduced = 0;
+		if (nthreads == 0) {
+			nthreads = 1;
+		}
+		for (unsigned int i = 0; i < nthreads; i++) {
+			threads.push_back(new oxt::thread(
+				boost::bind(&RemoteSender::threadMain, this),
+				"RemoteSender thread " + toString(i + 1),
+				1024 * 512
+			));
+		}
 	}
 
 	~RemoteSender() {
-		Item item;
-		item.exit = true;
-		queue.add(item);
-		/* Wait until the thread sends out all queued items.
+		/* Wait until the threads send out all queued items.
 		 * If this cannot be done within a short amount of time,
 		 * e.g. because all servers are down, then we'll get killed
 		 * by the watchdog anyway.
 		 */
-		thr->join();
-		delete thr;
+		for (unsigned int i = 0; i < threads.size(); i++) {
+			ItemPtr item = boost::make_shared<Item>();
+			item->exit = true;
+			queue.add(item);
+		}
+		for (unsigned int i = 0; i < threads.size(); i++) {
+			threads[i]->join();
+			delete threads[i];
+		}
+		freeThreadData();
 	}
 
+	/**
+	 * Schedules data to be compressed and sent. This copies the data
+	 * but does not compress it, so it's cheap enough to call from an
+	 * event loop. If too much data is queued, the packet is dropped.
+	 */
 	void schedule(const string &unionStationKey, const StaticString &nodeName,
 		const StaticString &category, const StaticString data[],
 		unsigned int count)
 	{
-		Item item;
-
-		item.unionStationKey = unionStationKey;
-		item.nodeName = nodeName;
-		item.category = category;
+		ItemPtr item;
+		size_t size = 0;
+		unsigned int i;
 
-		if (compress(data, count, item.data)) {
-			item.compressed = true;
-		} else {
-			size_t size = 0;
-			unsigned int i;
+		for (i = 0; i < count; i++) {
+			size += data[i].size();
+		}
+		if (!reserveQueueSpace(size)) {
+			return;
+		}
 
-			for (i = 0; i < count; i++) {
-				size += data[i].size();
-			}
-			item.data.reserve(size);
-			for (i = 0; i < count; i++) {
-				item.data.append(data[i].c_str(), data[i].size());
-			}
+		item = createItem(unionStationKey, nodeName, category);
+		item->data.reserve(size);
+		for (i = 0; i < count; i++) {
+			item->data.append(data[i].data(), data[i].size());
 		}
+		enqueue(item, size);
+	}
 
-		P_DEBUG("Scheduling Union Station packet: key=" << unionStationKey <<
-			", node=" << nodeName << ", category=" << category <<
-			", compressedDataSize=" << item.data.size());
+	/**
+	 * Like the other schedule() method, but references the given
+	 * buffers instead of copying them. The buffers must come from a
+	 * thread-safe mbuf pool, because the sender threads release them.
+	 */
+	void schedule(const string &unionStationKey, const StaticString &nodeName,
+		const StaticString &category, const vector<MemoryKit::mbuf> &buffers)
+	{
+		ItemPtr item;
+		size_t size = 0;
+		unsigned int i;
 
-		if (!queue.tryAdd(item)) {
-			P_WARN("The Union Station gateway isn't responding quickly enough; dropping packet.");
-			boost::lock_guard<boost::mutex> l(syncher);
-			packetsDropped++;
+		for (i = 0; i < buffers.size(); i++) {
+			assert(buffers[i].mbuf_block == NULL || buffers[i].mbuf_block->thread_safe);
+			size += buffers[i].size();
+		}
+		if (!reserveQueueSpace(size)) {
+			return;
 		}
+
+		item = createItem(unionStationKey, nodeName, category);
+		item->buffers = buffers;
+		enqueue(item, size);
 	}
 
 	unsigned int queued() const {
@@ -812,7 +1085,14 @@ public:
 		boost::lock_guard<boost::mutex> l(syncher);
 		doc["up_servers"] = inspectUpServersStateAsJson();
 		doc["down_servers"] = inspectDownServersStateAsJson();
+		doc["threads"] = (Json::UInt) threads.size();
 		doc["queue_size"] = queue.size();
+		doc["queued_bytes"] = byteSizeToJson(queuedBytes);
+		doc["bytes_compressed"] = byteSizeToJson(bytesCompressed);
+		if (bytesCompressed > 0) {
+			doc["compression_ratio"] = capFloatPrecision(
+				(double) compressedBytesProduced / bytesCompressed);
+		}
 		doc["packets_accepted"] = packetsAccepted;
 		doc["packets_rejected"] = packetsRejected;
 		doc["packets_dropped"] = packetsDropped;
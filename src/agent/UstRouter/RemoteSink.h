@@ -27,10 +27,11 @@
 #define _PASSENGER_UST_ROUTER_REMOTE_SINK_H_
 
 #include <string>
-#include <cstring>
+#include <vector>
 #include <ctime>
 #include <ev++.h>
 #include <Logging.h>
+#include <MemoryKit/mbuf.h>
 #include <UstRouter/LogSink.h>
 #include <UstRouter/RemoteSender.h>
 
@@ -49,9 +50,9 @@ private:
 		if (bufferSize > 0) {
 			P_DEBUG("Flushing " << inspect() << ": " << bufferSize << " bytes");
 			lastFlushed = ev_now(Controller_getLoop(controller));
-			StaticString data(buffer, bufferSize);
 			Controller_getRemoteSender(controller).schedule(unionStationKey,
-				nodeName, category, &data, 1);
+				nodeName, category, buffer);
+			buffer.clear();
 			bufferSize = 0;
 			return true;
 		} else {
@@ -69,9 +70,9 @@ public:
 	 * data as possible to the server in a single TCP segment.
 	 * With the "little less" we take into account:
 	 * - HTTPS overhead. This can be as high as 2 KB.
-	 * - The fact that RemoteSink.append() might try to flush the
-	 *   current buffer. Observations have shown that the data
-	 *   for a request transaction is often less than 5 KB.
+	 * - The fact that RemoteSink.append() only flushes the buffer
+	 *   after it has exceeded this capacity. Observations have shown
+	 *   that the data for a request transaction is often less than 5 KB.
 	 */
 	static const unsigned int BUFFER_CAPACITY =
 		4 * 64 * 1024 -
@@ -80,7 +81,8 @@ public:
 	string unionStationKey;
 	string nodeName;
 	string category;
-	char buffer[BUFFER_CAPACITY];
+	/** References to the bodies of the buffered transactions. */
+	vector<MemoryKit::mbuf> buffer;
 	unsigned int bufferSize;
 
 	RemoteSink(Controller *controller, const string &_unionStationKey,
@@ -102,20 +104,15 @@ public:
 	}
 
 	virtual void append(const TransactionPtr &transaction) {
-		StaticString data = transaction->getBody();
 		LogSink::append(transaction);
-		if (bufferSize + data.size() > BUFFER_CAPACITY) {
-			StaticString data2[] = {
-				StaticString(buffer, bufferSize),
-				data
-			};
+		transaction->getBody(buffer);
+		bufferSize += transaction->getBodySize();
+		if (bufferSize > BUFFER_CAPACITY) {
 			Controller_getRemoteSender(controller).schedule(unionStationKey,
-				nodeName, category, data2, 2);
+				nodeName, category, buffer);
 			lastFlushed = ev_now(Controller_getLoop(controller));
+			buffer.clear();
 			bufferSize = 0;
-		} else {
-			memcpy(buffer + bufferSize, data.data(), data.size());
-			bufferSize += data.size();
 		}
 	}
 
@@ -30,12 +30,16 @@
 #include <boost/move/move.hpp>
 #include <boost/container/string.hpp>
 #include <boost/cstdint.hpp>
+#include <algorithm>
+#include <vector>
+#include <string>
 #include <cstdlib>
 #include <cstring>
 
 #include <ev++.h>
 #include <StaticString.h>
 #include <MemoryKit/palloc.h>
+#include <MemoryKit/mbuf.h>
 #include <DataStructures/LString.h>
 #include <Utils/JsonUtils.h>
 
@@ -45,6 +49,13 @@ namespace UstRouter {
 using namespace std;
 
 
+/**
+ * A transaction's metadata is interned in a single string. Its body is
+ * stored in a chain of refcounted mbuf blocks, so that log sinks can pass
+ * the body on to writev() or to the RemoteSender's compressor without
+ * copying it. The blocks come from a thread-safe pool because sinks may
+ * release them from other threads.
+ */
 class Transaction {
 private:
 	BOOST_MOVABLE_BUT_NOT_COPYABLE(Transaction);
@@ -62,9 +73,13 @@ private:
 	unsigned int writeCount;
 	unsigned int refCount;
 	unsigned int bodyOffset;
+	unsigned int lastBodyBlockSize;
 	bool crashProtect, discarded;
 
 	boost::container::string storage;
+	struct MemoryKit::mbuf_pool *bodyPool;
+	vector<MemoryKit::mbuf> bodyBlocks;
+	size_t bodySize;
 
 	template<typename IntegerType1, typename IntegerType2>
 	void internString(const StaticString &str, IntegerType1 *offset, IntegerType2 *size) {
@@ -77,18 +92,38 @@ private:
 		bodyOffset += str.size() + 1;
 	}
 
+	void appendToBody(const char *data, size_t size) {
+		while (size > 0) {
+			if (bodyBlocks.empty() || lastBodyBlockSize == bodyBlocks.back().size()) {
+				bodyBlocks.push_back(MemoryKit::mbuf_get(bodyPool));
+				lastBodyBlockSize = 0;
+			}
+
+			MemoryKit::mbuf &block = bodyBlocks.back();
+			size_t n = std::min<size_t>(size, block.size() - lastBodyBlockSize);
+			memcpy(block.start + lastBodyBlockSize, data, n);
+			lastBodyBlockSize += n;
+			bodySize += n;
+			data += n;
+			size -= n;
+		}
+	}
+
 public:
-	Transaction(const StaticString &txnId, const StaticString &groupName,
-		const StaticString &nodeName, const StaticString &category,
-		const StaticString &unionStationKey, ev_tstamp _createdAt,
-		const StaticString &filters = StaticString(),
-		unsigned int initialCapacity = 1024 * 8)
+	Transaction(struct MemoryKit::mbuf_pool *_bodyPool, const StaticString &txnId,
+		const StaticString &groupName, const StaticString &nodeName,
+		const StaticString &category, const StaticString &unionStationKey,
+		ev_tstamp _createdAt,
+		const StaticString &filters = StaticString())
 		: createdAt(_createdAt),
 		  writeCount(0),
 		  refCount(0),
 		  bodyOffset(0),
+		  lastBodyBlockSize(0),
 		  crashProtect(false),
-		  discarded(false)
+		  discarded(false),
+		  bodyPool(_bodyPool),
+		  bodySize(0)
 	{
 		internString(txnId, (boost::uint8_t *) NULL, &txnIdSize);
 		internString(groupName, &groupNameOffset, &groupNameSize);
@@ -114,10 +149,14 @@ public:
 		  writeCount(other.writeCount),
 		  refCount(other.refCount),
 		  bodyOffset(other.bodyOffset),
+		  lastBodyBlockSize(other.lastBodyBlockSize),
 		  crashProtect(other.crashProtect),
 		  discarded(other.discarded),
-		  storage(boost::move(other.storage))
+		  storage(boost::move(other.storage)),
+		  bodyPool(other.bodyPool),
+		  bodySize(other.bodySize)
 	{
+		bodyBlocks.swap(other.bodyBlocks);
 		other.groupNameOffset = 0;
 		other.nodeNameOffset = 0;
 		other.categoryOffset = 0;
@@ -133,6 +172,8 @@ public:
 		other.writeCount = 0;
 		other.refCount = 0;
 		other.bodyOffset = 0;
+		other.lastBodyBlockSize = 0;
+		other.bodySize = 0;
 		other.crashProtect = false;
 		other.discarded = true;
 	}
@@ -154,9 +195,14 @@ public:
 			writeCount = other.writeCount;
 			refCount = other.refCount;
 			bodyOffset = other.bodyOffset;
+			lastBodyBlockSize = other.lastBodyBlockSize;
 			crashProtect = other.crashProtect;
 			discarded = other.discarded;
 			storage = boost::move(other.storage);
+			bodyPool = other.bodyPool;
+			bodyBlocks.clear();
+			bodyBlocks.swap(other.bodyBlocks);
+			bodySize = other.bodySize;
 
 			other.groupNameOffset = 0;
 			other.nodeNameOffset = 0;
@@ -173,6 +219,8 @@ public:
 			other.writeCount = 0;
 			other.refCount = 0;
 			other.bodyOffset = 0;
+			other.lastBodyBlockSize = 0;
+			other.bodySize = 0;
 			other.crashProtect = false;
 			other.discarded = true;
 		}
@@ -203,8 +251,44 @@ public:
 		return StaticString(storage.data() + filtersOffset, filtersSize);
 	}
 
-	StaticString getBody() const {
-		return StaticString(storage.data() + bodyOffset, storage.size() - bodyOffset);
+	size_t getBodySize() const {
+		return bodySize;
+	}
+
+	/**
+	 * Appends references to the body's blocks to `output`, trimmed to
+	 * the part that contains data. No data is copied.
+	 */
+	void getBody(vector<MemoryKit::mbuf> &output) const {
+		unsigned int i;
+
+		if (bodyBlocks.empty()) {
+			return;
+		}
+		for (i = 0; i < bodyBlocks.size() - 1; i++) {
+			output.push_back(bodyBlocks[i]);
+		}
+		output.push_back(MemoryKit::mbuf(bodyBlocks.back(), 0, lastBodyBlockSize));
+	}
+
+	/**
+	 * Returns a contiguous copy of the body. Only meant for code paths
+	 * that cannot work with the individual blocks, like filters.
+	 */
+	string getBodyAsString() const {
+		string result;
+		unsigned int i;
+
+		result.reserve(bodySize);
+		for (i = 0; i < bodyBlocks.size(); i++) {
+			const MemoryKit::mbuf &block = bodyBlocks[i];
+			if (i == bodyBlocks.size() - 1) {
+				result.append(block.start, lastBodyBlockSize);
+			} else {
+				result.append(block.start, block.size());
+			}
+		}
+		return result;
 	}
 
 	bool crashProtectEnabled() const {
@@ -237,22 +321,22 @@ public:
 	}
 
 	void append(const StaticString &timestamp, const StaticString &data) {
-		char txnIdCopy[txnIdSize];
 		char writeCountStr[sizeof(unsigned int) * 2 + 1];
 		unsigned int writeCountStrSize = integerToHexatri(
 			writeCount, writeCountStr);
 
-		memcpy(txnIdCopy, getTxnId().data(), getTxnId().size());
 		writeCount++;
 
-		storage.append(txnIdCopy, getTxnId().size());
-		storage.append(1, ' ');
-		storage.append(timestamp.data(), timestamp.size());
-		storage.append(1, ' ');
-		storage.append(writeCountStr, writeCountStrSize);
-		storage.append(1, ' ');
-		storage.append(data.data(), data.size());
-		storage.append(1, '\n');
+		// The body lives outside 'storage', so the transaction ID
+		// can be appended without copying it first.
+		appendToBody(getTxnId().data(), getTxnId().size());
+		appendToBody(" ", 1);
+		appendToBody(timestamp.data(), timestamp.size());
+		appendToBody(" ", 1);
+		appendToBody(writeCountStr, writeCountStrSize);
+		appendToBody(" ", 1);
+		appendToBody(data.data(), data.size());
+		appendToBody("\n", 1);
 	}
 
 	Json::Value inspectStateAsJson() const {
@@ -264,7 +348,7 @@ public:
 		doc["category"] = getCategory().toString();
 		doc["key"] = getUnionStationKey().toString();
 		doc["refcount"] = refCount;
-		doc["body_size"] = byteSizeToJson(getBody().size());
+		doc["body_size"] = byteSizeToJson(bodySize);
 		return doc;
 	}
 };
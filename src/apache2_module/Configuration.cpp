@@ -310,6 +310,7 @@ DEFINE_SERVER_STR_CONFIG_SETTER(cmd_union_station_proxy_address, unionStationPro
 DEFINE_SERVER_STR_CONFIG_SETTER(cmd_passenger_analytics_log_user, analyticsLogUser)
 DEFINE_SERVER_STR_CONFIG_SETTER(cmd_passenger_analytics_log_group, analyticsLogGroup)
 DEFINE_SERVER_BOOLEAN_CONFIG_SETTER(cmd_passenger_turbocaching, turbocaching)
+DEFINE_SERVER_BOOLEAN_CONFIG_SETTER(cmd_passenger_count_standby_processes, countStandbyProcesses)
 
 static const char *
 cmd_passenger_ctl(cmd_parms *cmd, void *dummy, const char *name, const char *value) {
@@ -559,6 +560,11 @@ const command_rec passenger_commands[] = {
 		NULL,
 		RSRC_CONF,
 		"Whether to enable turbocaching."),
+	AP_INIT_FLAG("PassengerCountStandbyProcesses",
+		(FlagFunc) cmd_passenger_count_standby_processes,
+		NULL,
+		RSRC_CONF,
+		"Whether standby processes count towards the maximum pool size."),
 
 	#include "ConfigurationCommands.cpp"
 
@@ -604,11 +610,6 @@ const command_rec passenger_commands[] = {
 		"Whether to enable logging through Union Station."),
 
 	/*****************************/
-	AP_INIT_TAKE1("PassengerMemoryLimit",
-		(Take1Func) cmd_passenger_enterprise_only,
-		NULL,
-		OR_LIMIT | ACCESS_CONF | RSRC_CONF,
-		"The maximum amount of memory in MB that an application instance may use."),
 	AP_INIT_TAKE1("PassengerMaxInstances",
 		(Take1Func) cmd_passenger_enterprise_only,
 		NULL,
@@ -206,6 +206,9 @@ struct ServerConfig {
 
 	bool turbocaching;
 
+	/** Whether standby processes count towards maxPoolSize. */
+	bool countStandbyProcesses;
+
 	set<string> prestartURLs;
 
 	ServerConfig() {
@@ -229,6 +232,7 @@ struct ServerConfig {
 		analyticsLogUser   = DEFAULT_ANALYTICS_LOG_USER;
 		analyticsLogGroup  = DEFAULT_ANALYTICS_LOG_GROUP;
 		turbocaching       = true;
+		countStandbyProcesses = false;
 	}
 
 	/** Called after the configuration files have been loaded, inside
@@ -83,6 +83,41 @@
 		"The minimum number of application instances to keep when cleaning idle instances."),
 
 	
+	AP_INIT_TAKE1("PassengerSpawnConcurrency",
+		(Take1Func) cmd_passenger_spawn_concurrency,
+		NULL,
+		OR_LIMIT | ACCESS_CONF | RSRC_CONF,
+		"The maximum number of application instances that may be spawned at the same time."),
+
+	
+	AP_INIT_TAKE1("PassengerStandbyProcesses",
+		(Take1Func) cmd_passenger_standby_processes,
+		NULL,
+		OR_LIMIT | ACCESS_CONF | RSRC_CONF,
+		"The number of spawned application instances to keep on standby."),
+
+	
+	AP_INIT_FLAG("PassengerPredictiveScaling",
+		(FlagFunc) cmd_passenger_predictive_scaling,
+		NULL,
+		OR_LIMIT | ACCESS_CONF | RSRC_CONF,
+		"Whether to spawn and retire application instances ahead of predicted demand."),
+
+	
+	AP_INIT_TAKE1("PassengerMemoryLimit",
+		(Take1Func) cmd_passenger_memory_limit,
+		NULL,
+		OR_LIMIT | ACCESS_CONF | RSRC_CONF,
+		"The maximum amount of memory in MB that an application instance may use."),
+
+	
+	AP_INIT_TAKE1("PassengerMemoryLimitRecyclePercentage",
+		(Take1Func) cmd_passenger_memory_limit_recycle_percentage,
+		NULL,
+		OR_LIMIT | ACCESS_CONF | RSRC_CONF,
+		"The maximum percentage of application instances that may be recycled at the same time because of the memory limit."),
+
+	
 	AP_INIT_TAKE1("PassengerMaxInstancesPerApp",
 		(Take1Func) cmd_passenger_max_instances_per_app,
 		NULL,
@@ -146,6 +181,13 @@
 		"The maximum number of queued requests."),
 
 	
+	AP_INIT_TAKE1("PassengerRoutingPolicy",
+		(Take1Func) cmd_passenger_routing_policy,
+		NULL,
+		OR_ALL,
+		"The policy that decides which application process a request is routed to."),
+
+	
 	AP_INIT_TAKE1("PassengerMaxPreloaderIdleTime",
 		(Take1Func) cmd_passenger_max_preloader_idle_time,
 		NULL,
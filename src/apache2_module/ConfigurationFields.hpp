@@ -53,6 +53,8 @@ struct GeneratedDirConfigPart {
 	Threeway highPerformance;
 	/** Whether to load environment variables from the shell before running the application. */
 	Threeway loadShellEnvvars;
+	/** Whether to spawn and retire application instances ahead of predicted demand. */
+	Threeway predictiveScaling;
 	/** Whether to show the Phusion Passenger version number in the X-Powered-By header. */
 	Threeway showVersionInHeader;
 	/** Whether to enable sticky sessions. */
@@ -69,8 +71,16 @@ struct GeneratedDirConfigPart {
 	int maxRequestQueueSize;
 	/** The maximum number of requests that an application instance may process. */
 	int maxRequests;
+	/** The maximum amount of memory in MB that an application instance may use. */
+	int memoryLimit;
+	/** The maximum percentage of application instances that may be recycled at the same time because of the memory limit. */
+	int memoryLimitRecyclePercentage;
 	/** The minimum number of application instances to keep when cleaning idle instances. */
 	int minInstances;
+	/** The maximum number of application instances that may be spawned at the same time. */
+	int spawnConcurrency;
+	/** The number of spawned application instances to keep on standby. */
+	int standbyProcesses;
 	/** A timeout for application startup. */
 	int startTimeout;
 	/** The environment under which applications are run. */
@@ -89,6 +99,8 @@ struct GeneratedDirConfigPart {
 	const char *python;
 	/** The directory in which Passenger should look for restart.txt. */
 	const char *restartDir;
+	/** The policy that decides which application process a request is routed to. */
+	const char *routingPolicy;
 	/** The Ruby interpreter to use. */
 	const char *ruby;
 	/** The spawn method to use. */
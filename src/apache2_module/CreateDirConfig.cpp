@@ -45,6 +45,11 @@
 				config->meteorAppSettings = NULL;
 				config->appEnv = NULL;
 				config->minInstances = UNSET_INT_VALUE;
+				config->spawnConcurrency = UNSET_INT_VALUE;
+				config->standbyProcesses = UNSET_INT_VALUE;
+				config->predictiveScaling = DirConfig::UNSET;
+				config->memoryLimit = UNSET_INT_VALUE;
+				config->memoryLimitRecyclePercentage = UNSET_INT_VALUE;
 				config->maxInstancesPerApp = UNSET_INT_VALUE;
 				config->user = NULL;
 				config->group = NULL;
@@ -54,6 +59,7 @@
 				config->highPerformance = DirConfig::UNSET;
 				config->enabled = DirConfig::UNSET;
 				config->maxRequestQueueSize = UNSET_INT_VALUE;
+				config->routingPolicy = NULL;
 				config->maxPreloaderIdleTime = UNSET_INT_VALUE;
 				config->loadShellEnvvars = DirConfig::UNSET;
 				config->bufferUpload = DirConfig::UNSET;
@@ -83,6 +83,41 @@
 	
 
 	
+		config->spawnConcurrency =
+			(add->spawnConcurrency == UNSET_INT_VALUE) ?
+			base->spawnConcurrency :
+			add->spawnConcurrency;
+	
+
+	
+		config->standbyProcesses =
+			(add->standbyProcesses == UNSET_INT_VALUE) ?
+			base->standbyProcesses :
+			add->standbyProcesses;
+	
+
+	
+		config->predictiveScaling =
+			(add->predictiveScaling == DirConfig::UNSET) ?
+			base->predictiveScaling :
+			add->predictiveScaling;
+	
+
+	
+		config->memoryLimit =
+			(add->memoryLimit == UNSET_INT_VALUE) ?
+			base->memoryLimit :
+			add->memoryLimit;
+	
+
+	
+		config->memoryLimitRecyclePercentage =
+			(add->memoryLimitRecyclePercentage == UNSET_INT_VALUE) ?
+			base->memoryLimitRecyclePercentage :
+			add->memoryLimitRecyclePercentage;
+	
+
+	
 		config->maxInstancesPerApp =
 			(add->maxInstancesPerApp == UNSET_INT_VALUE) ?
 			base->maxInstancesPerApp :
@@ -146,6 +181,13 @@
 	
 
 	
+		config->routingPolicy =
+			(add->routingPolicy == NULL) ?
+			base->routingPolicy :
+			add->routingPolicy;
+	
+
+	
 		config->maxPreloaderIdleTime =
 			(add->maxPreloaderIdleTime == UNSET_INT_VALUE) ?
 			base->maxPreloaderIdleTime :
@@ -71,6 +71,31 @@
 	
 
 	
+		addHeader(r, result, StaticString("!~PASSENGER_SPAWN_CONCURRENCY",
+			sizeof("!~PASSENGER_SPAWN_CONCURRENCY") - 1), config->spawnConcurrency);
+	
+
+	
+		addHeader(r, result, StaticString("!~PASSENGER_STANDBY_PROCESSES",
+			sizeof("!~PASSENGER_STANDBY_PROCESSES") - 1), config->standbyProcesses);
+	
+
+	
+		addHeader(result, StaticString("!~PASSENGER_PREDICTIVE_SCALING",
+			sizeof("!~PASSENGER_PREDICTIVE_SCALING") - 1), config->predictiveScaling);
+	
+
+	
+		addHeader(r, result, StaticString("!~PASSENGER_MEMORY_LIMIT",
+			sizeof("!~PASSENGER_MEMORY_LIMIT") - 1), config->memoryLimit);
+	
+
+	
+		addHeader(r, result, StaticString("!~PASSENGER_MEMORY_LIMIT_RECYCLE_PERCENTAGE",
+			sizeof("!~PASSENGER_MEMORY_LIMIT_RECYCLE_PERCENTAGE") - 1), config->memoryLimitRecyclePercentage);
+	
+
+	
 		addHeader(r, result, StaticString("!~PASSENGER_MAX_PROCESSES",
 			sizeof("!~PASSENGER_MAX_PROCESSES") - 1), config->maxInstancesPerApp);
 	
@@ -101,6 +126,11 @@
 	
 
 	
+		addHeader(result, StaticString("!~PASSENGER_ROUTING_POLICY",
+			sizeof("!~PASSENGER_ROUTING_POLICY") - 1), config->routingPolicy);
+	
+
+	
 		addHeader(r, result, StaticString("!~PASSENGER_MAX_PRELOADER_IDLE_TIME",
 			sizeof("!~PASSENGER_MAX_PRELOADER_IDLE_TIME") - 1), config->maxPreloaderIdleTime);
 	
@@ -37,6 +37,10 @@
 
 	#define AGENT_EXE "PassengerAgent"
 
+	#define APP_CONNECTION_CACHE_SLOTS 16
+
+	#define APP_CONNECTION_IDLE_TIMEOUT 60
+
 	#define DEB_APACHE_MODULE_PACKAGE "libapache2-mod-passenger"
 
 	#define DEB_DEV_PACKAGE "passenger-dev"
@@ -73,6 +77,10 @@
 
 	#define DEFAULT_MBUF_CHUNK_SIZE 512
 
+	#define DEFAULT_MBUF_SPARE_MEMORY_HIGH_WATER_MARK 8388608
+
+	#define DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE 25
+
 	#define DEFAULT_NODEJS "node"
 
 	#define DEFAULT_POOL_IDLE_TIME 300
@@ -81,10 +89,14 @@
 
 	#define DEFAULT_RESPONSE_BUFFER_HIGH_WATERMARK 134217728
 
+	#define DEFAULT_ROUTING_POLICY "least-busy"
+
 	#define DEFAULT_RUBY "ruby"
 
 	#define DEFAULT_SOCKET_BACKLOG 1024
 
+	#define DEFAULT_SPAWN_CONCURRENCY 1
+
 	#define DEFAULT_SPAWN_METHOD "smart"
 
 	#define DEFAULT_START_TIMEOUT 90000
@@ -93,6 +105,10 @@
 
 	#define DEFAULT_STICKY_SESSIONS_COOKIE_NAME "_passenger_route"
 
+	#define DEFAULT_TURBOCACHE_MAX_ENTRIES 1024
+
+	#define DEFAULT_TURBOCACHE_MAX_SIZE 16777216
+
 	#define DEFAULT_UNION_STATION_GATEWAY_ADDRESS "gateway.unionstationapp.com"
 
 	#define DEFAULT_UNION_STATION_GATEWAY_PORT 443
@@ -0,0 +1,213 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2015 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#ifndef _PASSENGER_DATA_STRUCTURES_INDEXED_MIN_HEAP_H_
+#define _PASSENGER_DATA_STRUCTURES_INDEXED_MIN_HEAP_H_
+
+#include <boost/container/vector.hpp>
+#include <cassert>
+#include <cstddef>
+
+namespace Passenger {
+
+using namespace std;
+
+
+/**
+ * A binary min-heap of keys belonging to a dense, ordered set of items,
+ * which are identified by their index (0 ... size() - 1). It is meant to
+ * shadow an array-like list, such as a list of processes:
+ *
+ *  * Finding the item with the smallest key is O(1).
+ *  * Changing the key of any item is O(log n).
+ *  * Appending an item is O(log n).
+ *  * Erasing an item is O(n), because the indices of all subsequent items
+ *    shift down by one, just like they do in the list being shadowed.
+ *
+ * Ties are broken in favor of the item with the lowest index, so `top()`
+ * always returns exactly the same result as a linear scan for the first
+ * item with the smallest key would.
+ */
+template<typename Key>
+class IndexedMinHeap {
+private:
+	struct Node {
+		Key key;
+		unsigned int index;
+
+		Node() { }
+
+		Node(Key _key, unsigned int _index)
+			: key(_key),
+			  index(_index)
+			{ }
+	};
+
+	/** The heap, in the usual implicit binary tree layout. */
+	boost::container::vector<Node> heap;
+	/** Maps item indices to positions in `heap`. */
+	boost::container::vector<unsigned int> positions;
+
+	static bool precedes(const Node &a, const Node &b) {
+		return a.key < b.key || (a.key == b.key && a.index < b.index);
+	}
+
+	void place(unsigned int pos, const Node &node) {
+		heap[pos] = node;
+		positions[node.index] = pos;
+	}
+
+	void siftUp(unsigned int pos) {
+		Node node = heap[pos];
+		while (pos > 0) {
+			unsigned int parent = (pos - 1) / 2;
+			if (!precedes(node, heap[parent])) {
+				break;
+			}
+			place(pos, heap[parent]);
+			pos = parent;
+		}
+		place(pos, node);
+	}
+
+	void siftDown(unsigned int pos) {
+		Node node = heap[pos];
+		unsigned int size = heap.size();
+
+		while (true) {
+			unsigned int child = 2 * pos + 1;
+			if (child >= size) {
+				break;
+			}
+			if (child + 1 < size && precedes(heap[child + 1], heap[child])) {
+				child++;
+			}
+			if (!precedes(heap[child], node)) {
+				break;
+			}
+			place(pos, heap[child]);
+			pos = child;
+		}
+		place(pos, node);
+	}
+
+public:
+	unsigned int size() const {
+		return positions.size();
+	}
+
+	bool empty() const {
+		return positions.empty();
+	}
+
+	void clear() {
+		heap.clear();
+		positions.clear();
+	}
+
+	void shrink_to_fit() {
+		heap.shrink_to_fit();
+		positions.shrink_to_fit();
+	}
+
+	/**
+	 * Appends a new item with the given key. Its index is the old `size()`.
+	 */
+	void push_back(Key key) {
+		unsigned int index = positions.size();
+		heap.push_back(Node(key, index));
+		positions.push_back(index);
+		siftUp(index);
+	}
+
+	Key get(unsigned int index) const {
+		assert(index < size());
+		return heap[positions[index]].key;
+	}
+
+	void set(unsigned int index, Key key) {
+		assert(index < size());
+		unsigned int pos = positions[index];
+		Key oldKey = heap[pos].key;
+		heap[pos].key = key;
+		if (key < oldKey) {
+			siftUp(pos);
+		} else if (oldKey < key) {
+			siftDown(pos);
+		}
+	}
+
+	/**
+	 * Erases the item with the given index. The indices of all items after
+	 * it are decremented by one.
+	 */
+	void erase(unsigned int index) {
+		assert(index < size());
+		unsigned int i, size;
+		unsigned int pos = positions[index];
+
+		heap[pos] = heap.back();
+		heap.pop_back();
+		positions.pop_back();
+		size = heap.size();
+
+		// Renumbering preserves the relative order of the remaining items,
+		// so only the node that was moved into the hole may be out of place.
+		for (i = 0; i < size; i++) {
+			if (heap[i].index > index) {
+				heap[i].index--;
+			}
+			positions[heap[i].index] = i;
+		}
+		if (pos < size) {
+			unsigned int movedIndex = heap[pos].index;
+			siftUp(pos);
+			siftDown(positions[movedIndex]);
+		}
+	}
+
+	/**
+	 * Returns the index of the item with the smallest key.
+	 *
+	 * @pre !empty()
+	 */
+	unsigned int top() const {
+		assert(!empty());
+		return heap[0].index;
+	}
+
+	/**
+	 * @pre !empty()
+	 */
+	Key topKey() const {
+		assert(!empty());
+		return heap[0].key;
+	}
+};
+
+
+} // namespace Passenger
+
+#endif /* _PASSENGER_DATA_STRUCTURES_INDEXED_MIN_HEAP_H_ */
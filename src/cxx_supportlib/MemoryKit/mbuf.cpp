@@ -29,21 +29,57 @@ namespace MemoryKit {
 //#define MBUF_DEBUG
 
 
+static boost::uint32_t *
+_mbuf_pool_nactive_counter(struct mbuf_pool *pool, boost::uint32_t size_class)
+{
+	if (size_class == 0) {
+		return &pool->nactive_mbuf_blockq;
+	} else {
+		return &pool->size_classes[size_class - 1].nactive_mbuf_blockq;
+	}
+}
+
 static void
-_mbuf_block_mark_as_active(struct mbuf_pool *pool, struct mbuf_block *mbuf_block)
+_mbuf_block_mark_as_active(struct mbuf_pool *pool, struct mbuf_block *mbuf_block,
+	boost::uint32_t *nactive)
 {
 	STAILQ_NEXT(mbuf_block, next) = NULL;
 	#ifdef MBUF_ENABLE_DEBUGGING
-		TAILQ_INSERT_HEAD(&pool->active_mbuf_blockq, mbuf_block, active_q);
+		// The active list is not synchronized, and blocks in a thread-safe
+		// pool may be released from any thread, so they are not tracked.
+		if (!pool->thread_safe) {
+			TAILQ_INSERT_HEAD(&pool->active_mbuf_blockq, mbuf_block, active_q);
+		}
 	#endif
 	#ifdef MBUF_ENABLE_BACKTRACES
 		mbuf_block->backtrace = strdup(oxt::thread::current_backtrace().c_str());
 	#endif
-	pool->nactive_mbuf_blockq++;
+	if (pool->thread_safe) {
+		__sync_fetch_and_add(nactive, 1);
+	} else {
+		(*nactive)++;
+	}
+}
+
+/*
+ * Takes the mbuf_block off the pool's active list. Must be called exactly
+ * once for every active mbuf_block that is put on a freelist or freed;
+ * mbuf_block_free() doesn't do it because blocks on a freelist are not
+ * active.
+ */
+static void
+_mbuf_block_mark_as_inactive(struct mbuf_block *mbuf_block)
+{
+	#ifdef MBUF_ENABLE_DEBUGGING
+		if (!mbuf_block->thread_safe) {
+			TAILQ_REMOVE(&mbuf_block->pool->active_mbuf_blockq, mbuf_block, active_q);
+		}
+	#endif
 }
 
 static struct mbuf_block *
-_mbuf_block_init(struct mbuf_pool *pool, char *buf, size_t block_offset)
+_mbuf_block_init(struct mbuf_pool *pool, char *buf, size_t block_offset,
+	boost::uint32_t size_class = 0)
 {
 	struct mbuf_block *mbuf_block;
 
@@ -71,6 +107,13 @@ _mbuf_block_init(struct mbuf_pool *pool, char *buf, size_t block_offset)
 	 *                                    \
 	 *                                    block
 	 *
+	 * ## Size class mbuf_blocks
+	 *
+	 * Size class mbuf_blocks are normal mbuf_blocks whose chunk size is
+	 * that of one of the pool's size classes instead of
+	 * pool->mbuf_block_chunk_size. The 'size_class' field in the header
+	 * tells which one, so that they can be put back on the right freelist.
+	 *
 	 * ## Standalone mbuf_blocks
 	 *
 	 * Standalone mbuf_blocks are like normal ones, but can contain
@@ -94,11 +137,14 @@ _mbuf_block_init(struct mbuf_pool *pool, char *buf, size_t block_offset)
 	 */
 	mbuf_block = (struct mbuf_block *)(buf + block_offset);
 	mbuf_block->magic = MBUF_BLOCK_MAGIC;
+	mbuf_block->thread_safe = pool->thread_safe;
 	mbuf_block->pool  = pool;
 	mbuf_block->refcount = 1;
 	mbuf_block->offset = 0;
+	mbuf_block->size_class = size_class;
 
-	_mbuf_block_mark_as_active(pool, mbuf_block);
+	_mbuf_block_mark_as_active(pool, mbuf_block,
+		_mbuf_pool_nactive_counter(pool, size_class));
 	return mbuf_block;
 }
 
@@ -116,7 +162,7 @@ _mbuf_block_get(struct mbuf_pool *pool)
 		STAILQ_REMOVE_HEAD(&pool->free_mbuf_blockq, next);
 
 		assert(mbuf_block->magic == MBUF_BLOCK_MAGIC);
-		_mbuf_block_mark_as_active(pool, mbuf_block);
+		_mbuf_block_mark_as_active(pool, mbuf_block, &pool->nactive_mbuf_blockq);
 		return mbuf_block;
 	}
 
@@ -153,6 +199,63 @@ mbuf_block_get(struct mbuf_pool *pool)
 	return mbuf_block;
 }
 
+static struct mbuf_block *
+_mbuf_size_class_block_get(struct mbuf_pool *pool, unsigned int index)
+{
+	struct mbuf_size_class *size_class = &pool->size_classes[index];
+	struct mbuf_block *mbuf_block;
+	char *buf;
+
+	assert(index < pool->nsize_classes);
+
+	if (!STAILQ_EMPTY(&size_class->free_mbuf_blockq)) {
+		assert(size_class->nfree_mbuf_blockq > 0);
+
+		mbuf_block = STAILQ_FIRST(&size_class->free_mbuf_blockq);
+		size_class->nfree_mbuf_blockq--;
+		STAILQ_REMOVE_HEAD(&size_class->free_mbuf_blockq, next);
+
+		assert(mbuf_block->magic == MBUF_BLOCK_MAGIC);
+		assert(mbuf_block->size_class == index + 1);
+		_mbuf_block_mark_as_active(pool, mbuf_block, &size_class->nactive_mbuf_blockq);
+	} else {
+		buf = (char *) malloc(size_class->mbuf_block_chunk_size);
+		if (OXT_UNLIKELY(buf == NULL)) {
+			return NULL;
+		}
+		mbuf_block = _mbuf_block_init(pool, buf, size_class->mbuf_block_offset,
+			index + 1);
+	}
+
+	buf = (char *)mbuf_block - size_class->mbuf_block_offset;
+	mbuf_block->start = buf;
+	mbuf_block->end = buf + size_class->mbuf_block_offset;
+
+	#ifdef MBUF_DEBUG
+		printf("[%p] mbuf_block get %p (size class %u)\n", oxt::thread_signature,
+			mbuf_block, index + 1);
+	#endif
+
+	return mbuf_block;
+}
+
+/*
+ * Returns the index of the smallest size class whose blocks can hold
+ * `size` bytes, or -1 if there is none.
+ */
+static int
+_mbuf_pool_find_size_class(struct mbuf_pool *pool, size_t size)
+{
+	unsigned int i;
+
+	for (i = 0; i < pool->nsize_classes; i++) {
+		if (size <= pool->size_classes[i].mbuf_block_offset) {
+			return (int) i;
+		}
+	}
+	return -1;
+}
+
 struct mbuf_block *
 mbuf_block_new_standalone(struct mbuf_pool *pool, size_t size)
 {
@@ -193,24 +296,46 @@ mbuf_block_free(struct mbuf_block *mbuf_block)
 	assert(STAILQ_NEXT(mbuf_block, next) == NULL);
 	assert(mbuf_block->magic == MBUF_BLOCK_MAGIC);
 
-	#ifdef MBUF_ENABLE_DEBUGGING
-		TAILQ_REMOVE(&mbuf_block->pool->active_mbuf_blockq, mbuf_block, active_q);
-	#endif
 	#ifdef MBUF_ENABLE_BACKTRACES
 		free(mbuf_block->backtrace);
 	#endif
 
 	if (mbuf_block->offset > 0) {
 		buf = (char *) mbuf_block - mbuf_block->offset;
+	} else if (mbuf_block->size_class > 0) {
+		buf = (char *) mbuf_block - mbuf_block->pool->
+			size_classes[mbuf_block->size_class - 1].mbuf_block_offset;
 	} else {
 		buf = (char *) mbuf_block - mbuf_block->pool->mbuf_block_offset;
 	}
 	free(buf);
 }
 
+static void
+_mbuf_size_class_block_put(struct mbuf_block *mbuf_block)
+{
+	struct mbuf_size_class *size_class =
+		&mbuf_block->pool->size_classes[mbuf_block->size_class - 1];
+
+	assert(size_class->nactive_mbuf_blockq > 0);
+
+	size_class->nactive_mbuf_blockq--;
+	_mbuf_block_mark_as_inactive(mbuf_block);
+	if (size_class->nfree_mbuf_blockq >= size_class->max_free_mbuf_blockq) {
+		mbuf_block_free(mbuf_block);
+		return;
+	}
+
+	mbuf_block->refcount = 1;
+	size_class->nfree_mbuf_blockq++;
+	STAILQ_INSERT_HEAD(&size_class->free_mbuf_blockq, mbuf_block, next);
+}
+
 void
 mbuf_block_put(struct mbuf_block *mbuf_block)
 {
+	struct mbuf_pool *pool = mbuf_block->pool;
+
 	#ifdef MBUF_DEBUG
 		printf("[%p] mbuf_block put %p\n", oxt::thread_signature, mbuf_block);
 	#endif
@@ -218,17 +343,27 @@ mbuf_block_put(struct mbuf_block *mbuf_block)
 	assert(STAILQ_NEXT(mbuf_block, next) == NULL);
 	assert(mbuf_block->magic == MBUF_BLOCK_MAGIC);
 	assert(mbuf_block->refcount == 0);
-	assert(mbuf_block->pool->nactive_mbuf_blockq > 0);
 	assert(mbuf_block->offset == 0);
 
-	mbuf_block->refcount = 1;
-	mbuf_block->pool->nfree_mbuf_blockq++;
-	mbuf_block->pool->nactive_mbuf_blockq--;
-	STAILQ_INSERT_HEAD(&mbuf_block->pool->free_mbuf_blockq, mbuf_block, next);
+	if (mbuf_block->size_class > 0) {
+		_mbuf_size_class_block_put(mbuf_block);
+		return;
+	}
 
-	#ifdef MBUF_ENABLE_DEBUGGING
-		TAILQ_REMOVE(&mbuf_block->pool->active_mbuf_blockq, mbuf_block, active_q);
-	#endif
+	assert(pool->nactive_mbuf_blockq > 0);
+
+	pool->nactive_mbuf_blockq--;
+	_mbuf_block_mark_as_inactive(mbuf_block);
+	if (pool->max_free_mbuf_blockq > 0
+	 && pool->nfree_mbuf_blockq >= pool->max_free_mbuf_blockq)
+	{
+		mbuf_block_free(mbuf_block);
+		return;
+	}
+
+	mbuf_block->refcount = 1;
+	pool->nfree_mbuf_blockq++;
+	STAILQ_INSERT_HEAD(&pool->free_mbuf_blockq, mbuf_block, next);
 }
 
 /*
@@ -243,11 +378,34 @@ mbuf_block_remove(struct mhdr *mhdr, struct mbuf_block *mbuf_block)
 	STAILQ_NEXT(mbuf_block, next) = NULL;
 }
 
+static unsigned int
+_mbuf_freelist_trim(struct mhdr *freeq, boost::uint32_t *nfree, size_t chunk_size,
+	size_t *spare_memory, size_t max_spare_memory)
+{
+	unsigned int count = 0;
+
+	while (*spare_memory > max_spare_memory && !STAILQ_EMPTY(freeq)) {
+		struct mbuf_block *mbuf_block = STAILQ_FIRST(freeq);
+		mbuf_block_remove(freeq, mbuf_block);
+		mbuf_block_free(mbuf_block);
+		(*nfree)--;
+		*spare_memory -= chunk_size;
+		count++;
+	}
+
+	return count;
+}
+
 void
-mbuf_pool_init(struct mbuf_pool *pool)
+mbuf_pool_init(struct mbuf_pool *pool, bool thread_safe)
 {
+	static const size_t size_class_chunk_sizes[] = MBUF_SIZE_CLASS_CHUNK_SIZES;
+	unsigned int i;
+
+	pool->thread_safe = thread_safe;
 	pool->nfree_mbuf_blockq = 0;
 	pool->nactive_mbuf_blockq = 0;
+	pool->max_free_mbuf_blockq = 0;
 	STAILQ_INIT(&pool->free_mbuf_blockq);
 
 	#ifdef MBUF_ENABLE_DEBUGGING
@@ -255,6 +413,29 @@ mbuf_pool_init(struct mbuf_pool *pool)
 	#endif
 
 	pool->mbuf_block_offset = pool->mbuf_block_chunk_size - MBUF_BLOCK_HSIZE;
+
+	pool->nsize_classes = 0;
+	for (i = 0; i < sizeof(size_class_chunk_sizes) / sizeof(size_t); i++) {
+		struct mbuf_size_class *size_class;
+
+		if (size_class_chunk_sizes[i] <= pool->mbuf_block_chunk_size) {
+			continue;
+		}
+
+		assert(pool->nsize_classes < MBUF_POOL_MAX_SIZE_CLASSES);
+		size_class = &pool->size_classes[pool->nsize_classes];
+		size_class->nfree_mbuf_blockq = 0;
+		size_class->nactive_mbuf_blockq = 0;
+		size_class->max_free_mbuf_blockq = std::max<size_t>(1,
+			MBUF_SIZE_CLASS_MAX_SPARE_MEMORY / size_class_chunk_sizes[i]);
+		STAILQ_INIT(&size_class->free_mbuf_blockq);
+		size_class->mbuf_block_chunk_size = size_class_chunk_sizes[i];
+		size_class->mbuf_block_offset = size_class_chunk_sizes[i] - MBUF_BLOCK_HSIZE;
+		pool->nsize_classes++;
+	}
+
+	pool->spare_memory_high_water_mark = 0;
+	pool->nauto_compactions = 0;
 }
 
 void
@@ -273,22 +454,92 @@ mbuf_pool_data_size(struct mbuf_pool *pool)
 	return pool->mbuf_block_offset;
 }
 
+/*
+ * Return the amount of memory held by free mbuf_blocks, in all size classes.
+ */
+size_t
+mbuf_pool_spare_memory(const struct mbuf_pool *pool)
+{
+	size_t result = pool->nfree_mbuf_blockq * pool->mbuf_block_chunk_size;
+	unsigned int i;
+
+	for (i = 0; i < pool->nsize_classes; i++) {
+		result += pool->size_classes[i].nfree_mbuf_blockq
+			* pool->size_classes[i].mbuf_block_chunk_size;
+	}
+	return result;
+}
+
+/*
+ * Return the amount of memory held by active mbuf_blocks, in all size classes.
+ * Standalone mbuf_blocks are counted as if they had the pool's chunk size.
+ */
+size_t
+mbuf_pool_active_memory(const struct mbuf_pool *pool)
+{
+	size_t result = pool->nactive_mbuf_blockq * pool->mbuf_block_chunk_size;
+	unsigned int i;
+
+	for (i = 0; i < pool->nsize_classes; i++) {
+		result += pool->size_classes[i].nactive_mbuf_blockq
+			* pool->size_classes[i].mbuf_block_chunk_size;
+	}
+	return result;
+}
+
 unsigned int
 mbuf_pool_compact(struct mbuf_pool *pool)
 {
-	unsigned int count = pool->nfree_mbuf_blockq;
+	unsigned int count = mbuf_pool_trim(pool, 0);
+	assert(pool->nfree_mbuf_blockq == 0);
+	return count;
+}
 
-	while (!STAILQ_EMPTY(&pool->free_mbuf_blockq)) {
-		struct mbuf_block *mbuf_block = STAILQ_FIRST(&pool->free_mbuf_blockq);
-		mbuf_block_remove(&pool->free_mbuf_blockq, mbuf_block);
-		mbuf_block_free(mbuf_block);
-		pool->nfree_mbuf_blockq--;
+/*
+ * Free spare mbuf_blocks until the pool holds at most `max_spare_memory`
+ * bytes of them. The largest size classes are freed first. Returns the
+ * number of freed mbuf_blocks.
+ */
+unsigned int
+mbuf_pool_trim(struct mbuf_pool *pool, size_t max_spare_memory)
+{
+	size_t spare_memory = mbuf_pool_spare_memory(pool);
+	unsigned int count = 0;
+	unsigned int i;
+
+	for (i = pool->nsize_classes; i > 0; i--) {
+		struct mbuf_size_class *size_class = &pool->size_classes[i - 1];
+		count += _mbuf_freelist_trim(&size_class->free_mbuf_blockq,
+			&size_class->nfree_mbuf_blockq, size_class->mbuf_block_chunk_size,
+			&spare_memory, max_spare_memory);
 	}
-	assert(pool->nfree_mbuf_blockq == 0);
+	count += _mbuf_freelist_trim(&pool->free_mbuf_blockq,
+		&pool->nfree_mbuf_blockq, pool->mbuf_block_chunk_size,
+		&spare_memory, max_spare_memory);
 
 	return count;
 }
 
+/*
+ * If the pool holds more spare memory than pool->spare_memory_high_water_mark,
+ * free spare mbuf_blocks until it holds at most half of that. Meant to be
+ * called periodically, so that memory pinned by a burst of traffic is
+ * eventually returned without causing malloc churn in the steady state.
+ * Returns the number of freed mbuf_blocks.
+ */
+unsigned int
+mbuf_pool_auto_compact(struct mbuf_pool *pool)
+{
+	if (pool->spare_memory_high_water_mark == 0
+	 || mbuf_pool_spare_memory(pool) <= pool->spare_memory_high_water_mark)
+	{
+		return 0;
+	}
+
+	pool->nauto_compactions++;
+	return mbuf_pool_trim(pool, pool->spare_memory_high_water_mark / 2);
+}
+
 
 void
 mbuf_block_ref(struct mbuf_block *mbuf_block)
@@ -301,7 +552,11 @@ mbuf_block_ref(struct mbuf_block *mbuf_block)
 	#ifdef MBUF_ENABLE_BACKTRACES
 		mbuf_block->backtrace = strdup(oxt::thread::current_backtrace().c_str());
 	#endif
-	mbuf_block->refcount++;
+	if (OXT_UNLIKELY(mbuf_block->thread_safe)) {
+		__sync_fetch_and_add(&mbuf_block->refcount, 1);
+	} else {
+		mbuf_block->refcount++;
+	}
 }
 
 void
@@ -313,10 +568,21 @@ mbuf_block_unref(struct mbuf_block *mbuf_block)
 			mbuf_block->refcount, mbuf_block->refcount - 1);
 	#endif
 	assert(mbuf_block->refcount > 0);
+	if (OXT_UNLIKELY(mbuf_block->thread_safe)) {
+		if (__sync_sub_and_fetch(&mbuf_block->refcount, 1) == 0) {
+			// Thread-safe blocks bypass the (unsynchronized) freelist.
+			__sync_fetch_and_sub(_mbuf_pool_nactive_counter(mbuf_block->pool,
+				mbuf_block->size_class), 1);
+			_mbuf_block_mark_as_inactive(mbuf_block);
+			mbuf_block_free(mbuf_block);
+		}
+		return;
+	}
 	mbuf_block->refcount--;
 	if (mbuf_block->refcount == 0) {
 		if (mbuf_block->offset > 0) {
 			mbuf_block->pool->nactive_mbuf_blockq--;
+			_mbuf_block_mark_as_inactive(mbuf_block);
 			mbuf_block_free(mbuf_block);
 		} else {
 			mbuf_block_put(mbuf_block);
@@ -347,8 +613,12 @@ mbuf
 mbuf_get_with_size(struct mbuf_pool *pool, size_t size)
 {
 	struct mbuf_block *block;
+	int size_class;
+
 	if (size <= mbuf_pool_data_size(pool)) {
 		block = mbuf_block_get(pool);
+	} else if ((size_class = _mbuf_pool_find_size_class(pool, size)) != -1) {
+		block = _mbuf_size_class_block_get(pool, size_class);
 	} else {
 		block = mbuf_block_new_standalone(pool, size);
 	}
@@ -74,6 +74,7 @@ typedef void (*mbuf_block_copy_t)(struct mbuf_block *, void *);
 /* See _mbuf_block_init() for format description */
 struct mbuf_block {
 	boost::uint32_t    magic;     /* mbuf_block magic (const) */
+	boost::uint32_t    thread_safe; /* refcount is updated atomically (const) */
 	STAILQ_ENTRY(struct mbuf_block) next;         /* next free mbuf_block */
 	#ifdef MBUF_ENABLE_DEBUGGING
 		TAILQ_ENTRY(struct mbuf_block) active_q;  /* prev and next active mbuf_block */
@@ -86,6 +87,7 @@ struct mbuf_block {
 	struct mbuf_pool  *pool;      /* containing pool (const) */
 	boost::uint32_t    refcount;  /* number of references by mbuf subsets */
 	boost::uint32_t    offset;    /* standalone mbuf_block data size */
+	boost::uint32_t    size_class; /* 0 = pool chunk size, otherwise index + 1 in pool->size_classes (const) */
 };
 
 STAILQ_HEAD(mhdr, struct mbuf_block);
@@ -93,16 +95,41 @@ STAILQ_HEAD(mhdr, struct mbuf_block);
 	TAILQ_HEAD(active_mbuf_block_list, struct mbuf_block);
 #endif
 
+#define MBUF_POOL_MAX_SIZE_CLASSES 3
+
+/*
+ * Blocks that are larger than the pool's own chunk size, handed out by
+ * mbuf_get_with_size(). Each size class has its own freelist, which is
+ * bounded so that a burst of large buffers doesn't pin memory forever.
+ */
+struct mbuf_size_class {
+	boost::uint32_t nfree_mbuf_blockq;    /* # free mbuf_block */
+	boost::uint32_t nactive_mbuf_blockq;  /* # active (non-free) mbuf_block */
+	boost::uint32_t max_free_mbuf_blockq; /* freelist bound */
+	struct mhdr free_mbuf_blockq; /* free mbuf_block q */
+
+	size_t mbuf_block_chunk_size; /* mbuf_block chunk size - header + data (const) */
+	size_t mbuf_block_offset;     /* mbuf_block offset in chunk (const) */
+};
+
 struct mbuf_pool {
 	boost::uint32_t nfree_mbuf_blockq;   /* # free mbuf_block */
 	boost::uint32_t nactive_mbuf_blockq; /* # active (non-free) mbuf_block */
+	boost::uint32_t max_free_mbuf_blockq; /* freelist bound, 0 = unbounded */
 	struct mhdr free_mbuf_blockq; /* free mbuf_block q */
 	#ifdef MBUF_ENABLE_DEBUGGING
-		struct active_mbuf_block_list active_mbuf_blockq; /* active mbuf_block q */
+		struct active_mbuf_block_list active_mbuf_blockq; /* active mbuf_block q, empty if thread_safe */
 	#endif
 
 	size_t mbuf_block_chunk_size; /* mbuf_block chunk size - header + data (const) */
 	size_t mbuf_block_offset;     /* mbuf_block offset in chunk (const) */
+	bool   thread_safe;           /* whether blocks may be (un)referenced from multiple threads (const) */
+
+	struct mbuf_size_class size_classes[MBUF_POOL_MAX_SIZE_CLASSES];
+	unsigned int nsize_classes;   /* # size classes larger than mbuf_block_chunk_size (const) */
+
+	size_t spare_memory_high_water_mark; /* see mbuf_pool_auto_compact(), 0 = disabled */
+	boost::uint32_t nauto_compactions;   /* # times mbuf_pool_auto_compact() freed blocks */
 };
 
 #define MBUF_BLOCK_MAGIC      0xdeadbeef
@@ -111,13 +138,29 @@ struct mbuf_pool {
 #define MBUF_BLOCK_SIZE       16384
 #define MBUF_BLOCK_HSIZE      sizeof(struct mbuf_block)
 
+/* Chunk sizes of the size classes; only those larger than the pool's own are used. */
+#define MBUF_SIZE_CLASS_CHUNK_SIZES { 4096, 16384, 65536 }
+/* Each size class freelist is bounded so that it holds at most this much memory. */
+#define MBUF_SIZE_CLASS_MAX_SPARE_MEMORY (1024 * 1024)
+
 #define MBUF_BLOCK_EMPTY(mbuf_block) ((mbuf_block)->pos  == (mbuf_block)->last)
 #define MBUF_BLOCK_FULL(mbuf_block)  ((mbuf_block)->last == (mbuf_block)->end)
 
-void mbuf_pool_init(struct mbuf_pool *pool);
+/*
+ * A thread-safe pool hands out mbuf_blocks whose reference counts are
+ * updated atomically, so that mbufs referencing them may be copied and
+ * destroyed from any thread. The blocks themselves must still be obtained
+ * from one thread at a time. Thread-safe blocks are not recycled through the
+ * freelist: they are freed as soon as their last reference is dropped.
+ */
+void mbuf_pool_init(struct mbuf_pool *pool, bool thread_safe = false);
 void mbuf_pool_deinit(struct mbuf_pool *pool);
 size_t mbuf_pool_data_size(struct mbuf_pool *pool);
+size_t mbuf_pool_spare_memory(const struct mbuf_pool *pool);
+size_t mbuf_pool_active_memory(const struct mbuf_pool *pool);
 unsigned int mbuf_pool_compact(struct mbuf_pool *pool);
+unsigned int mbuf_pool_trim(struct mbuf_pool *pool, size_t max_spare_memory);
+unsigned int mbuf_pool_auto_compact(struct mbuf_pool *pool);
 
 struct mbuf_block *mbuf_block_get(struct mbuf_pool *pool);
 void mbuf_block_put(struct mbuf_block *mbuf_block);
@@ -37,6 +37,8 @@ static void psg_deinit_pool(psg_pool_t *pool);
 static void psg_init_pool(psg_pool_t *pool, size_t size);
 static void *psg_palloc_block(psg_pool_t *pool, size_t size);
 static void *psg_palloc_large(psg_pool_t *pool, size_t size);
+static bool psg_retain_large(psg_pool_t *pool, void *alloc, size_t size);
+static void *psg_reuse_large(psg_pool_t *pool, size_t size, size_t *capacity);
 
 
 static void *
@@ -65,6 +67,7 @@ psg_create_pool(size_t size)
 	}
 
 	psg_init_pool(p, size);
+	memset(p->retained, 0, sizeof(p->retained));
 
 	return p;
 }
@@ -91,6 +94,7 @@ psg_init_pool(psg_pool_t *pool, size_t size)
 
 	pool->current = pool;
 	pool->large = NULL;
+	pool->allocated = 0;
 }
 
 
@@ -107,6 +111,8 @@ psg_deinit_pool(psg_pool_t *pool)
 		}
 	}
 
+	psg_free_retained(pool);
+
 	p = pool->data.next;
 	while (p != NULL) {
 		psg_pool_t *next = p->data.next;
@@ -123,7 +129,7 @@ psg_reset_pool(psg_pool_t *pool, size_t size)
 	psg_pool_large_t  *l;
 
 	for (l = pool->large; l; l = l->next) {
-		if (l->alloc) {
+		if (l->alloc && !psg_retain_large(pool, l->alloc, l->size)) {
 			free(l->alloc);
 		}
 	}
@@ -134,6 +140,7 @@ psg_reset_pool(psg_pool_t *pool, size_t size)
 	} else {
 		pool->current = pool;
 		pool->large = NULL;
+		pool->allocated = 0;
 
 		for (p = pool; p; p = p->data.next) {
 			char *m = (char *) p;
@@ -159,6 +166,8 @@ psg_palloc(psg_pool_t *pool, size_t size)
 	char        *m;
 	psg_pool_t  *p;
 
+	pool->allocated += size;
+
 	if (OXT_LIKELY(size <= pool->max)) {
 		p = pool->current;
 
@@ -186,6 +195,8 @@ psg_pnalloc(psg_pool_t *pool, size_t size)
 	char        *m;
 	psg_pool_t  *p;
 
+	pool->allocated += size;
+
 	if (size <= pool->max) {
 		p = pool->current;
 
@@ -255,12 +266,17 @@ static void *
 psg_palloc_large(psg_pool_t *pool, size_t size)
 {
 	void              *p;
+	size_t             capacity;
 	unsigned int       n;
 	psg_pool_large_t  *large;
 
-	p = malloc(size);
+	p = psg_reuse_large(pool, size, &capacity);
 	if (p == NULL) {
-		return NULL;
+		p = malloc(size);
+		if (p == NULL) {
+			return NULL;
+		}
+		capacity = size;
 	}
 
 	n = 0;
@@ -268,6 +284,7 @@ psg_palloc_large(psg_pool_t *pool, size_t size)
 	for (large = pool->large; large; large = large->next) {
 		if (large->alloc == NULL) {
 			large->alloc = p;
+			large->size = capacity;
 			return p;
 		}
 
@@ -283,6 +300,7 @@ psg_palloc_large(psg_pool_t *pool, size_t size)
 	}
 
 	large->alloc = p;
+	large->size = capacity;
 	large->next = pool->large;
 	pool->large = large;
 
@@ -290,12 +308,98 @@ psg_palloc_large(psg_pool_t *pool, size_t size)
 }
 
 
+/*
+ * Called by psg_reset_pool() for each large allocation. Returns whether
+ * the allocation was kept for reuse by psg_reuse_large().
+ */
+static bool
+psg_retain_large(psg_pool_t *pool, void *alloc, size_t size)
+{
+	unsigned int i;
+
+	if (size == 0 || size > PSG_MAX_RETAINED_LARGE_SIZE) {
+		return false;
+	}
+
+	for (i = 0; i < PSG_MAX_RETAINED_LARGE; i++) {
+		if (pool->retained[i].alloc == NULL) {
+			pool->retained[i].alloc = alloc;
+			pool->retained[i].size = size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+size_t
+psg_pool_retained_size(psg_pool_t *pool)
+{
+	size_t        total = 0;
+	unsigned int  i;
+
+	for (i = 0; i < PSG_MAX_RETAINED_LARGE; i++) {
+		if (pool->retained[i].alloc != NULL) {
+			total += pool->retained[i].size;
+		}
+	}
+
+	return total;
+}
+
+
+void
+psg_free_retained(psg_pool_t *pool)
+{
+	unsigned int i;
+
+	for (i = 0; i < PSG_MAX_RETAINED_LARGE; i++) {
+		free(pool->retained[i].alloc);
+		pool->retained[i].alloc = NULL;
+	}
+}
+
+
+/*
+ * Takes the smallest retained large allocation that can hold `size`
+ * bytes, or returns NULL if there is none.
+ */
+static void *
+psg_reuse_large(psg_pool_t *pool, size_t size, size_t *capacity)
+{
+	psg_pool_retained_t  *best = NULL;
+	void                 *p;
+	unsigned int          i;
+
+	for (i = 0; i < PSG_MAX_RETAINED_LARGE; i++) {
+		psg_pool_retained_t *r = &pool->retained[i];
+		if (r->alloc != NULL && r->size >= size
+		 && (best == NULL || r->size < best->size))
+		{
+			best = r;
+		}
+	}
+
+	if (best == NULL) {
+		return NULL;
+	}
+
+	p = best->alloc;
+	*capacity = best->size;
+	best->alloc = NULL;
+	return p;
+}
+
+
 void *
 psg_pmemalign(psg_pool_t *pool, size_t size, size_t alignment)
 {
 	void              *p;
 	psg_pool_large_t  *large;
 
+	pool->allocated += size;
+
 	p = call_memalign(alignment, size);
 	if (p == NULL) {
 		return NULL;
@@ -308,6 +412,7 @@ psg_pmemalign(psg_pool_t *pool, size_t size, size_t alignment)
 	}
 
 	large->alloc = p;
+	large->size = 0;
 	large->next = pool->large;
 	pool->large = large;
 
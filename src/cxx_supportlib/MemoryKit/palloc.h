@@ -62,6 +62,14 @@
 
 #define PSG_DEFAULT_POOL_SIZE    (16 * 1024)
 
+/*
+ * psg_reset_pool() keeps up to this many large allocations of at most
+ * PSG_MAX_RETAINED_LARGE_SIZE bytes, so that the next user of the pool
+ * can reuse them instead of calling malloc() again.
+ */
+#define PSG_MAX_RETAINED_LARGE       4
+#define PSG_MAX_RETAINED_LARGE_SIZE  (64 * 1024)
+
 #define PSG_POOL_ALIGNMENT       16
 #define PSG_MIN_POOL_SIZE                                                     \
 	psg_align((sizeof(psg_pool_t) + 2 * sizeof(psg_pool_large_t)),            \
@@ -74,8 +82,14 @@ typedef struct psg_pool_large_s  psg_pool_large_t;
 typedef struct psg_pool_large_s {
 	psg_pool_large_s     *next;
 	void                 *alloc;
+	size_t                size;   /** 0 if the allocation may not be retained. */
 } psg_pool_large_t;
 
+typedef struct {
+	void                 *alloc;
+	size_t                size;
+} psg_pool_retained_t;
+
 typedef struct {
 	char               *last;   /** Last allocated byte inside this block. */
 	char               *end;    /** End of block memory. Read-only */
@@ -94,13 +108,31 @@ struct psg_pool_s {
 	size_t                max;      /* Read-only */
 	psg_pool_t           *current;
 	psg_pool_large_t     *large;
+	/* Large allocations kept by psg_reset_pool() for reuse. */
+	psg_pool_retained_t   retained[PSG_MAX_RETAINED_LARGE];
+	/* Number of bytes allocated since creation or the last reset. */
+	size_t                allocated;
 };
 
 
 psg_pool_t *psg_create_pool(size_t size);
 void psg_destroy_pool(psg_pool_t *pool);
+/** Frees everything that was allocated from the pool, except for up to
+ * PSG_MAX_RETAINED_LARGE large allocations, which are kept for reuse.
+ * Returns false if the pool had grown beyond its first block. The pool is
+ * still usable in that case, but the caller may want to destroy it to
+ * release the extra blocks.
+ */
 bool psg_reset_pool(psg_pool_t *pool, size_t size);
 
+/** Returns the total size of the large allocations that the pool retains
+ * for reuse.
+ */
+size_t psg_pool_retained_size(psg_pool_t *pool);
+
+/** Frees the large allocations that the pool retains for reuse. */
+void psg_free_retained(psg_pool_t *pool);
+
 /** Allocate `size` bytes from the pool, aligned on platform word size. */
 void *psg_palloc(psg_pool_t *pool, size_t size);
 
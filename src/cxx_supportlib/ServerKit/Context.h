@@ -31,6 +31,8 @@
 #include <cstddef>
 #include <jsoncpp/json.h>
 #include <MemoryKit/mbuf.h>
+#include <ServerKit/PallocPoolRecycler.h>
+#include <ServerKit/IoUringEngine.h>
 #include <SafeLibev.h>
 #include <Constants.h>
 #include <Utils/StrIntUtils.h>
@@ -67,32 +69,64 @@ private:
 	void initialize() {
 		mbuf_pool.mbuf_block_chunk_size = DEFAULT_MBUF_CHUNK_SIZE;
 		MemoryKit::mbuf_pool_init(&mbuf_pool);
+		mbuf_pool.spare_memory_high_water_mark = DEFAULT_MBUF_SPARE_MEMORY_HIGH_WATER_MARK;
 	}
 
 public:
 	SafeLibevPtr libev;
 	struct uv_loop_s *libuv;
 	struct MemoryKit::mbuf_pool mbuf_pool;
+	PallocPoolRecycler pallocPoolRecycler;
 	string secureModePassword;
 	FileBufferedChannelConfig defaultFileBufferedChannelConfig;
+	/**
+	 * If not NULL, FileBufferedChannels perform their temp file reads and
+	 * writes through this engine instead of through libuv's thread pool.
+	 * Owned by the Context; see `enableIoUring()`.
+	 */
+	IoUringEngine *ioUringEngine;
 
 	Context(const SafeLibevPtr &_libev, struct uv_loop_s *_libuv)
 		: libev(_libev),
-		  libuv(_libuv)
+		  libuv(_libuv),
+		  ioUringEngine(NULL)
 	{
 		initialize();
 	}
 
 	Context(struct ev_loop *loop)
-		: libev(boost::make_shared<SafeLibev>(loop))
+		: libev(boost::make_shared<SafeLibev>(loop)),
+		  ioUringEngine(NULL)
 	{
 		initialize();
 	}
 
 	~Context() {
+		delete ioUringEngine;
 		MemoryKit::mbuf_pool_deinit(&mbuf_pool);
 	}
 
+	/**
+	 * Creates `ioUringEngine`. Returns 0 on success, or an errno code if
+	 * io_uring is not available, in which case FileBufferedChannels keep
+	 * using libuv. Must be called from the event loop thread, or before
+	 * the event loop is started.
+	 */
+	int enableIoUring(unsigned int entries = IoUringEngine::DEFAULT_ENTRIES) {
+		if (ioUringEngine != NULL) {
+			return 0;
+		}
+
+		IoUringEngine *engine = new IoUringEngine(libev);
+		int e = engine->initialize(entries);
+		if (e == 0) {
+			ioUringEngine = engine;
+		} else {
+			delete engine;
+		}
+		return e;
+	}
+
 	Json::Value inspectStateAsJson() const {
 		Json::Value doc;
 		Json::Value mbufDoc;
@@ -105,6 +139,30 @@ public:
 			* mbuf_pool.mbuf_block_chunk_size);
 		mbufDoc["active_memory"] = byteSizeToJson(mbuf_pool.nactive_mbuf_blockq
 			* mbuf_pool.mbuf_block_chunk_size);
+		mbufDoc["total_spare_memory"] = byteSizeToJson(
+			MemoryKit::mbuf_pool_spare_memory(&mbuf_pool));
+		mbufDoc["total_active_memory"] = byteSizeToJson(
+			MemoryKit::mbuf_pool_active_memory(&mbuf_pool));
+		mbufDoc["spare_memory_high_water_mark"] = byteSizeToJson(
+			mbuf_pool.spare_memory_high_water_mark);
+		mbufDoc["auto_compactions"] = (Json::UInt) mbuf_pool.nauto_compactions;
+
+		Json::Value sizeClassesDoc(Json::arrayValue);
+		for (unsigned int i = 0; i < mbuf_pool.nsize_classes; i++) {
+			const struct MemoryKit::mbuf_size_class &sizeClass = mbuf_pool.size_classes[i];
+			Json::Value sizeClassDoc;
+
+			sizeClassDoc["chunk_size"] = (Json::UInt) sizeClass.mbuf_block_chunk_size;
+			sizeClassDoc["free_blocks"] = (Json::UInt) sizeClass.nfree_mbuf_blockq;
+			sizeClassDoc["active_blocks"] = (Json::UInt) sizeClass.nactive_mbuf_blockq;
+			sizeClassDoc["free_blocks_limit"] = (Json::UInt) sizeClass.max_free_mbuf_blockq;
+			sizeClassDoc["spare_memory"] = byteSizeToJson(sizeClass.nfree_mbuf_blockq
+				* sizeClass.mbuf_block_chunk_size);
+			sizeClassDoc["active_memory"] = byteSizeToJson(sizeClass.nactive_mbuf_blockq
+				* sizeClass.mbuf_block_chunk_size);
+			sizeClassesDoc.append(sizeClassDoc);
+		}
+		mbufDoc["size_classes"] = sizeClassesDoc;
 		#ifdef MBUF_ENABLE_DEBUGGING
 			struct MemoryKit::active_mbuf_block_list *list =
 				const_cast<struct MemoryKit::active_mbuf_block_list *>(
@@ -127,6 +185,43 @@ public:
 		#endif
 
 		doc["mbuf_pool"] = mbufDoc;
+		doc["palloc_pools"] = inspectPallocPoolRecyclerStateAsJson();
+		if (ioUringEngine != NULL) {
+			doc["io_uring"] = ioUringEngine->inspectStateAsJson();
+		}
+
+		return doc;
+	}
+
+	Json::Value inspectPallocPoolRecyclerStateAsJson() const {
+		const PallocPoolRecycler &recycler = pallocPoolRecycler;
+		Json::Value doc;
+		Json::Value histogramDoc(Json::arrayValue);
+
+		doc["pool_size"] = byteSizeToJson(recycler.poolSize);
+		doc["warm_single_block_pools"] = recycler.getSingleBlockPoolCount();
+		doc["warm_grown_pools"] = recycler.getGrownPoolCount();
+		doc["retained_large_buffers"] = byteSizeToJson(recycler.getRetainedBytes());
+		doc["checkouts"] = (Json::UInt64) recycler.checkouts;
+		doc["reuses"] = (Json::UInt64) recycler.reuses;
+		doc["requests"] = (Json::UInt64) recycler.totalRequests;
+		if (recycler.totalRequests > 0) {
+			doc["average_allocated_per_request"] = byteSizeToJson(
+				recycler.totalAllocated / recycler.totalRequests);
+		}
+		doc["max_allocated_per_request"] = byteSizeToJson(recycler.maxAllocated);
+
+		for (unsigned int i = 0; i < PallocPoolRecycler::HISTOGRAM_BUCKETS; i++) {
+			Json::Value bucketDoc;
+			if (i < PallocPoolRecycler::HISTOGRAM_BUCKETS - 1) {
+				bucketDoc["max_allocated"] = byteSizeToJson((size_t) 1024 << i);
+			} else {
+				bucketDoc["max_allocated"] = Json::Value(Json::nullValue);
+			}
+			bucketDoc["requests"] = (Json::UInt64) recycler.histogram[i];
+			histogramDoc.append(bucketDoc);
+		}
+		doc["allocated_per_request_histogram"] = histogramDoc;
 
 		return doc;
 	}
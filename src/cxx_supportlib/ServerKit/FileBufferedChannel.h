@@ -32,6 +32,7 @@
 #include <boost/move/move.hpp>
 #include <boost/atomic.hpp>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <uv.h>
 #include <jsoncpp/json.h>
 #include <cassert>
@@ -206,7 +207,9 @@ public:
 private:
 	/**
 	 * A structure containing the details of a libuv asynchronous
-	 * filesystem I/O request.
+	 * filesystem I/O request. Reads and writes may also be performed by
+	 * the Context's IoUringEngine, which completes the same `req` with the
+	 * same callback.
 	 *
 	 * The I/O callback is responsible for destroying its corresponding
 	 * FileIOContext object.
@@ -246,11 +249,18 @@ private:
 		 */
 		void *logbase;
 
+		/**
+		 * Whether the current operation was started through the
+		 * IoUringEngine instead of through libuv.
+		 */
+		bool usingIoUring;
+
 		FileIOContext(FileBufferedChannel *_self)
 			: self(_self),
 			  libev(_self->ctx->libev),
 			  libuv(_self->ctx->libuv),
-			  logbase(_self)
+			  logbase(_self),
+			  usingIoUring(false)
 		{
 			req.type = UV_UNKNOWN_REQ;
 			req.result = -1;
@@ -264,7 +274,11 @@ private:
 				// uv_cancel() fails if the work is already in progress
 				// or completed, so we set self to NULL as an extra
 				// indicator that this I/O operation is canceled.
-				uv_cancel((uv_req_t *) &req);
+				// io_uring operations cannot be canceled this way at all,
+				// so for those we only rely on the latter.
+				if (!usingIoUring) {
+					uv_cancel((uv_req_t *) &req);
+				}
 				self = NULL;
 			}
 		}
@@ -421,6 +435,8 @@ private:
 	ReaderState readerState: 3;
 	/** Number of buffers in `firstBuffer` + `moreBuffers`. */
 	unsigned int nbuffers: 27;
+	/** Whether `cork()` is in effect. */
+	bool corked: 1;
 
 	/**
 	 * If an error is encountered, its details are stored here.
@@ -736,9 +752,8 @@ private:
 		readerState = RS_READING_FROM_FILE;
 		inFileMode->readRequest = readContext;
 
-		uv_fs_read(ctx->libuv, &readContext->req, inFileMode->fd,
-			&readContext->uvBuffer, 1, inFileMode->readOffset,
-			_nextChunkDoneReading);
+		startFileRead(readContext, inFileMode->fd, &readContext->uvBuffer,
+			inFileMode->readOffset, _nextChunkDoneReading);
 		verifyInvariants();
 	}
 
@@ -1093,8 +1108,8 @@ private:
 
 		inFileMode->writerState = WS_MOVING;
 		inFileMode->writerRequest = moveContext;
-		int result = uv_fs_write(ctx->libuv, &moveContext->req, inFileMode->fd,
-			&moveContext->uvBuffer, 1,
+		int result = startFileWrite(moveContext, inFileMode->fd,
+			&moveContext->uvBuffer,
 			inFileMode->readOffset + inFileMode->written,
 			_bufferWrittenToFile);
 		if (result != 0) {
@@ -1152,9 +1167,9 @@ private:
 				moveContext->uvBuffer = uv_buf_init(
 					moveContext->buffer.start + moveContext->written,
 					moveContext->buffer.size() - moveContext->written);
-				int result = uv_fs_write(ctx->libuv, &moveContext->req,
-					inFileMode->fd, &moveContext->uvBuffer, 1,
-					inFileMode->readOffset + inFileMode->written,
+				int result = startFileWrite(moveContext,
+					inFileMode->fd, &moveContext->uvBuffer,
+					inFileMode->readOffset + inFileMode->written + moveContext->written,
 					_bufferWrittenToFile);
 				if (result != 0) {
 					moveContext->req.result = result;
@@ -1174,6 +1189,47 @@ private:
 	}
 
 
+	/***** File I/O *****/
+
+	/**
+	 * Starts reading from the temp file through the Context's IoUringEngine,
+	 * or through libuv's thread pool if there is no engine or if the engine
+	 * is busy. Returns 0 or a libuv error code, like `uv_fs_read()`.
+	 */
+	int startFileRead(FileIOContext *ioContext, int fd, const uv_buf_t *buffer,
+		boost::int64_t offset, uv_fs_cb callback)
+	{
+		if (ctx->ioUringEngine != NULL
+		 && ctx->ioUringEngine->read(&ioContext->req, fd, buffer, offset, callback) == 0)
+		{
+			ioContext->usingIoUring = true;
+			return 0;
+		} else {
+			ioContext->usingIoUring = false;
+			return uv_fs_read(ctx->libuv, &ioContext->req, fd, buffer, 1,
+				offset, callback);
+		}
+	}
+
+	/**
+	 * Like `startFileRead()`, but for writing.
+	 */
+	int startFileWrite(FileIOContext *ioContext, int fd, const uv_buf_t *buffer,
+		boost::int64_t offset, uv_fs_cb callback)
+	{
+		if (ctx->ioUringEngine != NULL
+		 && ctx->ioUringEngine->write(&ioContext->req, fd, buffer, offset, callback) == 0)
+		{
+			ioContext->usingIoUring = true;
+			return 0;
+		} else {
+			ioContext->usingIoUring = false;
+			return uv_fs_write(ctx->libuv, &ioContext->req, fd, buffer, 1,
+				offset, callback);
+		}
+	}
+
+
 	/***** Misc *****/
 
 	void setError(int errcode, const char *file, unsigned int line) {
@@ -1351,6 +1407,7 @@ public:
 		  mode(IN_MEMORY_MODE),
 		  readerState(RS_INACTIVE),
 		  nbuffers(0),
+		  corked(false),
 		  errcode(0),
 		  bytesBuffered(0),
 		  inFileMode(),
@@ -1366,6 +1423,7 @@ public:
 		  mode(IN_MEMORY_MODE),
 		  readerState(RS_INACTIVE),
 		  nbuffers(0),
+		  corked(false),
 		  errcode(0),
 		  bytesBuffered(0),
 		  inFileMode(),
@@ -1419,7 +1477,7 @@ public:
 		{
 			moveNextBufferToFile();
 		}
-		if (readerState == RS_INACTIVE) {
+		if (readerState == RS_INACTIVE && !corked) {
 			if (acceptingInput()) {
 				readNextWithoutRefGuard();
 			} else {
@@ -1456,6 +1514,7 @@ public:
 		clearBuffers(false);
 		mode = IN_MEMORY_MODE;
 		readerState = RS_INACTIVE;
+		corked = false;
 		errcode = 0;
 		if (OXT_UNLIKELY(inFileMode != NULL)) {
 			inFileMode.reset();
@@ -1479,6 +1538,107 @@ public:
 		Channel::consumed(size, end);
 	}
 
+	/**
+	 * Corks the channel: data that is fed from now on is buffered, but is not
+	 * passed to the data callback until `uncork()` is called. This allows the
+	 * writer to feed a number of small buffers, and to have the data callback
+	 * process them as a single batch (see `peekQueuedBuffers()`).
+	 *
+	 * Corking has no effect if the data callback is already processing data.
+	 */
+	void cork() {
+		corked = true;
+	}
+
+	/**
+	 * Undoes `cork()`, and passes any data that was buffered in the mean time
+	 * to the data callback. Does nothing if the channel isn't corked.
+	 */
+	void uncork() {
+		if (!corked) {
+			return;
+		}
+		corked = false;
+		if (readerState == RS_INACTIVE && (hasBuffers() || mode == IN_FILE_MODE)) {
+			RefGuard guard(hooks, this, __FILE__, __LINE__);
+			if (acceptingInput()) {
+				readNextWithoutRefGuard();
+			} else {
+				readNextWhenChannelIdle();
+			}
+		}
+	}
+
+	bool isCorked() const {
+		return corked;
+	}
+
+	/**
+	 * Allows the data callback to process the in-memory buffers that are queued
+	 * behind the buffer that it has been passed, for example in order to write
+	 * them all out with a single `writev()` call.
+	 *
+	 * Fills `iov` with at most `maxiov` queued buffers, stopping at EOF, and
+	 * returns the number of entries filled. `dataSize` is set to their total size.
+	 * Once the data callback has processed some of that data, it must call
+	 * `consumeQueuedBuffers()` with the number of bytes processed, and return a
+	 * Channel::Result that says that the passed buffer is fully consumed.
+	 *
+	 * Only works in the in-memory mode, because in the in-file mode the queued
+	 * buffers belong to the writer. Returns 0 in any other mode.
+	 */
+	unsigned int peekQueuedBuffers(struct iovec *iov, unsigned int maxiov,
+		size_t &dataSize) const
+	{
+		unsigned int count = 0;
+
+		dataSize = 0;
+		if (mode != IN_MEMORY_MODE || nbuffers == 0 || maxiov == 0
+		 || (readerState != RS_FEEDING && readerState != RS_WAITING_FOR_CHANNEL_IDLE))
+		{
+			return 0;
+		}
+
+		if (firstBuffer.empty()) {
+			return 0;
+		}
+		iov[0].iov_base = firstBuffer.start;
+		iov[0].iov_len = firstBuffer.size();
+		dataSize += firstBuffer.size();
+		count++;
+
+		deque<MemoryKit::mbuf>::const_iterator it, end = moreBuffers.end();
+		for (it = moreBuffers.begin(); it != end && count < maxiov && !it->empty(); it++) {
+			iov[count].iov_base = it->start;
+			iov[count].iov_len = it->size();
+			dataSize += it->size();
+			count++;
+		}
+
+		return count;
+	}
+
+	/**
+	 * Removes the first `size` bytes of the buffers returned by `peekQueuedBuffers()`
+	 * from the queue. This may call `buffersFlushedCallback`, so the caller must
+	 * check for deinitialization afterwards.
+	 */
+	void consumeQueuedBuffers(size_t size) {
+		P_ASSERT_EQ(mode, IN_MEMORY_MODE);
+		while (size > 0) {
+			assert(hasBuffers());
+			assert(!peekBuffer().empty());
+			if (size >= peekBuffer().size()) {
+				size -= peekBuffer().size();
+				popBuffer();
+			} else {
+				firstBuffer = MemoryKit::mbuf(firstBuffer, size);
+				bytesBuffered -= size;
+				size = 0;
+			}
+		}
+	}
+
 	Channel::State getState() const {
 		return state;
 	}
@@ -1594,6 +1754,9 @@ public:
 
 		doc["reader_state"] = getReaderStateString();
 		doc["nbuffers"] = nbuffers;
+		if (corked) {
+			doc["corked"] = true;
+		}
 		doc["bytes_buffered"] = byteSizeToJson(getBytesBuffered());
 
 		return doc;
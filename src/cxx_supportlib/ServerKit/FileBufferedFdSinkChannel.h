@@ -28,6 +28,8 @@
 
 #include <oxt/macros.hpp>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <unistd.h>
 #include <Logging.h>
 #include <MemoryKit/mbuf.h>
@@ -36,6 +38,17 @@
 namespace Passenger {
 namespace ServerKit {
 
+// The maximum number of buffers that FileBufferedFdSinkChannel writes
+// with a single writev() call. The iovec array lives on the stack,
+// so we don't go all the way up to IOV_MAX if that is large.
+#if !defined(IOV_MAX)
+	#define PSG_FBFSC_MAX_WRITEV_BUFFERS 16
+#elif IOV_MAX < 256
+	#define PSG_FBFSC_MAX_WRITEV_BUFFERS IOV_MAX
+#else
+	#define PSG_FBFSC_MAX_WRITEV_BUFFERS 256
+#endif
+
 
 class FileBufferedFdSinkChannel: protected FileBufferedChannel {
 public:
@@ -52,12 +65,30 @@ private:
 		// install a RefGuard before calling this callback.
 
 		if (buffer.size() > 0) {
+			// Write the buffer together with any buffers that are queued
+			// behind it, so that we need only one system call.
+			struct iovec iov[PSG_FBFSC_MAX_WRITEV_BUFFERS];
+			unsigned int niov;
+			size_t queuedSize;
 			ssize_t ret;
+
+			iov[0].iov_base = buffer.start;
+			iov[0].iov_len = buffer.size();
+			niov = 1 + self->peekQueuedBuffers(iov + 1,
+				PSG_FBFSC_MAX_WRITEV_BUFFERS - 1, queuedSize);
 			do {
-				ret = ::write(self->watcher.fd, buffer.start, buffer.size());
+				ret = ::writev(self->watcher.fd, iov, niov);
 			} while (OXT_UNLIKELY(ret == -1 && errno == EINTR));
 			if (ret != -1) {
-				return Channel::Result(ret, false);
+				if ((size_t) ret <= buffer.size()) {
+					return Channel::Result(ret, false);
+				} else {
+					// Part of the queued buffers were written too. It doesn't
+					// matter if this deinitializes the channel: Channel checks
+					// for that after we return.
+					self->consumeQueuedBuffers(ret - buffer.size());
+					return Channel::Result(buffer.size(), false);
+				}
 			} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
 				ev_io_start(self->ctx->libev->getLoop(), &self->watcher);
 				return Channel::Result(-1, false);
@@ -143,6 +174,26 @@ public:
 		FileBufferedChannel::feedError(errcode, file, line);
 	}
 
+	/**
+	 * While corked, fed data is buffered instead of written, so that
+	 * multiple small buffers can be written with a single writev() call
+	 * when `uncork()` is called.
+	 */
+	OXT_FORCE_INLINE
+	void cork() {
+		FileBufferedChannel::cork();
+	}
+
+	OXT_FORCE_INLINE
+	void uncork() {
+		FileBufferedChannel::uncork();
+	}
+
+	OXT_FORCE_INLINE
+	bool isCorked() const {
+		return FileBufferedChannel::isCorked();
+	}
+
 	/**
 	 * Reinitialize the channel without a file descriptor. The channel
 	 * will be reinitialized in a stopped state. To start it, you must
@@ -214,6 +265,16 @@ public:
 		return FileBufferedChannel::getTotalBytesBuffered();
 	}
 
+	/**
+	 * Returns whether all data fed so far has been written to the file
+	 * descriptor. When this is true, the caller may write to the file
+	 * descriptor directly without reordering the data stream.
+	 */
+	bool flushed() const {
+		return FileBufferedChannel::getReaderState() == RS_INACTIVE
+			&& getTotalBytesBuffered() == 0;
+	}
+
 	OXT_FORCE_INLINE
 	bool ended() const {
 		return FileBufferedChannel::ended();
@@ -27,6 +27,7 @@
 #define _PASSENGER_SERVER_KIT_HTTP_CLIENT_H_
 
 #include <psg_sysqueue.h>
+#include <MemoryKit/palloc.h>
 #include <ServerKit/Client.h>
 #include <ServerKit/HttpRequest.h>
 
@@ -34,6 +35,18 @@ namespace Passenger {
 namespace ServerKit {
 
 
+/**
+ * A response that has been fully written to the client output channel, but
+ * that has not been flushed yet. Its request has already been deinitialized,
+ * but its palloc pool must live until the output channel is flushed because
+ * the channel may still refer to data in it. Allocated inside that pool.
+ */
+struct HttpQueuedResponse {
+	psg_pool_t *pool;
+	HttpQueuedResponse *next;
+};
+
+
 template<typename Request = HttpRequest>
 class BaseHttpClient: public BaseClient {
 public:
@@ -47,11 +60,32 @@ public:
 	 *         currentRequest->httpState != HttpRequest::IN_FREELIST
 	 */
 	Request *currentRequest;
+	/**
+	 * The next request on this connection, if the client pipelined it
+	 * while `currentRequest` was still being processed. Its header has
+	 * been (partially) parsed, but onRequestBegin() has not been called
+	 * yet.
+	 *
+	 * @invariant
+	 *     if pipelinedRequest != NULL:
+	 *         currentRequest != NULL
+	 *         pipelinedRequest->httpState <= HttpRequest::ERROR
+	 */
+	Request *pipelinedRequest;
+	/**
+	 * Responses of earlier pipelined requests that are still being
+	 * written out, in reverse order.
+	 */
+	HttpQueuedResponse *queuedResponses;
+	unsigned int queuedResponseCount;
 	unsigned int requestsBegun;
 
 	BaseHttpClient(void *server)
 		: BaseClient(server),
 		  currentRequest(NULL),
+		  pipelinedRequest(NULL),
+		  queuedResponses(NULL),
+		  queuedResponseCount(0),
 		  requestsBegun(0)
 		{ }
 };
@@ -68,6 +68,12 @@ public:
 
 	FreeRequestList freeRequests;
 	unsigned int freeRequestCount, requestFreelistLimit;
+	/**
+	 * The maximum number of unflushed responses per client that may be
+	 * queued in its output channel while pipelined requests are handled.
+	 * 0 disables handling pipelined requests ahead of time.
+	 */
+	unsigned int pipelinedResponseQueueLimit;
 	unsigned long totalRequestsBegun, lastTotalRequestsBegun;
 	double requestBeginSpeed1m, requestBeginSpeed1h;
 
@@ -196,7 +202,7 @@ private:
 	/***** Request deinitialization and preparation for next request *****/
 
 	void deinitializeRequestAndAddToFreelist(Client *client, Request *req) {
-		assert(client->currentRequest == req);
+		assert(client->currentRequest == req || client->pipelinedRequest == req);
 
 		if (req->httpState != Request::WAITING_FOR_REFERENCES) {
 			req->httpState = Request::WAITING_FOR_REFERENCES;
@@ -218,10 +224,9 @@ private:
 		P_ASSERT_EQ(req->httpState, Request::WAITING_FOR_REFERENCES);
 		assert(req->pool != NULL);
 		c->currentRequest = NULL;
-		if (!psg_reset_pool(req->pool, PSG_DEFAULT_POOL_SIZE)) {
-			psg_destroy_pool(req->pool);
-			req->pool = NULL;
-		}
+		this->getContext()->pallocPoolRecycler.checkin(req->pool);
+		req->pool = NULL;
+		releaseQueuedResponses(c);
 		unrefRequest(req, __FILE__, __LINE__);
 		if (keepAlive) {
 			SKC_TRACE(c, 3, "Keeping alive connection, handling next request");
@@ -238,6 +243,13 @@ private:
 	void handleNextRequest(Client *client) {
 		Request *req;
 
+		if (client->pipelinedRequest != NULL) {
+			client->output.deinitialize();
+			client->output.reinitialize(client->getFd());
+			beginPipelinedRequest(client);
+			return;
+		}
+
 		// A request object references its client object.
 		// This reference will be removed when the request ends,
 		// in requestReachedZeroRefcount().
@@ -252,6 +264,145 @@ private:
 		reinitializeRequest(client, req);
 	}
 
+	/**
+	 * Called by endRequest() instead of waiting for the output to be
+	 * flushed, when the client has already pipelined the next request.
+	 * The response stays in client->output, which writes it out before
+	 * anything that the next request writes, so we can begin the next
+	 * request right away. Only the palloc pool has to stay around until
+	 * the output is flushed.
+	 */
+	void doneWithCurrentRequestBeforeFlush(Client *client) {
+		Request *req = client->currentRequest;
+
+		P_ASSERT_EQ(req->httpState, Request::WAITING_FOR_REFERENCES);
+		assert(req->pool != NULL);
+		assert(client->pipelinedRequest != NULL);
+
+		if (client->output.flushed()) {
+			this->getContext()->pallocPoolRecycler.checkin(req->pool);
+		} else {
+			HttpQueuedResponse *queued = (HttpQueuedResponse *) psg_palloc(
+				req->pool, sizeof(HttpQueuedResponse));
+			queued->pool = req->pool;
+			queued->next = client->queuedResponses;
+			client->queuedResponses = queued;
+			client->queuedResponseCount++;
+			SKC_TRACE(client, 3, "Response queued until output is flushed (" <<
+				client->queuedResponseCount << " queued responses)");
+		}
+		req->pool = NULL;
+		client->currentRequest = NULL;
+		unrefRequest(req, __FILE__, __LINE__);
+
+		SKC_TRACE(client, 3, "Handling next pipelined request");
+		beginPipelinedRequest(client);
+	}
+
+	void releaseQueuedResponses(Client *client) {
+		HttpQueuedResponse *queued = client->queuedResponses;
+
+		if (queued != NULL) {
+			SKC_TRACE(client, 3, "Releasing " << client->queuedResponseCount <<
+				" flushed responses");
+			client->queuedResponses = NULL;
+			client->queuedResponseCount = 0;
+			while (queued != NULL) {
+				// `queued` lives inside the pool that we're checking in.
+				HttpQueuedResponse *next = queued->next;
+				this->getContext()->pallocPoolRecycler.checkin(queued->pool);
+				queued = next;
+			}
+		}
+	}
+
+
+	/***** Pipelined request handling *****/
+
+	/**
+	 * Called when the client sends more data while the current request has
+	 * no more body data to receive, i.e. when the client pipelines the next
+	 * request. Parses as much of the next request's header as `buffer`
+	 * contains, so that we don't have to do that after the current request
+	 * is done. Returns the number of bytes consumed.
+	 */
+	unsigned int preparsePipelinedRequest(Client *client, Request *req,
+		const MemoryKit::mbuf &buffer)
+	{
+		Request *next;
+		size_t ret;
+
+		if (buffer.empty()
+		 || pipelinedResponseQueueLimit == 0
+		 || client->pipelinedRequest != NULL
+		 || !canKeepAlive(req))
+		{
+			return 0;
+		}
+
+		// Like in handleNextRequest(), the request object references
+		// its client object.
+		this->refClient(client, __FILE__, __LINE__);
+		client->pipelinedRequest = next = checkoutRequestObject(client);
+		next->client = client;
+		reinitializeRequest(client, next);
+
+		SKC_TRACE(client, 3, "Preparsing " << buffer.size() <<
+			" bytes of pipelined HTTP header: \"" << cEscapeString(StaticString(
+				buffer.start, buffer.size())) << "\"");
+		ret = createRequestHeaderParser(this->getContext(), next).feed(buffer);
+		if (next->httpState == Request::PARSING_HEADERS) {
+			// The rest of the header will be parsed after the
+			// pipelined request has become the current request.
+			return buffer.size();
+		}
+
+		headerParserStatePool.destroy(next->parserState.headerParser);
+		next->parserState.headerParser = NULL;
+		if (next->httpState == Request::COMPLETE
+		 && (next->method == HTTP_GET || next->method == HTTP_HEAD))
+		{
+			onPipelinedRequestParsed(client, next);
+		}
+		return ret;
+	}
+
+	void beginPipelinedRequest(Client *client) {
+		Request *req = client->pipelinedRequest;
+		RequestRef ref(req, __FILE__, __LINE__);
+
+		assert(client->currentRequest == NULL);
+		client->pipelinedRequest = NULL;
+		client->currentRequest = req;
+
+		if (req->httpState == Request::PARSING_HEADERS) {
+			client->input.start();
+		} else {
+			Client *c = client;
+			Channel::Result result = processParsedRequestHeader(c, req,
+				MemoryKit::mbuf(), 0);
+			// If the request has already ended, then the next request
+			// will start the input once it is handled.
+			if (!result.end && !req->ended()) {
+				client->input.start();
+			}
+		}
+	}
+
+	void discardPipelinedRequest(Client *client) {
+		Request *req = client->pipelinedRequest;
+
+		if (req->httpState == Request::PARSING_HEADERS
+		 && req->parserState.headerParser != NULL)
+		{
+			headerParserStatePool.destroy(req->parserState.headerParser);
+			req->parserState.headerParser = NULL;
+		}
+		deinitializeRequestAndAddToFreelist(client, req);
+		client->pipelinedRequest = NULL;
+		unrefRequest(req, __FILE__, __LINE__);
+	}
+
 
 	/***** Client data handling *****/
 
@@ -273,57 +424,67 @@ private:
 			}
 
 			// Done parsing.
-			SKC_TRACE(client, 2, "New request received: #" << (totalRequestsBegun + 1));
 			headerParserStatePool.destroy(req->parserState.headerParser);
 			req->parserState.headerParser = NULL;
+			return processParsedRequestHeader(client, req, buffer, ret);
+		} else {
+			this->disconnect(&client);
+			return Channel::Result(0, true);
+		}
+	}
 
-			if (HttpServer::serverState == HttpServer::SHUTTING_DOWN
-			 && shouldDisconnectClientOnShutdown(client))
-			{
-				endWithErrorResponse(&client, &req, 503, "Server shutting down\n");
-				return Channel::Result(buffer.size(), false);
-			}
+	/**
+	 * Begins a request whose header has been fully parsed. `ret` is the
+	 * number of header bytes that were consumed from `buffer`.
+	 */
+	Channel::Result processParsedRequestHeader(Client *client, Request *req,
+		const MemoryKit::mbuf &buffer, size_t ret)
+	{
+		SKC_TRACE(client, 2, "New request received: #" << (totalRequestsBegun + 1));
 
-			switch (req->httpState) {
-			case Request::COMPLETE:
-				req->detectingNextRequestEarlyReadError = true;
-				onRequestBegin(client, req);
-				return Channel::Result(ret, false);
-			case Request::PARSING_BODY:
-				SKC_TRACE(client, 2, "Expecting a request body");
-				onRequestBegin(client, req);
-				return Channel::Result(ret, false);
-			case Request::PARSING_CHUNKED_BODY:
-				SKC_TRACE(client, 2, "Expecting a chunked request body");
-				prepareChunkedBodyParsing(client, req);
+		if (HttpServer::serverState == HttpServer::SHUTTING_DOWN
+		 && shouldDisconnectClientOnShutdown(client))
+		{
+			endWithErrorResponse(&client, &req, 503, "Server shutting down\n");
+			return Channel::Result(buffer.size(), false);
+		}
+
+		switch (req->httpState) {
+		case Request::COMPLETE:
+			req->detectingNextRequestEarlyReadError = true;
+			onRequestBegin(client, req);
+			return Channel::Result(ret, false);
+		case Request::PARSING_BODY:
+			SKC_TRACE(client, 2, "Expecting a request body");
+			onRequestBegin(client, req);
+			return Channel::Result(ret, false);
+		case Request::PARSING_CHUNKED_BODY:
+			SKC_TRACE(client, 2, "Expecting a chunked request body");
+			prepareChunkedBodyParsing(client, req);
+			onRequestBegin(client, req);
+			return Channel::Result(ret, false);
+		case Request::UPGRADED:
+			assert(!req->wantKeepAlive);
+			if (supportsUpgrade(client, req)) {
+				SKC_TRACE(client, 2, "Expecting connection upgrade");
 				onRequestBegin(client, req);
 				return Channel::Result(ret, false);
-			case Request::UPGRADED:
-				assert(!req->wantKeepAlive);
-				if (supportsUpgrade(client, req)) {
-					SKC_TRACE(client, 2, "Expecting connection upgrade");
-					onRequestBegin(client, req);
-					return Channel::Result(ret, false);
-				} else {
-					endWithErrorResponse(&client, &req, 422,
-						"Connection upgrading not allowed for this request");
-					return Channel::Result(0, true);
-				}
-			case Request::ERROR:
-				// Change state so that the response body will be written.
-				req->httpState = Request::COMPLETE;
-				if (req->aux.parseError == HTTP_VERSION_NOT_SUPPORTED) {
-					endWithErrorResponse(&client, &req, 505, "HTTP version not supported\n");
-				} else {
-					endAsBadRequest(&client, &req, getErrorDesc(req->aux.parseError));
-				}
-				return Channel::Result(0, true);
-			default:
-				P_BUG("Invalid request HTTP state " << (int) req->httpState);
+			} else {
+				endWithErrorResponse(&client, &req, 422,
+					"Connection upgrading not allowed for this request");
 				return Channel::Result(0, true);
 			}
-		} else {
-			this->disconnect(&client);
+		case Request::ERROR:
+			// Change state so that the response body will be written.
+			req->httpState = Request::COMPLETE;
+			if (req->aux.parseError == HTTP_VERSION_NOT_SUPPORTED) {
+				endWithErrorResponse(&client, &req, 505, "HTTP version not supported\n");
+			} else {
+				endAsBadRequest(&client, &req, getErrorDesc(req->aux.parseError));
+			}
+			return Channel::Result(0, true);
+		default:
+			P_BUG("Invalid request HTTP state " << (int) req->httpState);
 			return Channel::Result(0, true);
 		}
 	}
@@ -628,6 +789,7 @@ private:
 			channel->getHooks()->userData));
 
 		HttpServer *self = static_cast<HttpServer *>(HttpServer::getServerFromClient(client));
+		self->releaseQueuedResponses(client);
 		if (client->currentRequest != NULL
 		 && client->currentRequest->httpState == Request::FLUSHING_OUTPUT)
 		{
@@ -719,7 +881,7 @@ protected:
 			req->lastDataReceiveTime = ev_now(this->getLoop());
 		}
 		if (detectNextRequestEarlyReadError(client, req, buffer, errcode)) {
-			return Channel::Result(0, false);
+			return Channel::Result(preparsePipelinedRequest(client, req, buffer), false);
 		}
 
 		// Moved outside switch() so that the CPU branch predictor can do its work
@@ -768,11 +930,17 @@ protected:
 			client->currentRequest = NULL;
 			unrefRequest(req, __FILE__, __LINE__);
 		}
+		if (client->pipelinedRequest != NULL) {
+			discardPipelinedRequest(client);
+		}
+		releaseQueuedResponses(client);
 	}
 
 	virtual void deinitializeClient(Client *client) {
 		ParentClass::deinitializeClient(client);
 		client->currentRequest = NULL;
+		client->pipelinedRequest = NULL;
+		releaseQueuedResponses(client);
 	}
 
 	virtual bool shouldDisconnectClientOnShutdown(Client *client) {
@@ -832,6 +1000,18 @@ protected:
 		// Do nothing.
 	}
 
+	/**
+	 * Called when the header of a pipelined GET or HEAD request without a
+	 * body has been parsed, while the previous request on the connection is
+	 * still being processed. `req` is not the current request yet:
+	 * onRequestBegin() will be called for it once the previous request is
+	 * done. Subclasses can use this hook to prepare work for `req` ahead of
+	 * time, but may not write a response or end the request.
+	 */
+	virtual void onPipelinedRequestParsed(Client *client, Request *req) {
+		// Do nothing.
+	}
+
 	virtual bool supportsUpgrade(Client *client, Request *req) {
 		return false;
 	}
@@ -850,6 +1030,8 @@ protected:
 		ParentClass::reinitializeClient(client, fd);
 		client->requestsBegun = 0;
 		assert(client->currentRequest == NULL);
+		assert(client->pipelinedRequest == NULL);
+		assert(client->queuedResponses == NULL);
 	}
 
 	virtual void reinitializeRequest(Client *client, Request *req) {
@@ -863,10 +1045,10 @@ protected:
 		req->detectingNextRequestEarlyReadError = false;
 		req->parserState.headerParser = headerParserStatePool.construct();
 		createRequestHeaderParser(this->getContext(), req).initialize();
-		if (OXT_UNLIKELY(req->pool == NULL)) {
-			// We assume that most of the time, the pool from the
-			// last request is reset and reused.
-			req->pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+		if (OXT_LIKELY(req->pool == NULL)) {
+			// Most of the time, this is a warm pool that a previous
+			// request has checked back in.
+			req->pool = this->getContext()->pallocPoolRecycler.checkout();
 		}
 		psg_lstr_init(&req->path);
 		req->bodyChannel.reinitialize();
@@ -909,8 +1091,8 @@ protected:
 			it.next();
 		}
 
-		if (req->pool != NULL && !psg_reset_pool(req->pool, PSG_DEFAULT_POOL_SIZE)) {
-			psg_destroy_pool(req->pool);
+		if (req->pool != NULL) {
+			this->getContext()->pallocPoolRecycler.checkin(req->pool);
 			req->pool = NULL;
 		}
 
@@ -934,6 +1116,7 @@ public:
 		: ParentClass(context),
 		  freeRequestCount(0),
 		  requestFreelistLimit(1024),
+		  pipelinedResponseQueueLimit(16),
 		  totalRequestsBegun(0),
 		  lastTotalRequestsBegun(0),
 		  requestBeginSpeed1m(-1),
@@ -965,6 +1148,10 @@ public:
 
 		SKS_LOG(logLevel, __FILE__, __LINE__,
 			"Freed " << count << " spare request objects");
+
+		count = this->getContext()->pallocPoolRecycler.compact();
+		SKS_LOG(logLevel, __FILE__, __LINE__,
+			"Freed " << count << " spare palloc pools");
 	}
 
 
@@ -1157,6 +1344,15 @@ public:
 		deinitializeRequestAndAddToFreelist(c, req);
 		req->pool = pool;
 
+		if (c->pipelinedRequest != NULL
+		 && canKeepAlive(req)
+		 && !c->output.ended()
+		 && (c->output.flushed() || c->queuedResponseCount < pipelinedResponseQueueLimit))
+		{
+			doneWithCurrentRequestBeforeFlush(c);
+			return true;
+		}
+
 		if (!c->output.ended()) {
 			c->output.feedWithoutRefGuard(MemoryKit::mbuf());
 		}
@@ -1187,11 +1383,15 @@ public:
 		if (doc.isMember("request_freelist_limit")) {
 			requestFreelistLimit = doc["request_freelist_limit"].asUInt();
 		}
+		if (doc.isMember("pipelined_response_queue_limit")) {
+			pipelinedResponseQueueLimit = doc["pipelined_response_queue_limit"].asUInt();
+		}
 	}
 
 	virtual Json::Value getConfigAsJson() const {
 		Json::Value doc = ParentClass::getConfigAsJson();
 		doc["request_freelist_limit"] = requestFreelistLimit;
+		doc["pipelined_response_queue_limit"] = pipelinedResponseQueueLimit;
 		return doc;
 	}
 
@@ -1213,6 +1413,10 @@ public:
 		if (client->currentRequest) {
 			doc["current_request"] = inspectRequestStateAsJson(client->currentRequest);
 		}
+		if (client->pipelinedRequest) {
+			doc["pipelined_request"] = inspectRequestStateAsJson(client->pipelinedRequest);
+		}
+		doc["queued_response_count"] = client->queuedResponseCount;
 		doc["requests_begun"] = client->requestsBegun;
 		doc["lingering_request_count"] = client->lingeringRequestCount;
 		return doc;
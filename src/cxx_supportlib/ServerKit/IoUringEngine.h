@@ -0,0 +1,501 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2015 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#ifndef _PASSENGER_SERVER_KIT_IO_URING_ENGINE_H_
+#define _PASSENGER_SERVER_KIT_IO_URING_ENGINE_H_
+
+#include <boost/cstdint.hpp>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <ev.h>
+#include <uv.h>
+#include <jsoncpp/json.h>
+#include <Logging.h>
+#include <SafeLibev.h>
+
+#ifdef __linux__
+	#include <sys/syscall.h>
+	#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) \
+	 && defined(__NR_io_uring_register)
+		#define PSG_HAVE_IO_URING
+		#include <sys/mman.h>
+		#include <sys/eventfd.h>
+		#include <linux/io_uring.h>
+	#endif
+#endif
+
+namespace Passenger {
+namespace ServerKit {
+
+using namespace std;
+
+
+/**
+ * Performs file reads and writes through a Linux io_uring, as an alternative
+ * to libuv's thread pool. FileBufferedChannel uses this for moving buffers to
+ * its temp file and reading them back, when its Context has an engine.
+ *
+ * Requests are described by ordinary `uv_fs_t` structures and complete with
+ * ordinary `uv_fs_cb` callbacks, so that callers handle both kinds of I/O the
+ * same way. The request structure and the buffer must stay valid until the
+ * callback has been called; cancellation works by ignoring the result, just
+ * like with libuv requests that are already running.
+ *
+ * Operations that are started during an event loop iteration are submitted
+ * to the kernel with a single system call, right before the event loop goes
+ * to sleep. Completions are signaled through an eventfd that is watched by
+ * the event loop.
+ *
+ * Not thread-safe: each ServerKit::Context has its own engine, which may only
+ * be used from that Context's event loop thread.
+ */
+class IoUringEngine {
+public:
+	static const unsigned int DEFAULT_ENTRIES = 256;
+
+private:
+	struct ev_loop *loop;
+	int ringFd;
+	int eventFd;
+	struct ev_io eventFdWatcher;
+	struct ev_prepare prepareWatcher;
+
+	void *sqRing;
+	void *cqRing;
+	size_t sqRingSize;
+	size_t cqRingSize;
+	void *sqeArea;
+	size_t sqeAreaSize;
+
+	unsigned int *sqHead;
+	unsigned int *sqTail;
+	unsigned int *sqMask;
+	unsigned int *sqArray;
+	unsigned int sqEntries;
+	unsigned int *cqHead;
+	unsigned int *cqTail;
+	unsigned int *cqMask;
+	unsigned int cqEntries;
+	void *cqes;
+
+	/** Number of operations in the submission queue that haven't been
+	 * passed to the kernel yet.
+	 */
+	unsigned int unsubmitted;
+	/** Number of operations whose completion hasn't been processed yet.
+	 * This never exceeds the size of the completion queue, so that the
+	 * completion queue cannot overflow.
+	 */
+	unsigned int inFlight;
+
+	#ifdef PSG_HAVE_IO_URING
+		static int ioUringSetup(unsigned int entries, struct io_uring_params *params) {
+			return (int) syscall(__NR_io_uring_setup, entries, params);
+		}
+
+		static int ioUringEnter(int fd, unsigned int toSubmit, unsigned int minComplete,
+			unsigned int flags)
+		{
+			return (int) syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+				flags, NULL, 0);
+		}
+
+		static int ioUringRegister(int fd, unsigned int opcode, void *arg,
+			unsigned int nargs)
+		{
+			return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nargs);
+		}
+
+		static unsigned int *ringField(void *ring, unsigned int offset) {
+			return (unsigned int *) ((char *) ring + offset);
+		}
+
+		int mapRings(const struct io_uring_params &params) {
+			sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+			cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+			if (params.features & IORING_FEAT_SINGLE_MMAP) {
+				sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+			}
+
+			sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+			if (sqRing == MAP_FAILED) {
+				sqRing = NULL;
+				return errno;
+			}
+			if (params.features & IORING_FEAT_SINGLE_MMAP) {
+				cqRing = sqRing;
+			} else {
+				cqRing = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+				if (cqRing == MAP_FAILED) {
+					cqRing = NULL;
+					return errno;
+				}
+			}
+
+			sqeAreaSize = params.sq_entries * sizeof(struct io_uring_sqe);
+			sqeArea = mmap(NULL, sqeAreaSize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+			if (sqeArea == MAP_FAILED) {
+				sqeArea = NULL;
+				return errno;
+			}
+
+			sqHead  = ringField(sqRing, params.sq_off.head);
+			sqTail  = ringField(sqRing, params.sq_off.tail);
+			sqMask  = ringField(sqRing, params.sq_off.ring_mask);
+			sqArray = ringField(sqRing, params.sq_off.array);
+			sqEntries = params.sq_entries;
+			cqHead  = ringField(cqRing, params.cq_off.head);
+			cqTail  = ringField(cqRing, params.cq_off.tail);
+			cqMask  = ringField(cqRing, params.cq_off.ring_mask);
+			cqEntries = params.cq_entries;
+			cqes = (char *) cqRing + params.cq_off.cqes;
+			return 0;
+		}
+
+		struct io_uring_sqe *getSqe() {
+			unsigned int tail = *sqTail;
+			if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+				submit();
+				if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+					return NULL;
+				}
+			}
+
+			unsigned int index = tail & *sqMask;
+			struct io_uring_sqe *sqe = (struct io_uring_sqe *) sqeArea + index;
+			memset(sqe, 0, sizeof(struct io_uring_sqe));
+			sqArray[index] = index;
+			return sqe;
+		}
+
+		void commitSqe() {
+			__atomic_store_n(sqTail, *sqTail + 1, __ATOMIC_RELEASE);
+			unsubmitted++;
+			inFlight++;
+			queued++;
+		}
+
+		int startIO(unsigned char opcode, uv_fs_t *req, uv_file fd, const uv_buf_t *buf,
+			boost::int64_t offset, uv_fs_cb cb)
+		{
+			if (inFlight >= cqEntries) {
+				return UV_EAGAIN;
+			}
+
+			struct io_uring_sqe *sqe = getSqe();
+			if (sqe == NULL) {
+				return UV_EAGAIN;
+			}
+
+			initializeReq(req, (opcode == IORING_OP_READV) ? UV_FS_READ : UV_FS_WRITE, cb);
+			sqe->opcode = opcode;
+			sqe->fd = fd;
+			// uv_buf_t has the same layout as struct iovec on Unix.
+			sqe->addr = (unsigned long) buf;
+			sqe->len = 1;
+			sqe->off = offset;
+			sqe->user_data = (unsigned long) req;
+			commitSqe();
+			return 0;
+		}
+	#endif
+
+	/**
+	 * Makes `req` look like a finished libuv request, so that the caller
+	 * can treat it like one. In particular, `uv_fs_req_cleanup()` must be
+	 * a no-op on it.
+	 */
+	static void initializeReq(uv_fs_t *req, uv_fs_type type, uv_fs_cb cb) {
+		req->type = UV_FS;
+		req->fs_type = type;
+		req->loop = NULL;
+		req->cb = cb;
+		req->result = 0;
+		req->ptr = NULL;
+		req->path = NULL;
+		req->new_path = NULL;
+	}
+
+	static void onEventFdReadable(struct ev_loop *loop, struct ev_io *io, int revents) {
+		IoUringEngine *self = static_cast<IoUringEngine *>(io->data);
+		boost::uint64_t value;
+		ssize_t ret;
+
+		do {
+			ret = ::read(self->eventFd, &value, sizeof(value));
+		} while (ret == -1 && errno == EINTR);
+		self->processCompletions();
+	}
+
+	static void onEventLoopPrepare(struct ev_loop *loop, struct ev_prepare *prepare,
+		int revents)
+	{
+		IoUringEngine *self = static_cast<IoUringEngine *>(prepare->data);
+		if (self->unsubmitted > 0) {
+			self->submit();
+		}
+	}
+
+	void destroyRing() {
+		#ifdef PSG_HAVE_IO_URING
+			if (sqeArea != NULL) {
+				munmap(sqeArea, sqeAreaSize);
+				sqeArea = NULL;
+			}
+			if (cqRing != NULL && cqRing != sqRing) {
+				munmap(cqRing, cqRingSize);
+			}
+			cqRing = NULL;
+			if (sqRing != NULL) {
+				munmap(sqRing, sqRingSize);
+				sqRing = NULL;
+			}
+		#endif
+		if (eventFd != -1) {
+			::close(eventFd);
+			eventFd = -1;
+		}
+		if (ringFd != -1) {
+			::close(ringFd);
+			ringFd = -1;
+		}
+	}
+
+public:
+	/** Number of operations that were queued. */
+	boost::uint64_t queued;
+	/** Number of io_uring_enter() calls that submitted operations. Each
+	 * call submits a whole batch of queued operations.
+	 */
+	boost::uint64_t submitCalls;
+	/** Number of operations that have completed. */
+	boost::uint64_t completed;
+
+	IoUringEngine(const SafeLibevPtr &libev)
+		: loop(libev->getLoop()),
+		  ringFd(-1),
+		  eventFd(-1),
+		  sqRing(NULL),
+		  cqRing(NULL),
+		  sqRingSize(0),
+		  cqRingSize(0),
+		  sqeArea(NULL),
+		  sqeAreaSize(0),
+		  sqEntries(0),
+		  cqEntries(0),
+		  unsubmitted(0),
+		  inFlight(0),
+		  queued(0),
+		  submitCalls(0),
+		  completed(0)
+	{
+		ev_io_init(&eventFdWatcher, onEventFdReadable, -1, EV_READ);
+		eventFdWatcher.data = this;
+		ev_prepare_init(&prepareWatcher, onEventLoopPrepare);
+		prepareWatcher.data = this;
+	}
+
+	/**
+	 * Waits until all operations have completed, and calls their callbacks,
+	 * before destroying the ring. Must be called from the event loop thread,
+	 * or after the event loop has stopped.
+	 */
+	~IoUringEngine() {
+		if (ringFd == -1) {
+			return;
+		}
+
+		ev_io_stop(loop, &eventFdWatcher);
+		ev_prepare_stop(loop, &prepareWatcher);
+		#ifdef PSG_HAVE_IO_URING
+			while (inFlight > 0) {
+				int ret = ioUringEnter(ringFd, unsubmitted, 1, IORING_ENTER_GETEVENTS);
+				if (ret >= 0) {
+					unsubmitted -= std::min<unsigned int>(ret, unsubmitted);
+				} else if (errno != EINTR) {
+					P_CRITICAL("Cannot wait for io_uring operations to complete: " <<
+						strerror(errno) << " (errno=" << errno << ")");
+					abort();
+				}
+				processCompletions();
+			}
+		#endif
+		destroyRing();
+	}
+
+	/**
+	 * Sets up the ring. Returns 0 on success, or an errno code if io_uring
+	 * is not available, in which case this object must not be used.
+	 * Must be called from the event loop thread, or before the event loop
+	 * is started.
+	 */
+	int initialize(unsigned int entries = DEFAULT_ENTRIES) {
+		#ifdef PSG_HAVE_IO_URING
+			struct io_uring_params params;
+			int e;
+
+			memset(&params, 0, sizeof(params));
+			ringFd = ioUringSetup(entries, &params);
+			if (ringFd == -1) {
+				return errno;
+			}
+			if ((e = mapRings(params)) != 0) {
+				destroyRing();
+				return e;
+			}
+
+			eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (eventFd == -1) {
+				e = errno;
+				destroyRing();
+				return e;
+			}
+			if (ioUringRegister(ringFd, IORING_REGISTER_EVENTFD, &eventFd, 1) == -1) {
+				e = errno;
+				destroyRing();
+				return e;
+			}
+
+			ev_io_set(&eventFdWatcher, eventFd, EV_READ);
+			ev_io_start(loop, &eventFdWatcher);
+			ev_prepare_start(loop, &prepareWatcher);
+			return 0;
+		#else
+			return ENOSYS;
+		#endif
+	}
+
+	/**
+	 * Starts reading into `buf` from `fd` at `offset`, like `uv_fs_read()`
+	 * with one buffer. Returns 0 on success, or a libuv error code if the
+	 * operation cannot be started right now, in which case the caller
+	 * should use libuv instead.
+	 */
+	int read(uv_fs_t *req, uv_file fd, const uv_buf_t *buf, boost::int64_t offset,
+		uv_fs_cb cb)
+	{
+		#ifdef PSG_HAVE_IO_URING
+			return startIO(IORING_OP_READV, req, fd, buf, offset, cb);
+		#else
+			return UV_ENOSYS;
+		#endif
+	}
+
+	/**
+	 * Starts writing `buf` to `fd` at `offset`, like `uv_fs_write()` with
+	 * one buffer. Returns 0 on success, or a libuv error code if the
+	 * operation cannot be started right now, in which case the caller
+	 * should use libuv instead.
+	 */
+	int write(uv_fs_t *req, uv_file fd, const uv_buf_t *buf, boost::int64_t offset,
+		uv_fs_cb cb)
+	{
+		#ifdef PSG_HAVE_IO_URING
+			return startIO(IORING_OP_WRITEV, req, fd, buf, offset, cb);
+		#else
+			return UV_ENOSYS;
+		#endif
+	}
+
+	/**
+	 * Passes all queued operations to the kernel. This normally happens
+	 * automatically, right before the event loop goes to sleep.
+	 */
+	void submit() {
+		#ifdef PSG_HAVE_IO_URING
+			while (unsubmitted > 0) {
+				int ret = ioUringEnter(ringFd, unsubmitted, 0, 0);
+				if (ret > 0) {
+					unsubmitted -= std::min<unsigned int>(ret, unsubmitted);
+					submitCalls++;
+				} else if (ret == -1 && errno == EINTR) {
+					continue;
+				} else {
+					if (ret == -1 && errno != EAGAIN && errno != EBUSY) {
+						P_WARN("Cannot submit io_uring operations: " <<
+							strerror(errno) << " (errno=" << errno << "). "
+							"Trying again later");
+					}
+					// The operations stay in the submission queue,
+					// and we try again on the next event loop iteration.
+					return;
+				}
+			}
+		#endif
+	}
+
+	/**
+	 * Calls the callbacks of all operations that have completed.
+	 * This normally happens automatically when the eventfd becomes readable.
+	 */
+	void processCompletions() {
+		#ifdef PSG_HAVE_IO_URING
+			unsigned int head = *cqHead;
+
+			while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+				struct io_uring_cqe *cqe = (struct io_uring_cqe *) cqes + (head & *cqMask);
+				uv_fs_t *req = (uv_fs_t *) (unsigned long) cqe->user_data;
+				int res = cqe->res;
+
+				// Release the completion queue entry before calling the
+				// callback, which may start new operations.
+				head++;
+				__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+				inFlight--;
+				completed++;
+
+				req->result = res;
+				req->cb(req);
+			}
+		#endif
+	}
+
+	unsigned int getInFlight() const {
+		return inFlight;
+	}
+
+	Json::Value inspectStateAsJson() const {
+		Json::Value doc;
+		doc["entries"] = sqEntries;
+		doc["in_flight"] = inFlight;
+		doc["queued"] = (Json::UInt64) queued;
+		doc["submit_calls"] = (Json::UInt64) submitCalls;
+		doc["completed"] = (Json::UInt64) completed;
+		return doc;
+	}
+};
+
+
+} // namespace ServerKit
+} // namespace Passenger
+
+#endif /* _PASSENGER_SERVER_KIT_IO_URING_ENGINE_H_ */
@@ -0,0 +1,217 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2015 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#ifndef _PASSENGER_SERVER_KIT_PALLOC_POOL_RECYCLER_H_
+#define _PASSENGER_SERVER_KIT_PALLOC_POOL_RECYCLER_H_
+
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <cstddef>
+#include <MemoryKit/palloc.h>
+
+namespace Passenger {
+namespace ServerKit {
+
+using namespace std;
+
+
+/**
+ * Keeps warm palloc pools around so that requests can check out a pool
+ * without calling malloc(), and check it back in when they're done.
+ * Pools are kept in two tiers: pools that still consist of a single block,
+ * and pools that have grown beyond it. The latter are kept in smaller
+ * numbers because they hold more memory, but reusing them saves the
+ * allocations that made them grow in the first place.
+ *
+ * Reset pools may also retain some large allocations for reuse (see
+ * psg_reset_pool()). The total size of those is capped by
+ * `retainedBytesLimit`: a pool that is checked in while the cap is
+ * reached has its retained allocations freed.
+ *
+ * Also records how many bytes each request allocated from its pool, so
+ * that PSG_DEFAULT_POOL_SIZE can be tuned from real data.
+ *
+ * Not thread-safe: each ServerKit::Context has its own recycler.
+ */
+class PallocPoolRecycler {
+public:
+	/** Histogram bucket `i` counts requests that allocated at most
+	 * (1 KB << i) bytes. The last bucket counts all larger ones.
+	 */
+	static const unsigned int HISTOGRAM_BUCKETS = 8;
+
+private:
+	vector<psg_pool_t *> singleBlockPools;
+	vector<psg_pool_t *> grownPools;
+	/** Total size of the large allocations retained by warm pools. */
+	size_t retainedBytes;
+
+	void destroyAll(vector<psg_pool_t *> &pools) {
+		vector<psg_pool_t *>::iterator it, end = pools.end();
+		for (it = pools.begin(); it != end; it++) {
+			psg_destroy_pool(*it);
+		}
+		pools.clear();
+	}
+
+	void keep(vector<psg_pool_t *> &pools, psg_pool_t *pool) {
+		size_t size = psg_pool_retained_size(pool);
+		if (retainedBytes + size > retainedBytesLimit) {
+			psg_free_retained(pool);
+		} else {
+			retainedBytes += size;
+		}
+		pools.push_back(pool);
+	}
+
+	psg_pool_t *take(vector<psg_pool_t *> &pools) {
+		psg_pool_t *pool = pools.back();
+		pools.pop_back();
+		retainedBytes -= psg_pool_retained_size(pool);
+		reuses++;
+		return pool;
+	}
+
+	void recordAllocation(size_t allocated) {
+		unsigned int i;
+
+		for (i = 0; i < HISTOGRAM_BUCKETS - 1; i++) {
+			if (allocated <= ((size_t) 1024 << i)) {
+				break;
+			}
+		}
+		histogram[i]++;
+		totalRequests++;
+		totalAllocated += allocated;
+		if (allocated > maxAllocated) {
+			maxAllocated = allocated;
+		}
+	}
+
+public:
+	size_t poolSize;
+	unsigned int singleBlockPoolLimit;
+	unsigned int grownPoolLimit;
+	size_t retainedBytesLimit;
+
+	boost::uint64_t checkouts;
+	boost::uint64_t reuses;
+	boost::uint64_t totalRequests;
+	boost::uint64_t totalAllocated;
+	size_t maxAllocated;
+	boost::uint64_t histogram[HISTOGRAM_BUCKETS];
+
+	PallocPoolRecycler(size_t _poolSize = PSG_DEFAULT_POOL_SIZE,
+		unsigned int _singleBlockPoolLimit = 128,
+		unsigned int _grownPoolLimit = 16,
+		size_t _retainedBytesLimit = 1024 * 1024)
+		: retainedBytes(0),
+		  poolSize(_poolSize),
+		  singleBlockPoolLimit(_singleBlockPoolLimit),
+		  grownPoolLimit(_grownPoolLimit),
+		  retainedBytesLimit(_retainedBytesLimit),
+		  checkouts(0),
+		  reuses(0),
+		  totalRequests(0),
+		  totalAllocated(0),
+		  maxAllocated(0)
+	{
+		for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+			histogram[i] = 0;
+		}
+	}
+
+	~PallocPoolRecycler() {
+		compact();
+	}
+
+	/**
+	 * Returns a warm pool if there is one, otherwise creates a new one.
+	 * Single-block pools are preferred over grown ones. Returns NULL if
+	 * a new pool could not be allocated.
+	 */
+	psg_pool_t *checkout() {
+		psg_pool_t *pool;
+
+		checkouts++;
+		if (!singleBlockPools.empty()) {
+			pool = take(singleBlockPools);
+		} else if (!grownPools.empty()) {
+			pool = take(grownPools);
+		} else {
+			pool = psg_create_pool(poolSize);
+		}
+		return pool;
+	}
+
+	/**
+	 * Records the pool's allocation statistics, resets it and either keeps
+	 * it for a future checkout() or destroys it if its tier is full.
+	 * Frees the pool's retained large allocations if keeping them would
+	 * exceed `retainedBytesLimit`.
+	 */
+	void checkin(psg_pool_t *pool) {
+		recordAllocation(pool->allocated);
+		if (psg_reset_pool(pool, poolSize)) {
+			if (singleBlockPools.size() < singleBlockPoolLimit) {
+				keep(singleBlockPools, pool);
+				return;
+			}
+		} else if (grownPools.size() < grownPoolLimit) {
+			keep(grownPools, pool);
+			return;
+		}
+		psg_destroy_pool(pool);
+	}
+
+	/**
+	 * Destroys all warm pools. Returns the number of destroyed pools.
+	 */
+	unsigned int compact() {
+		unsigned int count = singleBlockPools.size() + grownPools.size();
+		destroyAll(singleBlockPools);
+		destroyAll(grownPools);
+		retainedBytes = 0;
+		return count;
+	}
+
+	unsigned int getSingleBlockPoolCount() const {
+		return singleBlockPools.size();
+	}
+
+	unsigned int getGrownPoolCount() const {
+		return grownPools.size();
+	}
+
+	size_t getRetainedBytes() const {
+		return retainedBytes;
+	}
+};
+
+
+} // namespace ServerKit
+} // namespace Passenger
+
+#endif /* _PASSENGER_SERVER_KIT_PALLOC_POOL_RECYCLER_H_ */
@@ -347,6 +347,12 @@ private:
 		this->onUpdateStatistics();
 		this->onFinalizeStatisticsUpdate();
 
+		unsigned int count = MemoryKit::mbuf_pool_auto_compact(&ctx->mbuf_pool);
+		if (count > 0) {
+			SKS_DEBUG("mbuf pool exceeded its spare memory high water mark; freed "
+				<< count << " mbufs");
+		}
+
 		timer.repeat = timeToNextMultipleD(5, ev_now(this->getLoop()));
 		timer.again();
 	}
@@ -29,6 +29,12 @@
 #include <string.h>
 #include <limits.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+# define HTTP_PARSER_X86_SIMD 1
+# include <immintrin.h>
+#endif
+
 #ifndef ULLONG_MAX
 # define ULLONG_MAX ((boost::uint64_t) -1) /* 2^64-1 */
 #endif
@@ -384,6 +390,124 @@ enum http_host_state
 #endif
 
 
+/* Header scanning fast paths.
+ *
+ * Most bytes in a request header are inside header values (think big Cookie
+ * or X-Forwarded-For headers), and the state machine doesn't care about the
+ * contents of a general header value, only about where it ends. So instead
+ * of going through the main loop one byte at a time, we look for the CR or
+ * LF that ends the value 16 or 32 bytes at a time, using the best SIMD
+ * instructions that the CPU supports. Header names are skipped with a plain
+ * loop because every byte must be checked against the token table anyway.
+ */
+
+typedef const char *(*find_cr_or_lf_fn)(const char *p, const char *end);
+
+static const char *
+find_cr_or_lf_scalar(const char *p, const char *end)
+{
+  for (; p != end; p++) {
+    if (*p == CR || *p == LF) {
+      break;
+    }
+  }
+  return p;
+}
+
+#ifdef HTTP_PARSER_X86_SIMD
+__attribute__((target("sse4.2")))
+static const char *
+find_cr_or_lf_sse42(const char *p, const char *end)
+{
+  const __m128i needles = _mm_setr_epi8(CR, LF, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0);
+
+  while (end - p >= 16) {
+    __m128i data = _mm_loadu_si128((const __m128i *) p);
+    int index = _mm_cmpestri(needles, 2, data, 16,
+      _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+    if (index != 16) {
+      return p + index;
+    }
+    p += 16;
+  }
+  return find_cr_or_lf_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *
+find_cr_or_lf_avx2(const char *p, const char *end)
+{
+  const __m256i cr = _mm256_set1_epi8(CR);
+  const __m256i lf = _mm256_set1_epi8(LF);
+
+  while (end - p >= 32) {
+    __m256i data = _mm256_loadu_si256((const __m256i *) p);
+    unsigned int mask = (unsigned int) _mm256_movemask_epi8(_mm256_or_si256(
+      _mm256_cmpeq_epi8(data, cr), _mm256_cmpeq_epi8(data, lf)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return find_cr_or_lf_scalar(p, end);
+}
+#endif
+
+static find_cr_or_lf_fn
+find_cr_or_lf_for(enum http_header_scanner scanner)
+{
+  switch (scanner) {
+  case HTTP_HEADER_SCANNER_SCALAR:
+    return find_cr_or_lf_scalar;
+#ifdef HTTP_PARSER_X86_SIMD
+  case HTTP_HEADER_SCANNER_SSE42:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") ? find_cr_or_lf_sse42 : NULL;
+  case HTTP_HEADER_SCANNER_AVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? find_cr_or_lf_avx2 : NULL;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+static enum http_header_scanner
+best_header_scanner(void)
+{
+  if (find_cr_or_lf_for(HTTP_HEADER_SCANNER_AVX2) != NULL) {
+    return HTTP_HEADER_SCANNER_AVX2;
+  } else if (find_cr_or_lf_for(HTTP_HEADER_SCANNER_SSE42) != NULL) {
+    return HTTP_HEADER_SCANNER_SSE42;
+  } else {
+    return HTTP_HEADER_SCANNER_SCALAR;
+  }
+}
+
+static enum http_header_scanner header_scanner = best_header_scanner();
+/* NULL if the fast paths are disabled (HTTP_HEADER_SCANNER_NONE). */
+static find_cr_or_lf_fn find_cr_or_lf = find_cr_or_lf_for(header_scanner);
+
+/* The fast paths skip bytes without going through the main loop, so they
+ * do its HTTP_MAX_HEADER_SIZE accounting themselves. They never skip past
+ * HEADER_SKIP_LIMIT, so that the main loop still detects a header overflow
+ * at the exact same byte.
+ */
+#define HEADER_SKIP_LIMIT                                            \
+  (MIN(data + len, p + 1 + ((HTTP_MAX_HEADER_SIZE) - parser->nread)))
+
+/* Continue with the byte at TO, as if the bytes before it were processed
+ * one at a time without changing any state. TO is evaluated twice, so pass
+ * a variable rather than an expression that depends on p or nread.
+ */
+#define HEADER_SKIP_TO(TO)                                           \
+do {                                                                 \
+  parser->nread += (TO) - p - 1;                                     \
+  p = (TO) - 1;                                                      \
+} while (0)
+
+
 #define start_state (parser->type == HTTP_REQUEST ? s_start_req : s_start_res)
 
 
@@ -1283,6 +1407,14 @@ size_t http_parser_execute (http_parser *parser,
         if (c) {
           switch (parser->header_state) {
             case h_general:
+              if (find_cr_or_lf != NULL) {
+                const char *limit = HEADER_SKIP_LIMIT;
+                const char *q = p + 1;
+                while (q != limit && TOKEN(*q)) {
+                  q++;
+                }
+                HEADER_SKIP_TO(q);
+              }
               break;
 
             case h_C:
@@ -1492,6 +1624,10 @@ size_t http_parser_execute (http_parser *parser,
 
         switch (parser->header_state) {
           case h_general:
+            if (find_cr_or_lf != NULL) {
+              const char *q = find_cr_or_lf(p + 1, HEADER_SKIP_LIMIT);
+              HEADER_SKIP_TO(q);
+            }
             break;
 
           case h_connection:
@@ -2252,6 +2388,29 @@ http_parser_pause(http_parser *parser, int paused) {
   }
 }
 
+int
+http_parser_set_header_scanner(enum http_header_scanner scanner) {
+  find_cr_or_lf_fn fn = NULL;
+
+  if (scanner == HTTP_HEADER_SCANNER_AUTO) {
+    scanner = best_header_scanner();
+  }
+  if (scanner != HTTP_HEADER_SCANNER_NONE) {
+    fn = find_cr_or_lf_for(scanner);
+    if (fn == NULL) {
+      return 0;
+    }
+  }
+  header_scanner = scanner;
+  find_cr_or_lf = fn;
+  return 1;
+}
+
+enum http_header_scanner
+http_parser_get_header_scanner(void) {
+  return header_scanner;
+}
+
 int
 http_body_is_final(const struct http_parser *parser) {
     return parser->state == s_message_done;
@@ -321,6 +321,27 @@ int http_parser_parse_url(const char *buf, size_t buflen,
 /* Pause or un-pause the parser; a nonzero value pauses */
 void http_parser_pause(http_parser *parser, int paused);
 
+/* Ways in which http_parser_execute() can skip over header names and
+ * values, see http_parser_set_header_scanner().
+ */
+enum http_header_scanner
+  { HTTP_HEADER_SCANNER_NONE    /* No fast path: one byte at a time */
+  , HTTP_HEADER_SCANNER_SCALAR  /* Plain loops */
+  , HTTP_HEADER_SCANNER_SSE42   /* Scan values 16 bytes at a time */
+  , HTTP_HEADER_SCANNER_AVX2    /* Scan values 32 bytes at a time */
+  , HTTP_HEADER_SCANNER_AUTO    /* The best one that the CPU supports */
+  };
+
+/* Selects how header names and values are skipped over. The default is the
+ * best scanner that the CPU supports. This is meant for tests and benchmarks:
+ * it affects all parsers, and must not be called while any thread is parsing.
+ * Returns 0 if the scanner is not supported by this CPU or build, 1 otherwise.
+ */
+int http_parser_set_header_scanner(enum http_header_scanner scanner);
+
+/* Returns the header scanner that is in use. */
+enum http_header_scanner http_parser_get_header_scanner(void);
+
 /* Checks if this is the final chunk of the body. */
 int http_body_is_final(const http_parser *parser);
 
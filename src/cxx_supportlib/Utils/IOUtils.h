@@ -149,6 +149,8 @@ vector<string> resolveHostname(const string &hostname,
  * @param file The name of the source file that called this function,
  *             for file descriptor logging purposes.
  * @param line The line in the source file that called this function.
+ * @param reusePort If <tt>address</tt> is a TCP address, whether SO_REUSEPORT
+ *                  should be set. Otherwise this argument is ignored.
  * @return The file descriptor of the newly created server socket.
  * @throws ArgumentException The given address cannot be parsed.
  * @throws RuntimeException Something went wrong.
@@ -160,7 +162,8 @@ int createServer(const StaticString &address,
 	unsigned int backlogSize = 0,
 	bool autoDelete = true,
 	const char *file = __FILE__,
-	unsigned int line = __LINE__);
+	unsigned int line = __LINE__,
+	bool reusePort = false);
 
 /**
  * Create a new Unix server socket which is bounded to <tt>filename</tt>.
@@ -196,8 +199,12 @@ int createUnixServer(const StaticString &filename,
  * @param file The name of the source file that called this function,
  *             for file descriptor logging purposes.
  * @param line The line in the source file that called this function.
+ * @param reusePort Whether SO_REUSEPORT should be set on the socket, so that
+ *                  multiple sockets can be bound to the same address and port,
+ *                  with the kernel distributing incoming connections over them.
  * @return The file descriptor of the newly created server socket.
- * @throws SystemException Something went wrong while creating the server socket.
+ * @throws SystemException Something went wrong while creating the server socket,
+ *                         or SO_REUSEPORT is not supported.
  * @throws ArgumentException The given address cannot be parsed.
  * @throws boost::thread_interrupted A system call has been interrupted.
  * @ingroup Support
@@ -206,7 +213,8 @@ int createTcpServer(const char *address = "0.0.0.0",
 	unsigned short port = 0,
 	unsigned int backlogSize = 0,
 	const char *file = __FILE__,
-	unsigned int line = __LINE__);
+	unsigned int line = __LINE__,
+	bool reusePort = false);
 
 /**
  * Connect to a server at the given address in a blocking manner.
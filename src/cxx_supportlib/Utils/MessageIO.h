@@ -597,6 +597,41 @@ writeScalarMessage(int fd, const char *data, size_t size, unsigned long long *ti
 	writeScalarMessage(fd, StaticString(data, size), timeout);
 }
 
+/**
+ * Appends an array message to the given string, in the same format as
+ * writeArrayMessage() writes it. This allows building a batch of messages
+ * in memory and writing it with a single system call.
+ */
+inline void
+appendArrayMessage(string &output, const StaticString args[], unsigned int nargs) {
+	unsigned int i;
+	boost::uint16_t bodySize = 0;
+
+	for (i = 0; i < nargs; i++) {
+		bodySize += args[i].size() + 1;
+	}
+
+	boost::uint16_t header = htons(bodySize);
+	output.reserve(output.size() + sizeof(boost::uint16_t) + bodySize);
+	output.append((const char *) &header, sizeof(boost::uint16_t));
+	for (i = 0; i < nargs; i++) {
+		output.append(args[i].data(), args[i].size());
+		output.append(1, '\0');
+	}
+}
+
+/**
+ * Appends a scalar message to the given string, in the same format as
+ * writeScalarMessage() writes it.
+ */
+inline void
+appendScalarMessage(string &output, const StaticString &data) {
+	boost::uint32_t header = htonl(data.size());
+	output.reserve(output.size() + sizeof(boost::uint32_t) + data.size());
+	output.append((const char *) &header, sizeof(boost::uint32_t));
+	output.append(data.data(), data.size());
+}
+
 
 /**
  * Receive a file descriptor over the given Unix domain socket,
@@ -0,0 +1,147 @@
+/*
+ *  Phusion Passenger - https://www.phusionpassenger.com/
+ *  Copyright (c) 2015 Phusion Holding B.V.
+ *
+ *  "Passenger", "Phusion Passenger" and "Union Station" are registered
+ *  trademarks of Phusion Holding B.V.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ *  THE SOFTWARE.
+ */
+#ifndef _PASSENGER_READ_WRITE_LOCK_H_
+#define _PASSENGER_READ_WRITE_LOCK_H_
+
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <pthread.h>
+#include <cerrno>
+
+namespace Passenger {
+
+using namespace boost;
+
+
+/**
+ * A thin wrapper around pthread_rwlock_t which satisfies Boost's
+ * Lockable and SharedLockable concepts, so that it can be used with
+ * boost::unique_lock, boost::shared_lock and boost::condition_variable_any.
+ *
+ * Unlike boost::shared_mutex, acquiring this lock in shared mode does not
+ * involve an internal mutex and condition variable, so uncontended shared
+ * acquisitions are about as cheap as locking a plain mutex. Where supported,
+ * writers are preferred over readers so that a steady stream of readers
+ * cannot starve them.
+ */
+class ReadWriteLock: public boost::noncopyable {
+private:
+	pthread_rwlock_t rwlock;
+
+public:
+	ReadWriteLock() {
+		pthread_rwlockattr_t attr;
+		int ret;
+
+		pthread_rwlockattr_init(&attr);
+		#ifdef __GLIBC__
+			pthread_rwlockattr_setkind_np(&attr,
+				PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+		#endif
+		ret = pthread_rwlock_init(&rwlock, &attr);
+		pthread_rwlockattr_destroy(&attr);
+		if (ret != 0) {
+			boost::throw_exception(boost::thread_resource_error(ret,
+				"Cannot initialize a read-write lock"));
+		}
+	}
+
+	~ReadWriteLock() {
+		pthread_rwlock_destroy(&rwlock);
+	}
+
+	void lock() {
+		int ret;
+		do {
+			ret = pthread_rwlock_wrlock(&rwlock);
+		} while (ret == EINTR);
+		if (ret != 0) {
+			boost::throw_exception(boost::lock_error(ret,
+				"Cannot acquire a read-write lock in exclusive mode"));
+		}
+	}
+
+	bool try_lock() {
+		return pthread_rwlock_trywrlock(&rwlock) == 0;
+	}
+
+	void unlock() {
+		pthread_rwlock_unlock(&rwlock);
+	}
+
+	void lock_shared() {
+		int ret;
+		do {
+			ret = pthread_rwlock_rdlock(&rwlock);
+		} while (ret == EINTR);
+		if (ret != 0) {
+			boost::throw_exception(boost::lock_error(ret,
+				"Cannot acquire a read-write lock in shared mode"));
+		}
+	}
+
+	bool try_lock_shared() {
+		return pthread_rwlock_tryrdlock(&rwlock) == 0;
+	}
+
+	void unlock_shared() {
+		pthread_rwlock_unlock(&rwlock);
+	}
+};
+
+/** Shortcut typedefs. */
+typedef boost::lock_guard<ReadWriteLock> WriteLockGuard;
+typedef boost::unique_lock<ReadWriteLock> ScopedWriteLock;
+typedef boost::shared_lock<ReadWriteLock> ScopedReadLock;
+
+/** Nicer syntax for conditionally write-locking during construction. */
+class DynamicScopedWriteLock: public boost::unique_lock<ReadWriteLock> {
+public:
+	DynamicScopedWriteLock(ReadWriteLock &l, bool lockNow = true)
+		: boost::unique_lock<ReadWriteLock>(l, boost::defer_lock)
+	{
+		if (lockNow) {
+			lock();
+		}
+	}
+};
+
+/** Nicer syntax for conditionally read-locking during construction. */
+class DynamicScopedReadLock: public boost::shared_lock<ReadWriteLock> {
+public:
+	DynamicScopedReadLock(ReadWriteLock &l, bool lockNow = true)
+		: boost::shared_lock<ReadWriteLock>(l, boost::defer_lock)
+	{
+		if (lockNow) {
+			lock();
+		}
+	}
+};
+
+
+} // namespace Passenger
+
+#endif /* _PASSENGER_READ_WRITE_LOCK_H_ */
@@ -120,6 +120,63 @@ int generated_cache_location_part(ngx_conf_t *cf, passenger_loc_conf_t *conf) {
 	
 
 	
+		if (conf->spawn_concurrency != NGX_CONF_UNSET) {
+			end = ngx_snprintf(int_buf,
+				sizeof(int_buf) - 1,
+				"%d",
+				conf->spawn_concurrency);
+			len += sizeof("!~PASSENGER_SPAWN_CONCURRENCY: ") - 1;
+			len += end - int_buf;
+			len += sizeof("\r\n") - 1;
+		}
+	
+
+	
+		if (conf->standby_processes != NGX_CONF_UNSET) {
+			end = ngx_snprintf(int_buf,
+				sizeof(int_buf) - 1,
+				"%d",
+				conf->standby_processes);
+			len += sizeof("!~PASSENGER_STANDBY_PROCESSES: ") - 1;
+			len += end - int_buf;
+			len += sizeof("\r\n") - 1;
+		}
+	
+
+	
+		if (conf->predictive_scaling != NGX_CONF_UNSET) {
+			len += sizeof("!~PASSENGER_PREDICTIVE_SCALING: ") - 1;
+			len += conf->predictive_scaling
+				? sizeof("t\r\n") - 1
+				: sizeof("f\r\n") - 1;
+		}
+	
+
+	
+		if (conf->memory_limit != NGX_CONF_UNSET) {
+			end = ngx_snprintf(int_buf,
+				sizeof(int_buf) - 1,
+				"%d",
+				conf->memory_limit);
+			len += sizeof("!~PASSENGER_MEMORY_LIMIT: ") - 1;
+			len += end - int_buf;
+			len += sizeof("\r\n") - 1;
+		}
+	
+
+	
+		if (conf->memory_limit_recycle_percentage != NGX_CONF_UNSET) {
+			end = ngx_snprintf(int_buf,
+				sizeof(int_buf) - 1,
+				"%d",
+				conf->memory_limit_recycle_percentage);
+			len += sizeof("!~PASSENGER_MEMORY_LIMIT_RECYCLE_PERCENTAGE: ") - 1;
+			len += end - int_buf;
+			len += sizeof("\r\n") - 1;
+		}
+	
+
+	
 		if (conf->max_instances_per_app != NGX_CONF_UNSET) {
 			end = ngx_snprintf(int_buf,
 				sizeof(int_buf) - 1,
@@ -263,6 +320,14 @@ int generated_cache_location_part(ngx_conf_t *cf, passenger_loc_conf_t *conf) {
 	
 
 	
+		if (conf->routing_policy.data != NULL) {
+			len += sizeof("!~PASSENGER_ROUTING_POLICY: ") - 1;
+			len += conf->routing_policy.len;
+			len += sizeof("\r\n") - 1;
+		}
+	
+
+	
 		if (conf->request_queue_overflow_status_code != NGX_CONF_UNSET) {
 			end = ngx_snprintf(int_buf,
 				sizeof(int_buf) - 1,
@@ -446,6 +511,75 @@ if (buf == NULL) {
 	
 
 	
+		if (conf->spawn_concurrency != NGX_CONF_UNSET) {
+			pos = ngx_copy(pos,
+				"!~PASSENGER_SPAWN_CONCURRENCY: ",
+				sizeof("!~PASSENGER_SPAWN_CONCURRENCY: ") - 1);
+			end = ngx_snprintf(int_buf,
+				sizeof(int_buf) - 1,
+				"%d",
+				conf->spawn_concurrency);
+			pos = ngx_copy(pos, int_buf, end - int_buf);
+			pos = ngx_copy(pos, (const u_char *) "\r\n", sizeof("\r\n") - 1);
+		}
+	
+
+	
+		if (conf->standby_processes != NGX_CONF_UNSET) {
+			pos = ngx_copy(pos,
+				"!~PASSENGER_STANDBY_PROCESSES: ",
+				sizeof("!~PASSENGER_STANDBY_PROCESSES: ") - 1);
+			end = ngx_snprintf(int_buf,
+				sizeof(int_buf) - 1,
+				"%d",
+				conf->standby_processes);
+			pos = ngx_copy(pos, int_buf, end - int_buf);
+			pos = ngx_copy(pos, (const u_char *) "\r\n", sizeof("\r\n") - 1);
+		}
+	
+
+	
+		if (conf->predictive_scaling != NGX_CONF_UNSET) {
+			pos = ngx_copy(pos,
+				"!~PASSENGER_PREDICTIVE_SCALING: ",
+				sizeof("!~PASSENGER_PREDICTIVE_SCALING: ") - 1);
+			if (conf->predictive_scaling) {
+				pos = ngx_copy(pos, "t\r\n", sizeof("t\r\n") - 1);
+			} else {
+				pos = ngx_copy(pos, "f\r\n", sizeof("f\r\n") - 1);
+			}
+		}
+	
+
+	
+		if (conf->memory_limit != NGX_CONF_UNSET) {
+			pos = ngx_copy(pos,
+				"!~PASSENGER_MEMORY_LIMIT: ",
+				sizeof("!~PASSENGER_MEMORY_LIMIT: ") - 1);
+			end = ngx_snprintf(int_buf,
+				sizeof(int_buf) - 1,
+				"%d",
+				conf->memory_limit);
+			pos = ngx_copy(pos, int_buf, end - int_buf);
+			pos = ngx_copy(pos, (const u_char *) "\r\n", sizeof("\r\n") - 1);
+		}
+	
+
+	
+		if (conf->memory_limit_recycle_percentage != NGX_CONF_UNSET) {
+			pos = ngx_copy(pos,
+				"!~PASSENGER_MEMORY_LIMIT_RECYCLE_PERCENTAGE: ",
+				sizeof("!~PASSENGER_MEMORY_LIMIT_RECYCLE_PERCENTAGE: ") - 1);
+			end = ngx_snprintf(int_buf,
+				sizeof(int_buf) - 1,
+				"%d",
+				conf->memory_limit_recycle_percentage);
+			pos = ngx_copy(pos, int_buf, end - int_buf);
+			pos = ngx_copy(pos, (const u_char *) "\r\n", sizeof("\r\n") - 1);
+		}
+	
+
+	
 		if (conf->max_instances_per_app != NGX_CONF_UNSET) {
 			pos = ngx_copy(pos,
 				"!~PASSENGER_MAX_PROCESSES: ",
@@ -639,6 +773,18 @@ if (buf == NULL) {
 	
 
 	
+		if (conf->routing_policy.data != NULL) {
+			pos = ngx_copy(pos,
+				"!~PASSENGER_ROUTING_POLICY: ",
+				sizeof("!~PASSENGER_ROUTING_POLICY: ") - 1);
+			pos = ngx_copy(pos,
+				conf->routing_policy.data,
+				conf->routing_policy.len);
+			pos = ngx_copy(pos, (const u_char *) "\r\n", sizeof("\r\n") - 1);
+		}
+	
+
+	
 		if (conf->request_queue_overflow_status_code != NGX_CONF_UNSET) {
 			pos = ngx_copy(pos,
 				"!~PASSENGER_REQUEST_QUEUE_OVERFLOW_STATUS_CODE: ",
@@ -115,6 +115,7 @@ passenger_create_main_conf(ngx_conf_t *cf)
     conf->abort_on_startup_error = NGX_CONF_UNSET;
     conf->max_pool_size = NGX_CONF_UNSET_UINT;
     conf->pool_idle_time = NGX_CONF_UNSET_UINT;
+    conf->count_standby_processes = NGX_CONF_UNSET;
     conf->response_buffer_high_watermark = NGX_CONF_UNSET_UINT;
     conf->stat_throttle_rate = NGX_CONF_UNSET_UINT;
     conf->user_switching = NGX_CONF_UNSET;
@@ -197,6 +198,10 @@ passenger_init_main_conf(ngx_conf_t *cf, void *conf_pointer)
         conf->pool_idle_time = DEFAULT_POOL_IDLE_TIME;
     }
 
+    if (conf->count_standby_processes == NGX_CONF_UNSET) {
+        conf->count_standby_processes = 0;
+    }
+
     if (conf->response_buffer_high_watermark == NGX_CONF_UNSET_UINT) {
         conf->response_buffer_high_watermark = DEFAULT_RESPONSE_BUFFER_HIGH_WATERMARK;
     }
@@ -1505,6 +1510,13 @@ const ngx_command_t passenger_commands[] = {
       offsetof(passenger_main_conf_t, pool_idle_time),
       NULL },
 
+    { ngx_string("passenger_count_standby_processes"),
+      NGX_HTTP_MAIN_CONF | NGX_CONF_FLAG,
+      ngx_conf_set_flag_slot,
+      NGX_HTTP_MAIN_CONF_OFFSET,
+      offsetof(passenger_main_conf_t, count_standby_processes),
+      NULL },
+
     { ngx_string("passenger_response_buffer_high_watermark"),
       NGX_HTTP_MAIN_CONF | NGX_CONF_TAKE1,
       ngx_conf_set_num_slot,
@@ -46,6 +46,7 @@ typedef struct {
     ngx_flag_t   abort_on_startup_error;
     ngx_uint_t   max_pool_size;
     ngx_uint_t   pool_idle_time;
+    ngx_flag_t   count_standby_processes;
     ngx_uint_t   response_buffer_high_watermark;
     ngx_uint_t   stat_throttle_rate;
     ngx_flag_t   turbocaching;
@@ -130,6 +130,56 @@
 	NULL
 },
 
+{
+	
+	ngx_string("passenger_spawn_concurrency"),
+	NGX_HTTP_MAIN_CONF | NGX_HTTP_SRV_CONF | NGX_HTTP_LOC_CONF | NGX_HTTP_LIF_CONF | NGX_CONF_TAKE1,
+	ngx_conf_set_num_slot,
+	NGX_HTTP_LOC_CONF_OFFSET,
+	offsetof(passenger_loc_conf_t, spawn_concurrency),
+	NULL
+},
+
+{
+	
+	ngx_string("passenger_standby_processes"),
+	NGX_HTTP_MAIN_CONF | NGX_HTTP_SRV_CONF | NGX_HTTP_LOC_CONF | NGX_HTTP_LIF_CONF | NGX_CONF_TAKE1,
+	ngx_conf_set_num_slot,
+	NGX_HTTP_LOC_CONF_OFFSET,
+	offsetof(passenger_loc_conf_t, standby_processes),
+	NULL
+},
+
+{
+	
+	ngx_string("passenger_predictive_scaling"),
+	NGX_HTTP_MAIN_CONF | NGX_HTTP_SRV_CONF | NGX_HTTP_LOC_CONF | NGX_HTTP_LIF_CONF | NGX_CONF_FLAG,
+	ngx_conf_set_flag_slot,
+	NGX_HTTP_LOC_CONF_OFFSET,
+	offsetof(passenger_loc_conf_t, predictive_scaling),
+	NULL
+},
+
+{
+	
+	ngx_string("passenger_memory_limit"),
+	NGX_HTTP_MAIN_CONF | NGX_HTTP_SRV_CONF | NGX_HTTP_LOC_CONF | NGX_HTTP_LIF_CONF | NGX_CONF_TAKE1,
+	ngx_conf_set_num_slot,
+	NGX_HTTP_LOC_CONF_OFFSET,
+	offsetof(passenger_loc_conf_t, memory_limit),
+	NULL
+},
+
+{
+	
+	ngx_string("passenger_memory_limit_recycle_percentage"),
+	NGX_HTTP_MAIN_CONF | NGX_HTTP_SRV_CONF | NGX_HTTP_LOC_CONF | NGX_HTTP_LIF_CONF | NGX_CONF_TAKE1,
+	ngx_conf_set_num_slot,
+	NGX_HTTP_LOC_CONF_OFFSET,
+	offsetof(passenger_loc_conf_t, memory_limit_recycle_percentage),
+	NULL
+},
+
 {
 	
 	ngx_string("passenger_max_instances_per_app"),
@@ -430,6 +480,16 @@
 	NULL
 },
 
+{
+	
+	ngx_string("passenger_routing_policy"),
+	NGX_HTTP_MAIN_CONF | NGX_HTTP_SRV_CONF | NGX_HTTP_LOC_CONF | NGX_HTTP_LIF_CONF | NGX_CONF_TAKE1,
+	ngx_conf_set_str_slot,
+	NGX_HTTP_LOC_CONF_OFFSET,
+	offsetof(passenger_loc_conf_t, routing_policy),
+	NULL
+},
+
 {
 	
 	ngx_string("passenger_request_queue_overflow_status_code"),
@@ -550,16 +610,6 @@
 	NULL
 },
 
-{
-	
-	ngx_string("passenger_memory_limit"),
-	NGX_HTTP_MAIN_CONF | NGX_HTTP_SRV_CONF | NGX_HTTP_LOC_CONF | NGX_HTTP_LIF_CONF | NGX_CONF_TAKE1,
-	passenger_enterprise_only,
-	NGX_HTTP_LOC_CONF_OFFSET,
-	0,
-	NULL
-},
-
 {
 	
 	ngx_string("passenger_concurrency_model"),
@@ -81,12 +81,22 @@
 
 	ngx_int_t max_requests;
 
+	ngx_int_t memory_limit;
+
+	ngx_int_t memory_limit_recycle_percentage;
+
 	ngx_int_t min_instances;
 
+	ngx_int_t predictive_scaling;
+
 	ngx_int_t request_queue_overflow_status_code;
 
 	ngx_int_t socket_backlog;
 
+	ngx_int_t spawn_concurrency;
+
+	ngx_int_t standby_processes;
+
 	ngx_int_t start_timeout;
 
 	ngx_int_t sticky_sessions;
@@ -117,6 +127,8 @@
 
 	ngx_str_t restart_dir;
 
+	ngx_str_t routing_policy;
+
 	ngx_str_t ruby;
 
 	ngx_str_t spawn_method;
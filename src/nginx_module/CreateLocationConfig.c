@@ -83,6 +83,26 @@ void generated_set_conf_part(passenger_loc_conf_t  *conf) {
 	
 
 	
+		conf->spawn_concurrency = NGX_CONF_UNSET;
+	
+
+	
+		conf->standby_processes = NGX_CONF_UNSET;
+	
+
+	
+		conf->predictive_scaling = NGX_CONF_UNSET;
+	
+
+	
+		conf->memory_limit = NGX_CONF_UNSET;
+	
+
+	
+		conf->memory_limit_recycle_percentage = NGX_CONF_UNSET;
+	
+
+	
 		conf->max_instances_per_app = NGX_CONF_UNSET;
 	
 
@@ -175,6 +195,11 @@ void generated_set_conf_part(passenger_loc_conf_t  *conf) {
 	
 
 	
+		conf->routing_policy.data = NULL;
+		conf->routing_policy.len  = 0;
+	
+
+	
 		conf->request_queue_overflow_status_code = NGX_CONF_UNSET;
 	
 
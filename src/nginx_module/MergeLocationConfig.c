@@ -97,6 +97,36 @@ int generated_merge_part(passenger_loc_conf_t *conf, passenger_loc_conf_t *prev,
 	
 
 	
+		ngx_conf_merge_value(conf->spawn_concurrency,
+			prev->spawn_concurrency,
+			NGX_CONF_UNSET);
+	
+
+	
+		ngx_conf_merge_value(conf->standby_processes,
+			prev->standby_processes,
+			NGX_CONF_UNSET);
+	
+
+	
+		ngx_conf_merge_value(conf->predictive_scaling,
+			prev->predictive_scaling,
+			NGX_CONF_UNSET);
+	
+
+	
+		ngx_conf_merge_value(conf->memory_limit,
+			prev->memory_limit,
+			NGX_CONF_UNSET);
+	
+
+	
+		ngx_conf_merge_value(conf->memory_limit_recycle_percentage,
+			prev->memory_limit_recycle_percentage,
+			NGX_CONF_UNSET);
+	
+
+	
 		ngx_conf_merge_value(conf->max_instances_per_app,
 			prev->max_instances_per_app,
 			NGX_CONF_UNSET);
@@ -229,6 +259,12 @@ int generated_merge_part(passenger_loc_conf_t *conf, passenger_loc_conf_t *prev,
 	
 
 	
+		ngx_conf_merge_str_value(conf->routing_policy,
+			prev->routing_policy,
+			NULL);
+	
+
+	
 		ngx_conf_merge_value(conf->request_queue_overflow_status_code,
 			prev->request_queue_overflow_status_code,
 			NGX_CONF_UNSET);
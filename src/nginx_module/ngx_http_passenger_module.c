@@ -275,6 +275,7 @@ start_watchdog(ngx_cycle_t *cycle) {
     psg_variant_map_set_ngx_str(params, "default_ruby", &passenger_main_conf.default_ruby);
     psg_variant_map_set_int    (params, "max_pool_size", passenger_main_conf.max_pool_size);
     psg_variant_map_set_int    (params, "pool_idle_time", passenger_main_conf.pool_idle_time);
+    psg_variant_map_set_bool   (params, "count_standby_processes", passenger_main_conf.count_standby_processes);
     psg_variant_map_set_int    (params, "response_buffer_high_watermark", passenger_main_conf.response_buffer_high_watermark);
     psg_variant_map_set_int    (params, "stat_throttle_rate", passenger_main_conf.stat_throttle_rate);
     psg_variant_map_set_ngx_str(params, "analytics_log_user", &passenger_main_conf.analytics_log_user);
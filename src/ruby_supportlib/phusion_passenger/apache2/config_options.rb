@@ -90,6 +90,40 @@
     :header  => "PASSENGER_MIN_PROCESSES",
     :desc => "The minimum number of application instances to keep when cleaning idle instances."
   },
+  {
+    :name => "PassengerSpawnConcurrency",
+    :type => :integer,
+    :context => ["OR_LIMIT", "ACCESS_CONF", "RSRC_CONF"],
+    :min_value => 1,
+    :desc => "The maximum number of application instances that may be spawned at the same time."
+  },
+  {
+    :name => "PassengerStandbyProcesses",
+    :type => :integer,
+    :context => ["OR_LIMIT", "ACCESS_CONF", "RSRC_CONF"],
+    :min_value => 0,
+    :desc => "The number of spawned application instances to keep on standby."
+  },
+  {
+    :name => "PassengerPredictiveScaling",
+    :type => :flag,
+    :context => ["OR_LIMIT", "ACCESS_CONF", "RSRC_CONF"],
+    :desc => "Whether to spawn and retire application instances ahead of predicted demand."
+  },
+  {
+    :name => "PassengerMemoryLimit",
+    :type => :integer,
+    :context => ["OR_LIMIT", "ACCESS_CONF", "RSRC_CONF"],
+    :min_value => 0,
+    :desc => "The maximum amount of memory in MB that an application instance may use."
+  },
+  {
+    :name => "PassengerMemoryLimitRecyclePercentage",
+    :type => :integer,
+    :context => ["OR_LIMIT", "ACCESS_CONF", "RSRC_CONF"],
+    :min_value => 1,
+    :desc => "The maximum percentage of application instances that may be recycled at the same time because of the memory limit."
+  },
   {
     :name => "PassengerMaxInstancesPerApp",
     :type => :integer,
@@ -151,6 +185,12 @@
     :context   => ["OR_ALL"],
     :desc      => "The maximum number of queued requests."
   },
+  {
+    :name    => "PassengerRoutingPolicy",
+    :type    => :string,
+    :context => ["OR_ALL"],
+    :desc    => "The policy that decides which application process a request is routed to."
+  },
   {
     :name      => "PassengerMaxPreloaderIdleTime",
     :type      => :integer,
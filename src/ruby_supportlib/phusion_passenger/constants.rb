@@ -55,6 +55,9 @@ module SharedConstants
     DEFAULT_WEB_APP_USER = "nobody"
     DEFAULT_APP_ENV = "production"
     DEFAULT_SPAWN_METHOD = "smart"
+    DEFAULT_SPAWN_CONCURRENCY = 1
+    DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE = 25
+    DEFAULT_ROUTING_POLICY = "least-busy"
     # Apache's unixd.h also defines DEFAULT_USER, so we avoid naming clash here.
     PASSENGER_DEFAULT_USER = "nobody"
     DEFAULT_CONCURRENCY_MODEL = "process"
@@ -63,6 +66,8 @@ module SharedConstants
     DEFAULT_RESPONSE_BUFFER_HIGH_WATERMARK = 1024 * 1024 * 128
     DEFAULT_MAX_REQUEST_QUEUE_SIZE = 100
     DEFAULT_STAT_THROTTLE_RATE = 10
+    DEFAULT_TURBOCACHE_MAX_ENTRIES = 1024
+    DEFAULT_TURBOCACHE_MAX_SIZE = 1024 * 1024 * 16
     DEFAULT_ANALYTICS_LOG_USER = DEFAULT_WEB_APP_USER
     DEFAULT_ANALYTICS_LOG_GROUP = ""
     DEFAULT_ANALYTICS_LOG_PERMISSIONS = "u=rwx,g=rx,o=rx"
@@ -75,13 +80,16 @@ module SharedConstants
     MESSAGE_SERVER_MAX_USERNAME_SIZE = 100
     MESSAGE_SERVER_MAX_PASSWORD_SIZE = 100
     POOL_HELPER_THREAD_STACK_SIZE = 1024 * 256
+    APP_CONNECTION_CACHE_SLOTS = 16
     DEFAULT_MBUF_CHUNK_SIZE = 16 * 32
+    DEFAULT_MBUF_SPARE_MEMORY_HIGH_WATER_MARK = 1024 * 1024 * 8
     DEFAULT_FILE_BUFFERED_CHANNEL_THRESHOLD = 1024 * 128
     SERVER_KIT_MAX_SERVER_ENDPOINTS = 4
 
     # Time limits
     PROCESS_SHUTDOWN_TIMEOUT = 60 # In seconds
     PROCESS_SHUTDOWN_TIMEOUT_DISPLAY = "1 minute"
+    APP_CONNECTION_IDLE_TIMEOUT = 60 # In seconds
 
     # Versions
     PASSENGER_VERSION = PhusionPassenger::VERSION_STRING
@@ -131,6 +131,26 @@
     :type   => :integer,
     :header => 'PASSENGER_MIN_PROCESSES'
   },
+  {
+    :name   => 'passenger_spawn_concurrency',
+    :type   => :integer
+  },
+  {
+    :name   => 'passenger_standby_processes',
+    :type   => :integer
+  },
+  {
+    :name   => 'passenger_predictive_scaling',
+    :type   => :flag
+  },
+  {
+    :name   => 'passenger_memory_limit',
+    :type   => :integer
+  },
+  {
+    :name   => 'passenger_memory_limit_recycle_percentage',
+    :type   => :integer
+  },
   {
     :name     => 'passenger_max_instances_per_app',
     :context  => [:main],
@@ -283,6 +303,10 @@
     :name  => 'passenger_max_request_queue_size',
     :type  => :integer
   },
+  {
+    :name  => 'passenger_routing_policy',
+    :type  => :string
+  },
   {
     :name  => 'passenger_request_queue_overflow_status_code',
     :type  => :integer
@@ -342,12 +366,6 @@
     :function => 'passenger_enterprise_only',
     :field    => nil
   },
-  {
-    :name     => 'passenger_memory_limit',
-    :type     => :integer,
-    :function => 'passenger_enterprise_only',
-    :field    => nil
-  },
   {
     :name     => 'passenger_concurrency_model',
     :type     => :string,
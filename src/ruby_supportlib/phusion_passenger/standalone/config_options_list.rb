@@ -116,6 +116,13 @@ module Standalone
         :desc      => "Override size of the socket backlog.\n" \
                       "Default: #{DEFAULT_SOCKET_BACKLOG}"
       },
+      {
+        :name      => :reuse_port,
+        :type      => :boolean,
+        :desc      => "Give every server thread its own\n" \
+                      "SO_REUSEPORT socket (Builtin engine\n" \
+                      'only)'
+      },
       {
         :name      => :ssl,
         :type      => :boolean,
@@ -316,6 +323,53 @@ module Standalone
         :desc      => "Minimum number of processes per\n" \
                       'application. Default: 1'
       },
+      {
+        :name      => :spawn_concurrency,
+        :type      => :integer,
+        :min       => 1,
+        :desc      => "Maximum number of processes per application\n" \
+                      "that may be spawned at the same time.\n" \
+                      "Default: #{DEFAULT_SPAWN_CONCURRENCY}"
+      },
+      {
+        :name      => :standby_processes,
+        :type      => :integer,
+        :min       => 0,
+        :desc      => "Number of spawned processes per application\n" \
+                      "to keep on standby, ready to handle\n" \
+                      "requests when more capacity is needed.\n" \
+                      'Default: 0'
+      },
+      {
+        :name      => :predictive_scaling,
+        :type      => :boolean,
+        :desc      => "Spawn and retire processes ahead of the\n" \
+                      "demand predicted from the request\n" \
+                      'arrival rate'
+      },
+      {
+        :name      => :memory_limit,
+        :type      => :integer,
+        :type_desc => 'MB',
+        :min       => 0,
+        :desc      => "Restart application processes that go over\n" \
+                      "the given memory limit"
+      },
+      {
+        :name      => :memory_limit_recycle_percentage,
+        :type      => :integer,
+        :min       => 1,
+        :desc      => "Maximum percentage of an application's\n" \
+                      "processes that may be restarted at the\n" \
+                      "same time because of the memory limit.\n" \
+                      "Default: #{DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE}"
+      },
+      {
+        :name      => :count_standby_processes,
+        :type      => :boolean,
+        :desc      => "Count standby processes towards the\n" \
+                      'maximum pool size'
+      },
       {
         :name      => :pool_idle_time,
         :type      => :integer,
@@ -352,13 +406,6 @@ module Standalone
                       "the 'thread' concurrency model (Enterprise\n" \
                       "only). Default: #{DEFAULT_APP_THREAD_COUNT}"
       },
-      {
-        :name      => :memory_limit,
-        :type      => :integer,
-        :type_desc => 'MB',
-        :desc      => "Restart application processes that go over\n" \
-                      "the given memory limit (Enterprise only)"
-      },
       {
         :name      => :rolling_restarts,
         :type      => :boolean,
@@ -388,6 +435,13 @@ module Standalone
         :min       => 0,
         :desc      => "Specify request queue size. Default: #{DEFAULT_MAX_REQUEST_QUEUE_SIZE}"
       },
+      {
+        :name      => :routing_policy,
+        :type_desc => 'NAME',
+        :desc      => "How to pick the process that handles a\n" \
+                      "request: 'least-busy', 'power-of-two-choices'\n" \
+                      "or 'ewma-latency'. Default: #{DEFAULT_ROUTING_POLICY}"
+      },
       {
         :name      => :sticky_sessions,
         :type      => :boolean,
@@ -418,6 +472,26 @@ module Standalone
           options[:turbocaching] = false
         end
       },
+      {
+        :name      => :turbocache_max_entries,
+        :type      => :integer,
+        :type_desc => 'NUMBER',
+        :desc      => "Maximum number of entries in each\n" \
+                      "turbocache. Default: #{DEFAULT_TURBOCACHE_MAX_ENTRIES}"
+      },
+      {
+        :name      => :turbocache_max_size,
+        :type      => :integer,
+        :type_desc => 'BYTES',
+        :desc      => "Maximum memory usage of each turbocache.\n" \
+                      "Default: #{DEFAULT_TURBOCACHE_MAX_SIZE}"
+      },
+      {
+        :name      => :shared_turbocache,
+        :type      => :boolean,
+        :desc      => "Use a single turbocache for all core\n" \
+                      "threads instead of one per thread"
+      },
       {
         :name      => :unlimited_concurrency_paths,
         :type      => :array,
@@ -131,6 +131,7 @@ def build_daemon_controller_options
           command << " --listen #{listen_address(@apps[0])}"
           command << " --no-graceful-exit"
           add_param(command, :socket_backlog, "--socket-backlog")
+          add_flag_param(command, :reuse_port, "--reuse-port")
           add_param(command, :environment, "--environment")
           add_param(command, :app_type, "--app-type")
           add_param(command, :startup_file, "--startup-file")
@@ -146,6 +147,9 @@ def build_daemon_controller_options
           if @options[:turbocaching] == false
             command << " --disable-turbocaching"
           end
+          add_param(command, :turbocache_max_entries, "--turbocache-max-entries")
+          add_param(command, :turbocache_max_size, "--turbocache-max-size")
+          add_flag_param(command, :shared_turbocache, "--shared-turbocache")
           if @options[:abort_websockets_on_process_shutdown] == false
             command << " --no-abort-websockets-on-process-shutdown"
           end
@@ -153,13 +157,19 @@ def build_daemon_controller_options
           add_flag_param(command, :load_shell_envvars, "--load-shell-envvars")
           add_param(command, :max_pool_size, "--max-pool-size")
           add_param(command, :min_instances, "--min-instances")
+          add_param(command, :spawn_concurrency, "--spawn-concurrency")
+          add_param(command, :standby_processes, "--standby-processes")
+          add_flag_param(command, :predictive_scaling, "--predictive-scaling")
+          add_param(command, :memory_limit, "--memory-limit")
+          add_param(command, :memory_limit_recycle_percentage, "--memory-limit-recycle-percentage")
+          add_flag_param(command, :count_standby_processes, "--count-standby-processes")
           add_param(command, :pool_idle_time, "--pool-idle-time")
           add_param(command, :max_preloader_idle_time, "--max-preloader-idle-time")
           add_param(command, :max_request_queue_size, "--max-request-queue-size")
+          add_param(command, :routing_policy, "--routing-policy")
           add_enterprise_param(command, :concurrency_model, "--concurrency-model")
           add_enterprise_param(command, :thread_count, "--app-thread-count")
           add_enterprise_param(command, :max_request_time, "--max-request-time")
-          add_enterprise_param(command, :memory_limit, "--memory-limit")
           add_enterprise_flag_param(command, :rolling_restarts, "--rolling-restarts")
           add_enterprise_flag_param(command, :resist_deployment_errors, "--resist-deployment-errors")
           add_enterprise_flag_param(command, :debugger, "--debugger")
@@ -5,6 +5,7 @@
 #include <Utils/StrIntUtils.h>
 #include <MessageReadersWriters.h>
 #include <map>
+#include <set>
 #include <vector>
 #include <cerrno>
 #include <signal.h>
@@ -205,7 +206,7 @@ namespace tut {
 		// as the new process is done spawning.
 		Options options = createOptions();
 
-		ScopedLock l(pool->syncher);
+		ScopedWriteLock l(pool->syncher);
 		pool->asyncGet(options, callback, false);
 		ensure_equals(number, 0);
 		ensure(pool->getWaitlist.empty());
@@ -238,7 +239,7 @@ namespace tut {
 		ensure(!process->isTotallyBusy());
 
 		// Verify test assertion.
-		ScopedLock l(pool->syncher);
+		ScopedWriteLock l(pool->syncher);
 		pool->asyncGet(options, callback, false);
 		ensure_equals("callback is immediately called", number, 2);
 	}
@@ -359,7 +360,7 @@ namespace tut {
 
 		// Now open another session. It should complete immediately
 		// and should not use the first process.
-		ScopedLock l(pool->syncher);
+		ScopedWriteLock l(pool->syncher);
 		pool->asyncGet(options, callback, false);
 		ensure_equals("asyncGet() completed immediately", number, 2);
 		SessionPtr session2 = currentSession;
@@ -392,7 +393,7 @@ namespace tut {
 		GroupPtr group = pool->findOrCreateGroup(options);
 		spawningKitConfig->concurrency = 2;
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			group->spawn();
 		}
 		EVENTUALLY(5,
@@ -511,7 +512,7 @@ namespace tut {
 		);
 
 		// The next asyncGet() should spawn a new process and the action should be queued.
-		ScopedLock l(pool->syncher);
+		ScopedWriteLock l(pool->syncher);
 		spawningKitConfig->spawnTime = 5000000;
 		pool->asyncGet(options, callback, false);
 		ensure(group->spawning());
@@ -812,7 +813,7 @@ namespace tut {
 		SystemTime::force(2);
 		GroupPtr barGroup = pool->get(options2, &ticket)->getGroup()->shared_from_this();
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals("(1)", barGroup->spawn(), SR_OK);
 		}
 		debug->debugger->recv("Begin spawn loop iteration 1");
@@ -835,7 +836,7 @@ namespace tut {
 		debug->messages->send("Proceed with spawn loop iteration 2");
 		debug->debugger->recv("Spawn loop done");
 		EVENTUALLY(5,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			vector<ProcessPtr> processes = pool->getProcesses(false);
 			if (processes.size() == 1) {
 				GroupPtr group = processes[0]->getGroup()->shared_from_this();
@@ -897,7 +898,7 @@ namespace tut {
 		debug->messages->send("Proceed with spawn loop iteration 2");
 		debug->debugger->recv("Spawn loop done");
 		EVENTUALLY(5,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			vector<ProcessPtr> processes = pool->getProcesses(false);
 			if (processes.size() == 1) {
 				GroupPtr group = processes[0]->getGroup()->shared_from_this();
@@ -932,7 +933,7 @@ namespace tut {
 		ProcessPtr process = currentSession->getProcess()->shared_from_this();
 		pool->detachProcess(process);
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure(process->enabled == Process::DETACHED);
 		}
 		EVENTUALLY(5,
@@ -963,13 +964,13 @@ namespace tut {
 		pool->asyncGet(options, callback);
 
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals(pool->groups.lookupCopy("test")->getWaitlist.size(), 1u);
 		}
 
 		pool->detachProcess(session1->getProcess()->shared_from_this());
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure(pool->groups.lookupCopy("test")->spawning());
 			ensure_equals(pool->groups.lookupCopy("test")->enabledCount, 0);
 			ensure_equals(pool->groups.lookupCopy("test")->getWaitlist.size(), 1u);
@@ -1001,7 +1002,7 @@ namespace tut {
 		spawningKitConfig->spawnTime = 90000;
 		pool->asyncGet(options2, callback);
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals(pool->getWaitlist.size(), 1u);
 		}
 
@@ -1014,7 +1015,7 @@ namespace tut {
 		currentSession.reset();
 		pool->detachProcess(session1->getProcess()->shared_from_this());
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure(pool->groups.lookupCopy("test2") != NULL);
 			ensure_equals(pool->getWaitlist.size(), 0u);
 		}
@@ -1035,7 +1036,7 @@ namespace tut {
 		currentSession.reset();
 		GroupPtr group = process->getGroup()->shared_from_this();
 		pool->detachProcess(process);
-		LockGuard l(pool->syncher);
+		WriteLockGuard l(pool->syncher);
 		ensure_equals(pool->groups.size(), 1u);
 		ensure(group->isAlive());
 		ensure(!group->garbageCollectable());
@@ -1052,18 +1053,18 @@ namespace tut {
 
 		ensure(pool->detachProcess(process));
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals(process->enabled, Process::DETACHED);
 		}
 		SHOULD_NEVER_HAPPEN(100,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			result = !process->isAlive()
 				|| !process->osProcessExists();
 		);
 
 		session.reset();
 		EVENTUALLY(1,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			result = process->enabled == Process::DETACHED
 				&& !process->osProcessExists()
 				&& process->isDead();
@@ -1083,7 +1084,7 @@ namespace tut {
 
 		ensure(pool->detachProcess(process));
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals(process->enabled, Process::DETACHED);
 		}
 		EVENTUALLY(1,
@@ -1091,7 +1092,7 @@ namespace tut {
 		);
 
 		SHOULD_NEVER_HAPPEN(100,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			result = process->isDead()
 				|| !process->osProcessExists();
 		);
@@ -1100,7 +1101,7 @@ namespace tut {
 		g.clear();
 
 		EVENTUALLY(1,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			result = process->enabled == Process::DETACHED
 				&& !process->osProcessExists()
 				&& process->isDead();
@@ -1130,7 +1131,7 @@ namespace tut {
 		pool->detachProcess(process);
 		debug->debugger->recv("About to start detached processes checker");
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure(process->enabled == Process::DETACHED);
 		}
 
@@ -1162,7 +1163,7 @@ namespace tut {
 		ensure_equals("Disabling succeeds",
 			pool->disableProcess(processes[0]->getGupid()), DR_SUCCESS);
 
-		LockGuard l(pool->syncher);
+		WriteLockGuard l(pool->syncher);
 		ensure(processes[0]->isAlive());
 		ensure_equals("Process is disabled",
 			processes[0]->enabled,
@@ -1236,7 +1237,7 @@ namespace tut {
 		TempThread thr2(boost::bind(&Core_ApplicationPool_PoolTest::disableProcess,
 			this, process2, &code2));
 		EVENTUALLY(5,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			result = group->enabledCount == 0
 				&& group->disablingCount == 2
 				&& group->disabledCount == 0;
@@ -1255,7 +1256,7 @@ namespace tut {
 			result = code2 == DR_SUCCESS;
 		);
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals(group->enabledCount, 1);
 			ensure_equals(group->disablingCount, 0);
 			ensure_equals(group->disabledCount, 2);
@@ -1283,7 +1284,7 @@ namespace tut {
 			this, session2->getProcess()->shared_from_this(), &code2));
 		EVENTUALLY(2,
 			GroupPtr group = session1->getGroup()->shared_from_this();
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			result = group->enabledCount == 0
 				&& group->disablingCount == 2
 				&& group->disabledCount == 0;
@@ -1302,7 +1303,7 @@ namespace tut {
 		);
 		{
 			GroupPtr group = session1->getGroup()->shared_from_this();
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals(group->enabledCount, 2);
 			ensure_equals(group->disablingCount, 0);
 			ensure_equals(group->disabledCount, 0);
@@ -1361,7 +1362,7 @@ namespace tut {
 		ensure_equals(result, DR_SUCCESS);
 
 		{
-			ScopedLock l(pool->syncher);
+			ScopedWriteLock l(pool->syncher);
 			GroupPtr group = processes[0]->getGroup()->shared_from_this();
 			ensure_equals(group->enabledCount, 1);
 			ensure_equals(group->disablingCount, 0);
@@ -1909,7 +1910,7 @@ namespace tut {
 		}
 		ensure_equals(number, 0);
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals(group->getWaitlist.size(),
 				3u);
 		}
@@ -1999,6 +2000,736 @@ namespace tut {
 		currentSession.reset();
 	}
 
+	TEST_METHOD(80) {
+		// The routing policy is selected through Options::routingPolicy.
+		Options options = createOptions();
+		GroupPtr group = pool->findOrCreateGroup(options);
+		ensure_equals("Default policy", group->routingPolicy->getName().toString(), "least-busy");
+
+		options = createOptions();
+		options.appGroupName = "test2";
+		options.routingPolicy = "ewma-latency";
+		group = pool->findOrCreateGroup(options);
+		ensure_equals(group->routingPolicy->getName().toString(), "ewma-latency");
+
+		options = createOptions();
+		options.appGroupName = "test3";
+		options.routingPolicy = "foo";
+		setLogLevel(LVL_ERROR);
+		group = pool->findOrCreateGroup(options);
+		ensure_equals("Unknown policies fall back to the default",
+			group->routingPolicy->getName().toString(), "least-busy");
+	}
+
+	TEST_METHOD(81) {
+		// The power-of-two-choices policy never routes to a totally busy process
+		// as long as there are processes that aren't.
+		Options options = createOptions();
+		options.minProcesses = 4;
+		options.routingPolicy = "power-of-two-choices";
+		pool->setMax(4);
+		GroupPtr group = pool->findOrCreateGroup(options);
+		spawningKitConfig->concurrency = 1;
+		{
+			WriteLockGuard l(pool->syncher);
+			group->spawn();
+		}
+		EVENTUALLY(5,
+			result = pool->getProcessCount() == 4;
+		);
+
+		set<ProcessPtr> processes;
+		vector<SessionPtr> checkedOutSessions;
+		for (int i = 0; i < 4; i++) {
+			pool->asyncGet(options, callback);
+			ensure_equals(number, i + 1);
+			checkedOutSessions.push_back(currentSession);
+			processes.insert(currentSession->getProcess()->shared_from_this());
+			currentSession.reset();
+		}
+		ensure_equals("All processes got a request", processes.size(), 4u);
+
+		// All processes are now totally busy, so the next request is queued.
+		pool->asyncGet(options, callback);
+		SHOULD_NEVER_HAPPEN(100,
+			result = number > 4;
+		);
+		checkedOutSessions.pop_back();
+		EVENTUALLY(5,
+			result = number == 5;
+		);
+	}
+
+	TEST_METHOD(82) {
+		// The ewma-latency policy prefers processes with a lower response time
+		// average, and response times reported by sessions update the average.
+		Options options = createOptions();
+		options.minProcesses = 2;
+		options.routingPolicy = "ewma-latency";
+		pool->setMax(2);
+		GroupPtr group = pool->findOrCreateGroup(options);
+		spawningKitConfig->concurrency = 4;
+		{
+			WriteLockGuard l(pool->syncher);
+			group->spawn();
+		}
+		EVENTUALLY(5,
+			result = pool->getProcessCount() == 2;
+		);
+
+		ProcessPtr fast, slow;
+		{
+			WriteLockGuard l(pool->syncher);
+			fast = group->enabledProcesses[1];
+			slow = group->enabledProcesses[0];
+			fast->responseTimeEwma = 1000;
+			slow->responseTimeEwma = 100000;
+		}
+
+		vector<SessionPtr> checkedOutSessions;
+		for (int i = 0; i < 3; i++) {
+			pool->asyncGet(options, callback);
+			ensure_equals(number, i + 1);
+			ensure("Request goes to the fast process",
+				currentSession->getProcess() == fast.get());
+			checkedOutSessions.push_back(currentSession);
+			currentSession.reset();
+		}
+
+		checkedOutSessions[0]->reportResponseTime(5000);
+		checkedOutSessions.clear();
+		WriteLockGuard l(pool->syncher);
+		ensure_equals(fast->responseTimeEwma, (1000u * 3 + 5000) / 4);
+		ensure_equals(slow->responseTimeEwma, 100000u);
+	}
+
+	static void checkOutAndCloseSessions(Pool *pool, Options options, unsigned int count) {
+		Ticket ticket;
+		for (unsigned int i = 0; i < count; i++) {
+			pool->get(options, &ticket).reset();
+		}
+	}
+
+	TEST_METHOD(83) {
+		// Checking out and closing sessions from multiple threads at the same
+		// time, which mostly happens while holding the pool lock in shared mode
+		// only, keeps the statistics consistent.
+		Options options = createOptions();
+		options.minProcesses = 2;
+		pool->setMax(2);
+		GroupPtr group = pool->findOrCreateGroup(options);
+		spawningKitConfig->concurrency = 0;
+		{
+			WriteLockGuard l(pool->syncher);
+			group->spawn();
+		}
+		EVENTUALLY(5,
+			result = pool->getProcessCount() == 2;
+		);
+
+		boost::thread_group threads;
+		for (int i = 0; i < 4; i++) {
+			threads.create_thread(boost::bind(checkOutAndCloseSessions,
+				pool.get(), options.copyAndPersist(), 250));
+		}
+		threads.join_all();
+
+		WriteLockGuard l(pool->syncher);
+		ensure_equals(group->enabledCount, 2);
+		ensure_equals(group->nEnabledProcessesTotallyBusy, 0);
+		unsigned int processed = 0;
+		for (unsigned int i = 0; i < 2; i++) {
+			const ProcessPtr &process = group->enabledProcesses[i];
+			ensure_equals(process->sessions, 0);
+			ensure_equals(group->enabledProcessBusynessLevels.get(i), 0);
+			processed += process->processed;
+		}
+		ensure_equals(processed, 1000u);
+	}
+
+	TEST_METHOD(84) {
+		// With a spawn concurrency greater than 1, a group spawns multiple
+		// processes at the same time, within the pool's capacity, and it
+		// records how long the spawns took.
+		Options options = createOptions();
+		options.minProcesses = 6;
+		options.spawnConcurrency = 4;
+		pool->setMax(5);
+		spawningKitConfig->spawnTime = 300000;
+		GroupPtr group = pool->findOrCreateGroup(options);
+		unsigned long long startTime = SystemTime::getUsec();
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->spawn(), SR_OK);
+			ensure_equals(group->spawnLoopsActive, 4);
+			ensure_equals(group->processesBeingSpawned, 4);
+			ensure_equals("No more loops than the spawn concurrency",
+				group->spawn(), SR_IN_PROGRESS);
+			ensure_equals(group->spawnLoopsActive, 4);
+		}
+		EVENTUALLY(5,
+			result = pool->getProcessCount() == 5;
+		);
+		ensure("Processes were spawned in parallel",
+			SystemTime::getUsec() - startTime < 5 * 300000);
+
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = !group->spawning();
+		);
+		WriteLockGuard l(pool->syncher);
+		ensure_equals(group->spawnLoopsActive, 0);
+		ensure_equals(group->processesBeingSpawned, 0);
+		ensure_equals(group->spawnsCompleted, 5u);
+		ensure(group->maxSpawnTime >= 300000);
+		ensure(group->totalSpawnTime >= 5 * 300000);
+		unsigned int histogramTotal = 0;
+		for (unsigned int i = 0; i < Group::SPAWN_LATENCY_HISTOGRAM_BUCKETS; i++) {
+			histogramTotal += group->spawnLatencyHistogram[i];
+		}
+		ensure_equals(histogramTotal, 5u);
+		ensure_equals("Spawns that took less than 300 ms",
+			group->spawnLatencyHistogram[0] + group->spawnLatencyHistogram[1], 0u);
+
+		stringstream xml;
+		group->inspectXml(xml);
+		ensure(containsSubstring(xml.str(), "<spawns_completed>5</spawns_completed>"));
+	}
+
+	TEST_METHOD(86) {
+		// A group keeps standby processes, which don't count towards the
+		// pool's capacity. When all enabled processes are busy, a standby
+		// process is promoted instead of spawning a new one, and the group
+		// spawns a replacement standby process.
+		Options options = createOptions();
+		options.standbyProcesses = 2;
+		retainSessions = true;
+		pool->setMax(3);
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			result = number == 1;
+		);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = group->standbyCount == 2 && !group->spawning();
+		);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->enabledCount, 1);
+			ensure_equals(group->capacityUsed(), 1u);
+			ensure_equals(pool->getProcessCount(false), 1u);
+			ensure_equals(pool->getProcesses(false).size(), 3u);
+		}
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			result = number == 2;
+		);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->enabledCount, 2);
+			ensure_equals(group->standbyPromotions, 1u);
+		}
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = group->standbyCount == 2 && !group->spawning();
+		);
+
+		// The third process fills up the pool, so no replacement
+		// can be spawned after this promotion.
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			result = number == 3;
+		);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = !group->spawning();
+		);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->enabledCount, 3);
+			ensure_equals(group->standbyCount, 1);
+			ensure(pool->atFullCapacityUnlocked());
+		}
+
+		// The remaining standby process may not be promoted because
+		// that would exceed the pool's capacity.
+		pool->asyncGet(options, callback);
+		SHOULD_NEVER_HAPPEN(100,
+			result = number > 3;
+		);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->getWaitlist.size(), 1u);
+			ensure_equals(group->standbyCount, 1);
+		}
+
+		retainSessions = false;
+		clearAllSessions();
+		EVENTUALLY(5,
+			result = number == 4;
+		);
+		clearAllSessions();
+	}
+
+	TEST_METHOD(87) {
+		// When standby processes count towards the pool's capacity, they
+		// can be promoted even if the pool is full. A detached standby
+		// process is replaced.
+		Options options = createOptions();
+		options.standbyProcesses = 1;
+		retainSessions = true;
+		pool->setCountStandbyProcesses(true);
+		pool->setMax(2);
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = number == 1 && group->standbyCount == 1 && !group->spawning();
+		);
+		string gupid;
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->capacityUsed(), 2u);
+			ensure(pool->atFullCapacityUnlocked());
+			ensure(group->processLowerLimitsSatisfied());
+			gupid = group->standbyProcesses.back()->getGupid().toString();
+		}
+
+		ensure(pool->detachProcess(gupid));
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = group->standbyCount == 1 && !group->spawning();
+		);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure(group->standbyProcesses.back()->getGupid() != gupid);
+		}
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			result = number == 2;
+		);
+		WriteLockGuard l(pool->syncher);
+		ensure_equals(group->enabledCount, 2);
+		ensure_equals(group->standbyCount, 0);
+		ensure_equals(group->capacityUsed(), 2u);
+	}
+
+	TEST_METHOD(88) {
+		// When predictive scaling is on and the arrival rate is rising, the
+		// demand forecaster spawns a process before the get wait list fills
+		// up. The decision is shown in the group's XML.
+		Options options = createOptions();
+		options.predictiveScaling = true;
+		retainSessions = true;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = number == 1 && !group->spawning();
+		);
+
+		unsigned long long now = SystemTime::getUsec();
+		unsigned long long received;
+		{
+			WriteLockGuard l(pool->syncher);
+			received = group->getActionsReceived;
+		}
+		pool->realForecastDemand(now);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->lastDemandForecastDecision, Group::DFD_NONE);
+			group->getActionsReceived = received + 50;
+		}
+		pool->realForecastDemand(now + 5000000);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->predictedProcesses, 1u);
+			ensure_equals(group->lastDemandForecastDecision, Group::DFD_HOLD);
+			group->getActionsReceived = received + 200;
+		}
+		pool->realForecastDemand(now + 10000000);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure(group->predictedArrivalRate > group->arrivalRate);
+			ensure_equals(group->predictedProcesses, 2u);
+			ensure_equals(group->lastDemandForecastDecision, Group::DFD_SPAWN);
+			ensure_equals(group->predictiveSpawns, 1u);
+			ensure_equals(group->getMinProcessesToKeep(), 2u);
+			ensure(group->getWaitlist.empty());
+		}
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = group->enabledCount == 2 && !group->spawning();
+		);
+
+		stringstream stream;
+		{
+			WriteLockGuard l(pool->syncher);
+			group->inspectXml(stream);
+		}
+		ensure(containsSubstring(stream.str(), "<predicted_processes>2</predicted_processes>"));
+		ensure(containsSubstring(stream.str(), "<last_decision>SPAWN</last_decision>"));
+
+		retainSessions = false;
+		clearAllSessions();
+	}
+
+	TEST_METHOD(89) {
+		// When predictive scaling is on and the arrival rate is falling, the
+		// demand forecaster retires one idle process per forecast, but leaves
+		// the last process to the garbage collector.
+		Options options = createOptions();
+		options.predictiveScaling = true;
+		retainSessions = true;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		for (int i = 1; i <= 3; i++) {
+			pool->asyncGet(options, callback);
+			EVENTUALLY(5,
+				result = number == i;
+			);
+		}
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->enabledCount, 3);
+		}
+		retainSessions = false;
+		clearAllSessions();
+
+		unsigned long long now = SystemTime::getUsec() + 20000000;
+		unsigned long long received;
+		{
+			WriteLockGuard l(pool->syncher);
+			received = group->getActionsReceived;
+		}
+		pool->realForecastDemand(now);
+		{
+			WriteLockGuard l(pool->syncher);
+			group->getActionsReceived = received + 100;
+		}
+		pool->realForecastDemand(now + 5000000);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->predictedProcesses, 1u);
+			ensure_equals(group->lastDemandForecastDecision, Group::DFD_RETIRE);
+			ensure_equals(group->enabledCount, 2);
+			group->getActionsReceived = received + 150;
+		}
+		pool->realForecastDemand(now + 10000000);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->lastDemandForecastDecision, Group::DFD_RETIRE);
+			ensure_equals(group->enabledCount, 1);
+		}
+		pool->realForecastDemand(now + 15000000);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->lastDemandForecastDecision, Group::DFD_HOLD);
+			ensure_equals(group->enabledCount, 1);
+			ensure_equals(group->predictiveRetirements, 2u);
+		}
+	}
+
+	TEST_METHOD(90) {
+		// When predictive scaling is off, the forecast is made but no
+		// processes are spawned or retired because of it.
+		Options options = createOptions();
+		retainSessions = true;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = number == 1 && !group->spawning();
+		);
+
+		unsigned long long now = SystemTime::getUsec();
+		unsigned long long received;
+		{
+			WriteLockGuard l(pool->syncher);
+			received = group->getActionsReceived;
+		}
+		pool->realForecastDemand(now);
+		{
+			WriteLockGuard l(pool->syncher);
+			group->getActionsReceived = received + 50;
+		}
+		pool->realForecastDemand(now + 5000000);
+		{
+			WriteLockGuard l(pool->syncher);
+			group->getActionsReceived = received + 200;
+		}
+		pool->realForecastDemand(now + 10000000);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->predictedProcesses, 2u);
+			ensure_equals(group->lastDemandForecastDecision, Group::DFD_NONE);
+			ensure_equals(group->getMinProcessesToKeep(), 1u);
+			ensure(!group->spawning());
+			ensure_equals(group->enabledCount, 1);
+		}
+
+		retainSessions = false;
+		clearAllSessions();
+	}
+
+	TEST_METHOD(91) {
+		// Processes that go over the memory limit are recycled, largest first,
+		// but no more than memoryLimitRecyclePercentage percent of the group
+		// at the same time. A replacement process is spawned.
+		Options options = createOptions();
+		options.memoryLimit = 100;
+		options.memoryLimitRecyclePercentage = 25;
+		retainSessions = true;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		for (int i = 1; i <= 4; i++) {
+			pool->asyncGet(options, callback);
+			EVENTUALLY(5,
+				result = number == i;
+			);
+		}
+		retainSessions = false;
+		clearAllSessions();
+
+		boost::container::vector<Callback> actions;
+		string gupid;
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->enabledCount, 4);
+			for (unsigned int i = 0; i < group->enabledProcesses.size(); i++) {
+				ProcessPtr process = group->enabledProcesses[i];
+				process->metrics.pid = process->getPid();
+				process->metrics.privateDirty = (150 + i * 10) * 1024;
+				process->metrics.swap = 0;
+			}
+			gupid = group->enabledProcesses.back()->getGupid().toString();
+
+			pool->recycleProcessesOverMemoryLimit(actions);
+			ensure_equals(group->memoryRecycles, 1u);
+			ensure_equals(group->enabledCount, 3);
+			ensure_equals(group->detachedProcesses.size(), 1u);
+			ensure_equals(group->detachedProcesses[0]->getGupid().toString(), gupid);
+			ensure(group->detachedProcesses[0]->recyclingForMemory);
+
+			// The other processes must wait until the first one is gone.
+			pool->recycleProcessesOverMemoryLimit(actions);
+			ensure_equals(group->memoryRecycles, 1u);
+			ensure_equals(group->enabledCount, 3);
+		}
+		Pool::runAllActions(actions);
+
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = group->enabledCount == 4 && !group->spawning();
+		);
+
+		stringstream stream;
+		{
+			WriteLockGuard l(pool->syncher);
+			group->inspectXml(stream);
+		}
+		ensure(containsSubstring(stream.str(), "<memory_recycles>1</memory_recycles>"));
+	}
+
+	TEST_METHOD(92) {
+		// Processes are not recycled if there is no memory limit.
+		Options options = createOptions();
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			result = number == 1;
+		);
+
+		boost::container::vector<Callback> actions;
+		WriteLockGuard l(pool->syncher);
+		ProcessPtr process = group->enabledProcesses[0];
+		process->metrics.pid = process->getPid();
+		process->metrics.privateDirty = 1024 * 1024;
+		process->metrics.swap = 0;
+		pool->recycleProcessesOverMemoryLimit(actions);
+		ensure(actions.empty());
+		ensure_equals(group->memoryRecycles, 0u);
+		ensure_equals(group->enabledCount, 1);
+	}
+
+	TEST_METHOD(93) {
+		// Disabling a standby process shuts it down right away, and a
+		// replacement standby process is spawned.
+		Options options = createOptions();
+		options.standbyProcesses = 1;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = number == 1 && group->standbyCount == 1 && !group->spawning();
+		);
+		string gupid;
+		{
+			WriteLockGuard l(pool->syncher);
+			gupid = group->standbyProcesses.back()->getGupid().toString();
+		}
+
+		ensure_equals(pool->disableProcess(gupid), DR_SUCCESS);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->disabledCount, 0);
+			ensure_equals(group->enabledCount, 1);
+			ensure(group->standbyProcesses.empty()
+				|| group->standbyProcesses.back()->getGupid() != gupid);
+		}
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = group->standbyCount == 1 && !group->spawning();
+		);
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure(group->standbyProcesses.back()->getGupid() != gupid);
+		}
+		ensure(!pool->enableProcess(gupid));
+	}
+
+	TEST_METHOD(94) {
+		// Enabling a standby process promotes it, and a replacement standby
+		// process is spawned.
+		Options options = createOptions();
+		options.standbyProcesses = 1;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = number == 1 && group->standbyCount == 1 && !group->spawning();
+		);
+		string gupid;
+		{
+			WriteLockGuard l(pool->syncher);
+			gupid = group->standbyProcesses.back()->getGupid().toString();
+		}
+
+		ensure(pool->enableProcess(gupid));
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure_equals(group->enabledCount, 2);
+			ensure_equals(group->enabledProcesses.back()->getGupid().toString(), gupid);
+			ensure_equals(group->standbyPromotions, 1u);
+		}
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = group->standbyCount == 1 && !group->spawning();
+		);
+		ensure(!pool->enableProcess("none"));
+	}
+
+	TEST_METHOD(95) {
+		// Disabling a standby process in a full pool does not make the pool
+		// exceed its capacity.
+		Options options = createOptions();
+		options.standbyProcesses = 1;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = number == 1 && group->standbyCount == 1 && !group->spawning();
+		);
+		pool->setMax(1);
+		string gupid;
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure(pool->atFullCapacityUnlocked());
+			gupid = group->standbyProcesses.back()->getGupid().toString();
+		}
+
+		ensure_equals(pool->disableProcess(gupid), DR_SUCCESS);
+		WriteLockGuard l(pool->syncher);
+		ensure_equals(group->disabledCount, 0);
+		ensure_equals(group->standbyCount, 0);
+		ensure_equals(group->capacityUsed(), 1u);
+		ensure_equals(pool->capacityUsedUnlocked(), 1u);
+		ensure(!group->spawning());
+	}
+
+	TEST_METHOD(96) {
+		// Enabling a standby process in a full pool leaves it on standby.
+		Options options = createOptions();
+		options.standbyProcesses = 1;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = number == 1 && group->standbyCount == 1 && !group->spawning();
+		);
+		pool->setMax(1);
+		string gupid;
+		{
+			WriteLockGuard l(pool->syncher);
+			ensure(pool->atFullCapacityUnlocked());
+			gupid = group->standbyProcesses.back()->getGupid().toString();
+		}
+
+		ensure(!pool->enableProcess(gupid));
+		WriteLockGuard l(pool->syncher);
+		ensure_equals(group->enabledCount, 1);
+		ensure_equals(group->standbyCount, 1);
+		ensure_equals(group->standbyPromotions, 0u);
+		ensure_equals(pool->capacityUsedUnlocked(), 1u);
+	}
+
+	TEST_METHOD(97) {
+		// The only enabled process of a group is not recycled because of the
+		// memory limit until a replacement process has been attached.
+		Options options = createOptions();
+		options.memoryLimit = 100;
+		GroupPtr group = pool->findOrCreateGroup(options);
+
+		pool->asyncGet(options, callback);
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = number == 1 && !group->spawning();
+		);
+
+		boost::container::vector<Callback> actions;
+		ProcessPtr process;
+		{
+			WriteLockGuard l(pool->syncher);
+			process = group->enabledProcesses[0];
+			process->metrics.pid = process->getPid();
+			process->metrics.privateDirty = 200 * 1024;
+			process->metrics.swap = 0;
+
+			pool->recycleProcessesOverMemoryLimit(actions);
+			ensure_equals(group->memoryRecycles, 0u);
+			ensure_equals(group->enabledCount, 1);
+			ensure(group->spawning());
+		}
+		Pool::runAllActions(actions);
+		actions.clear();
+
+		EVENTUALLY(5,
+			WriteLockGuard l(pool->syncher);
+			result = group->enabledCount == 2 && !group->spawning();
+		);
+		{
+			WriteLockGuard l(pool->syncher);
+			pool->recycleProcessesOverMemoryLimit(actions);
+			ensure_equals(group->memoryRecycles, 1u);
+			ensure_equals(group->enabledCount, 1);
+			ensure(group->enabledProcesses[0] != process);
+			ensure(process->recyclingForMemory);
+		}
+		Pool::runAllActions(actions);
+	}
+
 	// TODO: Persistent connections.
 	// TODO: If one closes the session before it has reached EOF, and process's maximum concurrency
 	//       has already been reached, then the pool should ping the process so that it can detect
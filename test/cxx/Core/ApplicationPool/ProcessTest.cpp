@@ -39,7 +39,7 @@ namespace tut {
 			server1.assign(createTcpServer("127.0.0.1", 0, 0, __FILE__, __LINE__), NULL, 0);
 			getsockname(server1, (struct sockaddr *) &addr, &len);
 			socket["name"] = "main1";
-			socket["address"] = "tcp://127.0.0.1:" + toString(addr.sin_port);
+			socket["address"] = "tcp://127.0.0.1:" + toString(ntohs(addr.sin_port));
 			socket["protocol"] = "session";
 			socket["concurrency"] = 3;
 			sockets.append(socket);
@@ -48,7 +48,7 @@ namespace tut {
 			getsockname(server2, (struct sockaddr *) &addr, &len);
 			socket = Json::Value();
 			socket["name"] = "main2";
-			socket["address"] = "tcp://127.0.0.1:" + toString(addr.sin_port);
+			socket["address"] = "tcp://127.0.0.1:" + toString(ntohs(addr.sin_port));
 			socket["protocol"] = "session";
 			socket["concurrency"] = 3;
 			sockets.append(socket);
@@ -57,7 +57,7 @@ namespace tut {
 			getsockname(server3, (struct sockaddr *) &addr, &len);
 			socket = Json::Value();
 			socket["name"] = "main3";
-			socket["address"] = "tcp://127.0.0.1:" + toString(addr.sin_port);
+			socket["address"] = "tcp://127.0.0.1:" + toString(ntohs(addr.sin_port));
 			socket["protocol"] = "session";
 			socket["concurrency"] = 3;
 			sockets.append(socket);
@@ -204,4 +204,112 @@ namespace tut {
 				&& gatheredOutput.find("errorPipe 2\n") != string::npos;
 		);
 	}
+
+	static void checkOutConnection(Socket *socket, Connection *connection) {
+		*connection = socket->checkoutConnection();
+	}
+
+	TEST_METHOD(6) {
+		set_test_name("Connections that are checked back in are reused, also by other threads, "
+			"and the connection pool statistics are updated accordingly");
+		ProcessPtr process = createProcess();
+		SessionPtr session = process->newSession();
+		Socket *socket = session->getSocket();
+		unsigned long long reused, connects;
+
+		Connection connection = socket->checkoutConnection();
+		int fd = connection.fd;
+		connection.fail = false;
+		connection.wantKeepAlive = true;
+		socket->checkinConnection(connection);
+		ensure_equals(socket->getIdleConnectionCount(), 1);
+
+		connection = socket->checkoutConnection();
+		ensure_equals("The same thread reuses the connection", connection.fd, fd);
+		connection.fail = false;
+		connection.wantKeepAlive = true;
+		socket->checkinConnection(connection);
+
+		Connection connection2;
+		boost::thread thr(boost::bind(checkOutConnection, socket, &connection2));
+		thr.join();
+		ensure_equals("Another thread reuses the connection", connection2.fd, fd);
+
+		socket->getConnectionStatistics(reused, connects);
+		ensure_equals(reused, 2u);
+		ensure_equals(connects, 1u);
+		ensure_equals(socket->totalConnections.load(), 1);
+
+		connection2.fail = true;
+		socket->checkinConnection(connection2);
+		ensure_equals("Failed connections are not reused",
+			socket->getIdleConnectionCount(), 0);
+		ensure_equals(socket->totalConnections.load(), 0);
+		process->sessionClosed(session.get());
+	}
+
+	TEST_METHOD(7) {
+		set_test_name("closeIdleConnections() closes connections that have been idle for too long");
+		ProcessPtr process = createProcess();
+		SessionPtr session = process->newSession();
+		Socket *socket = session->getSocket();
+
+		SystemTime::forceUsec(1000000);
+		Connection connection = socket->checkoutConnection();
+		connection.fail = false;
+		connection.wantKeepAlive = true;
+		socket->checkinConnection(connection);
+
+		SystemTime::forceUsec(2000000);
+		connection = socket->checkoutConnection();
+		Connection connection2 = socket->checkoutConnection();
+		connection.fail = false;
+		connection.wantKeepAlive = true;
+		connection2.fail = false;
+		connection2.wantKeepAlive = true;
+		socket->checkinConnection(connection);
+		SystemTime::forceUsec(3000000);
+		socket->checkinConnection(connection2);
+		ensure_equals(socket->totalConnections.load(), 2);
+
+		ensure_equals(process->closeIdleConnections(2500000), 3000000ull);
+		ensure_equals(socket->getIdleConnectionCount(), 1);
+		ensure_equals(socket->totalConnections.load(), 1);
+		ensure_equals(process->closeIdleConnections(3500000), 0ull);
+		ensure_equals(socket->getIdleConnectionCount(), 0);
+		ensure_equals(socket->totalConnections.load(), 0);
+
+		SystemTime::releaseAll();
+		process->sessionClosed(session.get());
+	}
+
+	static void checkInConnection(Socket *socket, Connection *connection) {
+		socket->checkinConnection(*connection);
+	}
+
+	TEST_METHOD(8) {
+		set_test_name("The number of idle connections is limited per socket, "
+			"not per thread");
+		ProcessPtr process = createProcess();
+		SessionPtr session = process->newSession();
+		Socket *socket = session->getSocket();
+		Connection connections[5];
+
+		for (int i = 0; i < 5; i++) {
+			connections[i] = socket->checkoutConnection();
+			connections[i].fail = false;
+			connections[i].wantKeepAlive = true;
+		}
+		for (int i = 0; i < 5; i++) {
+			boost::thread thr(boost::bind(checkInConnection, socket, &connections[i]));
+			thr.join();
+		}
+		ensure_equals(socket->getIdleConnectionCount(), 3);
+		ensure_equals(socket->idleConnectionCount.load(), 3);
+		ensure_equals(socket->totalConnections.load(), 3);
+
+		ensure_equals(process->closeIdleConnections(SystemTime::getUsec() + 1), 0ull);
+		ensure_equals(socket->idleConnectionCount.load(), 0);
+		process->sessionClosed(session.get());
+	}
 }
@@ -18,16 +18,21 @@ namespace tut {
 			virtual void asyncGetFromApplicationPool(Request *req,
 				ApplicationPool2::GetCallback callback)
 			{
+				asyncGetCount++;
 				callback(sessionToReturn, exceptionToReturn);
 				sessionToReturn.reset();
+				sessionToReturn.swap(nextSessionToReturn);
 			}
 
 		public:
 			ApplicationPool2::AbstractSessionPtr sessionToReturn;
+			ApplicationPool2::AbstractSessionPtr nextSessionToReturn;
 			ApplicationPool2::ExceptionPtr exceptionToReturn;
+			unsigned int asyncGetCount;
 
 			MyController(ServerKit::Context *context, const VariantMap *agentsOptions)
-				: Core::Controller(context, agentsOptions)
+				: Core::Controller(context, agentsOptions),
+				  asyncGetCount(0)
 				{ }
 		};
 
@@ -37,6 +42,8 @@ namespace tut {
 		VariantMap options;
 		int serverSocket;
 		TestSession testSession;
+		TestSession pipelinedTestSession;
+		TestSession delayedTestSession;
 		FileDescriptor clientConnection;
 		BufferedIO clientConnectionIO;
 		string peerRequestHeader;
@@ -62,8 +69,14 @@ namespace tut {
 			options.set("sticky_sessions_cookie_name", DEFAULT_STICKY_SESSIONS_COOKIE_NAME);
 			options.setBool("user_switching", false);
 			options.setInt("min_instances", 1);
+			options.setInt("spawn_concurrency", DEFAULT_SPAWN_CONCURRENCY);
+			options.setInt("standby_processes", 0);
+			options.setBool("predictive_scaling", false);
+			options.setInt("memory_limit", 0);
+			options.setInt("memory_limit_recycle_percentage", DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE);
 			options.setInt("max_preloader_idle_time", DEFAULT_MAX_PRELOADER_IDLE_TIME);
 			options.setInt("max_request_queue_size", DEFAULT_MAX_REQUEST_QUEUE_SIZE);
+			options.set("routing_policy", DEFAULT_ROUTING_POLICY);
 			options.setBool("abort_websockets_on_process_shutdown", true);
 			options.setInt("force_max_concurrent_requests_per_process", -1);
 			options.set("spawn_method", DEFAULT_SPAWN_METHOD);
@@ -88,6 +101,7 @@ namespace tut {
 			}
 			safelyClose(serverSocket);
 			unlink("tmp.server");
+			removeDirTree("tmp.redirect_root");
 			setLogLevel(DEFAULT_LOG_LEVEL);
 			bg.stop();
 		}
@@ -136,6 +150,33 @@ namespace tut {
 			controller->sessionToReturn.reset(&testSession, false);
 		}
 
+		void usePipelinedTestSessionObject() {
+			bg.safe->runSync(boost::bind(&Core_ControllerTest::_setPipelinedTestSessionObject, this));
+		}
+
+		void _setPipelinedTestSessionObject() {
+			controller->nextSessionToReturn.reset(&pipelinedTestSession, false);
+		}
+
+		void useDelayedTestSessionObject() {
+			bg.safe->runSync(boost::bind(&Core_ControllerTest::_setDelayedTestSessionObject, this));
+		}
+
+		void _setDelayedTestSessionObject() {
+			controller->sessionToReturn.reset(&delayedTestSession, false);
+		}
+
+		unsigned int getAsyncGetCount() {
+			unsigned int result;
+			bg.safe->runSync(boost::bind(&Core_ControllerTest::_getAsyncGetCount,
+				this, &result));
+			return result;
+		}
+
+		void _getAsyncGetCount(unsigned int *result) {
+			*result = controller->asyncGetCount;
+		}
+
 		MyController::State getServerState() {
 			Controller::State result;
 			bg.safe->runSync(boost::bind(&Core_ControllerTest::_getServerState,
@@ -246,6 +287,45 @@ namespace tut {
 		string readResponseBody() {
 			return clientConnectionIO.readAll();
 		}
+
+		string createLargeBody(unsigned int size) {
+			string body;
+			body.reserve(size);
+			for (unsigned int i = 0; i < size; i++) {
+				body.append(1, 'a' + i % 23);
+			}
+			return body;
+		}
+
+		Json::Value inspectState() {
+			Json::Value result;
+			bg.safe->runSync(boost::bind(&Core_ControllerTest::_inspectState,
+				this, &result));
+			return result;
+		}
+
+		void _inspectState(Json::Value *result) {
+			*result = controller->inspectStateAsJson();
+		}
+
+		void enableInternalRedirects(const StaticString &fileContents) {
+			removeDirTree("tmp.redirect_root");
+			makeDirTree("tmp.redirect_root");
+			createFile("tmp.redirect_root/file.bin", fileContents);
+			options.set("internal_redirect_header", "X-Sendfile");
+			options.set("internal_redirect_root", "tmp.redirect_root");
+		}
+
+		void sendInternalRedirectRequest(const string &extraHeaders = string()) {
+			connectToServer();
+			sendRequest("GET /hello HTTP/1.1\r\n"
+				"Host: localhost\r\n"
+				"Connection: close\r\n" +
+				extraHeaders +
+				"\r\n");
+			waitUntilSessionInitiated();
+			readPeerRequestHeader();
+		}
 	};
 
 	DEFINE_TEST_GROUP(Core_ControllerTest);
@@ -380,6 +460,43 @@ namespace tut {
 			"0\r\n\r\n");
 	}
 
+	TEST_METHOD(14) {
+		set_test_name("Chunked response body, with coalescing of chunked frames enabled");
+
+		options.setBool("coalesce_chunked_frames", true);
+		init();
+		useTestSessionObject();
+
+		connectToServer();
+		sendRequest(
+			"GET /hello HTTP/1.1\r\n"
+			"Host: localhost\r\n"
+			"Connection: close\r\n"
+			"\r\n");
+		waitUntilSessionInitiated();
+
+		readPeerRequestHeader();
+		sendPeerResponse(
+			"HTTP/1.1 200 OK\r\n"
+			"Connection: close\r\n"
+			"Transfer-Encoding: chunked\r\n\r\n"
+			"5\r\n"
+			"hello\r\n"
+			"6\r\n"
+			" world\r\n"
+			"0\r\n\r\n");
+
+		string header = readResponseHeader();
+		string body = readResponseBody();
+		ensure("HTTP response OK", containsSubstring(header, "HTTP/1.1 200 OK\r\n"));
+		ensure_equals(body,
+			"5\r\n"
+			"hello\r\n"
+			"6\r\n"
+			" world\r\n"
+			"0\r\n\r\n");
+	}
+
 	TEST_METHOD(13) {
 		set_test_name("Upgraded response body");
 
@@ -743,4 +860,276 @@ namespace tut {
 		ensure("(1)", testSession.isSuccessful());
 		ensure("(2)", !testSession.wantsKeepAlive());
 	}
+
+
+	/***** Splicing response bodies *****/
+
+	TEST_METHOD(40) {
+		set_test_name("Large fixed response bodies are spliced to the client");
+
+		options.setBool("splice_responses", true);
+		init();
+		useTestSessionObject();
+
+		connectToServer();
+		sendRequest(
+			"GET /hello HTTP/1.1\r\n"
+			"Host: localhost\r\n"
+			"Connection: close\r\n"
+			"\r\n");
+		waitUntilSessionInitiated();
+
+		readPeerRequestHeader();
+		string body = createLargeBody(4 * 1024 * 1024);
+		string response = "HTTP/1.1 200 OK\r\n"
+			"Content-Length: " + toString(body.size()) + "\r\n\r\n" + body;
+		TempThread thr(boost::bind(&Core_ControllerTest::sendPeerResponse,
+			this, StaticString(response)));
+
+		string header = readResponseHeader();
+		ensure("(1)", containsSubstring(header, "HTTP/1.1 200 OK\r\n"));
+		ensure("(2)", readResponseBody() == body);
+
+		waitUntilSessionClosed();
+		ensure("(3)", testSession.isSuccessful());
+		ensure("(4)", testSession.wantsKeepAlive());
+		Json::Value doc = inspectState()["response_splicing"];
+		ensure_equals("(5)", doc["responses"].asUInt(), 1u);
+		ensure_equals("(6)", doc["fallbacks"].asUInt(), 0u);
+	}
+
+	TEST_METHOD(41) {
+		set_test_name("Splicing falls back to buffering if the client is slower than the app");
+
+		options.setBool("splice_responses", true);
+		init();
+		useTestSessionObject();
+
+		connectToServer();
+		sendRequest(
+			"GET /hello HTTP/1.1\r\n"
+			"Host: localhost\r\n"
+			"Connection: close\r\n"
+			"\r\n");
+		waitUntilSessionInitiated();
+
+		readPeerRequestHeader();
+		string body = createLargeBody(8 * 1024 * 1024);
+		string response = "HTTP/1.1 200 OK\r\n"
+			"Content-Length: " + toString(body.size()) + "\r\n\r\n" + body;
+		TempThread thr(boost::bind(&Core_ControllerTest::sendPeerResponse,
+			this, StaticString(response)));
+
+		// Don't read anything until the client socket buffer is full.
+		EVENTUALLY(5,
+			result = inspectState()["response_splicing"]["fallbacks"].asUInt() == 1;
+		);
+
+		string header = readResponseHeader();
+		ensure("(1)", containsSubstring(header, "HTTP/1.1 200 OK\r\n"));
+		ensure("(2)", readResponseBody() == body);
+		ensure_equals("(3)", inspectState()["response_splicing"]["responses"].asUInt(), 1u);
+	}
+
+	/***** Internal redirects *****/
+
+	TEST_METHOD(42) {
+		set_test_name("Internal redirect targets are served without waiting for the app");
+
+		string contents = createLargeBody(3 * 1024 * 1024);
+		enableInternalRedirects(contents);
+		init();
+		useTestSessionObject();
+		sendInternalRedirectRequest();
+
+		// The app keeps its end of the connection open, which shouldn't matter.
+		writeExact(testSession.peerFd(), "HTTP/1.1 200 OK\r\n"
+			"Content-Type: application/octet-stream\r\n"
+			"X-Sendfile: /file.bin\r\n\r\n");
+		waitUntilSessionClosed();
+		ensure("(1)", testSession.isSuccessful());
+
+		string header = readResponseHeader();
+		ensure("(2)", containsSubstring(header, "HTTP/1.1 200 OK\r\n"));
+		ensure("(3)", containsSubstring(header, "Content-Length: " + toString(contents.size()) + "\r\n"));
+		ensure("(4)", containsSubstring(header, "Accept-Ranges: bytes\r\n"));
+		ensure("(5)", containsSubstring(header, "Content-Type: application/octet-stream\r\n"));
+		ensure("(6)", !containsSubstring(header, "X-Sendfile"));
+		ensure("(7)", readResponseBody() == contents);
+		ensure_equals("(8)", inspectState()["internal_redirects"]["responses"].asUInt(), 1u);
+	}
+
+	TEST_METHOD(43) {
+		set_test_name("Internal redirect targets support byte ranges");
+
+		enableInternalRedirects("0123456789");
+		init();
+		useTestSessionObject();
+		sendInternalRedirectRequest("Range: bytes=2-5\r\n");
+
+		sendPeerResponse("HTTP/1.1 200 OK\r\n"
+			"X-Sendfile: /file.bin\r\n\r\n");
+		string header = readResponseHeader();
+		ensure("(1)", containsSubstring(header, "HTTP/1.1 206 Partial Content\r\n"));
+		ensure("(2)", containsSubstring(header, "Content-Range: bytes 2-5/10\r\n"));
+		ensure("(3)", containsSubstring(header, "Content-Length: 4\r\n"));
+		ensure_equals("(4)", readResponseBody(), "2345");
+	}
+
+	TEST_METHOD(44) {
+		set_test_name("Internal redirect targets respond with 416 to unsatisfiable ranges");
+
+		enableInternalRedirects("0123456789");
+		init();
+		useTestSessionObject();
+		sendInternalRedirectRequest("Range: bytes=10-\r\n");
+
+		sendPeerResponse("HTTP/1.1 200 OK\r\n"
+			"X-Sendfile: /file.bin\r\n\r\n");
+		string header = readResponseHeader();
+		ensure("(1)", containsSubstring(header, "HTTP/1.1 416 Requested Range Not Satisfiable\r\n"));
+		ensure("(2)", containsSubstring(header, "Content-Range: bytes */10\r\n"));
+		ensure_equals("(3)", readResponseBody(), "");
+	}
+
+	TEST_METHOD(45) {
+		set_test_name("Internal redirects to nonexistent files result in a 404");
+
+		setLogLevel(LVL_ERROR);
+		enableInternalRedirects("0123456789");
+		init();
+		useTestSessionObject();
+		sendInternalRedirectRequest();
+
+		sendPeerResponse("HTTP/1.1 200 OK\r\n"
+			"X-Sendfile: /nonexistent.bin\r\n\r\n");
+		string header = readResponseHeader();
+		ensure(containsSubstring(header, "HTTP/1.1 404 Not Found\r\n"));
+	}
+
+	TEST_METHOD(46) {
+		set_test_name("Internal redirects outside the internal redirect root are rejected");
+
+		setLogLevel(LVL_CRIT);
+		enableInternalRedirects("0123456789");
+		init();
+		useTestSessionObject();
+		sendInternalRedirectRequest();
+
+		sendPeerResponse("HTTP/1.1 200 OK\r\n"
+			"X-Sendfile: /../tmp.redirect_root/file.bin\r\n\r\n");
+		string header = readResponseHeader();
+		ensure("(1)", containsSubstring(header, "HTTP/1.1 500 Internal Server Error\r\n"));
+		ensure("(2)", !containsSubstring(readResponseBody(), "0123456789"));
+	}
+
+	TEST_METHOD(48) {
+		set_test_name("Internal redirects to FIFOs are rejected without opening them");
+
+		setLogLevel(LVL_CRIT);
+		enableInternalRedirects("0123456789");
+		ensure(mkfifo("tmp.redirect_root/fifo", 0600) == 0);
+		init();
+		useTestSessionObject();
+		sendInternalRedirectRequest();
+
+		sendPeerResponse("HTTP/1.1 200 OK\r\n"
+			"X-Sendfile: /fifo\r\n\r\n");
+		string header = readResponseHeader();
+		ensure(containsSubstring(header, "HTTP/1.1 403 Forbidden\r\n"));
+	}
+
+
+	/***** Pipelining *****/
+
+	TEST_METHOD(47) {
+		set_test_name("A session is checked out ahead of time for a pipelined GET request");
+
+		init();
+		useTestSessionObject();
+		usePipelinedTestSessionObject();
+
+		connectToServer();
+		sendRequest(
+			"GET /one HTTP/1.1\r\n"
+			"Host: localhost\r\n"
+			"\r\n"
+			"GET /two HTTP/1.1\r\n"
+			"Host: localhost\r\n"
+			"Connection: close\r\n"
+			"\r\n");
+		waitUntilSessionInitiated();
+		readPeerRequestHeader();
+		EVENTUALLY(5,
+			result = getAsyncGetCount() == 2;
+		);
+		ensure_equals("(1)", pipelinedTestSession.fd(), -1);
+
+		sendPeerResponse("HTTP/1.1 200 OK\r\n"
+			"Content-Length: 3\r\n\r\n"
+			"one");
+		EVENTUALLY(5,
+			result = pipelinedTestSession.fd() != -1;
+		);
+		ensure(containsSubstring(readScalarMessage(pipelinedTestSession.peerFd()),
+			P_STATIC_STRING("REQUEST_URI\0/two\0")));
+		writeExact(pipelinedTestSession.peerFd(), "HTTP/1.1 200 OK\r\n"
+			"Content-Length: 3\r\n\r\n"
+			"two");
+		pipelinedTestSession.closePeerFd();
+
+		string responses = readAll(clientConnection);
+		string::size_type one = responses.find("\r\n\r\none");
+		string::size_type two = responses.find("\r\n\r\ntwo");
+		ensure("(2)", one != string::npos);
+		ensure("(3)", two != string::npos);
+		ensure("(4)", one < two);
+		ensure_equals("(5)", getAsyncGetCount(), 2u);
+	}
+
+	TEST_METHOD(49) {
+		set_test_name("A session that is checked out ahead of time is released "
+			"if it took the last free slot of its process");
+
+		init();
+		useTestSessionObject();
+		usePipelinedTestSessionObject();
+		pipelinedTestSession.setTookLastFreeSlot(true);
+
+		connectToServer();
+		sendRequest(
+			"GET /one HTTP/1.1\r\n"
+			"Host: localhost\r\n"
+			"\r\n"
+			"GET /two HTTP/1.1\r\n"
+			"Host: localhost\r\n"
+			"Connection: close\r\n"
+			"\r\n");
+		waitUntilSessionInitiated();
+		readPeerRequestHeader();
+		EVENTUALLY(5,
+			result = getAsyncGetCount() == 2;
+		);
+		ensure("(1)", pipelinedTestSession.isClosed());
+		ensure_equals("(2)", pipelinedTestSession.fd(), -1);
+
+		useDelayedTestSessionObject();
+		sendPeerResponse("HTTP/1.1 200 OK\r\n"
+			"Content-Length: 3\r\n\r\n"
+			"one");
+		EVENTUALLY(5,
+			result = delayedTestSession.fd() != -1;
+		);
+		ensure(containsSubstring(readScalarMessage(delayedTestSession.peerFd()),
+			P_STATIC_STRING("REQUEST_URI\0/two\0")));
+		writeExact(delayedTestSession.peerFd(), "HTTP/1.1 200 OK\r\n"
+			"Content-Length: 3\r\n\r\n"
+			"two");
+		delayedTestSession.closePeerFd();
+
+		string responses = readAll(clientConnection);
+		ensure("(3)", containsSubstring(responses, "\r\n\r\ntwo"));
+		ensure_equals("(4)", getAsyncGetCount(), 3u);
+	}
+
 }
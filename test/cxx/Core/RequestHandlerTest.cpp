@@ -266,7 +266,7 @@ namespace tut {
 		ensure_equals(io.readLine(), "HTTP/1.1 200 OK\r\n");
 		ProcessPtr process;
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals(pool->getProcessCount(false), 1u);
 			SuperGroupPtr superGroup = pool->superGroups.get(wsgiAppPath);
 			process = superGroup->defaultGroup->enabledProcesses.front();
@@ -274,7 +274,7 @@ namespace tut {
 		}
 		connection.close();
 		EVENTUALLY(5,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			result = process->sessions == 0;
 		);
 	}
@@ -1131,11 +1131,11 @@ namespace tut {
 			result = processes.size() == 1;
 		);
 		EVENTUALLY(5,
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			result = processes[0]->processed == 1;
 		);
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ensure_equals("The session is closed before the client is done reading",
 				processes[0]->sessions, 0);
 		}
@@ -1226,7 +1226,7 @@ namespace tut {
 		ensure_equals(io.readLine(), "HTTP/1.1 101 Switching Protocols\r\n");
 		processes = pool->getProcesses();
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			ProcessPtr process = processes[0];
 			ensure_equals(process->sessionSockets.top()->protocol, "http_session");
 		}
@@ -1424,7 +1424,7 @@ namespace tut {
 		// Get a reference to the orignal process and verify oobw has been requested.
 		ProcessPtr origProcess;
 		{
-			LockGuard l(pool->syncher);
+			WriteLockGuard l(pool->syncher);
 			origProcess = pool->superGroups.get(wsgiAppPath)->defaultGroup->disablingProcesses.front();
 			ensure("OOBW requested", origProcess->oobwStatus == Process::OOBW_IN_PROGRESS);
 		}
@@ -1446,13 +1446,13 @@ namespace tut {
 
 		// Wait for the original process to finish oobw request.
 		EVENTUALLY(2,
-			boost::unique_lock<boost::mutex> lock(pool->syncher);
+			ScopedWriteLock lock(pool->syncher);
 			result = origProcess->oobwStatus == Process::OOBW_NOT_ACTIVE;
 		);
 
 		// Final asserts.
 		{
-			boost::unique_lock<boost::mutex> lock(pool->syncher);
+			ScopedWriteLock lock(pool->syncher);
 			ensure_equals("2 enabled processes", pool->superGroups.get(wsgiAppPath)->defaultGroup->enabledProcesses.size(), 2u);
 			ensure_equals("oobw is reset", origProcess->oobwStatus, Process::OOBW_NOT_ACTIVE);
 			ensure_equals("process is enabled", origProcess->enabled, Process::ENABLED);
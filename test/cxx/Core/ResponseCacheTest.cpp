@@ -5,6 +5,9 @@
 #include <Core/Controller/Request.h>
 #include <Core/Controller/AppResponse.h>
 #include <Core/ResponseCache.h>
+#include <Core/SharedResponseCache.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 using namespace Passenger;
 using namespace Passenger::Core;
@@ -13,6 +16,7 @@ using namespace std;
 
 namespace tut {
 	typedef ResponseCache<Request> ResponseCacheType;
+	typedef SharedResponseCache<Request> SharedResponseCacheType;
 
 	struct Core_ResponseCacheTest {
 		ResponseCacheType responseCache;
@@ -145,6 +149,54 @@ namespace tut {
 			req.appResponse.bodyType = AppResponse::RBT_CONTENT_LENGTH;
 			req.appResponse.aux.bodyInfo.contentLength = body.size();
 		}
+
+		void setPath(const string &path) {
+			psg_lstr_init(&req.path);
+			psg_lstr_append(&req.path, req.pool, path.data(), path.size());
+		}
+
+		ResponseCacheType::Entry storeResponse(ResponseCacheType &cache,
+			const string &path, const string &header, const string &body)
+		{
+			reset();
+			setPath(path);
+			initCacheableResponse();
+			initResponseBody(body);
+			ensure(cache.prepareRequest(this, &req));
+			ensure(cache.prepareRequestForStoring(&req));
+
+			ResponseCacheType::Entry entry(cache.store(&req, time(NULL),
+				header.size(), body.size()));
+			if (entry.valid()) {
+				cache.storeHeaderData(entry, 0, header.data(), header.size());
+				cache.storeBodyData(entry, 0, body.data(), body.size());
+				cache.commit(entry);
+			}
+			return entry;
+		}
+
+		ResponseCacheType::Entry fetchResponse(ResponseCacheType &cache, const string &path) {
+			reset();
+			setPath(path);
+			ensure(cache.prepareRequest(this, &req));
+			return cache.fetch(&req, time(NULL));
+		}
+
+		string readHeader(ResponseCacheType &cache, const ResponseCacheType::Entry &entry) {
+			string result(entry.body->httpHeaderSize, '\0');
+			cache.copyHeaderData(entry, &result[0]);
+			return result;
+		}
+
+		string readBody(ResponseCacheType &cache, const ResponseCacheType::Entry &entry) {
+			string result;
+			unsigned int offset = 0;
+			while (offset < entry.body->httpBodySize) {
+				MemoryKit::mbuf part(cache.getBodyPart(entry, offset));
+				result.append(part.start, part.size());
+			}
+			return result;
+		}
 	};
 
 	DEFINE_TEST_GROUP_WITH_LIMIT(Core_ResponseCacheTest, 100);
@@ -564,4 +616,298 @@ namespace tut {
 		ResponseCacheType::Entry entry2(responseCache.fetch(&req, time(NULL)));
 		ensure("(22)", !entry2.valid());
 	}
+
+
+	/***** Capacity and eviction *****/
+
+	TEST_METHOD(70) {
+		set_test_name("It stores header and body data that spans multiple storage blocks");
+		string header = "content-type: text/plain\r\n"
+			"cache-control: public,max-age=99999\r\n";
+		string body;
+		for (unsigned int i = 0; i < 10000; i++) {
+			body.append(1, (char) ('a' + i % 26));
+		}
+
+		ResponseCacheType::Entry entry(storeResponse(responseCache, "/", header, body));
+		ensure("(1)", entry.valid());
+		ensure("(2)", entry.body->storage.size() > 1);
+
+		entry = fetchResponse(responseCache, "/");
+		ensure("(3)", entry.valid());
+		ensure_equals("(4)", readHeader(responseCache, entry), header);
+		ensure_equals("(5)", readBody(responseCache, entry), body);
+	}
+
+	TEST_METHOD(71) {
+		set_test_name("It evicts the least recently used entry when the maximum number of entries is reached");
+		ResponseCacheType cache(3);
+
+		ensure("(1)", storeResponse(cache, "/1", "header", "body1").valid());
+		ensure("(2)", storeResponse(cache, "/2", "header", "body2").valid());
+		ensure("(3)", storeResponse(cache, "/3", "header", "body3").valid());
+		ensure("(4)", fetchResponse(cache, "/1").valid());
+		ensure("(5)", storeResponse(cache, "/4", "header", "body4").valid());
+
+		ensure_equals("(6)", cache.getEntryCount(), 3u);
+		ensure_equals("(7)", cache.getTotalEvictions(), 1u);
+		ensure("(8)", fetchResponse(cache, "/1").valid());
+		ensure("(9)", !fetchResponse(cache, "/2").valid());
+		ensure("(10)", fetchResponse(cache, "/3").valid());
+		ResponseCacheType::Entry entry(fetchResponse(cache, "/4"));
+		ensure("(11)", entry.valid());
+		ensure_equals("(12)", readBody(cache, entry), "body4");
+	}
+
+	TEST_METHOD(72) {
+		set_test_name("It evicts least recently used entries when the maximum size is reached");
+		ResponseCacheType cache(100, ResponseCacheType::STORAGE_BLOCK_SIZE * 2);
+
+		ensure("(1)", storeResponse(cache, "/1", "header", "body1").valid());
+		ensure("(2)", storeResponse(cache, "/2", "header", "body2").valid());
+		ensure_equals("(3)", cache.getSize(), ResponseCacheType::STORAGE_BLOCK_SIZE * 2u);
+		ensure("(4)", storeResponse(cache, "/3", "header", "body3").valid());
+
+		ensure_equals("(5)", cache.getEntryCount(), 2u);
+		ensure_equals("(6)", cache.getSize(), ResponseCacheType::STORAGE_BLOCK_SIZE * 2u);
+		ensure("(7)", !fetchResponse(cache, "/1").valid());
+		ensure("(8)", fetchResponse(cache, "/2").valid());
+		ensure("(9)", fetchResponse(cache, "/3").valid());
+	}
+
+	TEST_METHOD(73) {
+		set_test_name("It refuses to store responses that are larger than the maximum size");
+		ResponseCacheType cache(100, ResponseCacheType::STORAGE_BLOCK_SIZE);
+
+		ensure("(1)", storeResponse(cache, "/1", "header", "body1").valid());
+		ensure("(2)", !storeResponse(cache, "/2", "header",
+			string(ResponseCacheType::STORAGE_BLOCK_SIZE, 'x')).valid());
+		ensure_equals("(3)", cache.getEntryCount(), 1u);
+		ensure("(4)", fetchResponse(cache, "/1").valid());
+		ensure("(5)", !fetchResponse(cache, "/2").valid());
+	}
+
+	TEST_METHOD(74) {
+		set_test_name("Storing an existing key replaces its data");
+		storeResponse(responseCache, "/", "header", "hello");
+		storeResponse(responseCache, "/", "header2", "world!");
+		ensure_equals("(1)", responseCache.getEntryCount(), 1u);
+
+		ResponseCacheType::Entry entry(fetchResponse(responseCache, "/"));
+		ensure("(2)", entry.valid());
+		ensure_equals("(3)", readHeader(responseCache, entry), "header2");
+		ensure_equals("(4)", readBody(responseCache, entry), "world!");
+	}
+
+	TEST_METHOD(75) {
+		set_test_name("It keeps track of hits and misses");
+		storeResponse(responseCache, "/", "header", "hello");
+		fetchResponse(responseCache, "/");
+		fetchResponse(responseCache, "/");
+		fetchResponse(responseCache, "/foo");
+		ensure_equals("(1)", responseCache.getTotalHits(), 2u);
+		ensure_equals("(2)", responseCache.getTotalMisses(), 1u);
+		ensure_equals("(3)", responseCache.getTotalEvictions(), 0u);
+	}
+
+	TEST_METHOD(76) {
+		set_test_name("It supports many entries");
+		ResponseCacheType cache(10000, 10000 * ResponseCacheType::STORAGE_BLOCK_SIZE);
+
+		for (unsigned int i = 0; i < 10000; i++) {
+			ensure(storeResponse(cache, "/" + toString(i), "header", toString(i)).valid());
+		}
+		ensure_equals("(1)", cache.getEntryCount(), 10000u);
+		ensure_equals("(2)", cache.getTotalEvictions(), 0u);
+		for (unsigned int i = 0; i < 10000; i++) {
+			ResponseCacheType::Entry entry(fetchResponse(cache, "/" + toString(i)));
+			ensure(entry.valid());
+			ensure_equals(readBody(cache, entry), toString(i));
+		}
+
+		ensure(storeResponse(cache, "/10000", "header", "10000").valid());
+		ensure_equals("(3)", cache.getEntryCount(), 10000u);
+		ensure_equals("(4)", cache.getTotalEvictions(), 1u);
+		ensure("(5)", !fetchResponse(cache, "/0").valid());
+		ensure("(6)", fetchResponse(cache, "/10000").valid());
+	}
+
+
+	/***** Shared mode *****/
+
+	static void storeSharedEntry(SharedResponseCacheType *cache, const string &key,
+		const string &body)
+	{
+		HashedStaticString cacheKey(key);
+		SharedResponseCacheType::Entry entry(cache->allocate(cacheKey,
+			key.size() + body.size()));
+		if (entry.valid()) {
+			// The bodies used by these tests fit in a single block.
+			assert(entry.body->storage.size() == 1);
+			memcpy(entry.body->storage[0].start + key.size(), body.data(), body.size());
+			entry.header->date = time(NULL);
+			entry.body->expiryDate = time(NULL) + 99999;
+			entry.body->httpBodySize = body.size();
+			cache->publish(entry);
+		}
+	}
+
+	static void readSharedEntriesInThread(SharedResponseCacheType *cache,
+		boost::atomic<bool> *done, boost::atomic<unsigned int> *errors,
+		boost::atomic<unsigned int> *hits)
+	{
+		SharedResponseCacheType::Reader *reader = cache->registerReader();
+		unsigned int i = 0;
+
+		while (!done->load()) {
+			string key = "k" + toString(i++ % 8);
+			MemoryKit::mbuf buffer;
+
+			cache->beginRead(reader);
+			SharedResponseCacheType::Entry entry(cache->fetch(key));
+			if (entry.valid()) {
+				buffer = MemoryKit::mbuf(entry.body->storage[0], key.size(),
+					entry.body->httpBodySize);
+				(*hits)++;
+			}
+			cache->endRead(reader);
+
+			// The data must stay intact even after the entry is reclaimed.
+			for (unsigned int j = 1; j < buffer.size(); j++) {
+				if (buffer.start[j] != buffer.start[0]) {
+					(*errors)++;
+					break;
+				}
+			}
+		}
+
+		cache->unregisterReader(reader);
+	}
+
+	TEST_METHOD(80) {
+		set_test_name("In shared mode, entries stored through one cache can be fetched through another");
+		SharedResponseCacheType shared;
+		ResponseCacheType cache1(0, 0, &shared);
+		ResponseCacheType cache2(0, 0, &shared);
+
+		ensure("(1)", storeResponse(cache1, "/", "header", "hello").valid());
+		ensure_equals("(2)", cache2.getEntryCount(), 1u);
+
+		ResponseCacheType::Entry entry(fetchResponse(cache2, "/"));
+		ensure("(3)", entry.valid());
+		ensure_equals("(4)", readHeader(cache2, entry), "header");
+		ensure_equals("(5)", readBody(cache2, entry), "hello");
+		cache2.release(entry);
+		ensure_equals("(6)", cache1.getTotalHits(), 0u);
+		ensure_equals("(7)", cache2.getTotalHits(), 1u);
+	}
+
+	TEST_METHOD(81) {
+		set_test_name("In shared mode, stored entries only become visible when committed");
+		SharedResponseCacheType shared;
+		ResponseCacheType cache(0, 0, &shared);
+
+		reset();
+		initCacheableResponse();
+		initResponseBody("hello");
+		ensure("(1)", cache.prepareRequest(this, &req));
+		ensure("(2)", cache.prepareRequestForStoring(&req));
+		ResponseCacheType::Entry entry(cache.store(&req, time(NULL), 6, 5));
+		ensure("(3)", entry.valid());
+		cache.storeHeaderData(entry, 0, "header", 6);
+		cache.storeBodyData(entry, 0, "hello", 5);
+
+		ensure("(4)", !fetchResponse(cache, "/").valid());
+		cache.commit(entry);
+		entry = fetchResponse(cache, "/");
+		ensure("(5)", entry.valid());
+		ensure_equals("(6)", readBody(cache, entry), "hello");
+		cache.release(entry);
+	}
+
+	TEST_METHOD(82) {
+		set_test_name("In shared mode, removed entries are not destroyed while another thread may still read them");
+		SharedResponseCacheType shared;
+		ResponseCacheType cache1(0, 0, &shared);
+		ResponseCacheType cache2(0, 0, &shared);
+
+		storeResponse(cache1, "/", "header", "hello");
+		ResponseCacheType::Entry entry(fetchResponse(cache2, "/"));
+		ensure("(1)", entry.valid());
+
+		storeResponse(cache1, "/", "header", "world");
+		ensure_equals("(2)", shared.getEntryCount(), 1u);
+		ensure_equals("(3)", shared.getRetiredCount(), 1u);
+		ensure_equals("(4)", readBody(cache2, entry), "hello");
+		cache2.release(entry);
+
+		storeResponse(cache1, "/foo", "header", "foo");
+		ensure_equals("(5)", shared.getRetiredCount(), 0u);
+		entry = fetchResponse(cache2, "/");
+		ensure_equals("(6)", readBody(cache2, entry), "world");
+		cache2.release(entry);
+	}
+
+	TEST_METHOD(83) {
+		set_test_name("In shared mode, served body data outlives the entry");
+		SharedResponseCacheType shared;
+		ResponseCacheType cache(0, 0, &shared);
+		unsigned int offset = 0;
+
+		storeResponse(cache, "/", "header", "hello");
+		ResponseCacheType::Entry entry(fetchResponse(cache, "/"));
+		ensure("(1)", entry.valid());
+		MemoryKit::mbuf part(cache.getBodyPart(entry, offset));
+		cache.release(entry);
+
+		shared.clear();
+		ensure_equals("(2)", shared.getEntryCount(), 0u);
+		ensure_equals("(3)", shared.getRetiredCount(), 0u);
+		ensure_equals("(4)", StaticString(part.start, part.size()), "hello");
+	}
+
+	TEST_METHOD(84) {
+		set_test_name("In shared mode, recently fetched entries get a second chance on eviction");
+		SharedResponseCacheType shared(2);
+		ResponseCacheType cache(0, 0, &shared);
+
+		storeResponse(cache, "/1", "header", "body1");
+		storeResponse(cache, "/2", "header", "body2");
+		ResponseCacheType::Entry entry(fetchResponse(cache, "/1"));
+		cache.release(entry);
+		storeResponse(cache, "/3", "header", "body3");
+
+		ensure_equals("(1)", cache.getEntryCount(), 2u);
+		ensure_equals("(2)", cache.getTotalEvictions(), 1u);
+		entry = fetchResponse(cache, "/1");
+		ensure("(3)", entry.valid());
+		cache.release(entry);
+		ensure("(4)", !fetchResponse(cache, "/2").valid());
+		entry = fetchResponse(cache, "/3");
+		ensure("(5)", entry.valid());
+		cache.release(entry);
+	}
+
+	TEST_METHOD(85) {
+		set_test_name("In shared mode, entries can be fetched concurrently with stores");
+		SharedResponseCacheType shared(4, 4 * ResponseCacheType::STORAGE_BLOCK_SIZE);
+		boost::atomic<bool> done(false);
+		boost::atomic<unsigned int> errors(0), hits(0);
+		boost::thread_group threads;
+
+		for (unsigned int i = 0; i < 3; i++) {
+			threads.create_thread(boost::bind(readSharedEntriesInThread,
+				&shared, &done, &errors, &hits));
+		}
+		for (unsigned int i = 0; i < 20000; i++) {
+			storeSharedEntry(&shared, "k" + toString(i % 8),
+				string(100 + i % 1000, (char) ('a' + i % 26)));
+		}
+		done.store(true);
+		threads.join_all();
+
+		ensure_equals("(1)", errors.load(), 0u);
+		ensure_equals("(2)", shared.getEntryCount(), 4u);
+		ensure_equals("(3)", shared.getRetiredCount(), 0u);
+	}
 }
@@ -103,6 +103,17 @@ namespace tut {
 			*state = controller->serverState;
 		}
 
+		Json::Value inspectLogSink(const string &key) {
+			Json::Value result;
+			bg->safe->runSync(boost::bind(&Core_UnionStationTest::_inspectLogSink,
+				this, key, &result));
+			return result;
+		}
+
+		void _inspectLogSink(const string &key, Json::Value *result) {
+			*result = controller->inspectLogSinkCacheStateAsJson()[key];
+		}
+
 		string timestampString(unsigned long long timestamp) {
 			char str[2 * sizeof(unsigned long long) + 1];
 			integerToHexatri<unsigned long long>(timestamp, str);
@@ -564,5 +575,115 @@ namespace tut {
 		ensureSubstringNotInDumpFile("transaction 2\n");
 	}
 
+	TEST_METHOD(23) {
+		set_test_name("The dump file is reopened after it has been rotated");
+		init();
+		SystemTime::forceAll(YESTERDAY);
+		string rotatedPath = getDumpFilePath() + ".1";
+
+		TransactionPtr log = context->newTransaction("foobar");
+		log->message("transaction 1");
+		log.reset();
+		ensureSubstringInDumpFile("transaction 1\n");
+
+		ensure("(1)", rename(getDumpFilePath().c_str(), rotatedPath.c_str()) == 0);
+		// The sink checks for rotation at most once per second.
+		syscalls::usleep(1100000);
+
+		log = context->newTransaction("foobar");
+		log->message("transaction 2");
+		log.reset();
+		ensureSubstringInDumpFile("transaction 2\n");
+		ensure("(2)", readAll(getDumpFilePath()).find("transaction 1") == string::npos);
+		ensure("(3)", readAll(rotatedPath).find("transaction 2") == string::npos);
+		EVENTUALLY(5,
+			result = inspectLogSink("file:requests")["reopened"].asUInt64() == 1;
+		);
+	}
+
+	TEST_METHOD(24) {
+		set_test_name("Dump file writes are grouped, and their statistics are"
+			" reported in the UstRouter state");
+		controllerOptions.setBool("ust_router_dump_fdatasync", true);
+		controllerOptions.setInt("ust_router_dump_flush_delay", 200);
+		init();
+		SystemTime::forceAll(YESTERDAY);
+
+		for (unsigned int i = 0; i < 10; i++) {
+			TransactionPtr log = context->newTransaction("foobar");
+			log->message("transaction " + toString(i));
+		}
+		ensureSubstringInDumpFile("transaction 9\n");
+
+		Json::Value doc;
+		EVENTUALLY(5,
+			doc = inspectLogSink("file:requests");
+			result = doc["sync_calls"].asUInt64() > 0;
+		);
+		ensure("(1)", doc["fdatasync"].asBool());
+		ensure("(2)", doc["write_calls"].asUInt64() < 10);
+		ensure_equals("(3)", doc["sync_calls"].asUInt64(), doc["write_calls"].asUInt64());
+		ensure_equals("(4)", doc["bytes_flushed"]["bytes"].asUInt64(),
+			doc["total_bytes_written"]["bytes"].asUInt64());
+		ensure_equals("(5)", doc["bytes_dropped"]["bytes"].asUInt64(), 0ull);
+		ensure("(6)", doc["max_flush_latency"]["microseconds"].asUInt64() > 0);
+	}
+
+
+	/***** Batched logging *****/
+
+	TEST_METHOD(30) {
+		set_test_name("Messages of a transaction with a LogRing are written"
+			" by the batched log writer");
+		init();
+		SystemTime::forceAll(YESTERDAY);
+		context->enableBatching();
+		LogRing *ring = context->createLogRing();
+
+		TransactionPtr log = context->newTransaction("foobar", "requests", "-",
+			string(), ring);
+		log->message("hello");
+		log->message("world");
+		ensure(!log->isNull());
+		log.reset();
+
+		ensureSubstringInDumpFile("hello\n");
+		ensureSubstringInDumpFile("world\n");
+		EVENTUALLY(5,
+			result = context->getBatchedLogWriter()->inspectStateAsJson()
+				["records_written"].asUInt64() == 3;
+		);
+		ensure_equals(ring->queued.load(), (boost::uint64_t) 3);
+		ensure_equals(ring->dropped.load(), (boost::uint64_t) 0);
+	}
+
+	TEST_METHOD(31) {
+		set_test_name("If a LogRing is full, messages are dropped and counted,"
+			" but the transaction is still closed");
+		init();
+		SystemTime::forceAll(YESTERDAY);
+		// Use a long flush interval so that we control when the rings are flushed.
+		context->enableBatching(4, 60000000);
+		LogRing *ring = context->createLogRing();
+
+		TransactionPtr log = context->newTransaction("foobar", "requests", "-",
+			string(), ring);
+		for (unsigned int i = 0; i < 10; i++) {
+			log->message("message " + toString(i));
+		}
+		log.reset();
+		ensure_equals("(1)", ring->queued.load(), (boost::uint64_t) 4);
+		ensure_equals("(2)", ring->dropped.load(), (boost::uint64_t) 6);
+
+		ensure_equals("(3)", context->getBatchedLogWriter()->flush(), 5u);
+		ensureSubstringInDumpFile("message 3\n");
+		ensureSubstringNotInDumpFile("message 4\n");
+
+		Json::Value doc = context->getBatchedLogWriter()->inspectStateAsJson();
+		ensure_equals("(4)", doc["dropped"].asUInt64(), (boost::uint64_t) 6);
+		ensure_equals("(5)", doc["records_written"].asUInt64(), (boost::uint64_t) 5);
+		ensure_equals("(6)", doc["batches_written"].asUInt64(), (boost::uint64_t) 1);
+	}
+
 	/************************************/
 }
@@ -0,0 +1,141 @@
+#include <TestSupport.h>
+#include <cstdlib>
+#include <vector>
+#include <DataStructures/IndexedMinHeap.h>
+
+using namespace Passenger;
+using namespace std;
+
+namespace tut {
+	struct DataStructures_IndexedMinHeapTest {
+		IndexedMinHeap<int> heap;
+		vector<int> keys;
+
+		void push_back(int key) {
+			heap.push_back(key);
+			keys.push_back(key);
+		}
+
+		void set(unsigned int index, int key) {
+			heap.set(index, key);
+			keys[index] = key;
+		}
+
+		void erase(unsigned int index) {
+			heap.erase(index);
+			keys.erase(keys.begin() + index);
+		}
+
+		// The result of a linear scan for the first item with the smallest key.
+		unsigned int scan() const {
+			unsigned int result = 0;
+			for (unsigned int i = 1; i < keys.size(); i++) {
+				if (keys[i] < keys[result]) {
+					result = i;
+				}
+			}
+			return result;
+		}
+
+		void verify() {
+			ensure_equals("size", heap.size(), (unsigned int) keys.size());
+			for (unsigned int i = 0; i < keys.size(); i++) {
+				ensure_equals("key", heap.get(i), keys[i]);
+			}
+			if (!keys.empty()) {
+				ensure_equals("top", heap.top(), scan());
+				ensure_equals("topKey", heap.topKey(), keys[scan()]);
+			}
+		}
+	};
+
+	DEFINE_TEST_GROUP(DataStructures_IndexedMinHeapTest);
+
+	TEST_METHOD(1) {
+		set_test_name("Initial state");
+		ensure(heap.empty());
+		ensure_equals(heap.size(), 0u);
+	}
+
+	TEST_METHOD(2) {
+		set_test_name("top() returns the index of the item with the smallest key");
+		push_back(5);
+		push_back(3);
+		push_back(8);
+		push_back(1);
+		ensure_equals(heap.top(), 3u);
+		ensure_equals(heap.topKey(), 1);
+		verify();
+	}
+
+	TEST_METHOD(3) {
+		set_test_name("Ties are broken in favor of the lowest index");
+		push_back(2);
+		push_back(1);
+		push_back(1);
+		push_back(1);
+		ensure_equals("(1)", heap.top(), 1u);
+		set(1, 2);
+		ensure_equals("(2)", heap.top(), 2u);
+		set(1, 1);
+		ensure_equals("(3)", heap.top(), 1u);
+	}
+
+	TEST_METHOD(4) {
+		set_test_name("set() moves items up and down");
+		for (int i = 0; i < 10; i++) {
+			push_back(i);
+		}
+		set(0, 100);
+		ensure_equals("(1)", heap.top(), 1u);
+		verify();
+		set(9, -1);
+		ensure_equals("(2)", heap.top(), 9u);
+		verify();
+	}
+
+	TEST_METHOD(5) {
+		set_test_name("erase() renumbers subsequent items");
+		push_back(4);
+		push_back(2);
+		push_back(3);
+		push_back(2);
+		erase(1);
+		ensure_equals("(1)", heap.top(), 2u);
+		ensure_equals("(2)", heap.get(0), 4);
+		ensure_equals("(3)", heap.get(1), 3);
+		ensure_equals("(4)", heap.get(2), 2);
+		verify();
+		erase(2);
+		erase(0);
+		ensure_equals("(5)", heap.top(), 0u);
+		erase(0);
+		ensure(heap.empty());
+	}
+
+	TEST_METHOD(6) {
+		set_test_name("It behaves exactly like a linear scan under random operations");
+		srand(1234);
+		for (unsigned int i = 0; i < 20000; i++) {
+			unsigned int op = rand() % 10;
+			if (keys.empty() || op < 2) {
+				push_back(rand() % 8);
+			} else if (op < 3) {
+				erase(rand() % keys.size());
+			} else {
+				set(rand() % keys.size(), rand() % 8);
+			}
+			verify();
+		}
+	}
+
+	TEST_METHOD(7) {
+		set_test_name("clear() removes all items");
+		push_back(1);
+		push_back(2);
+		heap.clear();
+		ensure(heap.empty());
+		heap.push_back(3);
+		ensure_equals(heap.top(), 0u);
+	}
+}
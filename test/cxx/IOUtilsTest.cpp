@@ -844,6 +844,33 @@ namespace tut {
 		}
 	}
 
+	/***** Test createTcpServer() *****/
+
+	#ifdef SO_REUSEPORT
+		TEST_METHOD(75) {
+			// With reusePort, multiple server sockets can be bound to the same port.
+			FileDescriptor server1(createTcpServer("127.0.0.1", 0, 0,
+				__FILE__, __LINE__, true), NULL, 0);
+			struct sockaddr_in addr;
+			socklen_t len = sizeof(addr);
+			getsockname(server1, (struct sockaddr *) &addr, &len);
+			unsigned short port = ntohs(addr.sin_port);
+
+			FileDescriptor server2(createTcpServer("127.0.0.1", port, 0,
+				__FILE__, __LINE__, true), NULL, 0);
+			FileDescriptor client(connectToTcpServer("127.0.0.1", port,
+				__FILE__, __LINE__), NULL, 0);
+
+			try {
+				createTcpServer("127.0.0.1", port, 0, __FILE__, __LINE__);
+				fail("SystemException expected");
+			} catch (const SystemException &e) {
+				ensure_equals("Sockets without reusePort cannot join",
+					e.code(), EADDRINUSE);
+			}
+		}
+	#endif
+
 	/***** Test readFileDescriptor() and writeFileDescriptor() *****/
 
 	TEST_METHOD(80) {
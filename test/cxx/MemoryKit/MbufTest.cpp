@@ -226,16 +226,140 @@ namespace tut {
 	}
 
 	TEST_METHOD(13) {
-		set_test_name("mbuf_get_with_size (large)");
+		set_test_name("mbuf_get_with_size (larger than all size classes)");
 		{
-			mbuf buffer(mbuf_get_with_size(&pool, mbuf_pool_data_size(&pool) + 10));
+			mbuf buffer(mbuf_get_with_size(&pool, 1024 * 1024));
 			ensure_equals("(1)", pool.nfree_mbuf_blockq, 0u);
 			ensure_equals("(2)", pool.nactive_mbuf_blockq, 1u);
-			ensure_equals("(3)", buffer.size(), mbuf_pool_data_size(&pool) + 10);
+			ensure_equals("(3)", buffer.size(), 1024u * 1024u);
 			memcpy(buffer.start, "hello", 6);
 			ensure_equals("(4)", string(buffer.start), "hello");
 		}
 		ensure_equals("(5)", pool.nfree_mbuf_blockq, 0u);
 		ensure_equals("(6)", pool.nactive_mbuf_blockq, 0u);
 	}
+
+
+	/***** Size classes *****/
+
+	TEST_METHOD(14) {
+		set_test_name("Size classes larger than the pool's chunk size are set up");
+		ensure_equals("(1)", pool.nsize_classes, 3u);
+		ensure_equals("(2)", pool.size_classes[0].mbuf_block_chunk_size, 4096u);
+		ensure_equals("(3)", pool.size_classes[1].mbuf_block_chunk_size, 16384u);
+		ensure_equals("(4)", pool.size_classes[2].mbuf_block_chunk_size, 65536u);
+
+		struct mbuf_pool pool2;
+		pool2.mbuf_block_chunk_size = 16384;
+		mbuf_pool_init(&pool2);
+		ensure_equals("(5)", pool2.nsize_classes, 1u);
+		ensure_equals("(6)", pool2.size_classes[0].mbuf_block_chunk_size, 65536u);
+		mbuf_pool_deinit(&pool2);
+	}
+
+	TEST_METHOD(15) {
+		set_test_name("mbuf_get_with_size picks the smallest size class that fits");
+		{
+			mbuf buffer(mbuf_get_with_size(&pool, mbuf_pool_data_size(&pool) + 10));
+			ensure_equals("(1)", pool.nactive_mbuf_blockq, 0u);
+			ensure_equals("(2)", pool.size_classes[0].nactive_mbuf_blockq, 1u);
+			ensure_equals("(3)", buffer.size(), mbuf_pool_data_size(&pool) + 10);
+			ensure_equals("(4)", buffer.mbuf_block->size_class, 1u);
+			memset(buffer.start, 'x', buffer.size());
+
+			mbuf buffer2(mbuf_get_with_size(&pool, 5000));
+			ensure_equals("(5)", pool.size_classes[1].nactive_mbuf_blockq, 1u);
+			ensure_equals("(6)", buffer2.mbuf_block->size_class, 2u);
+
+			mbuf buffer3(mbuf_get_with_size(&pool, 20000));
+			ensure_equals("(7)", pool.size_classes[2].nactive_mbuf_blockq, 1u);
+			ensure_equals("(8)", buffer3.mbuf_block->size_class, 3u);
+		}
+		ensure_equals("(9)", pool.size_classes[0].nactive_mbuf_blockq, 0u);
+		ensure_equals("(10)", pool.size_classes[0].nfree_mbuf_blockq, 1u);
+		ensure_equals("(11)", pool.size_classes[1].nfree_mbuf_blockq, 1u);
+		ensure_equals("(12)", pool.size_classes[2].nfree_mbuf_blockq, 1u);
+		ensure_equals("(13)", mbuf_pool_spare_memory(&pool), 4096u + 16384u + 65536u);
+
+		mbuf buffer(mbuf_get_with_size(&pool, 5000));
+		ensure_equals("(14)", pool.size_classes[1].nfree_mbuf_blockq, 0u);
+		ensure_equals("(15)", pool.size_classes[1].nactive_mbuf_blockq, 1u);
+	}
+
+	TEST_METHOD(16) {
+		set_test_name("Size class freelists are bounded");
+		struct mbuf_size_class &sizeClass = pool.size_classes[2];
+		unsigned int limit = sizeClass.max_free_mbuf_blockq;
+		vector<mbuf> buffers;
+
+		ensure_equals("(1)", limit, MBUF_SIZE_CLASS_MAX_SPARE_MEMORY / 65536u);
+		for (unsigned int i = 0; i < limit + 2; i++) {
+			buffers.push_back(mbuf_get_with_size(&pool, 60000));
+		}
+		ensure_equals("(2)", sizeClass.nactive_mbuf_blockq, limit + 2);
+		buffers.clear();
+		ensure_equals("(3)", sizeClass.nactive_mbuf_blockq, 0u);
+		ensure_equals("(4)", sizeClass.nfree_mbuf_blockq, limit);
+	}
+
+	TEST_METHOD(17) {
+		set_test_name("The pool's own freelist can be bounded");
+		pool.max_free_mbuf_blockq = 1;
+		{
+			mbuf buffer(mbuf_get(&pool));
+			mbuf buffer2(mbuf_get(&pool));
+			ensure_equals("(1)", pool.nactive_mbuf_blockq, 2u);
+		}
+		ensure_equals("(2)", pool.nactive_mbuf_blockq, 0u);
+		ensure_equals("(3)", pool.nfree_mbuf_blockq, 1u);
+	}
+
+	TEST_METHOD(18) {
+		set_test_name("mbuf_pool_compact frees spare blocks of all size classes");
+		{
+			mbuf buffer(mbuf_get(&pool));
+			mbuf buffer2(mbuf_get_with_size(&pool, 1000));
+			mbuf buffer3(mbuf_get_with_size(&pool, 60000));
+		}
+		ensure_equals("(1)", mbuf_pool_compact(&pool), 3u);
+		ensure_equals("(2)", pool.nfree_mbuf_blockq, 0u);
+		ensure_equals("(3)", pool.size_classes[0].nfree_mbuf_blockq, 0u);
+		ensure_equals("(4)", pool.size_classes[2].nfree_mbuf_blockq, 0u);
+		ensure_equals("(5)", mbuf_pool_spare_memory(&pool), 0u);
+	}
+
+	TEST_METHOD(19) {
+		set_test_name("mbuf_pool_trim frees the largest size classes first");
+		{
+			mbuf buffer(mbuf_get(&pool));
+			mbuf buffer2(mbuf_get_with_size(&pool, 1000));
+			mbuf buffer3(mbuf_get_with_size(&pool, 60000));
+		}
+		ensure_equals("(1)", mbuf_pool_trim(&pool, 4096 + DEFAULT_MBUF_CHUNK_SIZE), 1u);
+		ensure_equals("(2)", pool.size_classes[2].nfree_mbuf_blockq, 0u);
+		ensure_equals("(3)", pool.size_classes[0].nfree_mbuf_blockq, 1u);
+		ensure_equals("(4)", pool.nfree_mbuf_blockq, 1u);
+	}
+
+	TEST_METHOD(20) {
+		set_test_name("mbuf_pool_auto_compact only compacts above the high water mark");
+		vector<mbuf> buffers;
+
+		for (unsigned int i = 0; i < 16; i++) {
+			buffers.push_back(mbuf_get_with_size(&pool, 60000));
+		}
+		buffers.clear();
+		ensure_equals("(1)", pool.size_classes[2].nfree_mbuf_blockq, 16u);
+
+		ensure_equals("Disabled by default", mbuf_pool_auto_compact(&pool), 0u);
+
+		pool.spare_memory_high_water_mark = 16 * 65536;
+		ensure_equals("(2)", mbuf_pool_auto_compact(&pool), 0u);
+		ensure_equals("(3)", pool.nauto_compactions, 0u);
+
+		pool.spare_memory_high_water_mark = 4 * 65536;
+		ensure_equals("(4)", mbuf_pool_auto_compact(&pool), 14u);
+		ensure_equals("(5)", pool.size_classes[2].nfree_mbuf_blockq, 2u);
+		ensure_equals("(6)", pool.nauto_compactions, 1u);
+	}
 }
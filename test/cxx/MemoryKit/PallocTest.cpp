@@ -439,4 +439,61 @@ namespace tut {
 		ensure("psg_reset_pool fails",
 			!psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE));
 	}
+
+	TEST_METHOD(21) {
+		set_test_name("psg_reset_pool() retains large allocations for reuse");
+		pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+
+		void *large1 = psg_palloc(pool, 8000);
+		void *large2 = psg_palloc(pool, 20000);
+		void *huge = psg_palloc(pool, PSG_MAX_RETAINED_LARGE_SIZE + 1);
+		ensure("(1)", large1 != NULL && large2 != NULL && huge != NULL);
+		ensure("(2) psg_reset_pool succeeds",
+			psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE));
+		ensure_equals<void *>("(3)", pool->large, NULL);
+
+		unsigned int retained = 0;
+		for (unsigned int i = 0; i < PSG_MAX_RETAINED_LARGE; i++) {
+			if (pool->retained[i].alloc != NULL) {
+				retained++;
+			}
+		}
+		ensure_equals("(4) Allocations that are too large are not retained",
+			retained, 2u);
+
+		ensure_equals<void *>("(5) The smallest fitting allocation is reused",
+			psg_palloc(pool, 5000), large1);
+		ensure_equals<void *>("(6)", psg_palloc(pool, 5000), large2);
+		ensure("(7)", psg_palloc(pool, 5000) != large1);
+	}
+
+	TEST_METHOD(22) {
+		set_test_name("Reused large allocations can be retained again");
+		pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+
+		void *large = psg_palloc(pool, 20000);
+		psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE);
+		ensure_equals<void *>("(1)", psg_palloc(pool, 5000), large);
+		psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE);
+		ensure_equals<void *>("(2) It remembers the original capacity",
+			psg_palloc(pool, 20000), large);
+	}
+
+	TEST_METHOD(23) {
+		set_test_name("It counts the number of bytes allocated since the last reset");
+		pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+
+		ensure_equals("(1)", pool->allocated, 0u);
+		psg_pnalloc(pool, 10);
+		psg_palloc(pool, 100);
+		ensure_equals("(2)", pool->allocated, 110u);
+		psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE);
+		ensure_equals("(3)", pool->allocated, 0u);
+
+		while (pool->data.next == NULL) {
+			psg_palloc(pool, 1000);
+		}
+		ensure("(4)", !psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE));
+		ensure_equals("(5)", pool->allocated, 0u);
+	}
 }
@@ -357,4 +357,26 @@ namespace tut {
 			ensure(timeout <= 2000);
 		}
 	}
+
+	/***** Test appendArrayMessage() and appendScalarMessage() *****/
+
+	TEST_METHOD(40) {
+		// They produce the same format as writeArrayMessage() and
+		// writeScalarMessage(), so that multiple messages can be written at once.
+		StaticString args[] = { "hello", "world" };
+		string buffer;
+		appendArrayMessage(buffer, args, 2);
+		appendScalarMessage(buffer, "foobar");
+		appendArrayMessage(buffer, args, 1);
+		writeExact(pipes[1], buffer.data(), buffer.size());
+
+		vector<string> message = readArrayMessage(pipes[0]);
+		ensure_equals(message.size(), 2u);
+		ensure_equals(message[0], "hello");
+		ensure_equals(message[1], "world");
+		ensure_equals(readScalarMessage(pipes[0]), "foobar");
+		message = readArrayMessage(pipes[0]);
+		ensure_equals(message.size(), 1u);
+		ensure_equals(message[0], "hello");
+	}
 }
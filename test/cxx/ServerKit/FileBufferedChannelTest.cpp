@@ -918,6 +918,85 @@ namespace tut {
 		);
 	}
 
+	TEST_METHOD(17) {
+		set_test_name("When corked, it buffers fed data and only calls the callback "
+			"after uncork() is called");
+
+		startLoop();
+		bg.safe->runSync(boost::bind(&FileBufferedChannel::cork, &channel));
+		feedChannel("hello");
+		feedChannel("world");
+		SHOULD_NEVER_HAPPEN(100,
+			LOCK();
+			result = !log.empty();
+		);
+		ensure_equals(getChannelBytesBuffered(), 10u);
+
+		bg.safe->runLater(boost::bind(&FileBufferedChannel::uncork, &channel));
+		EVENTUALLY(5,
+			LOCK();
+			result = log ==
+				"Data: hello\n"
+				"Data: world\n";
+		);
+		EVENTUALLY(5,
+			result = getChannelReaderState() == FileBufferedChannel::RS_INACTIVE;
+		);
+	}
+
+	static Channel::Result test_18_callback(Channel *_channel, const mbuf &buffer,
+		int errcode)
+	{
+		FileBufferedChannel *channel = reinterpret_cast<FileBufferedChannel *>(_channel);
+		ServerKit_FileBufferedChannelTest *self = (ServerKit_FileBufferedChannelTest *)
+			channel->getHooks();
+		boost::mutex &syncher = self->syncher;
+		struct iovec iov[8];
+		unsigned int niov;
+		size_t queuedSize;
+		string data(buffer.start, buffer.size());
+
+		niov = channel->peekQueuedBuffers(iov, 8, queuedSize);
+		for (unsigned int i = 0; i < niov; i++) {
+			data.append((const char *) iov[i].iov_base, iov[i].iov_len);
+		}
+
+		{
+			LOCK();
+			self->log.append("Batch: " + data + "\n");
+		}
+
+		// Pretend that only 3 bytes of the queued data could be processed.
+		if (queuedSize > 3) {
+			channel->consumeQueuedBuffers(3);
+		}
+		return Channel::Result(buffer.size(), false);
+	}
+
+	TEST_METHOD(18) {
+		set_test_name("The data callback can process the buffers that are queued behind "
+			"the passed buffer, and consume part of them");
+
+		channel.setDataCallback(test_18_callback);
+		startLoop();
+		bg.safe->runSync(boost::bind(&FileBufferedChannel::cork, &channel));
+		feedChannel("hello");
+		feedChannel("world");
+		feedChannel("!");
+		bg.safe->runLater(boost::bind(&FileBufferedChannel::uncork, &channel));
+
+		EVENTUALLY(5,
+			LOCK();
+			result = log ==
+				"Batch: helloworld!\n"
+				"Batch: ld!\n"
+				"Batch: !\n";
+		);
+		EVENTUALLY(5,
+			result = getChannelBytesBuffered() == 0;
+		);
+	}
+
 
 	/***** When stopped *****/
 
@@ -0,0 +1,306 @@
+#include <TestSupport.h>
+#include <string>
+#include <vector>
+#include <BackgroundEventLoop.h>
+#include <StaticString.h>
+#include <MemoryKit/palloc.h>
+#include <ServerKit/Context.h>
+#include <ServerKit/HttpRequest.h>
+#include <ServerKit/HttpHeaderParser.h>
+#include <Utils/StrIntUtils.h>
+
+using namespace Passenger;
+using namespace Passenger::ServerKit;
+using namespace Passenger::MemoryKit;
+using namespace std;
+
+namespace tut {
+	struct ServerKit_HttpHeaderParserTest {
+		BackgroundEventLoop bg;
+		ServerKit::Context context;
+		HttpHeaderParserState state;
+		unsigned int seed;
+
+		ServerKit_HttpHeaderParserTest()
+			: bg(false, true),
+			  context(bg.safe, bg.libuv_loop),
+			  seed(1)
+			{ }
+
+		~ServerKit_HttpHeaderParserTest() {
+			http_parser_set_header_scanner(HTTP_HEADER_SCANNER_AUTO);
+		}
+
+		unsigned int random(unsigned int max) {
+			seed = seed * 1103515245 + 12345;
+			return (seed >> 16) % max;
+		}
+
+		string randomHeaderName() {
+			static const char *names[] = {
+				"Host", "Connection", "Content-Length", "Transfer-Encoding",
+				"Upgrade", "Cookie", "X-Forwarded-For", "Accept"
+			};
+			static const char chars[] = "abcdefghijklmnopqrstuvwxyz-_.ABC0123456789";
+			if (random(2) == 0) {
+				return names[random(sizeof(names) / sizeof(const char *))];
+			}
+
+			string result;
+			unsigned int size = 1 + random(40);
+			for (unsigned int i = 0; i < size; i++) {
+				switch (random(50)) {
+				case 0:
+					// Not a token character.
+					result.append(1, (char) random(256));
+					break;
+				case 1:
+					result.append(1, ' ');
+					break;
+				default:
+					result.append(1, chars[random(sizeof(chars) - 1)]);
+					break;
+				}
+			}
+			return result;
+		}
+
+		string randomHeaderValue() {
+			static const char *values[] = {
+				"close", "keep-alive", "chunked", "123", " 45 ", "12a"
+			};
+			if (random(4) == 0) {
+				return values[random(sizeof(values) / sizeof(const char *))];
+			}
+
+			string result;
+			unsigned int size = random(300);
+			for (unsigned int i = 0; i < size; i++) {
+				switch (random(100)) {
+				case 0:
+					result.append(1, '\r');
+					break;
+				case 1:
+					result.append(1, '\n');
+					break;
+				case 2:
+					// Continuation line.
+					result.append("\r\n ");
+					break;
+				case 3:
+					result.append(1, (char) (128 + random(128)));
+					break;
+				case 4:
+					result.append(1, '\t');
+					break;
+				default:
+					result.append(1, (char) (32 + random(95)));
+					break;
+				}
+			}
+			return result;
+		}
+
+		string randomRequest() {
+			string result = "GET /foo?bar=baz HTTP/1.1\r\n";
+			unsigned int nheaders = random(12);
+			for (unsigned int i = 0; i < nheaders; i++) {
+				result.append(randomHeaderName());
+				result.append(random(10) == 0 ? ":" : ": ");
+				result.append(randomHeaderValue());
+				result.append(random(20) == 0 ? "\n" : "\r\n");
+			}
+			result.append("\r\n");
+			if (random(10) == 0) {
+				// Truncated request.
+				result.resize(random(result.size()));
+			}
+			return result;
+		}
+
+		vector<size_t> randomSplits(size_t size) {
+			vector<size_t> result;
+			size_t pos = 0;
+			while (pos < size) {
+				size_t piece = 1 + random(random(2) == 0 ? 8 : 200);
+				pos = std::min(pos + piece, size);
+				result.push_back(pos);
+			}
+			return result;
+		}
+
+		void describeString(string &result, const LString *str) {
+			const LString::Part *part = str->start;
+			result.append("[");
+			while (part != NULL) {
+				result.append(cEscapeString(StaticString(part->data, part->size)));
+				if (part->next != NULL) {
+					result.append("|");
+				}
+				part = part->next;
+			}
+			result.append("]");
+		}
+
+		void describeHeaders(string &result, const HeaderTable &headers) {
+			HeaderTable::ConstIterator it(headers);
+			while (*it != NULL) {
+				describeString(result, &it->header->origKey);
+				result.append(": ");
+				describeString(result, &it->header->val);
+				result.append("\n");
+				it.next();
+			}
+		}
+
+		void deinitializeHeaders(HeaderTable &headers) {
+			HeaderTable::Iterator it(headers);
+			while (*it != NULL) {
+				psg_lstr_deinit(&it->header->key);
+				psg_lstr_deinit(&it->header->origKey);
+				psg_lstr_deinit(&it->header->val);
+				it.next();
+			}
+			headers.clear();
+		}
+
+		/**
+		 * Parses `data`, fed in pieces that end at the given split points, and
+		 * returns a description of everything that the parser produced,
+		 * including how the header names and values are split over LString parts.
+		 */
+		string parse(const string &data, const vector<size_t> &splits) {
+			BaseHttpRequest req;
+			string result;
+			size_t pos = 0;
+
+			req.httpMajor = 1;
+			req.httpMinor = 0;
+			req.httpState = BaseHttpRequest::PARSING_HEADERS;
+			req.bodyType = BaseHttpRequest::RBT_NO_BODY;
+			req.method = HTTP_GET;
+			req.wantKeepAlive = false;
+			req.pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+			psg_lstr_init(&req.path);
+			req.aux.bodyInfo.contentLength = 0;
+			req.queryStringIndex = -1;
+			HttpHeaderParser<BaseHttpRequest> parser(&context, &state, &req, req.pool);
+			parser.initialize();
+
+			for (unsigned int i = 0; i < splits.size()
+				&& req.httpState == BaseHttpRequest::PARSING_HEADERS; i++)
+			{
+				size_t size = splits[i] - pos;
+				mbuf buffer(mbuf_get_with_size(&context.mbuf_pool, size));
+				memcpy(buffer.start, data.data() + pos, size);
+				buffer = mbuf(buffer, 0, size);
+				result.append("Consumed: " + toString(parser.feed(buffer)) + "\n");
+				pos = splits[i];
+			}
+
+			result.append("State: " + toString((int) req.httpState) + "\n");
+			if (req.httpState == BaseHttpRequest::ERROR) {
+				result.append("Error: " + toString(req.aux.parseError) + "\n");
+			} else if (req.httpState != BaseHttpRequest::PARSING_HEADERS) {
+				result.append("Path: ");
+				describeString(result, &req.path);
+				result.append("\nKeep-alive: " + toString(req.wantKeepAlive) + "\n");
+				result.append("Body type: " + toString((int) req.bodyType) + "\n");
+				describeHeaders(result, req.headers);
+			}
+
+			psg_lstr_deinit(&req.path);
+			deinitializeHeaders(req.headers);
+			deinitializeHeaders(req.secureHeaders);
+			psg_destroy_pool(req.pool);
+			return result;
+		}
+
+		string parseWithScanner(enum http_header_scanner scanner, const string &data,
+			const vector<size_t> &splits)
+		{
+			ensure(http_parser_set_header_scanner(scanner));
+			return parse(data, splits);
+		}
+
+		vector<http_header_scanner> supportedFastScanners() {
+			static const http_header_scanner scanners[] = {
+				HTTP_HEADER_SCANNER_SCALAR,
+				HTTP_HEADER_SCANNER_SSE42,
+				HTTP_HEADER_SCANNER_AVX2
+			};
+			vector<http_header_scanner> result;
+			for (unsigned int i = 0; i < sizeof(scanners) / sizeof(http_header_scanner); i++) {
+				if (http_parser_set_header_scanner(scanners[i])) {
+					result.push_back(scanners[i]);
+				}
+			}
+			return result;
+		}
+	};
+
+	DEFINE_TEST_GROUP(ServerKit_HttpHeaderParserTest);
+
+	TEST_METHOD(1) {
+		set_test_name("By default, the best header scanner that the CPU supports is used");
+		vector<http_header_scanner> scanners = supportedFastScanners();
+		ensure(http_parser_set_header_scanner(HTTP_HEADER_SCANNER_AUTO));
+		ensure(!scanners.empty());
+		ensure_equals((int) http_parser_get_header_scanner(), (int) scanners.back());
+	}
+
+	TEST_METHOD(2) {
+		set_test_name("Long header values are parsed correctly by all header scanners");
+		string cookie(5000, 'x');
+		string data = "GET / HTTP/1.1\r\n"
+			"Cookie: " + cookie + "\r\n"
+			"X-Forwarded-For: 1.2.3.4, 5.6.7.8\r\n\r\n";
+		vector<size_t> splits;
+		splits.push_back(data.size());
+		vector<http_header_scanner> scanners = supportedFastScanners();
+
+		for (unsigned int i = 0; i < scanners.size(); i++) {
+			string result = parseWithScanner(scanners[i], data, splits);
+			ensure("(" + toString(i) + ")", containsSubstring(result,
+				"[Cookie]: [" + cookie + "]\n"));
+			ensure("(" + toString(i) + ")", containsSubstring(result,
+				"[X-Forwarded-For]: [1.2.3.4, 5.6.7.8]\n"));
+		}
+	}
+
+	TEST_METHOD(3) {
+		set_test_name("All header scanners produce the same results as parsing "
+			"one byte at a time, on random requests that are fed in random pieces");
+		vector<http_header_scanner> scanners = supportedFastScanners();
+
+		for (unsigned int i = 0; i < 3000; i++) {
+			string data = randomRequest();
+			vector<size_t> splits = randomSplits(data.size());
+			string expected = parseWithScanner(HTTP_HEADER_SCANNER_NONE, data, splits);
+
+			for (unsigned int j = 0; j < scanners.size(); j++) {
+				string actual = parseWithScanner(scanners[j], data, splits);
+				if (actual != expected) {
+					fail(("Scanner " + toString((int) scanners[j]) +
+						" differs on request: \"" + cEscapeString(data) + "\"\n"
+						"Expected:\n" + expected + "\nActual:\n" + actual).c_str());
+				}
+			}
+		}
+	}
+
+	TEST_METHOD(4) {
+		set_test_name("All header scanners detect too large headers at the same byte "
+			"as parsing one byte at a time");
+		string data = "GET / HTTP/1.1\r\n"
+			"Cookie: " + string(HTTP_MAX_HEADER_SIZE, 'x') + "\r\n\r\n";
+		vector<size_t> splits = randomSplits(data.size());
+		string expected = parseWithScanner(HTTP_HEADER_SCANNER_NONE, data, splits);
+		vector<http_header_scanner> scanners = supportedFastScanners();
+
+		ensure(containsSubstring(expected, "State: " + toString((int) BaseHttpRequest::ERROR)));
+		for (unsigned int i = 0; i < scanners.size(); i++) {
+			ensure_equals(parseWithScanner(scanners[i], data, splits), expected);
+		}
+	}
+}
@@ -143,6 +143,30 @@ namespace tut {
 			// Continues in onRequestEarlyHalfClose()
 		}
 
+		void testDeferredResponse(MyClient *client, MyRequest *req, const LString *value) {
+			value = psg_lstr_make_contiguous(value, req->pool);
+			unsigned int delay = stringToUint(StaticString(value->start->data, value->size));
+			refRequest(req, __FILE__, __LINE__);
+			if (delay == 0) {
+				getContext()->libev->runLater(boost::bind(
+					&MyServer::respondDeferred, this, req));
+			} else {
+				getContext()->libev->runAfter(delay, boost::bind(
+					&MyServer::respondDeferred, this, req));
+			}
+		}
+
+		void respondDeferred(MyRequest *req) {
+			if (req->ended()) {
+				// Do nothing.
+			} else if (psg_lstr_cmp(&req->path, "/large_response")) {
+				testLargeResponse(static_cast<MyClient *>(req->client), req);
+			} else {
+				testRequest(static_cast<MyClient *>(req->client), req);
+			}
+			unrefRequest(req, __FILE__, __LINE__);
+		}
+
 		void testEarlyReadErrorDetection(MyClient *client, MyRequest *req) {
 			req->nextRequestEarlyReadError = ENOSPC;
 			writeSimpleResponse(client, 200, NULL, "OK");
@@ -161,8 +185,11 @@ namespace tut {
 
 		virtual void onRequestBegin(MyClient *client, MyRequest *req) {
 			ParentClass::onRequestBegin(client, req);
+			const LString *defer = req->headers.lookup("defer");
 
-			if (psg_lstr_cmp(&req->path, "/body_test")) {
+			if (defer != NULL) {
+				testDeferredResponse(client, req, defer);
+			} else if (psg_lstr_cmp(&req->path, "/body_test")) {
 				testBody(client, req);
 			} else if (psg_lstr_cmp(&req->path, "/body_stop_test")) {
 				testBodyStop(client, req);
@@ -240,6 +267,11 @@ namespace tut {
 			return allowUpgrades;
 		}
 
+		virtual void onPipelinedRequestParsed(MyClient *client, MyRequest *req) {
+			ParentClass::onPipelinedRequestParsed(client, req);
+			pipelinedRequestsParsed++;
+		}
+
 	public:
 		bool allowUpgrades;
 
@@ -247,13 +279,15 @@ namespace tut {
 		unsigned int bodyBytesRead;
 		unsigned int halfCloseDetected;
 		unsigned int clientDataErrors;
+		unsigned int pipelinedRequestsParsed;
 
 		MyServer(Context *context)
 			: ParentClass(context),
 			  allowUpgrades(true),
 			  bodyBytesRead(0),
 			  halfCloseDetected(0),
-			  clientDataErrors(0)
+			  clientDataErrors(0),
+			  pipelinedRequestsParsed(0)
 			{ }
 
 		void startAcceptingBody() {
@@ -386,6 +420,21 @@ namespace tut {
 			*result = server->bodyBytesRead;
 		}
 
+		void getPallocPoolRecyclerStats(boost::uint64_t *checkouts, boost::uint64_t *reuses,
+			boost::uint64_t *requests)
+		{
+			bg.safe->runSync(boost::bind(&ServerKit_HttpServerTest::_getPallocPoolRecyclerStats,
+				this, checkouts, reuses, requests));
+		}
+
+		void _getPallocPoolRecyclerStats(boost::uint64_t *checkouts, boost::uint64_t *reuses,
+			boost::uint64_t *requests)
+		{
+			*checkouts = context.pallocPoolRecycler.checkouts;
+			*reuses = context.pallocPoolRecycler.reuses;
+			*requests = context.pallocPoolRecycler.totalRequests;
+		}
+
 		unsigned int getActiveClientCount() {
 			unsigned int result;
 			bg.safe->runSync(boost::bind(&ServerKit_HttpServerTest::_getActiveClientCount,
@@ -433,6 +482,18 @@ namespace tut {
 			*result = server->clientDataErrors;
 		}
 
+		unsigned int getPipelinedRequestsParsed() {
+			unsigned int result;
+			bg.safe->runSync(boost::bind(
+				&ServerKit_HttpServerTest::_getPipelinedRequestsParsed,
+				this, &result));
+			return result;
+		}
+
+		void _getPipelinedRequestsParsed(unsigned int *result) {
+			*result = server->pipelinedRequestsParsed;
+		}
+
 		void startAcceptingBody() {
 			bg.safe->runLater(boost::bind(&ServerKit_HttpServerTest::_startAcceptingBody,
 				this));
@@ -462,6 +523,27 @@ namespace tut {
 			}
 		}
 
+		static void writeInRandomChunks(int fd, const string &data) {
+			string::size_type pos = 0;
+			while (pos < data.size()) {
+				string::size_type size = std::min<string::size_type>(
+					1 + rand() % 512, data.size() - pos);
+				writeExact(fd, data.data() + pos, size);
+				pos += size;
+			}
+		}
+
+		string createHelloResponse(const string &path, bool keepAlive) {
+			string body = "hello " + path;
+			return "HTTP/1.1 200 OK\r\n"
+				"Status: 200 OK\r\n"
+				"Content-Type: text/plain\r\n"
+				"Date: Thu, 11 Sep 2014 12:54:09 GMT\r\n"
+				"Connection: " + string(keepAlive ? "keep-alive" : "close") + "\r\n"
+				"Content-Length: " + toString(body.size()) + "\r\n\r\n" +
+				body;
+		}
+
 		string readResponseHeader() {
 			string result;
 			string line;
@@ -480,7 +562,7 @@ namespace tut {
 		}
 	};
 
-	DEFINE_TEST_GROUP_WITH_LIMIT(ServerKit_HttpServerTest, 100);
+	DEFINE_TEST_GROUP_WITH_LIMIT(ServerKit_HttpServerTest, 110);
 
 
 	/***** Valid HTTP header parsing *****/
@@ -1727,4 +1809,109 @@ namespace tut {
 			result = getActiveClientCount() == 0;
 		);
 	}
+
+	TEST_METHOD(98) {
+		set_test_name("Keep-alive requests reuse palloc pools through the context's recycler");
+		boost::uint64_t checkouts, reuses, requests;
+
+		connectToServer();
+		sendRequest(
+			"GET / HTTP/1.1\r\n"
+			"Connection: keep-alive\r\n"
+			"Host: foo\r\n\r\n"
+			"GET /foo HTTP/1.1\r\n"
+			"Connection: close\r\n"
+			"Host: foo\r\n\r\n");
+		readAll(fd);
+
+		EVENTUALLY(5,
+			getPallocPoolRecyclerStats(&checkouts, &reuses, &requests);
+			result = requests == 2;
+		);
+		ensure_equals("(1)", checkouts, 2u);
+		ensure_equals("(2)", reuses, 1u);
+	}
+
+
+	/***** Pipelining *****/
+
+	TEST_METHOD(100) {
+		set_test_name("Pipelined requests are parsed while the previous request is being processed");
+
+		connectToServer();
+		sendRequest(
+			"GET /1 HTTP/1.1\r\n"
+			"Host: foo\r\n"
+			"Defer: 200\r\n\r\n"
+			"GET /2 HTTP/1.1\r\n"
+			"Host: foo\r\n\r\n"
+			"GET /3 HTTP/1.1\r\n"
+			"Connection: close\r\n"
+			"Host: foo\r\n\r\n");
+		EVENTUALLY(5,
+			result = getPipelinedRequestsParsed() == 1;
+		);
+		ensure_equals(getTotalRequestsBegun(), 1u);
+
+		ensure_equals(readAll(fd),
+			createHelloResponse("/1", true) +
+			createHelloResponse("/2", true) +
+			createHelloResponse("/3", false));
+	}
+
+	TEST_METHOD(101) {
+		set_test_name("If the next request is pipelined, it is begun before the previous "
+			"response is flushed, and the responses are written in order");
+
+		connectToServer();
+		sendRequest(
+			"GET /large_response HTTP/1.1\r\n"
+			"Host: foo\r\n"
+			"Size: 1000000\r\n"
+			"Defer: 10\r\n\r\n"
+			"GET /foo HTTP/1.1\r\n"
+			"Connection: close\r\n"
+			"Host: foo\r\n\r\n");
+		EVENTUALLY(5,
+			result = getTotalRequestsBegun() == 2;
+		);
+
+		string data = readAll(fd);
+		string response2 = createHelloResponse("/foo", false);
+		string body = stripHeaders(data);
+		ensure(startsWith(data, "HTTP/1.1 200 OK\r\n"));
+		ensure_equals(body.size(), 1000000u + response2.size());
+		ensure_equals(body.substr(0, 1000000), string(1000000, 'x'));
+		ensure_equals(body.substr(1000000), response2);
+	}
+
+	TEST_METHOD(102) {
+		set_test_name("Pipelining load test");
+		const unsigned int REQUESTS = 2000;
+		string requests, expectedResponses;
+
+		for (unsigned int i = 0; i < REQUESTS; i++) {
+			bool last = i == REQUESTS - 1;
+			string path = "/" + toString(i);
+
+			requests.append("GET " + path + " HTTP/1.1\r\n"
+				"Host: foo\r\n");
+			if (i % 3 != 0) {
+				requests.append("Defer: 0\r\n");
+			}
+			if (last) {
+				requests.append("Connection: close\r\n");
+			}
+			requests.append("\r\n");
+			expectedResponses.append(createHelloResponse(path, !last));
+		}
+
+		connectToServer();
+		TempThread writer(boost::bind(writeInRandomChunks, (int) fd, requests));
+		string responses = readAll(fd);
+		ensure_equals(responses.size(), expectedResponses.size());
+		ensure(responses == expectedResponses);
+		ensure_equals(getTotalRequestsBegun(), (unsigned long) REQUESTS);
+		ensure(getPipelinedRequestsParsed() > 0);
+	}
 }
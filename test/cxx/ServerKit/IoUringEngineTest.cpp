@@ -0,0 +1,297 @@
+#include <TestSupport.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <BackgroundEventLoop.h>
+#include <FileDescriptor.h>
+#include <Logging.h>
+#include <ServerKit/IoUringEngine.h>
+#include <ServerKit/FileBufferedChannel.h>
+#include <Utils/StrIntUtils.h>
+
+using namespace Passenger;
+using namespace Passenger::ServerKit;
+using namespace Passenger::MemoryKit;
+using namespace std;
+
+namespace tut {
+	struct IoUringEngineTest_StressChannel: public ServerKit::Hooks {
+		FileBufferedChannel channel;
+		string received;
+		bool eof;
+
+		IoUringEngineTest_StressChannel(Context *context)
+			: channel(context),
+			  eof(false)
+		{
+			Hooks::impl = NULL;
+			Hooks::userData = NULL;
+			channel.setHooks(this);
+		}
+	};
+
+	struct ServerKit_IoUringEngineTest {
+		typedef IoUringEngineTest_StressChannel StressChannel;
+
+		BackgroundEventLoop bg;
+		ServerKit::Context context;
+		vector<StressChannel *> channels;
+		boost::mutex syncher;
+		unsigned int finished;
+		string tmpFile;
+
+		ServerKit_IoUringEngineTest()
+			: bg(false, true),
+			  context(bg.safe, bg.libuv_loop),
+			  finished(0)
+			{ }
+
+		~ServerKit_IoUringEngineTest() {
+			if (bg.isStarted()) {
+				bg.safe->runSync(boost::bind(&ServerKit_IoUringEngineTest::destroyChannels,
+					this));
+			} else {
+				destroyChannels();
+			}
+			bg.stop();
+			if (!tmpFile.empty()) {
+				unlink(tmpFile.c_str());
+			}
+			setLogLevel(DEFAULT_LOG_LEVEL);
+		}
+
+		bool ioUringAvailable(unsigned int entries = IoUringEngine::DEFAULT_ENTRIES) {
+			int e = context.enableIoUring(entries);
+			if (e != 0) {
+				P_WARN("io_uring is not available, skipping test: " << strerror(e));
+				return false;
+			}
+			return true;
+		}
+
+		void destroyChannels() {
+			for (unsigned int i = 0; i < channels.size(); i++) {
+				channels[i]->channel.deinitialize();
+				delete channels[i];
+			}
+			channels.clear();
+		}
+
+		static string chunkData(unsigned int channel, unsigned int chunk) {
+			string result = toString(channel) + ":" + toString(chunk) + ";";
+			result.append(1000 - result.size(), (char) ('a' + (channel + chunk) % 26));
+			return result;
+		}
+
+		static Channel::Result stressDataCallback(Channel *_channel, const mbuf &buffer,
+			int errcode)
+		{
+			FileBufferedChannel *channel = reinterpret_cast<FileBufferedChannel *>(_channel);
+			StressChannel *stressChannel = static_cast<StressChannel *>(channel->getHooks());
+			ServerKit_IoUringEngineTest *self = static_cast<ServerKit_IoUringEngineTest *>(
+				stressChannel->userData);
+
+			if (errcode != 0) {
+				stressChannel->received.append("Error: " + toString(errcode));
+				return Channel::Result(0, true);
+			} else if (buffer.empty()) {
+				boost::lock_guard<boost::mutex> l(self->syncher);
+				stressChannel->eof = true;
+				self->finished++;
+				return Channel::Result(0, true);
+			} else {
+				// Simulate a slow client: consume the buffer in a later
+				// event loop iteration, so that the data piles up and the
+				// channel spills it to its temp file.
+				stressChannel->received.append(buffer.start, buffer.size());
+				self->bg.safe->runLater(boost::bind(&FileBufferedChannel::consumed,
+					&stressChannel->channel, buffer.size(), false));
+				return Channel::Result(-1, false);
+			}
+		}
+
+		void createAndFeedStressChannels(unsigned int nchannels, unsigned int nchunks) {
+			for (unsigned int i = 0; i < nchannels; i++) {
+				StressChannel *stressChannel = new StressChannel(&context);
+				stressChannel->userData = this;
+				stressChannel->channel.setDataCallback(stressDataCallback);
+				channels.push_back(stressChannel);
+			}
+			for (unsigned int j = 0; j < nchunks; j++) {
+				for (unsigned int i = 0; i < nchannels; i++) {
+					string data = chunkData(i, j);
+					mbuf buffer(mbuf_get_with_size(&context.mbuf_pool, data.size()));
+					memcpy(buffer.start, data.data(), data.size());
+					channels[i]->channel.feed(mbuf(buffer, 0, data.size()));
+				}
+			}
+			for (unsigned int i = 0; i < nchannels; i++) {
+				channels[i]->channel.feed(mbuf());
+			}
+		}
+
+		void checkStressChannels(unsigned int nchannels, unsigned int nchunks) {
+			for (unsigned int i = 0; i < nchannels; i++) {
+				string expected;
+				for (unsigned int j = 0; j < nchunks; j++) {
+					expected.append(chunkData(i, j));
+				}
+				if (channels[i]->received != expected) {
+					fail(("Channel " + toString(i) + " received the wrong data").c_str());
+				}
+			}
+		}
+
+		void runStressTest(unsigned int nchannels, unsigned int nchunks) {
+			context.defaultFileBufferedChannelConfig.threshold = 4096;
+			bg.start();
+			bg.safe->runSync(boost::bind(
+				&ServerKit_IoUringEngineTest::createAndFeedStressChannels,
+				this, nchannels, nchunks));
+			EVENTUALLY(30,
+				boost::lock_guard<boost::mutex> l(syncher);
+				result = finished == nchannels;
+			);
+			checkStressChannels(nchannels, nchunks);
+		}
+
+		Json::Value inspectIoUringEngine() {
+			Json::Value result;
+			bg.safe->runSync(boost::bind(&ServerKit_IoUringEngineTest::_inspectIoUringEngine,
+				this, &result));
+			return result;
+		}
+
+		void _inspectIoUringEngine(Json::Value *result) {
+			*result = context.ioUringEngine->inspectStateAsJson();
+		}
+
+		int createTmpFile() {
+			char path[] = "/tmp/passenger-io-uring-test.XXXXXX";
+			int fd = mkstemp(path);
+			if (fd == -1) {
+				int e = errno;
+				throw FileSystemException("Cannot create a temp file", e, path);
+			}
+			tmpFile = path;
+			return fd;
+		}
+	};
+
+	DEFINE_TEST_GROUP(ServerKit_IoUringEngineTest);
+
+	struct IoUringEngineTest_Request {
+		uv_fs_t req;
+		uv_buf_t buf;
+		char data[16];
+		ssize_t *result;
+	};
+
+	static void ioUringEngineTestRequestDone(uv_fs_t *req) {
+		IoUringEngineTest_Request *request = (IoUringEngineTest_Request *) req->data;
+		uv_fs_req_cleanup(req);
+		*request->result = req->result;
+	}
+
+	TEST_METHOD(1) {
+		set_test_name("Operations that are started in the same event loop iteration "
+			"are submitted together, and complete with their libuv callbacks");
+		if (!ioUringAvailable()) {
+			return;
+		}
+
+		FileDescriptor fd(createTmpFile(), __FILE__, __LINE__);
+		IoUringEngineTest_Request writes[4], read;
+		ssize_t results[5] = { -1, -1, -1, -1, -1 };
+		IoUringEngine *engine = context.ioUringEngine;
+
+		for (unsigned int i = 0; i < 4; i++) {
+			memset(writes[i].data, 'a' + i, sizeof(writes[i].data));
+			writes[i].buf = uv_buf_init(writes[i].data, sizeof(writes[i].data));
+			writes[i].req.data = &writes[i];
+			writes[i].result = &results[i];
+			ensure_equals(engine->write(&writes[i].req, fd, &writes[i].buf,
+				i * sizeof(writes[i].data), ioUringEngineTestRequestDone), 0);
+		}
+		ensure_equals(engine->getInFlight(), 4u);
+		engine->submit();
+		ensure_equals(engine->submitCalls, (boost::uint64_t) 1);
+
+		while (engine->getInFlight() > 0) {
+			usleep(1000);
+			engine->processCompletions();
+		}
+		for (unsigned int i = 0; i < 4; i++) {
+			ensure_equals(results[i], (ssize_t) sizeof(writes[i].data));
+		}
+
+		read.buf = uv_buf_init(read.data, sizeof(read.data));
+		read.req.data = &read;
+		read.result = &results[4];
+		ensure_equals(engine->read(&read.req, fd, &read.buf, 2 * sizeof(read.data),
+			ioUringEngineTestRequestDone), 0);
+		bg.start();
+		EVENTUALLY(5,
+			result = results[4] != -1;
+		);
+		ensure_equals(results[4], (ssize_t) sizeof(read.data));
+		ensure_equals(string(read.data, sizeof(read.data)), string(sizeof(read.data), 'c'));
+	}
+
+	TEST_METHOD(2) {
+		set_test_name("Errors are passed to the callback as libuv error codes");
+		if (!ioUringAvailable()) {
+			return;
+		}
+
+		IoUringEngineTest_Request request;
+		ssize_t ret = 0;
+
+		request.buf = uv_buf_init(request.data, sizeof(request.data));
+		request.req.data = &request;
+		request.result = &ret;
+		ensure_equals(context.ioUringEngine->read(&request.req, 999999, &request.buf, 0,
+			ioUringEngineTestRequestDone), 0);
+		bg.start();
+		EVENTUALLY(5,
+			result = ret != 0;
+		);
+		ensure_equals(ret, (ssize_t) UV_EBADF);
+	}
+
+	TEST_METHOD(3) {
+		set_test_name("Hundreds of channels that spill to disk at the same time "
+			"all pass their data through intact");
+		if (!ioUringAvailable()) {
+			return;
+		}
+
+		runStressTest(300, 48);
+		Json::Value doc = inspectIoUringEngine();
+		ensure("(1)", doc["completed"].asUInt64() > 0);
+		ensure("(2)", doc["submit_calls"].asUInt64() < doc["queued"].asUInt64());
+		ensure_equals("(3)", doc["in_flight"].asUInt(), 0u);
+	}
+
+	TEST_METHOD(4) {
+		set_test_name("If the ring is full, channels fall back to libuv's thread pool");
+		if (!ioUringAvailable(4)) {
+			return;
+		}
+
+		runStressTest(300, 48);
+		Json::Value doc = inspectIoUringEngine();
+		ensure("(1)", doc["completed"].asUInt64() > 0);
+		ensure_equals("(2)", doc["in_flight"].asUInt(), 0u);
+	}
+
+	TEST_METHOD(5) {
+		set_test_name("Without an engine, hundreds of spilling channels go through "
+			"libuv's thread pool");
+		runStressTest(300, 48);
+	}
+}
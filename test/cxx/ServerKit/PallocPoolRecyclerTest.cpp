@@ -0,0 +1,128 @@
+#include <TestSupport.h>
+#include <ServerKit/PallocPoolRecycler.h>
+
+using namespace Passenger;
+using namespace Passenger::ServerKit;
+using namespace std;
+
+namespace tut {
+	struct ServerKit_PallocPoolRecyclerTest {
+		PallocPoolRecycler recycler;
+
+		ServerKit_PallocPoolRecyclerTest()
+			: recycler(PSG_DEFAULT_POOL_SIZE, 2, 1)
+			{ }
+	};
+
+	DEFINE_TEST_GROUP(ServerKit_PallocPoolRecyclerTest);
+
+	static void growPool(psg_pool_t *pool) {
+		while (pool->data.next == NULL) {
+			psg_palloc(pool, 1000);
+		}
+	}
+
+	TEST_METHOD(1) {
+		set_test_name("Checked in pools are reused");
+		psg_pool_t *pool = recycler.checkout();
+		ensure("(1)", pool != NULL);
+		ensure_equals("(2)", recycler.reuses, 0u);
+
+		recycler.checkin(pool);
+		ensure_equals("(3)", recycler.getSingleBlockPoolCount(), 1u);
+		ensure_equals<void *>("(4)", recycler.checkout(), pool);
+		ensure_equals("(5)", recycler.reuses, 1u);
+		ensure_equals("(6)", recycler.checkouts, 2u);
+		recycler.checkin(pool);
+	}
+
+	TEST_METHOD(2) {
+		set_test_name("Grown pools are kept in a separate tier, "
+			"and single-block pools are preferred");
+		psg_pool_t *pool1 = recycler.checkout();
+		psg_pool_t *pool2 = recycler.checkout();
+
+		growPool(pool1);
+		recycler.checkin(pool1);
+		recycler.checkin(pool2);
+		ensure_equals("(1)", recycler.getSingleBlockPoolCount(), 1u);
+		ensure_equals("(2)", recycler.getGrownPoolCount(), 1u);
+
+		ensure_equals<void *>("(3)", recycler.checkout(), pool2);
+		ensure_equals<void *>("(4)", recycler.checkout(), pool1);
+		ensure("(5) The grown pool is still usable", psg_palloc(pool1, 100) != NULL);
+		recycler.checkin(pool1);
+		recycler.checkin(pool2);
+	}
+
+	TEST_METHOD(3) {
+		set_test_name("Each tier is bounded");
+		psg_pool_t *pools[5];
+		unsigned int i;
+
+		for (i = 0; i < 5; i++) {
+			pools[i] = recycler.checkout();
+		}
+		growPool(pools[3]);
+		growPool(pools[4]);
+		for (i = 0; i < 5; i++) {
+			recycler.checkin(pools[i]);
+		}
+		ensure_equals("(1)", recycler.getSingleBlockPoolCount(), 2u);
+		ensure_equals("(2)", recycler.getGrownPoolCount(), 1u);
+		ensure_equals("(3)", recycler.compact(), 3u);
+		ensure_equals("(4)", recycler.getSingleBlockPoolCount(), 0u);
+		ensure_equals("(5)", recycler.getGrownPoolCount(), 0u);
+	}
+
+	TEST_METHOD(4) {
+		set_test_name("It records how many bytes each request allocated");
+		psg_pool_t *pool = recycler.checkout();
+		psg_palloc(pool, 100);
+		recycler.checkin(pool);
+
+		pool = recycler.checkout();
+		psg_palloc(pool, 3000);
+		recycler.checkin(pool);
+
+		pool = recycler.checkout();
+		psg_palloc(pool, 1024 * 1024);
+		recycler.checkin(pool);
+
+		ensure_equals("(1)", recycler.totalRequests, 3u);
+		ensure_equals("(2)", recycler.histogram[0], 1u);
+		ensure_equals("(3)", recycler.histogram[2], 1u);
+		ensure_equals("(4)", recycler.histogram[PallocPoolRecycler::HISTOGRAM_BUCKETS - 1], 1u);
+		ensure("(5)", recycler.maxAllocated >= 1024u * 1024u);
+		ensure("(6)", recycler.totalAllocated >= 1024u * 1024u + 3100u);
+	}
+
+	TEST_METHOD(5) {
+		set_test_name("The total size of retained large allocations is bounded");
+		PallocPoolRecycler recycler(PSG_DEFAULT_POOL_SIZE, 4, 1, 40 * 1024);
+		psg_pool_t *pools[3];
+		unsigned int i;
+
+		for (i = 0; i < 3; i++) {
+			pools[i] = recycler.checkout();
+			psg_palloc(pools[i], 16 * 1024);
+		}
+		for (i = 0; i < 3; i++) {
+			recycler.checkin(pools[i]);
+		}
+		ensure_equals("(1)", recycler.getSingleBlockPoolCount(), 3u);
+		ensure_equals("(2)", psg_pool_retained_size(pools[0]), 16u * 1024u);
+		ensure_equals("(3)", psg_pool_retained_size(pools[1]), 16u * 1024u);
+		ensure_equals("(4) The third pool's buffer is freed",
+			psg_pool_retained_size(pools[2]), 0u);
+		ensure_equals("(5)", recycler.getRetainedBytes(), 32u * 1024u);
+
+		ensure_equals<void *>("(6)", recycler.checkout(), pools[2]);
+		ensure_equals<void *>("(7)", recycler.checkout(), pools[1]);
+		ensure_equals("(8)", recycler.getRetainedBytes(), 16u * 1024u);
+		recycler.checkin(pools[1]);
+		recycler.checkin(pools[2]);
+		ensure_equals("(9)", recycler.compact(), 3u);
+		ensure_equals("(10)", recycler.getRetainedBytes(), 0u);
+	}
+}
@@ -3,11 +3,20 @@
 
 using namespace Passenger;
 using namespace Passenger::UstRouter;
+using namespace Passenger::MemoryKit;
 using namespace std;
 
 namespace tut {
 	struct UstRouter_TransactionTest {
+		struct mbuf_pool pool;
+
 		UstRouter_TransactionTest() {
+			pool.mbuf_block_chunk_size = 1024;
+			mbuf_pool_init(&pool, true);
+		}
+
+		~UstRouter_TransactionTest() {
+			mbuf_pool_deinit(&pool);
 		}
 	};
 
@@ -15,7 +24,7 @@ namespace tut {
 
 	TEST_METHOD(1) {
 		set_test_name("Constructor");
-		Transaction t("txnId", "groupName", "nodeName", "category",
+		Transaction t(&pool, "txnId", "groupName", "nodeName", "category",
 			"unionStationKey", 1234, "filters");
 		ensure_equals("(1)", t.getTxnId(), "txnId");
 		ensure_equals("(2)", t.getGroupName(), "groupName");
@@ -23,24 +32,24 @@ namespace tut {
 		ensure_equals("(4)", t.getCategory(), "category");
 		ensure_equals("(5)", t.getUnionStationKey(), "unionStationKey");
 		ensure_equals("(6)", t.getFilters(), "filters");
-		ensure_equals("(7)", t.getBody(), "");
+		ensure_equals("(7)", t.getBodyAsString(), "");
 	}
 
 	TEST_METHOD(2) {
 		set_test_name("Appending body data");
-		Transaction t("txnId", "groupName", "nodeName", "category",
+		Transaction t(&pool, "txnId", "groupName", "nodeName", "category",
 			"unionStationKey", 1234, "filters");
 
 		t.append("timestamp1", "body1");
 		t.append("timestamp2", "body2");
-		ensure_equals(t.getBody(),
+		ensure_equals(t.getBodyAsString(),
 			"txnId timestamp1 0 body1\n"
 			"txnId timestamp2 1 body2\n");
 	}
 
 	TEST_METHOD(3) {
 		set_test_name("Move constructor");
-		Transaction t("txnId", "groupName", "nodeName", "category",
+		Transaction t(&pool, "txnId", "groupName", "nodeName", "category",
 			"unionStationKey", 1234, "filters");
 		t.append("timestamp1", "body1");
 		t.append("timestamp2", "body2");
@@ -53,7 +62,7 @@ namespace tut {
 		ensure_equals("(4)", t.getCategory(), "");
 		ensure_equals("(5)", t.getUnionStationKey(), "");
 		ensure_equals("(6)", t.getFilters(), "");
-		ensure_equals("(7)", t.getBody(), "");
+		ensure_equals("(7)", t.getBodyAsString(), "");
 
 		ensure_equals("(11)", t2.getTxnId(), "txnId");
 		ensure_equals("(12)", t2.getGroupName(), "groupName");
@@ -61,19 +70,19 @@ namespace tut {
 		ensure_equals("(14)", t2.getCategory(), "category");
 		ensure_equals("(15)", t2.getUnionStationKey(), "unionStationKey");
 		ensure_equals("(16)", t2.getFilters(), "filters");
-		ensure_equals("(17)", t2.getBody(),
+		ensure_equals("(17)", t2.getBodyAsString(),
 			"txnId timestamp1 0 body1\n"
 			"txnId timestamp2 1 body2\n");
 	}
 
 	TEST_METHOD(4) {
 		set_test_name("Move assignment");
-		Transaction t("txnId", "groupName", "nodeName", "category",
+		Transaction t(&pool, "txnId", "groupName", "nodeName", "category",
 			"unionStationKey", 1234, "filters");
 		t.append("timestamp1", "body1");
 		t.append("timestamp2", "body2");
 
-		Transaction t2("txnId2", "groupName2", "nodeName2", "category2",
+		Transaction t2(&pool, "txnId2", "groupName2", "nodeName2", "category2",
 			"unionStationKey2", 4321, "filters2");
 		t2 = boost::move(t);
 
@@ -83,7 +92,7 @@ namespace tut {
 		ensure_equals("(4)", t.getCategory(), "");
 		ensure_equals("(5)", t.getUnionStationKey(), "");
 		ensure_equals("(6)", t.getFilters(), "");
-		ensure_equals("(7)", t.getBody(), "");
+		ensure_equals("(7)", t.getBodyAsString(), "");
 
 		ensure_equals("(11)", t2.getTxnId(), "txnId");
 		ensure_equals("(12)", t2.getGroupName(), "groupName");
@@ -91,15 +100,15 @@ namespace tut {
 		ensure_equals("(14)", t2.getCategory(), "category");
 		ensure_equals("(15)", t2.getUnionStationKey(), "unionStationKey");
 		ensure_equals("(16)", t2.getFilters(), "filters");
-		ensure_equals("(17)", t2.getBody(),
+		ensure_equals("(17)", t2.getBodyAsString(),
 			"txnId timestamp1 0 body1\n"
 			"txnId timestamp2 1 body2\n");
 	}
 
 	TEST_METHOD(5) {
-		set_test_name("Expanding the storage area");
-		Transaction t("txnId", "groupName", "nodeName", "category",
-			"unionStationKey", 1234, "filters", 128);
+		set_test_name("Appending more data than fits in a single block");
+		Transaction t(&pool, "txnId", "groupName", "nodeName", "category",
+			"unionStationKey", 1234, "filters");
 		string body1(1024, 'x');
 		string body2(1024, 'y');
 
@@ -112,8 +121,30 @@ namespace tut {
 		ensure_equals("(4)", t.getCategory(), "category");
 		ensure_equals("(5)", t.getUnionStationKey(), "unionStationKey");
 		ensure_equals("(6)", t.getFilters(), "filters");
-		ensure_equals("(7)", t.getBody(),
+		ensure_equals("(7)", t.getBodyAsString(),
 			"txnId timestamp1 0 " + body1 + "\n"
 			"txnId timestamp2 1 " + body2 + "\n");
 	}
+
+	TEST_METHOD(6) {
+		set_test_name("getBody() returns references to the body's blocks, "
+			"trimmed to the data");
+		Transaction t(&pool, "txnId", "groupName", "nodeName", "category",
+			"unionStationKey", 1234, "filters");
+		string body1(1500, 'x');
+		vector<mbuf> buffers;
+		string data;
+
+		t.append("timestamp1", body1);
+		t.append("timestamp2", "body2");
+		t.getBody(buffers);
+
+		ensure("(1)", buffers.size() > 1);
+		for (unsigned int i = 0; i < buffers.size(); i++) {
+			data.append(buffers[i].start, buffers[i].size());
+		}
+		ensure_equals("(2)", data, t.getBodyAsString());
+		ensure_equals("(3)", data.size(), t.getBodySize());
+		ensure_equals("(4)", buffers[0].mbuf_block->refcount, 2u);
+	}
 }
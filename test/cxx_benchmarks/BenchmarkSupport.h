@@ -0,0 +1,186 @@
+#ifndef _PASSENGER_BENCHMARK_SUPPORT_H_
+#define _PASSENGER_BENCHMARK_SUPPORT_H_
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <time.h>
+#include <boost/cstdint.hpp>
+
+namespace Passenger {
+namespace Benchmarks {
+
+using namespace std;
+
+
+typedef void (*BenchmarkFunction)();
+
+struct BenchmarkRegistration {
+	const char *name;
+	BenchmarkFunction func;
+};
+
+vector<BenchmarkRegistration> &getBenchmarks();
+
+struct BenchmarkRegistrar {
+	BenchmarkRegistrar(const char *name, BenchmarkFunction func) {
+		BenchmarkRegistration reg;
+		reg.name = name;
+		reg.func = func;
+		getBenchmarks().push_back(reg);
+	}
+};
+
+#define DEFINE_BENCHMARK(name) \
+	static void benchmark_ ## name(); \
+	static Passenger::Benchmarks::BenchmarkRegistrar benchmark_registrar_ ## name( \
+		#name, benchmark_ ## name); \
+	static void benchmark_ ## name()
+
+
+inline boost::uint64_t
+monotonicNanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (boost::uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Reports the result of a single benchmark case. If `bytesPerIteration` is
+ * nonzero, then the throughput is reported too. If `allocationsPerIteration`
+ * is not negative, then it is reported as well.
+ */
+void report(const string &benchmark, const string &variant,
+	boost::uint64_t iterations, boost::uint64_t elapsedNs,
+	boost::uint64_t bytesPerIteration = 0,
+	double allocationsPerIteration = -1);
+
+/**
+ * Whether getAllocationCount() works on this platform.
+ */
+bool allocationCountingSupported();
+
+/**
+ * The number of malloc(), calloc() and realloc() calls made by the
+ * benchmark program so far, including those made by `operator new`.
+ */
+boost::uint64_t getAllocationCount();
+
+/**
+ * The minimum amount of time that a BenchmarkLoop runs for, as set by the
+ * `-t` command line option.
+ */
+boost::uint64_t getMinTimeNs();
+
+
+/**
+ * Runs the body of a benchmark case as often as necessary to obtain a
+ * stable measurement, and reports the result once done:
+ *
+ *     BenchmarkLoop loop("header_table", "lookup/hit");
+ *     while (loop.keepRunning()) {
+ *         ...
+ *     }
+ *
+ * The loop starts with a single iteration and keeps growing the iteration
+ * count until a whole batch takes at least getMinTimeNs(). Only the last
+ * batch is reported, so setup code before the loop is not measured.
+ */
+class BenchmarkLoop {
+private:
+	static const boost::uint64_t MAX_ITERATIONS = 1000000000;
+
+	string benchmark;
+	string variant;
+	boost::uint64_t iterations;
+	boost::uint64_t remaining;
+	boost::uint64_t bytesPerIteration;
+	boost::uint64_t startTime;
+	boost::uint64_t startAllocations;
+	bool countAllocations;
+
+	bool nextBatch() {
+		boost::uint64_t elapsed = monotonicNanoseconds() - startTime;
+		boost::uint64_t minTime = getMinTimeNs();
+
+		if (elapsed >= minTime || iterations >= MAX_ITERATIONS) {
+			double allocations = -1;
+			if (countAllocations) {
+				allocations = (double) (getAllocationCount() - startAllocations)
+					/ iterations;
+			}
+			report(benchmark, variant, iterations, elapsed, bytesPerIteration,
+				allocations);
+			return false;
+		}
+
+		// Aim 40% past the minimum time so that we usually need only one more
+		// batch, but grow by at most 10x when the last batch was too short to
+		// predict anything.
+		double multiplier;
+		if (elapsed * 10 > minTime) {
+			multiplier = 1.4 * minTime / elapsed;
+		} else {
+			multiplier = 10;
+		}
+		iterations = std::min<boost::uint64_t>(MAX_ITERATIONS,
+			std::max<boost::uint64_t>(iterations + 1, iterations * multiplier));
+		remaining = iterations - 1;
+		startAllocations = getAllocationCount();
+		startTime = monotonicNanoseconds();
+		return true;
+	}
+
+public:
+	BenchmarkLoop(const string &_benchmark, const string &_variant)
+		: benchmark(_benchmark),
+		  variant(_variant),
+		  iterations(1),
+		  remaining(1),
+		  bytesPerIteration(0),
+		  startTime(monotonicNanoseconds()),
+		  startAllocations(getAllocationCount()),
+		  countAllocations(false)
+		{ }
+
+	/**
+	 * Lets the report include the throughput, given the number of bytes that
+	 * a single iteration processes.
+	 */
+	void setBytesPerIteration(boost::uint64_t bytes) {
+		bytesPerIteration = bytes;
+	}
+
+	/**
+	 * Lets the report include the average number of memory allocations
+	 * that a single iteration makes, if the platform supports counting them.
+	 */
+	void setCountAllocations(bool enabled) {
+		countAllocations = enabled && allocationCountingSupported();
+	}
+
+	bool keepRunning() {
+		if (remaining > 0) {
+			remaining--;
+			return true;
+		} else {
+			return nextBatch();
+		}
+	}
+};
+
+/**
+ * Prevents the compiler from optimizing away a computed value.
+ */
+template<typename T>
+inline void
+doNotOptimize(const T &value) {
+	__asm__ __volatile__("" : : "g"(value) : "memory");
+}
+
+
+} // namespace Benchmarks
+} // namespace Passenger
+
+#endif /* _PASSENGER_BENCHMARK_SUPPORT_H_ */
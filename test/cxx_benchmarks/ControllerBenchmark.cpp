@@ -0,0 +1,128 @@
+/*
+ * Measures how long the Core takes to construct the request header that it
+ * sends to the application, for both the 'session' and the 'http' protocol.
+ * The request is a parsed browser request, as forwarded by a web server.
+ */
+#include "BenchmarkSupport.h"
+#include "HttpRequestSamples.h"
+#include <sys/uio.h>
+#include <BackgroundEventLoop.h>
+#include <Constants.h>
+#include <Logging.h>
+#include <Utils/VariantMap.h>
+#include <MemoryKit/palloc.h>
+#include <Core/Controller.h>
+#include <Core/ApplicationPool/TestSession.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+using namespace Passenger::Core;
+
+namespace {
+
+void
+initOptions(VariantMap &options) {
+	options.setInt("stat_throttle_rate", DEFAULT_STAT_THROTTLE_RATE);
+	options.setInt("response_buffer_high_watermark", DEFAULT_RESPONSE_BUFFER_HIGH_WATERMARK);
+	options.setBool("show_version_in_header", true);
+	options.setBool("sticky_sessions", false);
+	options.setBool("core_graceful_exit", true);
+	options.setBool("multi_app", false);
+	options.set("environment", DEFAULT_APP_ENV);
+	options.set("app_root", "stub/rack");
+	options.set("app_type", "dummy");
+	options.set("startup_file", "none");
+	options.set("default_ruby", DEFAULT_RUBY);
+	options.set("default_server_name", "localhost");
+	options.setInt("default_server_port", 80);
+	options.set("server_software", PROGRAM_NAME);
+	options.set("sticky_sessions_cookie_name", DEFAULT_STICKY_SESSIONS_COOKIE_NAME);
+	options.setBool("user_switching", false);
+	options.setInt("min_instances", 1);
+	options.setInt("spawn_concurrency", DEFAULT_SPAWN_CONCURRENCY);
+	options.setInt("standby_processes", 0);
+	options.setBool("predictive_scaling", false);
+	options.setInt("memory_limit", 0);
+	options.setInt("memory_limit_recycle_percentage", DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE);
+	options.setInt("max_preloader_idle_time", DEFAULT_MAX_PRELOADER_IDLE_TIME);
+	options.setInt("max_request_queue_size", DEFAULT_MAX_REQUEST_QUEUE_SIZE);
+	options.set("routing_policy", DEFAULT_ROUTING_POLICY);
+	options.setBool("abort_websockets_on_process_shutdown", true);
+	options.setInt("force_max_concurrent_requests_per_process", -1);
+	options.set("spawn_method", DEFAULT_SPAWN_METHOD);
+	options.setBool("load_shell_envvars", false);
+}
+
+void
+runSessionProtocol(Controller &controller, Request *req) {
+	char buffer[16 * 1024];
+	unsigned int size = controller.constructSessionProtocolHeader(req,
+		buffer, sizeof(buffer));
+
+	if (size == 0) {
+		fprintf(stderr, "Cannot construct the session protocol header\n");
+		abort();
+	}
+
+	BenchmarkLoop loop("controller_header_construction", "session_protocol");
+	loop.setBytesPerIteration(size);
+	while (loop.keepRunning()) {
+		doNotOptimize(controller.constructSessionProtocolHeader(req,
+			buffer, sizeof(buffer)));
+	}
+}
+
+void
+runHttpProtocol(Controller &controller, Request *req) {
+	struct iovec buffers[128];
+	unsigned int dataSize;
+
+	if (controller.constructHttpProtocolHeaderBuffers(req, buffers,
+		sizeof(buffers) / sizeof(struct iovec), dataSize) == 0)
+	{
+		fprintf(stderr, "Cannot construct the http protocol header\n");
+		abort();
+	}
+
+	BenchmarkLoop loop("controller_header_construction", "http_protocol");
+	loop.setBytesPerIteration(dataSize);
+	while (loop.keepRunning()) {
+		doNotOptimize(controller.constructHttpProtocolHeaderBuffers(req,
+			buffers, sizeof(buffers) / sizeof(struct iovec), dataSize));
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(controller_header_construction) {
+	BackgroundEventLoop bg(false, true);
+	ServerKit::Context context(bg.safe, bg.libuv_loop);
+	VariantMap options;
+	ApplicationPool2::TestSession session;
+	ServerKit::HttpHeaderParserState parserState;
+	Request req;
+
+	setLogLevel(LVL_WARN);
+	initOptions(options);
+	Controller controller(&context, &options);
+
+	MemoryKit::mbuf buffer(createRequestBuffer(&context.mbuf_pool,
+		P_STATIC_STRING(BROWSER_REQUEST)));
+	req.pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+	if (!parseRequestHeader(&context, &req, &parserState, buffer)) {
+		fprintf(stderr, "Cannot parse the request\n");
+		abort();
+	}
+	req.https = false;
+	req.host = req.headers.lookup("host");
+	req.envvars = NULL;
+	req.session.reset(&session, false);
+
+	runSessionProtocol(controller, &req);
+	runHttpProtocol(controller, &req);
+
+	req.session.reset();
+	deinitializeParsedRequest(&req);
+	psg_destroy_pool(req.pool);
+	controller.shutdown(true);
+}
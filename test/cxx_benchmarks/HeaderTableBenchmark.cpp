@@ -0,0 +1,75 @@
+/*
+ * Measures HeaderTable, which holds the headers of every request and every
+ * application response. Lookups use precomputed HashedStaticStrings, as the
+ * Core does for the headers that it is interested in.
+ */
+#include "BenchmarkSupport.h"
+#include <MemoryKit/palloc.h>
+#include <ServerKit/HeaderTable.h>
+#include <DataStructures/HashedStaticString.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+
+namespace {
+
+const char *HEADERS[][2] = {
+	{ "Host", "www.example.com" },
+	{ "Connection", "keep-alive" },
+	{ "Cache-Control", "max-age=0" },
+	{ "Upgrade-Insecure-Requests", "1" },
+	{ "User-Agent", "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_11_3) AppleWebKit/537.36" },
+	{ "Accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8" },
+	{ "Referer", "https://www.example.com/products/1234" },
+	{ "Accept-Encoding", "gzip, deflate, sdch" },
+	{ "Accept-Language", "en-US,en;q=0.8,nl;q=0.6" },
+	{ "Cookie", "_session_id=8f7a1c2b3d4e5f60718293a4b5c6d7e8; locale=en" }
+};
+const unsigned int NHEADERS = sizeof(HEADERS) / sizeof(HEADERS[0]);
+
+void
+insertHeaders(ServerKit::HeaderTable &table, psg_pool_t *pool) {
+	for (unsigned int i = 0; i < NHEADERS; i++) {
+		table.insert(pool, HEADERS[i][0], HEADERS[i][1]);
+	}
+}
+
+void
+runInsert() {
+	ServerKit::HeaderTable table;
+	psg_pool_t *pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+
+	BenchmarkLoop loop("header_table", "insert/10 headers");
+	while (loop.keepRunning()) {
+		insertHeaders(table, pool);
+		doNotOptimize(table.size());
+		table.clear();
+		psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE);
+	}
+
+	psg_destroy_pool(pool);
+}
+
+void
+runLookup(const char *variant, const HashedStaticString &key) {
+	ServerKit::HeaderTable table;
+	psg_pool_t *pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+
+	insertHeaders(table, pool);
+
+	BenchmarkLoop loop("header_table", variant);
+	while (loop.keepRunning()) {
+		doNotOptimize(table.lookup(key));
+	}
+
+	psg_destroy_pool(pool);
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(header_table) {
+	runInsert();
+	runLookup("lookup/hit", "host");
+	runLookup("lookup/hit long key", "upgrade-insecure-requests");
+	runLookup("lookup/miss", "x-forwarded-for");
+}
@@ -0,0 +1,93 @@
+/*
+ * Measures ServerKit's request header parser on realistic requests. Every
+ * iteration parses one request header into a fresh request object and then
+ * releases it again, like HttpServer does for every request on a keep-alive
+ * connection. A request with big Cookie and X-Forwarded-For headers is
+ * parsed with every header scanner that the CPU supports.
+ */
+#include "BenchmarkSupport.h"
+#include "HttpRequestSamples.h"
+#include <BackgroundEventLoop.h>
+#include <MemoryKit/palloc.h>
+#include <ServerKit/Context.h>
+#include <ServerKit/HttpRequest.h>
+#include <ServerKit/HttpHeaderParser.h>
+#include <ServerKit/http_parser.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+
+namespace {
+
+void
+run(ServerKit::Context *context, const char *variant, const StaticString &data) {
+	ServerKit::BaseHttpRequest req;
+	ServerKit::HttpHeaderParserState state;
+	MemoryKit::mbuf buffer(createRequestBuffer(&context->mbuf_pool, data));
+
+	req.pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+	if (!parseRequestHeader(context, &req, &state, buffer)) {
+		fprintf(stderr, "Cannot parse the %s request\n", variant);
+		abort();
+	}
+	deinitializeParsedRequest(&req);
+	psg_reset_pool(req.pool, PSG_DEFAULT_POOL_SIZE);
+
+	BenchmarkLoop loop("http_header_parser", variant);
+	loop.setBytesPerIteration(data.size());
+	while (loop.keepRunning()) {
+		parseRequestHeader(context, &req, &state, buffer);
+		doNotOptimize(req.headers.size());
+		deinitializeParsedRequest(&req);
+		psg_reset_pool(req.pool, PSG_DEFAULT_POOL_SIZE);
+	}
+
+	psg_destroy_pool(req.pool);
+}
+
+string
+createLargeHeadersRequest() {
+	string result = "GET /dashboard HTTP/1.1\r\n"
+		"Host: www.example.com\r\n"
+		"Cookie: _session_id=8f7a1c2b3d4e5f60718293a4b5c6d7e8";
+	for (unsigned int i = 0; i < 64; i++) {
+		char cookie[64];
+		snprintf(cookie, sizeof(cookie), "; tracking_%u=a1b2c3d4e5f60718293a4b5c6d7e8f90", i);
+		result.append(cookie);
+	}
+	result.append("\r\nX-Forwarded-For: ");
+	for (unsigned int i = 0; i < 16; i++) {
+		char address[32];
+		snprintf(address, sizeof(address), "%s203.0.113.%u", (i == 0) ? "" : ", ", i + 1);
+		result.append(address);
+	}
+	result.append("\r\n\r\n");
+	return result;
+}
+
+void
+runWithScanner(ServerKit::Context *context, const char *name,
+	enum http_header_scanner scanner, const string &data)
+{
+	string variant = string("large_headers/") + name;
+	if (http_parser_set_header_scanner(scanner)) {
+		run(context, variant.c_str(), data);
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(http_header_parser) {
+	BackgroundEventLoop bg(false, true);
+	ServerKit::Context context(bg.safe, bg.libuv_loop);
+
+	run(&context, "browser_get", P_STATIC_STRING(BROWSER_REQUEST));
+	run(&context, "api_post", P_STATIC_STRING(API_REQUEST));
+
+	string data = createLargeHeadersRequest();
+	runWithScanner(&context, "byte_at_a_time", HTTP_HEADER_SCANNER_NONE, data);
+	runWithScanner(&context, "scalar", HTTP_HEADER_SCANNER_SCALAR, data);
+	runWithScanner(&context, "sse4.2", HTTP_HEADER_SCANNER_SSE42, data);
+	runWithScanner(&context, "avx2", HTTP_HEADER_SCANNER_AVX2, data);
+	http_parser_set_header_scanner(HTTP_HEADER_SCANNER_AUTO);
+}
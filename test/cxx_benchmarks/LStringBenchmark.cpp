@@ -0,0 +1,107 @@
+/*
+ * Measures the psg_lstr_* operations that the HTTP parser and the Core
+ * perform on header names and values. Values that arrive in multiple reads
+ * end up fragmented over several parts, so most operations are measured
+ * on both a contiguous and a fragmented string.
+ */
+#include "BenchmarkSupport.h"
+#include <MemoryKit/palloc.h>
+#include <DataStructures/LString.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+
+namespace {
+
+const StaticString VALUE = P_STATIC_STRING(
+	"application/x-www-form-urlencoded; charset=utf-8");
+const unsigned int NPARTS = 4;
+
+void
+appendValue(LString *str, psg_pool_t *pool, unsigned int nparts) {
+	unsigned int partSize = VALUE.size() / nparts;
+	for (unsigned int i = 0; i < nparts; i++) {
+		unsigned int size = (i == nparts - 1)
+			? VALUE.size() - i * partSize
+			: partSize;
+		psg_lstr_append(str, pool, VALUE.data() + i * partSize, size);
+	}
+}
+
+string
+variantName(const char *operation, unsigned int nparts) {
+	return string(operation) + ((nparts == 1) ? "/contiguous" : "/fragmented");
+}
+
+void
+runAppend(psg_pool_t *pool) {
+	LString str;
+
+	BenchmarkLoop loop("lstring", "append/4 parts");
+	while (loop.keepRunning()) {
+		psg_lstr_init(&str);
+		appendValue(&str, pool, NPARTS);
+		doNotOptimize(str.size);
+		psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE);
+	}
+}
+
+void
+runCmp(psg_pool_t *pool, unsigned int nparts) {
+	LString str;
+
+	psg_lstr_init(&str);
+	appendValue(&str, pool, nparts);
+
+	BenchmarkLoop loop("lstring", variantName("cmp", nparts));
+	while (loop.keepRunning()) {
+		doNotOptimize(psg_lstr_cmp(&str, VALUE));
+	}
+
+	psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE);
+}
+
+void
+runHash(psg_pool_t *pool, unsigned int nparts) {
+	LString str;
+
+	psg_lstr_init(&str);
+	appendValue(&str, pool, nparts);
+
+	BenchmarkLoop loop("lstring", variantName("hash", nparts));
+	while (loop.keepRunning()) {
+		doNotOptimize(psg_lstr_hash(&str));
+	}
+
+	psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE);
+}
+
+void
+runMakeContiguous(psg_pool_t *pool) {
+	LString str;
+	LString *result;
+
+	BenchmarkLoop loop("lstring", "append+make_contiguous/4 parts");
+	while (loop.keepRunning()) {
+		psg_lstr_init(&str);
+		appendValue(&str, pool, NPARTS);
+		result = psg_lstr_make_contiguous(&str, pool);
+		doNotOptimize(result);
+		psg_reset_pool(pool, PSG_DEFAULT_POOL_SIZE);
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(lstring) {
+	psg_pool_t *pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+
+	runAppend(pool);
+	runCmp(pool, 1);
+	runCmp(pool, NPARTS);
+	runHash(pool, 1);
+	runHash(pool, NPARTS);
+	runMakeContiguous(pool);
+
+	psg_destroy_pool(pool);
+}
@@ -0,0 +1,80 @@
+/*
+ * Measures getting an mbuf from a pool and putting it back, for the pool's
+ * own chunk size, for each size class and for standalone blocks. The pools
+ * are warm, as they are in a running server.
+ */
+#include "BenchmarkSupport.h"
+#include <Constants.h>
+#include <MemoryKit/mbuf.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+using namespace Passenger::MemoryKit;
+
+namespace {
+
+void
+initPool(struct mbuf_pool *pool, bool threadSafe) {
+	pool->mbuf_block_chunk_size = DEFAULT_MBUF_CHUNK_SIZE;
+	mbuf_pool_init(pool, threadSafe);
+}
+
+void
+runGetPut(const char *variant, bool threadSafe) {
+	struct mbuf_pool pool;
+	initPool(&pool, threadSafe);
+
+	BenchmarkLoop loop("mbuf", variant);
+	while (loop.keepRunning()) {
+		mbuf buffer(mbuf_get(&pool));
+		doNotOptimize(buffer.start);
+	}
+
+	mbuf_pool_deinit(&pool);
+}
+
+void
+runGetPutWithSize(size_t size) {
+	struct mbuf_pool pool;
+	char variant[64];
+
+	initPool(&pool, false);
+	snprintf(variant, sizeof(variant), "get_with_size+put/%u KB",
+		(unsigned int) (size / 1024));
+
+	BenchmarkLoop loop("mbuf", variant);
+	while (loop.keepRunning()) {
+		mbuf buffer(mbuf_get_with_size(&pool, size));
+		doNotOptimize(buffer.start);
+	}
+
+	mbuf_pool_deinit(&pool);
+}
+
+void
+runSubset() {
+	struct mbuf_pool pool;
+	initPool(&pool, false);
+	mbuf buffer(mbuf_get(&pool));
+
+	BenchmarkLoop loop("mbuf", "subset");
+	while (loop.keepRunning()) {
+		mbuf subset(buffer, 16, 64);
+		doNotOptimize(subset.start);
+	}
+
+	buffer = mbuf();
+	mbuf_pool_deinit(&pool);
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(mbuf) {
+	runGetPut("get+put", false);
+	runGetPut("get+put/thread safe pool", true);
+	runGetPutWithSize(4 * 1024);
+	runGetPutWithSize(16 * 1024);
+	runGetPutWithSize(64 * 1024);
+	runGetPutWithSize(128 * 1024);
+	runSubset();
+}
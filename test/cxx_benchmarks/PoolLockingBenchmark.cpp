@@ -0,0 +1,117 @@
+/*
+ * Compares serializing session checkouts and closes on a single pool-wide
+ * mutex, as Pool::asyncGet() and Group::onSessionClose() used to do, with
+ * their current fast paths, which hold the pool lock in shared mode plus a
+ * per-group mutex. Every iteration simulates one request on one of four
+ * groups: select the least busy process, open a session on it and close it
+ * again. The reported time is wall clock time divided by the number of
+ * requests over all threads.
+ */
+#include "BenchmarkSupport.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <DataStructures/IndexedMinHeap.h>
+#include <Utils/ReadWriteLock.h>
+#include <vector>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+
+namespace {
+
+const unsigned int ITERATIONS = 1000000;
+const unsigned int GROUPS = 4;
+const unsigned int PROCESSES_PER_GROUP = 16;
+
+struct SimulatedGroup {
+	boost::mutex sessionSyncher;
+	IndexedMinHeap<int> busyness;
+
+	SimulatedGroup() {
+		for (unsigned int i = 0; i < PROCESSES_PER_GROUP; i++) {
+			busyness.push_back(0);
+		}
+	}
+
+	unsigned int checkout() {
+		unsigned int process = busyness.top();
+		busyness.set(process, busyness.get(process) + 1);
+		return process;
+	}
+
+	void close(unsigned int process) {
+		busyness.set(process, busyness.get(process) - 1);
+	}
+};
+
+struct SimulatedPool {
+	boost::mutex globalSyncher;
+	ReadWriteLock syncher;
+	SimulatedGroup groups[GROUPS];
+};
+
+void
+globalMutexWorker(SimulatedPool *pool, SimulatedGroup *group, unsigned int iterations) {
+	for (unsigned int i = 0; i < iterations; i++) {
+		unsigned int process;
+		{
+			boost::lock_guard<boost::mutex> l(pool->globalSyncher);
+			process = group->checkout();
+		}
+		{
+			boost::lock_guard<boost::mutex> l(pool->globalSyncher);
+			group->close(process);
+		}
+		doNotOptimize(process);
+	}
+}
+
+void
+sharedLockWorker(SimulatedPool *pool, SimulatedGroup *group, unsigned int iterations) {
+	for (unsigned int i = 0; i < iterations; i++) {
+		unsigned int process;
+		{
+			ScopedReadLock l(pool->syncher);
+			boost::lock_guard<boost::mutex> l2(group->sessionSyncher);
+			process = group->checkout();
+		}
+		{
+			ScopedReadLock l(pool->syncher);
+			boost::lock_guard<boost::mutex> l2(group->sessionSyncher);
+			group->close(process);
+		}
+		doNotOptimize(process);
+	}
+}
+
+void
+run(const char *name,
+	void (*worker)(SimulatedPool *, SimulatedGroup *, unsigned int),
+	unsigned int nthreads)
+{
+	SimulatedPool pool;
+	boost::thread_group threads;
+	unsigned int iterationsPerThread = ITERATIONS / nthreads;
+	boost::uint64_t start = monotonicNanoseconds();
+
+	for (unsigned int i = 0; i < nthreads; i++) {
+		threads.create_thread(boost::bind(worker, &pool,
+			&pool.groups[i % GROUPS], iterationsPerThread));
+	}
+	threads.join_all();
+
+	char variant[64];
+	snprintf(variant, sizeof(variant), "%s/%u threads", name, nthreads);
+	report("pool_locking", variant, iterationsPerThread * nthreads,
+		monotonicNanoseconds() - start);
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(pool_locking) {
+	const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+	for (unsigned int i = 0; i < sizeof(threadCounts) / sizeof(unsigned int); i++) {
+		run("global_mutex", globalMutexWorker, threadCounts[i]);
+		run("shared_pool_lock", sharedLockWorker, threadCounts[i]);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Compares the old linear scan for the least busy enabled process, as done
+ * by Group::route(), with the IndexedMinHeap that replaced it. Every
+ * iteration simulates one request: select the least busy process, open a
+ * session on it and close a session on some other process.
+ */
+#include "BenchmarkSupport.h"
+#include <DataStructures/IndexedMinHeap.h>
+#include <cstdlib>
+#include <vector>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+
+namespace {
+
+const unsigned int ITERATIONS = 2000000;
+
+string
+variantName(const char *name, unsigned int nprocesses) {
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%s/%u processes", name, nprocesses);
+	return buf;
+}
+
+void
+runLinearScan(unsigned int nprocesses) {
+	vector<int> busyness(nprocesses, 0);
+	boost::uint64_t start = monotonicNanoseconds();
+	unsigned int seed = 1;
+
+	for (unsigned int i = 0; i < ITERATIONS; i++) {
+		int lowest = busyness[0];
+		unsigned int leastBusy = 0;
+		for (unsigned int j = 1; j < nprocesses; j++) {
+			if (busyness[j] < lowest) {
+				lowest = busyness[j];
+				leastBusy = j;
+			}
+		}
+		busyness[leastBusy]++;
+
+		unsigned int other = rand_r(&seed) % nprocesses;
+		if (busyness[other] > 0) {
+			busyness[other]--;
+		}
+		doNotOptimize(leastBusy);
+	}
+
+	report("process_selection", variantName("linear_scan", nprocesses),
+		ITERATIONS, monotonicNanoseconds() - start);
+}
+
+void
+runIndexedMinHeap(unsigned int nprocesses) {
+	IndexedMinHeap<int> busyness;
+	for (unsigned int j = 0; j < nprocesses; j++) {
+		busyness.push_back(0);
+	}
+	boost::uint64_t start = monotonicNanoseconds();
+	unsigned int seed = 1;
+
+	for (unsigned int i = 0; i < ITERATIONS; i++) {
+		unsigned int leastBusy = busyness.top();
+		busyness.set(leastBusy, busyness.get(leastBusy) + 1);
+
+		unsigned int other = rand_r(&seed) % nprocesses;
+		int level = busyness.get(other);
+		if (level > 0) {
+			busyness.set(other, level - 1);
+		}
+		doNotOptimize(leastBusy);
+	}
+
+	report("process_selection", variantName("indexed_min_heap", nprocesses),
+		ITERATIONS, monotonicNanoseconds() - start);
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(process_selection) {
+	const unsigned int sizes[] = { 1, 16, 256, 1024 };
+	for (unsigned int i = 0; i < sizeof(sizes) / sizeof(unsigned int); i++) {
+		runLinearScan(sizes[i]);
+		runIndexedMinHeap(sizes[i]);
+	}
+}
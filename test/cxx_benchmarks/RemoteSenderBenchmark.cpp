@@ -0,0 +1,205 @@
+/*
+ * Measures how fast the UstRouter's RemoteSender compresses and uploads
+ * packets, with 1 and 4 sender threads. The packets go to a local stand-in
+ * for the Union Station gateway that speaks plain HTTP and takes a few
+ * milliseconds to process every packet, like a real gateway on the other
+ * side of a network. The reported throughput is in uncompressed bytes.
+ */
+#include "BenchmarkSupport.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <string>
+#include <Constants.h>
+#include <FileDescriptor.h>
+#include <Logging.h>
+#include <StaticString.h>
+#include <Utils/IOUtils.h>
+#include <Utils/StrIntUtils.h>
+#include <UstRouter/RemoteSender.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+
+namespace {
+
+const unsigned int PACKETS = 200;
+const unsigned int PACKET_SIZE = 4 * 64 * 1024 - 16 * 1024;
+const unsigned int GATEWAY_LATENCY = 5000; // In microseconds.
+
+/**
+ * A minimal HTTP/1.1 server that answers /ping with "pong" and /sink with
+ * an "ok" status, after sleeping GATEWAY_LATENCY microseconds. Every
+ * connection is handled by its own thread.
+ */
+class StandInGateway {
+private:
+	FileDescriptor serverFd;
+	boost::thread *acceptThread;
+	boost::thread_group connectionThreads;
+
+	void acceptConnections() {
+		while (true) {
+			int fd = ::accept(serverFd, NULL, NULL);
+			if (fd == -1) {
+				return;
+			}
+			connectionThreads.create_thread(boost::bind(
+				&StandInGateway::handleConnection, this, fd));
+		}
+	}
+
+	static bool readHeader(int fd, string &buffer, string &header) {
+		char chunk[16 * 1024];
+		string::size_type end;
+
+		while ((end = buffer.find("\r\n\r\n")) == string::npos) {
+			ssize_t ret = ::read(fd, chunk, sizeof(chunk));
+			if (ret <= 0) {
+				return false;
+			}
+			buffer.append(chunk, ret);
+		}
+		header = buffer.substr(0, end + 4);
+		buffer.erase(0, end + 4);
+		return true;
+	}
+
+	static string headerValue(const string &header, const string &name) {
+		string lowerHeader = header;
+		for (string::size_type i = 0; i < lowerHeader.size(); i++) {
+			lowerHeader[i] = tolower(lowerHeader[i]);
+		}
+		string::size_type pos = lowerHeader.find("\r\n" + name + ":");
+		if (pos == string::npos) {
+			return string();
+		}
+		pos += name.size() + 3;
+		return strip(header.substr(pos, header.find("\r\n", pos) - pos));
+	}
+
+	void handleConnection(int _fd) {
+		FileDescriptor fd(_fd, NULL, 0);
+		string buffer, header;
+		char chunk[64 * 1024];
+
+		try {
+			while (readHeader(fd, buffer, header)) {
+				size_t contentLength = atol(headerValue(header,
+					"content-length").c_str());
+				if (headerValue(header, "expect") == "100-continue") {
+					writeExact(fd, P_STATIC_STRING("HTTP/1.1 100 Continue\r\n\r\n"));
+				}
+				while (buffer.size() < contentLength) {
+					ssize_t ret = ::read(fd, chunk, sizeof(chunk));
+					if (ret <= 0) {
+						return;
+					}
+					buffer.append(chunk, ret);
+				}
+				buffer.erase(0, contentLength);
+
+				usleep(GATEWAY_LATENCY);
+
+				const char *body = (header.find(" /ping ") != string::npos)
+					? "pong"
+					: "{\"status\": \"ok\"}";
+				string response = "HTTP/1.1 200 OK\r\n"
+					"Content-Type: text/plain\r\n"
+					"Content-Length: " + toString(strlen(body)) + "\r\n"
+					"\r\n";
+				response.append(body);
+				writeExact(fd, response);
+			}
+		} catch (const SystemException &) {
+			// The RemoteSender closed the connection.
+		}
+	}
+
+public:
+	unsigned short port;
+
+	StandInGateway() {
+		struct sockaddr_in addr;
+		socklen_t len = sizeof(addr);
+
+		serverFd.assign(createTcpServer("127.0.0.1", 0, 128, __FILE__, __LINE__),
+			NULL, 0);
+		getsockname(serverFd, (struct sockaddr *) &addr, &len);
+		port = ntohs(addr.sin_port);
+		acceptThread = new boost::thread(boost::bind(
+			&StandInGateway::acceptConnections, this));
+	}
+
+	~StandInGateway() {
+		::shutdown(serverFd, SHUT_RDWR);
+		acceptThread->join();
+		delete acceptThread;
+		// The RemoteSender has been destroyed by now, so all connections
+		// have been closed.
+		connectionThreads.join_all();
+	}
+};
+
+string
+createPacket() {
+	string packet;
+	unsigned int i = 0;
+
+	packet.reserve(PACKET_SIZE + 256);
+	while (packet.size() < PACKET_SIZE) {
+		packet.append("cjb8n-abcd " + toString(1263385422000000ull + i * 7919) +
+			" 1 " + toString(i % 7) + " BEGIN: request processing (" +
+			toString(i * 104729 % 100000) + ")\n");
+		packet.append("URI: /products/" + toString(i * 31 % 5000) +
+			"?page=" + toString(i % 12) + "\n");
+		packet.append("Controller action: ProductsController#show\n");
+		i++;
+	}
+	packet.resize(PACKET_SIZE);
+	return packet;
+}
+
+void
+waitForAcceptedPackets(const RemoteSender &sender, unsigned int count) {
+	while (sender.inspectStateAsJson()["packets_accepted"].asUInt() < count) {
+		usleep(1000);
+	}
+}
+
+void
+benchmarkThreads(unsigned int nthreads) {
+	StandInGateway gateway;
+	string packet = createPacket();
+	StaticString data(packet);
+
+	{
+		RemoteSender sender("127.0.0.1", gateway.port, "", "", nthreads, "http");
+
+		// The first packet also pings the gateway.
+		sender.schedule("key", "node", "requests", &data, 1);
+		waitForAcceptedPackets(sender, 1);
+
+		boost::uint64_t startTime = monotonicNanoseconds();
+		for (unsigned int i = 0; i < PACKETS; i++) {
+			sender.schedule("key", "node", "requests", &data, 1);
+		}
+		waitForAcceptedPackets(sender, PACKETS + 1);
+		report("remote_sender", "threads=" + toString(nthreads), PACKETS,
+			monotonicNanoseconds() - startTime, PACKET_SIZE);
+	}
+}
+
+} // anonymous namespace
+
+
+DEFINE_BENCHMARK(remote_sender) {
+	setLogLevel(LVL_WARN);
+	benchmarkThreads(1);
+	benchmarkThreads(4);
+	setLogLevel(DEFAULT_LOG_LEVEL);
+}
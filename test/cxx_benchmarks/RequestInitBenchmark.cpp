@@ -0,0 +1,105 @@
+/*
+ * Measures how long the Core takes to initialize the pool options of a
+ * request in single-app mode. The 'full_copy' variant makes every request
+ * copy the app group's cached Options, which is what happens when a request
+ * object was last used for another app group. The 'same_group' variant
+ * reuses the Options from the previous request on the same request object,
+ * which is the common case.
+ */
+#include "BenchmarkSupport.h"
+#include "HttpRequestSamples.h"
+#include <BackgroundEventLoop.h>
+#include <Constants.h>
+#include <Logging.h>
+#include <Utils/VariantMap.h>
+#include <MemoryKit/palloc.h>
+#include <Core/Controller.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+using namespace Passenger::Core;
+
+namespace {
+
+void
+initOptions(VariantMap &options) {
+	options.setInt("stat_throttle_rate", DEFAULT_STAT_THROTTLE_RATE);
+	options.setInt("response_buffer_high_watermark", DEFAULT_RESPONSE_BUFFER_HIGH_WATERMARK);
+	options.setBool("show_version_in_header", true);
+	options.setBool("sticky_sessions", false);
+	options.setBool("core_graceful_exit", true);
+	options.setBool("multi_app", false);
+	options.set("environment", DEFAULT_APP_ENV);
+	options.set("app_root", "stub/rack");
+	options.set("app_type", "dummy");
+	options.set("startup_file", "none");
+	options.set("default_ruby", DEFAULT_RUBY);
+	options.set("default_server_name", "localhost");
+	options.setInt("default_server_port", 80);
+	options.set("server_software", PROGRAM_NAME);
+	options.set("sticky_sessions_cookie_name", DEFAULT_STICKY_SESSIONS_COOKIE_NAME);
+	options.setBool("user_switching", false);
+	options.setInt("min_instances", 1);
+	options.setInt("spawn_concurrency", DEFAULT_SPAWN_CONCURRENCY);
+	options.setInt("standby_processes", 0);
+	options.setBool("predictive_scaling", false);
+	options.setInt("memory_limit", 0);
+	options.setInt("memory_limit_recycle_percentage", DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE);
+	options.setInt("max_preloader_idle_time", DEFAULT_MAX_PRELOADER_IDLE_TIME);
+	options.setInt("max_request_queue_size", DEFAULT_MAX_REQUEST_QUEUE_SIZE);
+	options.set("routing_policy", DEFAULT_ROUTING_POLICY);
+	options.setBool("abort_websockets_on_process_shutdown", true);
+	options.setInt("force_max_concurrent_requests_per_process", -1);
+	options.set("spawn_method", DEFAULT_SPAWN_METHOD);
+	options.setBool("load_shell_envvars", false);
+}
+
+void
+runFullCopy(Controller &controller, Request *req) {
+	BenchmarkLoop loop("controller_request_init", "full_copy");
+	while (loop.keepRunning()) {
+		req->baseOptions = NULL;
+		controller.initializeSingleAppPoolOptions(req);
+		doNotOptimize(req->options.maxRequests);
+	}
+}
+
+void
+runSameGroup(Controller &controller, Request *req) {
+	controller.initializeSingleAppPoolOptions(req);
+
+	BenchmarkLoop loop("controller_request_init", "same_group");
+	while (loop.keepRunning()) {
+		controller.initializeSingleAppPoolOptions(req);
+		doNotOptimize(req->options.maxRequests);
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(controller_request_init) {
+	BackgroundEventLoop bg(false, true);
+	ServerKit::Context context(bg.safe, bg.libuv_loop);
+	VariantMap options;
+	ServerKit::HttpHeaderParserState parserState;
+	Request req;
+
+	setLogLevel(LVL_WARN);
+	initOptions(options);
+	Controller controller(&context, &options);
+
+	MemoryKit::mbuf buffer(createRequestBuffer(&context.mbuf_pool,
+		P_STATIC_STRING(BROWSER_REQUEST)));
+	req.pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+	if (!parseRequestHeader(&context, &req, &parserState, buffer)) {
+		fprintf(stderr, "Cannot parse the request\n");
+		abort();
+	}
+
+	runFullCopy(controller, &req);
+	runSameGroup(controller, &req);
+
+	deinitializeParsedRequest(&req);
+	psg_destroy_pool(req.pool);
+	controller.shutdown(true);
+}
@@ -0,0 +1,162 @@
+/*
+ * Measures the turbocache: fetching entries, both from a thread's own
+ * cache and from the shared cache, and storing responses into a full cache
+ * so that every store evicts the least recently used entry.
+ */
+#include "BenchmarkSupport.h"
+#include <time.h>
+#include <MemoryKit/palloc.h>
+#include <Core/Controller/Request.h>
+#include <Core/ResponseCache.h>
+#include <Core/SharedResponseCache.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+using namespace Passenger::Core;
+
+namespace {
+
+typedef ResponseCache<Request> ResponseCacheType;
+typedef SharedResponseCache<Request> SharedResponseCacheType;
+
+const unsigned int NREQUESTS = 64;
+
+const char RESPONSE_HEADER[] =
+	"HTTP/1.1 200 OK\r\n"
+	"Content-Type: text/html; charset=utf-8\r\n"
+	"Content-Length: 2048\r\n"
+	"Cache-Control: public,max-age=3600\r\n"
+	"ETag: \"5e1c2b3d4e5f60718293a4b5c6d7e8f9\"\r\n"
+	"\r\n";
+
+// ResponseCache::prepareRequest() only needs this from the Controller.
+struct FakeController {
+	StaticString defaultVaryTurbocacheByCookie;
+};
+
+void
+initRequest(Request *req, unsigned int number) {
+	char *path;
+	int pathSize;
+
+	req->pool = psg_create_pool(PSG_DEFAULT_POOL_SIZE);
+	req->method = HTTP_GET;
+	req->bodyType = Request::RBT_NO_BODY;
+	req->https = false;
+	req->hasPragmaHeader = false;
+	req->host = psg_lstr_create(req->pool, P_STATIC_STRING("www.example.com"));
+	path = (char *) psg_pnalloc(req->pool, 32);
+	pathSize = snprintf(path, 32, "/products/%u", number);
+	psg_lstr_init(&req->path);
+	psg_lstr_append(&req->path, req->pool, path, pathSize);
+	req->cacheKey = HashedStaticString();
+	req->cacheControl = NULL;
+	req->varyCookie = NULL;
+	req->envvars = NULL;
+
+	req->appResponse.statusCode = 200;
+	req->appResponse.date = NULL;
+	req->appResponse.cacheControl = NULL;
+	req->appResponse.expiresHeader = NULL;
+	req->appResponse.lastModifiedHeader = NULL;
+	req->appResponse.headers.insert(req->pool, "cache-control", "public,max-age=3600");
+}
+
+struct Requests {
+	Request items[NREQUESTS];
+
+	Requests() {
+		for (unsigned int i = 0; i < NREQUESTS; i++) {
+			initRequest(&items[i], i);
+		}
+	}
+
+	~Requests() {
+		for (unsigned int i = 0; i < NREQUESTS; i++) {
+			psg_destroy_pool(items[i].pool);
+			items[i].pool = NULL;
+		}
+	}
+
+	void prepare(ResponseCacheType &cache) {
+		FakeController controller;
+		for (unsigned int i = 0; i < NREQUESTS; i++) {
+			cache.prepareRequest(&controller, &items[i]);
+			cache.prepareRequestForStoring(&items[i]);
+		}
+	}
+};
+
+void
+store(ResponseCacheType &cache, Request *req, ev_tstamp now, const string &body) {
+	ResponseCacheType::Entry entry(cache.store(req, now,
+		sizeof(RESPONSE_HEADER) - 1, body.size()));
+	if (entry.valid()) {
+		cache.storeHeaderData(entry, 0, RESPONSE_HEADER, sizeof(RESPONSE_HEADER) - 1);
+		cache.storeBodyData(entry, 0, body.data(), body.size());
+		cache.commit(entry);
+	}
+}
+
+void
+runFetch(ResponseCacheType &cache, const char *variant, bool populate) {
+	Requests requests;
+	ev_tstamp now = time(NULL);
+	string body(2048, 'x');
+	unsigned int i = 0;
+
+	requests.prepare(cache);
+	if (populate) {
+		for (unsigned int j = 0; j < NREQUESTS; j++) {
+			store(cache, &requests.items[j], now, body);
+		}
+	}
+
+	BenchmarkLoop loop("response_cache", variant);
+	while (loop.keepRunning()) {
+		ResponseCacheType::Entry entry(cache.fetch(&requests.items[i], now));
+		doNotOptimize(entry.valid());
+		if (entry.valid()) {
+			cache.release(entry);
+		}
+		i = (i + 1) % NREQUESTS;
+	}
+}
+
+void
+runStore() {
+	// Room for half of the requests, so every store evicts an entry.
+	ResponseCacheType cache(NREQUESTS / 2);
+	Requests requests;
+	ev_tstamp now = time(NULL);
+	string body(2048, 'x');
+	unsigned int i = 0;
+
+	requests.prepare(cache);
+
+	BenchmarkLoop loop("response_cache", "store/2 KB body with eviction");
+	loop.setBytesPerIteration(sizeof(RESPONSE_HEADER) - 1 + body.size());
+	while (loop.keepRunning()) {
+		store(cache, &requests.items[i], now, body);
+		i = (i + 1) % NREQUESTS;
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(response_cache) {
+	{
+		ResponseCacheType cache;
+		runFetch(cache, "fetch/hit", true);
+	}
+	{
+		ResponseCacheType cache;
+		runFetch(cache, "fetch/miss", false);
+	}
+	{
+		SharedResponseCacheType shared;
+		ResponseCacheType cache(0, 0, &shared);
+		runFetch(cache, "fetch/hit from shared cache", true);
+	}
+	runStore();
+}
@@ -0,0 +1,251 @@
+/*
+ * Measures how much CPU time the Core's event loop thread spends on
+ * forwarding a large fixed-length response body from the application to a
+ * client, with and without `splice_responses`. The client reads over TCP as
+ * fast as it can, so splicing does not fall back to buffering.
+ *
+ * The reported time is the CPU time of the event loop thread, not the
+ * wall clock time, so the MB/s column means "megabytes per CPU second".
+ */
+#include "BenchmarkSupport.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <time.h>
+#include <string>
+#include <BackgroundEventLoop.h>
+#include <Constants.h>
+#include <FileDescriptor.h>
+#include <Logging.h>
+#include <Utils/IOUtils.h>
+#include <Utils/MessageIO.h>
+#include <Utils/StrIntUtils.h>
+#include <Utils/VariantMap.h>
+#include <Core/Controller.h>
+#include <Core/ApplicationPool/TestSession.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+using namespace Passenger::Core;
+
+namespace {
+
+const unsigned int APP_WRITE_SIZE = 1024 * 1024;
+
+class BenchmarkController: public Controller {
+protected:
+	virtual void asyncGetFromApplicationPool(Request *req,
+		ApplicationPool2::GetCallback callback)
+	{
+		callback(sessionToReturn, ApplicationPool2::ExceptionPtr());
+		sessionToReturn.reset();
+	}
+
+public:
+	ApplicationPool2::AbstractSessionPtr sessionToReturn;
+
+	BenchmarkController(ServerKit::Context *context, const VariantMap *agentsOptions)
+		: Controller(context, agentsOptions)
+		{ }
+};
+
+void
+initOptions(VariantMap &options, bool spliceResponses) {
+	options.setInt("stat_throttle_rate", DEFAULT_STAT_THROTTLE_RATE);
+	options.setInt("response_buffer_high_watermark", DEFAULT_RESPONSE_BUFFER_HIGH_WATERMARK);
+	options.setBool("show_version_in_header", true);
+	options.setBool("sticky_sessions", false);
+	options.setBool("core_graceful_exit", true);
+	options.setBool("multi_app", false);
+	options.set("environment", DEFAULT_APP_ENV);
+	options.set("app_root", "stub/rack");
+	options.set("app_type", "dummy");
+	options.set("startup_file", "none");
+	options.set("default_ruby", DEFAULT_RUBY);
+	options.set("default_server_name", "localhost");
+	options.setInt("default_server_port", 80);
+	options.set("server_software", PROGRAM_NAME);
+	options.set("sticky_sessions_cookie_name", DEFAULT_STICKY_SESSIONS_COOKIE_NAME);
+	options.setBool("user_switching", false);
+	options.setInt("min_instances", 1);
+	options.setInt("spawn_concurrency", DEFAULT_SPAWN_CONCURRENCY);
+	options.setInt("standby_processes", 0);
+	options.setBool("predictive_scaling", false);
+	options.setInt("memory_limit", 0);
+	options.setInt("memory_limit_recycle_percentage", DEFAULT_MEMORY_LIMIT_RECYCLE_PERCENTAGE);
+	options.setInt("max_preloader_idle_time", DEFAULT_MAX_PRELOADER_IDLE_TIME);
+	options.setInt("max_request_queue_size", DEFAULT_MAX_REQUEST_QUEUE_SIZE);
+	options.set("routing_policy", DEFAULT_ROUTING_POLICY);
+	options.setBool("abort_websockets_on_process_shutdown", true);
+	options.setInt("force_max_concurrent_requests_per_process", -1);
+	options.set("spawn_method", DEFAULT_SPAWN_METHOD);
+	options.setBool("load_shell_envvars", false);
+	options.setBool("turbocaching", false);
+	options.setBool("splice_responses", spliceResponses);
+}
+
+void
+getThreadCpuTime(boost::uint64_t *result) {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	*result = (boost::uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Plays the application: reads the request header, then writes a response
+ * with a body of `bodySize` bytes.
+ */
+void
+respond(ApplicationPool2::TestSession *session, boost::uint64_t bodySize) {
+	string chunk(APP_WRITE_SIZE, 'x');
+	boost::uint64_t written = 0;
+
+	readScalarMessage(session->peerFd());
+	writeExact(session->peerFd(), "HTTP/1.1 200 OK\r\n"
+		"Content-Type: application/octet-stream\r\n"
+		"Content-Length: " + toString(bodySize) + "\r\n\r\n");
+	while (written < bodySize) {
+		unsigned int size = (unsigned int) std::min<boost::uint64_t>(
+			chunk.size(), bodySize - written);
+		writeExact(session->peerFd(), chunk.data(), size);
+		written += size;
+	}
+	session->closePeerFd();
+}
+
+class Fixture {
+private:
+	BackgroundEventLoop bg;
+	ServerKit::Context context;
+	VariantMap options;
+	BenchmarkController *controller;
+	FileDescriptor serverFd;
+	unsigned short port;
+
+	void createController() {
+		controller = new BenchmarkController(&context, &options);
+		controller->listen(serverFd);
+	}
+
+	void shutdownController() {
+		controller->shutdown(true);
+	}
+
+	void destroyController() {
+		delete controller;
+	}
+
+	void setSession(ApplicationPool2::TestSession *session) {
+		controller->sessionToReturn.reset(session, false);
+	}
+
+	void getServerState(BenchmarkController::State *state) {
+		*state = controller->serverState;
+	}
+
+	boost::uint64_t getEventLoopCpuTime() {
+		boost::uint64_t result;
+		bg.safe->runSync(boost::bind(getThreadCpuTime, &result));
+		return result;
+	}
+
+public:
+	Fixture(bool spliceResponses)
+		: bg(false, true),
+		  context(bg.safe, bg.libuv_loop)
+	{
+		struct sockaddr_in addr;
+		socklen_t len = sizeof(addr);
+
+		initOptions(options, spliceResponses);
+		serverFd.assign(createTcpServer("127.0.0.1", 0, 128, __FILE__, __LINE__),
+			NULL, 0);
+		getsockname(serverFd, (struct sockaddr *) &addr, &len);
+		port = ntohs(addr.sin_port);
+
+		bg.start();
+		bg.safe->runSync(boost::bind(&Fixture::createController, this));
+	}
+
+	~Fixture() {
+		BenchmarkController::State state;
+
+		bg.safe->runSync(boost::bind(&Fixture::shutdownController, this));
+		do {
+			usleep(10000);
+			bg.safe->runSync(boost::bind(&Fixture::getServerState, this, &state));
+		} while (state != BenchmarkController::FINISHED_SHUTDOWN);
+		bg.safe->runSync(boost::bind(&Fixture::destroyController, this));
+		bg.stop();
+	}
+
+	/**
+	 * Performs one request and returns the CPU time that the event loop
+	 * thread spent on it.
+	 */
+	boost::uint64_t download(boost::uint64_t bodySize) {
+		ApplicationPool2::TestSession session;
+		vector<char> buffer(256 * 1024);
+		boost::uint64_t startTime, received = 0;
+		ssize_t ret;
+
+		bg.safe->runSync(boost::bind(&Fixture::setSession, this, &session));
+		FileDescriptor client(connectToTcpServer("127.0.0.1", port, __FILE__, __LINE__),
+			NULL, 0);
+		startTime = getEventLoopCpuTime();
+		writeExact(client, P_STATIC_STRING("GET / HTTP/1.1\r\n"
+			"Host: localhost\r\n"
+			"Connection: close\r\n\r\n"));
+
+		while (session.fd() == -1) {
+			usleep(1000);
+		}
+		boost::thread app(boost::bind(respond, &session, bodySize));
+		do {
+			ret = ::read(client, &buffer[0], buffer.size());
+			if (ret > 0) {
+				received += ret;
+			}
+		} while (ret > 0);
+		app.join();
+
+		if (ret == -1 || received < bodySize) {
+			fprintf(stderr, "Incomplete response: received %llu bytes\n",
+				(unsigned long long) received);
+			abort();
+		}
+		return getEventLoopCpuTime() - startTime;
+	}
+};
+
+void
+benchmarkDownload(bool spliceResponses, const string &sizeName,
+	boost::uint64_t bodySize, unsigned int iterations)
+{
+	Fixture fixture(spliceResponses);
+	boost::uint64_t cpuTime = 0;
+
+	// Warm up.
+	fixture.download(bodySize);
+
+	for (unsigned int i = 0; i < iterations; i++) {
+		cpuTime += fixture.download(bodySize);
+	}
+	report("response_splice", string(spliceResponses ? "splice" : "copy") +
+		"/" + sizeName, iterations, cpuTime, bodySize);
+}
+
+} // anonymous namespace
+
+
+DEFINE_BENCHMARK(response_splice) {
+	setLogLevel(LVL_WARN);
+	benchmarkDownload(false, "10MB", 10 * 1024 * 1024, 50);
+	benchmarkDownload(true, "10MB", 10 * 1024 * 1024, 50);
+	benchmarkDownload(false, "1GB", 1024 * 1024 * 1024, 3);
+	benchmarkDownload(true, "1GB", 1024 * 1024 * 1024, 3);
+	setLogLevel(DEFAULT_LOG_LEVEL);
+}
@@ -0,0 +1,90 @@
+/*
+ * Measures StringKeyTable with keys that look like the application group
+ * names that the Core caches pool options for.
+ */
+#include "BenchmarkSupport.h"
+#include <DataStructures/StringKeyTable.h>
+#include <DataStructures/HashedStaticString.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+
+namespace {
+
+const unsigned int NKEYS = 64;
+
+struct Keys {
+	vector<string> storage;
+	vector<HashedStaticString> present;
+	vector<HashedStaticString> absent;
+
+	Keys() {
+		char buf[64];
+
+		for (unsigned int i = 0; i < NKEYS * 2; i++) {
+			snprintf(buf, sizeof(buf), "/webapps/app%u/public (production)", i);
+			storage.push_back(buf);
+		}
+		for (unsigned int i = 0; i < NKEYS; i++) {
+			present.push_back(storage[i]);
+			absent.push_back(storage[NKEYS + i]);
+		}
+	}
+};
+
+void
+insertKeys(StringKeyTable<int> &table, const Keys &keys) {
+	for (unsigned int i = 0; i < NKEYS; i++) {
+		table.insert(keys.present[i], i);
+	}
+}
+
+void
+runInsertIntoNewTable(const Keys &keys) {
+	BenchmarkLoop loop("string_key_table", "insert/64 keys into new table");
+	while (loop.keepRunning()) {
+		StringKeyTable<int> table;
+		insertKeys(table, keys);
+		doNotOptimize(table.size());
+	}
+}
+
+void
+runInsertIntoClearedTable(const Keys &keys) {
+	StringKeyTable<int> table;
+
+	BenchmarkLoop loop("string_key_table", "insert/64 keys into cleared table");
+	while (loop.keepRunning()) {
+		insertKeys(table, keys);
+		doNotOptimize(table.size());
+		table.clear();
+	}
+}
+
+void
+runLookup(const Keys &keys, const char *variant,
+	const vector<HashedStaticString> &lookupKeys)
+{
+	StringKeyTable<int> table;
+	unsigned int i = 0;
+	const int *result;
+
+	insertKeys(table, keys);
+
+	BenchmarkLoop loop("string_key_table", variant);
+	while (loop.keepRunning()) {
+		doNotOptimize(table.lookup(lookupKeys[i], &result));
+		i = (i + 1) % NKEYS;
+	}
+}
+
+} // anonymous namespace
+
+DEFINE_BENCHMARK(string_key_table) {
+	Keys keys;
+
+	runInsertIntoNewTable(keys);
+	runInsertIntoClearedTable(keys);
+	runLookup(keys, "lookup/hit", keys.present);
+	runLookup(keys, "lookup/miss", keys.absent);
+}
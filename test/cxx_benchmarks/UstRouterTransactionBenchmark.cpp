@@ -0,0 +1,181 @@
+/*
+ * Measures the cost of building a UstRouter transaction and handing its body
+ * to a remote sink, up to the point where the RemoteSender takes over. The
+ * "copying" variant replays how the UstRouter used to do this: the body was
+ * a growing string, the sink memcpy()'d it into its own buffer, and the
+ * RemoteSender copied the buffer once more. The "mbuf" variant uses the
+ * current Transaction class, whose body blocks are passed on by reference.
+ */
+#include "BenchmarkSupport.h"
+#include <boost/container/string.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <StaticString.h>
+#include <MemoryKit/mbuf.h>
+#include <UstRouter/Transaction.h>
+#include <Utils/StrIntUtils.h>
+
+using namespace Passenger;
+using namespace Passenger::Benchmarks;
+using namespace Passenger::MemoryKit;
+using namespace Passenger::UstRouter;
+
+namespace {
+
+const unsigned int SINK_BUFFER_CAPACITY = 4 * 64 * 1024 - 16 * 1024;
+const unsigned int BODY_BLOCK_SIZE = 1024 * 4;
+
+vector<string>
+createMessages() {
+	vector<string> messages;
+	messages.push_back("BEGIN: request processing (1263385422000000)");
+	messages.push_back("URI: /products/4711?page=3");
+	messages.push_back("Controller action: ProductsController#show");
+	messages.push_back("BEGIN: framework initialization (1263385422000100)");
+	messages.push_back("END: framework initialization (1263385422000200)");
+	for (unsigned int i = 0; i < 8; i++) {
+		messages.push_back("DB BENCHMARK: " + toString(i) + " 0.000351 "
+			"SELECT `products`.* FROM `products` WHERE `products`.`id` = "
+			+ toString(4711 + i) + " LIMIT 1");
+	}
+	messages.push_back("BEGIN: view rendering (1263385422000900)");
+	messages.push_back("END: view rendering (1263385422001200)");
+	messages.push_back("Status: 200 OK");
+	messages.push_back("END: request processing (1263385422001300)");
+	return messages;
+}
+
+/**
+ * The transaction layout that the UstRouter used before transaction bodies
+ * were stored in mbufs: metadata and body in a single growing string.
+ */
+struct CopyingTransaction {
+	boost::container::string storage;
+	unsigned int bodyOffset;
+	unsigned int writeCount;
+
+	CopyingTransaction(const StaticString &txnId)
+		: writeCount(0)
+	{
+		const char *metadata[] = { "group", "node", "requests", "key", "" };
+		storage.append(txnId.data(), txnId.size());
+		storage.append(1, '\0');
+		for (unsigned int i = 0; i < sizeof(metadata) / sizeof(const char *); i++) {
+			storage.append(metadata[i]);
+			storage.append(1, '\0');
+		}
+		bodyOffset = storage.size();
+	}
+
+	void append(const StaticString &txnId, const StaticString &timestamp,
+		const StaticString &data)
+	{
+		char writeCountStr[sizeof(unsigned int) * 2 + 1];
+		unsigned int writeCountStrSize = integerToHexatri(writeCount, writeCountStr);
+		writeCount++;
+
+		storage.append(txnId.data(), txnId.size());
+		storage.append(1, ' ');
+		storage.append(timestamp.data(), timestamp.size());
+		storage.append(1, ' ');
+		storage.append(writeCountStr, writeCountStrSize);
+		storage.append(1, ' ');
+		storage.append(data.data(), data.size());
+		storage.append(1, '\n');
+	}
+
+	StaticString getBody() const {
+		return StaticString(storage.data() + bodyOffset, storage.size() - bodyOffset);
+	}
+};
+
+const StaticString TXN_ID("cjb8n-abcdefghijk");
+const StaticString TIMESTAMP("1263385422000000");
+
+size_t
+getBodySize(const vector<string> &messages) {
+	CopyingTransaction transaction(TXN_ID);
+	for (unsigned int i = 0; i < messages.size(); i++) {
+		transaction.append(TXN_ID, TIMESTAMP, messages[i]);
+	}
+	return transaction.getBody().size();
+}
+
+void
+benchmarkCopying(const vector<string> &messages) {
+	vector<char> sinkBuffer(SINK_BUFFER_CAPACITY);
+	unsigned int sinkBufferSize = 0;
+
+	BenchmarkLoop loop("ust_router_transaction", "copying");
+	loop.setBytesPerIteration(getBodySize(messages));
+	loop.setCountAllocations(true);
+	while (loop.keepRunning()) {
+		boost::shared_ptr<CopyingTransaction> transaction =
+			boost::make_shared<CopyingTransaction>(TXN_ID);
+		for (unsigned int i = 0; i < messages.size(); i++) {
+			transaction->append(TXN_ID, TIMESTAMP, messages[i]);
+		}
+
+		StaticString body = transaction->getBody();
+		if (sinkBufferSize + body.size() > SINK_BUFFER_CAPACITY) {
+			// RemoteSender::schedule() copied the packet into its queue.
+			string packet;
+			packet.reserve(sinkBufferSize + body.size());
+			packet.append(&sinkBuffer[0], sinkBufferSize);
+			packet.append(body.data(), body.size());
+			doNotOptimize(packet.data());
+			sinkBufferSize = 0;
+		} else {
+			memcpy(&sinkBuffer[sinkBufferSize], body.data(), body.size());
+			sinkBufferSize += body.size();
+		}
+	}
+}
+
+void
+benchmarkMbuf(const vector<string> &messages) {
+	struct mbuf_pool pool;
+	vector<mbuf> sinkBuffer;
+	unsigned int sinkBufferSize = 0;
+
+	pool.mbuf_block_chunk_size = BODY_BLOCK_SIZE;
+	mbuf_pool_init(&pool, true);
+
+	{
+		BenchmarkLoop loop("ust_router_transaction", "mbuf");
+		loop.setBytesPerIteration(getBodySize(messages));
+		loop.setCountAllocations(true);
+		while (loop.keepRunning()) {
+			TransactionPtr transaction = boost::make_shared<Transaction>(
+				&pool, TXN_ID, "group", "node", "requests", "key", 0);
+			for (unsigned int i = 0; i < messages.size(); i++) {
+				transaction->append(TIMESTAMP, messages[i]);
+			}
+
+			transaction->getBody(sinkBuffer);
+			sinkBufferSize += transaction->getBodySize();
+			if (sinkBufferSize > SINK_BUFFER_CAPACITY) {
+				// RemoteSender::schedule() references the blocks.
+				vector<mbuf> packet(sinkBuffer);
+				doNotOptimize(&packet[0]);
+				sinkBuffer.clear();
+				sinkBufferSize = 0;
+			}
+		}
+	}
+
+	sinkBuffer.clear();
+	mbuf_pool_deinit(&pool);
+}
+
+} // anonymous namespace
+
+
+DEFINE_BENCHMARK(ust_router_transaction) {
+	vector<string> messages = createMessages();
+	benchmarkCopying(messages);
+	benchmarkMbuf(messages);
+}
@@ -0,0 +1,231 @@
+#include "BenchmarkSupport.h"
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+#include <jsoncpp/json.h>
+#include <oxt/initialize.hpp>
+#include <oxt/system_calls.hpp>
+#include <Constants.h>
+
+namespace Passenger {
+namespace Benchmarks {
+
+
+struct BenchmarkResult {
+	string benchmark;
+	string variant;
+	boost::uint64_t iterations;
+	boost::uint64_t elapsedNs;
+	boost::uint64_t bytesPerIteration;
+	double allocationsPerIteration;
+};
+
+static vector<BenchmarkResult> results;
+static boost::uint64_t minTimeNs = 500000000;
+static boost::uint64_t allocationCount = 0;
+
+} // namespace Benchmarks
+} // namespace Passenger
+
+
+#ifdef __GLIBC__
+	// Count allocations by interposing glibc's allocator entry points.
+	// free() needs no wrapper: the memory still comes from glibc.
+	extern "C" {
+		void *__libc_malloc(size_t size);
+		void *__libc_calloc(size_t nmemb, size_t size);
+		void *__libc_realloc(void *ptr, size_t size);
+
+		void *
+		malloc(size_t size) {
+			__sync_fetch_and_add(&Passenger::Benchmarks::allocationCount, 1);
+			return __libc_malloc(size);
+		}
+
+		void *
+		calloc(size_t nmemb, size_t size) {
+			__sync_fetch_and_add(&Passenger::Benchmarks::allocationCount, 1);
+			return __libc_calloc(nmemb, size);
+		}
+
+		void *
+		realloc(void *ptr, size_t size) {
+			__sync_fetch_and_add(&Passenger::Benchmarks::allocationCount, 1);
+			return __libc_realloc(ptr, size);
+		}
+	}
+#endif
+
+
+namespace Passenger {
+namespace Benchmarks {
+
+
+vector<BenchmarkRegistration> &
+getBenchmarks() {
+	static vector<BenchmarkRegistration> benchmarks;
+	return benchmarks;
+}
+
+boost::uint64_t
+getMinTimeNs() {
+	return minTimeNs;
+}
+
+bool
+allocationCountingSupported() {
+	#ifdef __GLIBC__
+		return true;
+	#else
+		return false;
+	#endif
+}
+
+boost::uint64_t
+getAllocationCount() {
+	return __sync_fetch_and_add(&allocationCount, 0);
+}
+
+void
+report(const string &benchmark, const string &variant,
+	boost::uint64_t iterations, boost::uint64_t elapsedNs,
+	boost::uint64_t bytesPerIteration, double allocationsPerIteration)
+{
+	BenchmarkResult result;
+	result.benchmark = benchmark;
+	result.variant = variant;
+	result.iterations = iterations;
+	result.elapsedNs = elapsedNs;
+	result.bytesPerIteration = bytesPerIteration;
+	result.allocationsPerIteration = allocationsPerIteration;
+	results.push_back(result);
+
+	printf("%-28s %-32s %12llu iterations %10.1f ns/op",
+		benchmark.c_str(), variant.c_str(),
+		(unsigned long long) iterations,
+		(double) elapsedNs / iterations);
+	if (bytesPerIteration > 0) {
+		printf(" %10.1f MB/s", (double) bytesPerIteration * iterations
+			/ (1024 * 1024) / (elapsedNs / 1000000000.0));
+	}
+	if (allocationsPerIteration >= 0) {
+		printf(" %8.2f allocs/op", allocationsPerIteration);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+
+} // namespace Benchmarks
+} // namespace Passenger
+
+using namespace Passenger::Benchmarks;
+
+static void
+usage() {
+	printf("Usage: main [OPTIONS]\n");
+	printf("Runs all benchmarks, or only the given ones.\n\n");
+	printf("Options:\n");
+	printf("  -b BENCHMARK_NAME  Run the given benchmark. May be passed multiple times\n");
+	printf("  -t SECONDS         Minimum time to run each benchmark case. Default: 0.5\n");
+	printf("  -o FILENAME        Also write the results to the given file, as JSON\n\n");
+	printf("Available benchmarks:\n");
+	for (unsigned int i = 0; i < getBenchmarks().size(); i++) {
+		printf("  %s\n", getBenchmarks()[i].name);
+	}
+}
+
+static Json::Value
+createResultsJson() {
+	Json::Value doc, context, cases(Json::arrayValue);
+	char hostname[256];
+	char date[64];
+	time_t now = time(NULL);
+	struct tm tm;
+
+	if (gethostname(hostname, sizeof(hostname)) != 0) {
+		hostname[0] = '\0';
+	}
+	hostname[sizeof(hostname) - 1] = '\0';
+	gmtime_r(&now, &tm);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+	context["passenger_version"] = PASSENGER_VERSION;
+	context["date"] = date;
+	context["host_name"] = hostname;
+	context["num_cpus"] = (Json::Int) sysconf(_SC_NPROCESSORS_ONLN);
+	context["min_time_ns"] = (Json::UInt64) minTimeNs;
+	doc["context"] = context;
+
+	for (unsigned int i = 0; i < results.size(); i++) {
+		const BenchmarkResult &result = results[i];
+		Json::Value item;
+
+		item["name"] = result.benchmark + "/" + result.variant;
+		item["benchmark"] = result.benchmark;
+		item["variant"] = result.variant;
+		item["iterations"] = (Json::UInt64) result.iterations;
+		item["elapsed_ns"] = (Json::UInt64) result.elapsedNs;
+		item["ns_per_op"] = (double) result.elapsedNs / result.iterations;
+		if (result.bytesPerIteration > 0) {
+			item["bytes_per_second"] = (double) result.bytesPerIteration
+				* result.iterations / (result.elapsedNs / 1000000000.0);
+		}
+		if (result.allocationsPerIteration >= 0) {
+			item["allocations_per_op"] = result.allocationsPerIteration;
+		}
+		cases.append(item);
+	}
+	doc["benchmarks"] = cases;
+
+	return doc;
+}
+
+int
+main(int argc, char *argv[]) {
+	vector<string> selected;
+	vector<BenchmarkRegistration> &benchmarks = getBenchmarks();
+	const char *outputFilename = NULL;
+	unsigned int i, j;
+
+	// Benchmarks that stop background threads need this.
+	oxt::initialize();
+	oxt::setup_syscall_interruption_support();
+
+	for (i = 1; i < (unsigned int) argc; i++) {
+		if (strcmp(argv[i], "-b") == 0 && i + 1 < (unsigned int) argc) {
+			selected.push_back(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < (unsigned int) argc) {
+			minTimeNs = (boost::uint64_t) (atof(argv[i + 1]) * 1000000000.0);
+			i++;
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < (unsigned int) argc) {
+			outputFilename = argv[i + 1];
+			i++;
+		} else {
+			usage();
+			return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	for (i = 0; i < benchmarks.size(); i++) {
+		bool run = selected.empty();
+		for (j = 0; j < selected.size() && !run; j++) {
+			run = selected[j] == benchmarks[i].name;
+		}
+		if (run) {
+			benchmarks[i].func();
+		}
+	}
+
+	if (outputFilename != NULL) {
+		std::ofstream output(outputFilename);
+		output << createResultsJson().toStyledString();
+		if (!output) {
+			fprintf(stderr, "Cannot write results to %s\n", outputFilename);
+			return 1;
+		}
+	}
+	return 0;
+}